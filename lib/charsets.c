@@ -62,6 +62,12 @@ const char *cp_source = NULL;
 
 /*** file scope type declarations ****************************************************************/
 
+typedef struct
+{
+    gunichar ch;
+    unsigned char byte;
+} codepage_pair_t;
+
 /*** file scope variables ************************************************************************/
 
 /*** file scope functions ************************************************************************/
@@ -75,6 +81,8 @@ new_codepage_desc (const char *id, const char *name)
     desc = g_new (codepage_desc, 1);
     desc->id = g_strdup (id);
     desc->name = g_strdup (name);
+    desc->table = NULL;
+    desc->table_loaded = FALSE;
 
     return desc;
 }
@@ -89,6 +97,7 @@ free_codepage_desc (gpointer data, gpointer user_data)
 
     g_free (desc->id);
     g_free (desc->name);
+    g_free (desc->table);
     g_free (desc);
 }
 
@@ -195,6 +204,95 @@ translate_character (GIConv cd, char c)
     return ch;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+codepage_pair_cmp (const void *a, const void *b)
+{
+    const codepage_pair_t *pa = (const codepage_pair_t *) a;
+    const codepage_pair_t *pb = (const codepage_pair_t *) b;
+
+    if (pa->ch != pb->ch)
+        return pa->ch < pb->ch ? -1 : 1;
+    /* prefer the lowest byte if several bytes are mapped to the same codepoint */
+    return (int) pa->byte - (int) pb->byte;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Build 8-bit <-> Unicode tables for codepage by converting every byte once with iconv.
+ *
+ * @param id codepage id
+ * @return newly allocated table or NULL if codepage is multibyte or cannot be converted
+ */
+
+static codepage_table_t *
+load_codepage_table (const char *id)
+{
+    codepage_table_t *table;
+    codepage_pair_t pairs[256];
+    GIConv cd;
+    size_t i, n = 0;
+
+    if (str_isutf8 (id))
+        return NULL;
+
+    cd = g_iconv_open ("UTF-8", id);
+    if (cd == INVALID_CONV)
+        return NULL;
+
+    table = g_new (codepage_table_t, 1);
+
+    for (i = 0; i < 256; i++)
+    {
+        char ibuf[1];
+        char obuf[UTF8_CHAR_LEN + 1];
+        gchar *ip = ibuf, *op = obuf;
+        gsize ileft = 1, oleft = UTF8_CHAR_LEN;
+        gunichar ch;
+
+        ibuf[0] = (char) i;
+        table->to_utf[i] = -1;
+
+        g_iconv (cd, NULL, NULL, NULL, NULL);
+        if (g_iconv (cd, &ip, &ileft, &op, &oleft) == (gsize) (-1) || ileft != 0)
+            continue;
+        *op = '\0';
+
+        if (op - obuf == 1)
+            ch = (unsigned char) obuf[0];
+        else
+        {
+            ch = g_utf8_get_char_validated (obuf, op - obuf);
+            if (ch == (gunichar) (-1) || ch == (gunichar) (-2))
+                continue;
+        }
+
+        table->to_utf[i] = (int) ch;
+        pairs[n].ch = ch;
+        pairs[n].byte = (unsigned char) i;
+        n++;
+    }
+
+    g_iconv_close (cd);
+
+    qsort (pairs, n, sizeof (codepage_pair_t), codepage_pair_cmp);
+
+    table->from_utf_len = 0;
+    for (i = 0; i < n; i++)
+    {
+        /* skip duplicates: keep the first (lowest) byte */
+        if (table->from_utf_len != 0
+            && table->from_utf_ch[table->from_utf_len - 1] == pairs[i].ch)
+            continue;
+        table->from_utf_ch[table->from_utf_len] = pairs[i].ch;
+        table->from_utf_byte[table->from_utf_len] = pairs[i].byte;
+        table->from_utf_len++;
+    }
+
+    return table;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /*** public functions ****************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -280,11 +378,129 @@ is_supported_encoding (const char *encoding)
 
 /* --------------------------------------------------------------------------------------------- */
 
+const codepage_table_t *
+get_codepage_table (const int n)
+{
+    codepage_desc *desc;
+
+    if (n < 0 || codepages == NULL || (guint) n >= codepages->len)
+        return NULL;
+
+    desc = (codepage_desc *) g_ptr_array_index (codepages, n);
+    if (!desc->table_loaded)
+    {
+        desc->table = load_codepage_table (desc->id);
+        desc->table_loaded = TRUE;
+    }
+
+    return desc->table;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find byte of 8-bit codepage for Unicode character.
+ *
+ * @param table codepage tables
+ * @param c Unicode character
+ * @return byte or -1 if character cannot be represented in codepage
+ */
+
+int
+convert_unichar_to_8bit (const codepage_table_t * table, gunichar c)
+{
+    size_t lo = 0, hi = table->from_utf_len;
+
+    /* fast path for ASCII compatible codepages */
+    if (c < 128 && table->to_utf[c] == (int) c)
+        return (int) c;
+
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (table->from_utf_ch[mid] == c)
+            return (int) table->from_utf_byte[mid];
+        if (table->from_utf_ch[mid] < c)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return -1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+gboolean
+convert_buf_from_8bit_to_utf (const codepage_table_t * table, const char *str, size_t len,
+                              GString * buff)
+{
+    gboolean ret = TRUE;
+    size_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        int ch;
+
+        ch = table->to_utf[(unsigned char) str[i]];
+        if (ch < 0)
+        {
+            ret = FALSE;
+            ch = '.';
+        }
+
+        if (ch < 128)
+            g_string_append_c (buff, (gchar) ch);
+        else
+            g_string_append_unichar (buff, (gunichar) ch);
+    }
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+gboolean
+convert_buf_from_utf_to_8bit (const codepage_table_t * table, const char *str, size_t len,
+                              GString * buff)
+{
+    gboolean ret = TRUE;
+    const char *end = str + len;
+
+    while (str < end)
+    {
+        gunichar uc;
+        int ch = -1;
+
+        uc = g_utf8_get_char_validated (str, end - str);
+        if (uc == (gunichar) (-1) || uc == (gunichar) (-2))
+            str++;
+        else
+        {
+            ch = convert_unichar_to_8bit (table, uc);
+            str = g_utf8_next_char (str);
+        }
+
+        if (ch < 0)
+        {
+            ret = FALSE;
+            ch = '.';
+        }
+
+        g_string_append_c (buff, (gchar) ch);
+    }
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
 char *
 init_translation_table (int cpsource, int cpdisplay)
 {
     int i;
     GIConv cd;
+    const codepage_table_t *src_table, *dst_table;
 
     /* Fill inpit <-> display tables */
 
@@ -307,6 +523,29 @@ init_translation_table (int cpsource, int cpdisplay)
     cp_source = ((codepage_desc *) g_ptr_array_index (codepages, cpsource))->id;
     cp_display = ((codepage_desc *) g_ptr_array_index (codepages, cpdisplay))->id;
 
+    /* both codepages are single-byte: recode through precomputed Unicode tables */
+    src_table = get_codepage_table (cpsource);
+    dst_table = get_codepage_table (cpdisplay);
+    if (src_table != NULL && dst_table != NULL)
+    {
+        for (i = 128; i <= 255; ++i)
+        {
+            int ch;
+
+            ch = src_table->to_utf[i];
+            if (ch >= 0)
+                ch = convert_unichar_to_8bit (dst_table, (gunichar) ch);
+            conv_displ[i] = (ch < 0) ? UNKNCHAR : (unsigned char) ch;
+
+            ch = dst_table->to_utf[i];
+            if (ch >= 0)
+                ch = convert_unichar_to_8bit (src_table, (gunichar) ch);
+            conv_input[i] = (ch < 0 || ch == UNKNCHAR) ? i : (unsigned char) ch;
+        }
+
+        return NULL;
+    }
+
     /* display <- inpit table */
 
     cd = g_iconv_open (cp_display, cp_source);
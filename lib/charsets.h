@@ -11,10 +11,24 @@
 
 /*** structures declarations (and typedefs of structures)*****************************************/
 
+/* Precomputed recode tables of a single-byte codepage */
+typedef struct
+{
+    /* Unicode codepoint of each byte, -1 if the byte has no mapping */
+    int to_utf[256];
+    /* reverse map: codepoints sorted in ascending order and their bytes */
+    gunichar from_utf_ch[256];
+    unsigned char from_utf_byte[256];
+    size_t from_utf_len;
+} codepage_table_t;
+
 typedef struct
 {
     char *id;
     char *name;
+    /* built lazily by get_codepage_table(), NULL for multibyte codepages */
+    codepage_table_t *table;
+    gboolean table_loaded;
 } codepage_desc;
 
 /*** global variables defined in .c file *********************************************************/
@@ -66,6 +80,29 @@ int convert_from_8bit_to_utf_c (const char input_char, GIConv conv);
  */
 int convert_from_8bit_to_utf_c2 (const char input_char);
 
+/*
+ * Get the precomputed 8-bit <-> Unicode tables of codepage
+ * param n, index of codepage
+ * return NULL if codepage is not single-byte or cannot be converted
+ */
+const codepage_table_t *get_codepage_table (const int n);
+
+/*
+ * Converter from 8-bit codepage to Unicode using precomputed table
+ * return FALSE if some character cannot be converted (it's replaced with '.')
+ */
+gboolean convert_buf_from_8bit_to_utf (const codepage_table_t * table, const char *str,
+                                       size_t len, GString * buff);
+
+/*
+ * Converter from UTF-8 to 8-bit codepage using precomputed table
+ * return FALSE if some character cannot be converted (it's replaced with '.')
+ */
+gboolean convert_buf_from_utf_to_8bit (const codepage_table_t * table, const char *str,
+                                       size_t len, GString * buff);
+
+int convert_unichar_to_8bit (const codepage_table_t * table, gunichar c);
+
 GString *str_convert_to_input (char *str);
 GString *str_nconvert_to_input (char *str, int len);
 
@@ -91,4 +128,25 @@ convert_from_input_c (int c)
     return (int) conv_input[c];
 }
 
+/* Table driven variants of convert_from_8bit_to_utf_c() and convert_from_utf_to_current_c().
+   If table is NULL, fall back to iconv */
+static inline int
+convert_from_8bit_to_utf_t (const codepage_table_t * table, unsigned char c, GIConv conv)
+{
+    if (table == NULL)
+        return convert_from_8bit_to_utf_c ((char) c, conv);
+    return table->to_utf[c] < 0 ? '.' : table->to_utf[c];
+}
+
+static inline unsigned char
+convert_from_utf_to_current_t (const codepage_table_t * table, int c, GIConv conv)
+{
+    int ch;
+
+    if (table == NULL)
+        return convert_from_utf_to_current_c (c, conv);
+    ch = convert_unichar_to_8bit (table, (gunichar) c);
+    return ch < 0 ? '.' : (unsigned char) ch;
+}
+
 #endif /* MC__CHARSETS_H */
@@ -23,6 +23,7 @@ typedef struct mc_fhl_struct
 /*** declarations of public functions ************************************************************/
 
 mc_fhl_t *mc_fhl_new (gboolean);
+void mc_fhl_prefetch (void);
 void mc_fhl_free (mc_fhl_t **);
 
 int mc_fhl_get_color (mc_fhl_t *, file_entry_t *);
@@ -38,6 +38,11 @@
 
 /*** file scope variables ************************************************************************/
 
+#ifdef HAVE_GLIB_THREADS
+/* thread reading filehighlight.ini for the first mc_fhl_new() call */
+static GThread *prefetch_thread = NULL;
+#endif
+
 /*** file scope functions ************************************************************************/
 
 static void
@@ -63,6 +68,33 @@ mc_fhl_array_free (mc_fhl_t * fhl)
     }
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Read filehighlight.ini without parsing it. VFS isn't used, since it isn't thread-safe,
+ * the file is loaded by GKeyFile directly.
+ */
+
+static gpointer
+mc_fhl_read (gpointer data)
+{
+    mc_fhl_t *fhl;
+    gchar *name;
+
+    (void) data;
+
+    name = mc_fhl_get_standard_file ();
+    if (name == NULL)
+        return NULL;
+
+    fhl = g_new0 (mc_fhl_t, 1);
+    fhl->config = mc_config_init (NULL, TRUE);
+    /* empty or unreadable file gives empty config like in mc_config_init() */
+    (void) g_key_file_load_from_file (fhl->config->handle, name, G_KEY_FILE_NONE, NULL);
+    fhl->config->ini_path = name;
+
+    return fhl;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /*** public functions ****************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -72,19 +104,23 @@ mc_fhl_new (gboolean need_auto_fill)
 {
     mc_fhl_t *fhl;
 
-    fhl = g_try_new0 (mc_fhl_t, 1);
-    if (fhl == NULL)
-        return NULL;
-
     if (!need_auto_fill)
-        return fhl;
+        return g_try_new0 (mc_fhl_t, 1);
 
-    if (!mc_fhl_init_from_standard_files (fhl))
+#ifdef HAVE_GLIB_THREADS
+    if (prefetch_thread != NULL)
     {
-        g_free (fhl);
-        return NULL;
+        fhl = (mc_fhl_t *) g_thread_join (prefetch_thread);
+        prefetch_thread = NULL;
     }
+    else
+#endif
+        fhl = (mc_fhl_t *) mc_fhl_read (NULL);
+
+    if (fhl == NULL)
+        return NULL;
 
+    /* colors are allocated and regexps are created here, so parse in the main thread */
     if (!mc_fhl_parse_ini_file (fhl))
     {
         mc_fhl_free (&fhl);
@@ -94,6 +130,21 @@ mc_fhl_new (gboolean need_auto_fill)
     return fhl;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Start reading filehighlight.ini in background. The next mc_fhl_new (TRUE) call
+ * waits for it and takes the result. Without threads it does nothing.
+ */
+
+void
+mc_fhl_prefetch (void)
+{
+#ifdef HAVE_GLIB_THREADS
+    if (prefetch_thread == NULL)
+        prefetch_thread = g_thread_try_new ("filehighlight", mc_fhl_read, NULL, NULL);
+#endif
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 void
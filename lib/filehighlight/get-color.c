@@ -52,13 +52,13 @@ mc_fhl_is_file (file_entry_t * fe)
 #if S_ISREG == 0
     (void) fe;
 #endif
-    return S_ISREG (fe->st.st_mode);
+    return S_ISREG (fe->st.mode);
 }
 
 inline static gboolean
 mc_fhl_is_file_exec (file_entry_t * fe)
 {
-    return is_exe (fe->st.st_mode);
+    return is_exe (fe->st.mode);
 }
 
 inline static gboolean
@@ -67,7 +67,7 @@ mc_fhl_is_dir (file_entry_t * fe)
 #if S_ISDIR == 0
     (void) fe;
 #endif
-    return S_ISDIR (fe->st.st_mode);
+    return S_ISDIR (fe->st.mode);
 }
 
 inline static gboolean
@@ -76,13 +76,13 @@ mc_fhl_is_link (file_entry_t * fe)
 #if S_ISLNK == 0
     (void) fe;
 #endif
-    return S_ISLNK (fe->st.st_mode);
+    return S_ISLNK (fe->st.mode);
 }
 
 inline static gboolean
 mc_fhl_is_hlink (file_entry_t * fe)
 {
-    return (fe->st.st_nlink > 1);
+    return (fe->st.nlink > 1);
 }
 
 inline static gboolean
@@ -103,7 +103,7 @@ mc_fhl_is_device_char (file_entry_t * fe)
 #if S_ISCHR == 0
     (void) fe;
 #endif
-    return S_ISCHR (fe->st.st_mode);
+    return S_ISCHR (fe->st.mode);
 }
 
 inline static gboolean
@@ -112,7 +112,7 @@ mc_fhl_is_device_block (file_entry_t * fe)
 #if S_ISBLK == 0
     (void) fe;
 #endif
-    return S_ISBLK (fe->st.st_mode);
+    return S_ISBLK (fe->st.mode);
 }
 
 inline static gboolean
@@ -121,7 +121,7 @@ mc_fhl_is_special_socket (file_entry_t * fe)
 #if S_ISSOCK == 0
     (void) fe;
 #endif
-    return S_ISSOCK (fe->st.st_mode);
+    return S_ISSOCK (fe->st.mode);
 }
 
 inline static gboolean
@@ -130,7 +130,7 @@ mc_fhl_is_special_fifo (file_entry_t * fe)
 #if S_ISFIFO == 0
     (void) fe;
 #endif
-    return S_ISFIFO (fe->st.st_mode);
+    return S_ISFIFO (fe->st.mode);
 }
 
 inline static gboolean
@@ -140,7 +140,7 @@ mc_fhl_is_special_door (file_entry_t * fe)
     (void) fe;
 #endif
 
-    return S_ISDOOR (fe->st.st_mode);
+    return S_ISDOOR (fe->st.mode);
 }
 
 
@@ -225,7 +225,7 @@ mc_fhl_get_color_filetype (mc_fhl_filter_t * mc_filter, mc_fhl_t * fhl, file_ent
         break;
     }
 
-    return (my_color) ? mc_filter->color_pair_index : -1;
+    return (my_color) ? mc_skin_color_get_by_id (mc_filter->color_id) : -1;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -238,7 +238,7 @@ mc_fhl_get_color_regexp (mc_fhl_filter_t * mc_filter, mc_fhl_t * fhl, file_entry
         return -1;
 
     if (mc_search_run (mc_filter->search_condition, fe->fname, 0, strlen (fe->fname), NULL))
-        return mc_filter->color_pair_index;
+        return mc_skin_color_get_by_id (mc_filter->color_id);
 
     return -1;
 }
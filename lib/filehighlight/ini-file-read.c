@@ -53,7 +53,7 @@ static void
 mc_fhl_parse_fill_color_info (mc_fhl_filter_t * mc_filter, mc_fhl_t * fhl, const gchar * group_name)
 {
     (void) fhl;
-    mc_filter->color_pair_index = mc_skin_color_get ("filehighlight", group_name);
+    mc_filter->color_id = mc_skin_color_intern ("filehighlight", group_name);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -189,32 +189,37 @@ mc_fhl_read_ini_file (mc_fhl_t * fhl, const gchar * filename)
 }
 
 /* --------------------------------------------------------------------------------------------- */
+/**
+ * Find filehighlight.ini in the user, system and data directories.
+ * VFS isn't used here, so it can be called from any thread.
+ *
+ * @return newly allocated name of the first existing file or NULL
+ */
 
-gboolean
-mc_fhl_init_from_standard_files (mc_fhl_t * fhl)
+gchar *
+mc_fhl_get_standard_file (void)
 {
     gchar *name;
-    gboolean ok;
 
     /* ${XDG_CONFIG_HOME}/mc/filehighlight.ini */
     name = mc_config_get_full_path (MC_FHL_INI_FILE);
-    ok = mc_fhl_read_ini_file (fhl, name);
+    if (exist_file (name))
+        return name;
     g_free (name);
-    if (ok)
-        return TRUE;
 
     /* ${sysconfdir}/mc/filehighlight.ini  */
     name = g_build_filename (mc_global.sysconfig_dir, MC_FHL_INI_FILE, (char *) NULL);
-    ok = mc_fhl_read_ini_file (fhl, name);
+    if (exist_file (name))
+        return name;
     g_free (name);
-    if (ok)
-        return TRUE;
 
     /* ${datadir}/mc/filehighlight.ini  */
     name = g_build_filename (mc_global.share_data_dir, MC_FHL_INI_FILE, (char *) NULL);
-    ok = mc_fhl_read_ini_file (fhl, name);
+    if (exist_file (name))
+        return name;
     g_free (name);
-    return ok;
+
+    return NULL;
 }
 
 /* --------------------------------------------------------------------------------------------- */
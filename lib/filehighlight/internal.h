@@ -36,7 +36,7 @@ typedef enum
 typedef struct mc_fhl_filter_struct
 {
 
-    int color_pair_index;
+    int color_id;               /* skin color ID, see mc_skin_color_intern() */
     gchar *fgcolor;
     gchar *bgcolor;
     mc_flhgh_filter_type type;
@@ -51,7 +51,7 @@ typedef struct mc_fhl_filter_struct
 
 void mc_fhl_array_free (mc_fhl_t *);
 
-gboolean mc_fhl_init_from_standard_files (mc_fhl_t *);
+gchar *mc_fhl_get_standard_file (void);
 
 /*** inline functions ****************************************************************************/
 
@@ -3,6 +3,11 @@
 
 /*** typedefs(not structures) and defined constants **********************************************/
 
+/* Since glib 2.32 threads are always enabled and don't require g_thread_init() */
+#if GLIB_CHECK_VERSION (2, 32, 0)
+#define HAVE_GLIB_THREADS 1
+#endif
+
 /*** enums ***************************************************************************************/
 
 /*** structures declarations (and typedefs of structures)*****************************************/
@@ -42,8 +42,18 @@
 
 /*** file scope type declarations ****************************************************************/
 
+/* Lookup tables of compiled keymap */
+typedef struct
+{
+    GHashTable *by_key;         /* key -> first keymap entry with this key */
+    GHashTable *by_command;     /* command -> first keymap entry with this command */
+} keymap_index_t;
+
 /*** file scope variables ************************************************************************/
 
+/* compiled keymaps: global_keymap_t * -> keymap_index_t * */
+static GHashTable *keymap_indexes = NULL;
+
 static name_keymap_t command_names[] = {
     /* common */
     {"InsertChar", CK_InsertChar},
@@ -332,6 +342,7 @@ static name_keymap_t command_names[] = {
     /* viewer */
     {"WrapMode", CK_WrapMode},
     {"HexEditMode", CK_HexEditMode},
+    {"HexFill", CK_HexFill},
     {"HexMode", CK_HexMode},
     {"MagicMode", CK_MagicMode},
     {"NroffMode", CK_NroffMode},
@@ -407,6 +418,26 @@ keymap_add (GArray * keymap, long key, unsigned long cmd, const char *caption)
     }
 }
 
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+keymap_index_free (gpointer data)
+{
+    keymap_index_t *index = (keymap_index_t *) data;
+
+    g_hash_table_destroy (index->by_key);
+    g_hash_table_destroy (index->by_command);
+    g_free (index);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static inline const keymap_index_t *
+keymap_find_index (const global_keymap_t * keymap)
+{
+    return keymap_indexes == NULL ? NULL : g_hash_table_lookup (keymap_indexes, keymap);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /*** public functions ****************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -454,13 +485,81 @@ keybind_lookup_actionname (unsigned long action)
 
 /* --------------------------------------------------------------------------------------------- */
 
+/**
+ * Build lookup tables for keymap. Lookups in compiled keymap don't depend on keymap size.
+ * The keymap must not be changed or freed until keybind_free_compiled_keymaps() is called.
+ * Like the linear search, lookup tables return the first entry for key or command.
+ *
+ * @param keymap keymap terminated by entry with zero key
+ */
+
+void
+keybind_compile_keymap (const global_keymap_t * keymap)
+{
+    keymap_index_t *index;
+    size_t i;
+
+    if (keymap == NULL)
+        return;
+
+    if (keymap_indexes == NULL)
+        keymap_indexes = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+                                                keymap_index_free);
+
+    index = g_new (keymap_index_t, 1);
+    index->by_key = g_hash_table_new (g_direct_hash, g_direct_equal);
+    index->by_command = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+    for (i = 0; keymap[i].key != 0; i++)
+    {
+        gpointer key, command;
+
+        key = GINT_TO_POINTER (keymap[i].key);
+        if (!g_hash_table_lookup_extended (index->by_key, key, NULL, NULL))
+            g_hash_table_insert (index->by_key, key, (gpointer) & keymap[i]);
+
+        command = GUINT_TO_POINTER (keymap[i].command);
+        if (!g_hash_table_lookup_extended (index->by_command, command, NULL, NULL))
+            g_hash_table_insert (index->by_command, command, (gpointer) & keymap[i]);
+    }
+
+    g_hash_table_insert (keymap_indexes, (gpointer) keymap, index);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Free lookup tables of all compiled keymaps.
+ */
+
+void
+keybind_free_compiled_keymaps (void)
+{
+    if (keymap_indexes != NULL)
+    {
+        g_hash_table_destroy (keymap_indexes);
+        keymap_indexes = NULL;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
 const char *
 keybind_lookup_keymap_shortcut (const global_keymap_t * keymap, unsigned long action)
 {
     if (keymap != NULL)
     {
+        const keymap_index_t *index;
         size_t i;
 
+        index = keymap_find_index (keymap);
+        if (index != NULL)
+        {
+            const global_keymap_t *k;
+
+            k = g_hash_table_lookup (index->by_command, GUINT_TO_POINTER (action));
+            return (k != NULL && k->caption[0] != '\0') ? k->caption : NULL;
+        }
+
         for (i = 0; keymap[i].key != 0; i++)
             if (keymap[i].command == action)
                 return (keymap[i].caption[0] != '\0') ? keymap[i].caption : NULL;
@@ -475,8 +574,18 @@ keybind_lookup_keymap_command (const global_keymap_t * keymap, long key)
 {
     if (keymap != NULL)
     {
+        const keymap_index_t *index;
         size_t i;
 
+        index = keymap_find_index (keymap);
+        if (index != NULL)
+        {
+            const global_keymap_t *k;
+
+            k = g_hash_table_lookup (index->by_key, GINT_TO_POINTER (key));
+            return (k != NULL) ? k->command : CK_IgnoreKey;
+        }
+
         for (i = 0; keymap[i].key != 0; i++)
             if (keymap[i].key == key)
                 return keymap[i].command;
@@ -312,6 +312,7 @@ enum
     CK_NroffMode,
     CK_HexMode,
     CK_HexEditMode,
+    CK_HexFill,
     CK_BookmarkGoto,
     CK_Ruler,
     CK_SearchForward,
@@ -364,6 +365,8 @@ typedef struct global_keymap_t
 void keybind_cmd_bind (GArray * keymap, const char *keybind, unsigned long action);
 unsigned long keybind_lookup_action (const char *name);
 const char *keybind_lookup_actionname (unsigned long action);
+void keybind_compile_keymap (const global_keymap_t * keymap);
+void keybind_free_compiled_keymaps (void);
 const char *keybind_lookup_keymap_shortcut (const global_keymap_t * keymap, unsigned long action);
 unsigned long keybind_lookup_keymap_command (const global_keymap_t * keymap, long key);
 
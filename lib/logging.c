@@ -47,13 +47,27 @@
 #define CONFIG_KEY_NAME "logging"
 #define CONFIG_KEY_NAME_FILE "logfile"
 
+#define STARTUP_PHASES_MAX 32
+
 /*** file scope type declarations ****************************************************************/
 
+typedef struct
+{
+    const char *name;
+    gint64 time;
+} startup_phase_t;
+
 /*** file scope variables ************************************************************************/
 
 static gboolean logging_initialized = FALSE;
 static gboolean logging_enabled = FALSE;
 
+/* Startup phases are only remembered while the program starts and written to the log at once,
+   so tracing doesn't slow down the startup itself */
+static startup_phase_t startup_phases[STARTUP_PHASES_MAX];
+static size_t startup_phases_num = 0;
+static gboolean startup_done = FALSE;
+
 /*** file scope functions ************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
 
@@ -161,3 +175,49 @@ mc_always_log (const char *fmt, ...)
 }
 
 /* --------------------------------------------------------------------------------------------- */
+/**
+ * Remember the time when the startup phase @phase is finished.
+ * The first call marks the beginning of the startup.
+ *
+ * @param phase name of phase, it must be a static string
+ */
+
+void
+mc_log_startup_phase (const char *phase)
+{
+    if (startup_done || startup_phases_num == STARTUP_PHASES_MAX)
+        return;
+
+    startup_phases[startup_phases_num].name = phase;
+    startup_phases[startup_phases_num].time = g_get_monotonic_time ();
+    startup_phases_num++;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Finish the startup tracing and write the time of each phase to the log
+ * if logging is enabled. Next calls do nothing.
+ */
+
+void
+mc_log_startup_done (void)
+{
+    size_t i;
+
+    if (startup_done)
+        return;
+
+    startup_done = TRUE;
+
+    if (startup_phases_num == 0 || !is_logging_enabled ())
+        return;
+
+    mc_log ("startup: %-24s %10s %10s\n", "phase", "ms", "total ms");
+
+    for (i = 1; i < startup_phases_num; i++)
+        mc_log ("startup: %-24s %10.3f %10.3f\n", startup_phases[i].name,
+                (startup_phases[i].time - startup_phases[i - 1].time) / 1000.0,
+                (startup_phases[i].time - startup_phases[0].time) / 1000.0);
+}
+
+/* --------------------------------------------------------------------------------------------- */
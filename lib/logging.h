@@ -25,6 +25,9 @@
 extern void mc_log (const char *, ...) __attribute__ ((__format__ (__printf__, 1, 2)));
 extern void mc_always_log (const char *, ...) __attribute__ ((__format__ (__printf__, 1, 2)));
 
+extern void mc_log_startup_phase (const char *phase);
+extern void mc_log_startup_done (void);
+
 /*** inline functions ****************************************************************************/
 
 #endif
@@ -15,10 +15,15 @@
 
 /*** structures declarations (and typedefs of structures)*****************************************/
 
+struct mc_config_shared_t;
+
 typedef struct mc_config_t
 {
     GKeyFile *handle;
     gchar *ini_path;
+    /* if not NULL, handle is owned by the cache and shared with other configs
+       read from the same file; it is copied before the first change */
+    struct mc_config_shared_t *shared;
 } mc_config_t;
 
 /*** global variables defined in .c file *********************************************************/
@@ -32,6 +37,8 @@ extern mc_config_t *mc_panels_config;
 
 mc_config_t *mc_config_init (const gchar * ini_path, gboolean read_only);
 void mc_config_deinit (mc_config_t * mc_config);
+void mc_config_unshare (mc_config_t * mc_config);
+void mc_config_cache_free (void);
 
 gboolean mc_config_del_key (mc_config_t *, const char *, const gchar *);
 gboolean mc_config_del_group (mc_config_t *, const char *);
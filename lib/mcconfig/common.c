@@ -27,6 +27,7 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>              /* extern int errno */
+#include <string.h>
 
 #include "lib/global.h"
 #include "lib/vfs/vfs.h"        /* mc_stat */
@@ -40,13 +41,143 @@ mc_config_t *mc_panels_config;
 
 /*** file scope macro definitions **************************************/
 
+/* total size of ini files kept in the cache, larger files aren't cached at all */
+#define MC_CONFIG_CACHE_SIZE (512 * 1024)
+
 /*** file scope type declarations **************************************/
 
+/* Ini file parsed once and shared by all configs read from it while it isn't changed */
+typedef struct mc_config_shared_t
+{
+    GKeyFile *handle;
+    gchar *ini_path;
+    GKeyFileFlags flags;
+    /* file is parsed again if any of these is changed */
+    dev_t dev;
+    ino_t ino;
+    time_t mtime;
+    off_t size;
+    int ref_count;
+} mc_config_shared_t;
+
 /*** file scope variables **********************************************/
 
+/* Parsed ini files, the most recently used is the first one. The list holds a reference to
+   each entry. It is used from the main thread only. */
+static GList *config_cache = NULL;
+static off_t config_cache_size = 0;
+
 /*** file scope functions **********************************************/
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
+static void
+mc_config_shared_unref (mc_config_shared_t * shared)
+{
+    shared->ref_count--;
+
+    if (shared->ref_count == 0)
+    {
+        g_key_file_free (shared->handle);
+        g_free (shared->ini_path);
+        g_free (shared);
+    }
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static void
+mc_config_cache_remove (GList * link)
+{
+    mc_config_shared_t *shared = (mc_config_shared_t *) link->data;
+
+    config_cache_size -= shared->size;
+    config_cache = g_list_delete_link (config_cache, link);
+    mc_config_shared_unref (shared);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+/**
+ * Drop the file from the cache. Configs which use it keep their copy.
+ * Called when file is written by us, since mtime has a granularity of one second
+ * and the file size can remain the same.
+ */
+
+static void
+mc_config_cache_forget (const gchar * ini_path)
+{
+    GList *l, *next;
+
+    for (l = config_cache; l != NULL; l = next)
+    {
+        next = g_list_next (l);
+
+        if (strcmp (((mc_config_shared_t *) l->data)->ini_path, ini_path) == 0)
+            mc_config_cache_remove (l);
+    }
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+/**
+ * Get the parsed file from the cache or parse it and put into the cache.
+ *
+ * @return new reference to the shared file or NULL if the file is too large to be cached
+ */
+
+static mc_config_shared_t *
+mc_config_cache_get (const gchar * ini_path, GKeyFileFlags flags, const struct stat *st)
+{
+    GList *l;
+    mc_config_shared_t *shared;
+
+    for (l = config_cache; l != NULL; l = g_list_next (l))
+    {
+        shared = (mc_config_shared_t *) l->data;
+
+        if (shared->flags != flags || strcmp (shared->ini_path, ini_path) != 0)
+            continue;
+
+        if (shared->dev == st->st_dev && shared->ino == st->st_ino
+            && shared->mtime == st->st_mtime && shared->size == st->st_size)
+        {
+            /* move to the head */
+            config_cache = g_list_remove_link (config_cache, l);
+            config_cache = g_list_concat (l, config_cache);
+            shared->ref_count++;
+            return shared;
+        }
+
+        /* file is changed */
+        mc_config_cache_remove (l);
+        break;
+    }
+
+    if (st->st_size > MC_CONFIG_CACHE_SIZE)
+        return NULL;
+
+    shared = g_new (mc_config_shared_t, 1);
+    shared->handle = g_key_file_new ();
+    g_key_file_load_from_file (shared->handle, ini_path, flags, NULL);
+    shared->ini_path = g_strdup (ini_path);
+    shared->flags = flags;
+    shared->dev = st->st_dev;
+    shared->ino = st->st_ino;
+    shared->mtime = st->st_mtime;
+    shared->size = st->st_size;
+    /* one reference for the cache, other one for the caller */
+    shared->ref_count = 2;
+
+    config_cache = g_list_prepend (config_cache, shared);
+    config_cache_size += shared->size;
+
+    /* drop least recently used files */
+    while (config_cache_size > MC_CONFIG_CACHE_SIZE)
+        mc_config_cache_remove (g_list_last (config_cache));
+
+    return shared;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
 static gboolean
 mc_config_new_or_override_file (mc_config_t * mc_config, const gchar * ini_path, GError ** mcerror)
 {
@@ -59,6 +190,8 @@ mc_config_new_or_override_file (mc_config_t * mc_config, const gchar * ini_path,
 
     mc_return_val_if_error (mcerror, FALSE);
 
+    mc_config_cache_forget (ini_path);
+
     data = g_key_file_to_data (mc_config->handle, &len, NULL);
     if (!exist_file (ini_path))
     {
@@ -135,7 +268,14 @@ mc_config_init (const gchar * ini_path, gboolean read_only)
                 flags |= G_KEY_FILE_KEEP_COMMENTS;
 
             /* file exists and not empty */
-            g_key_file_load_from_file (mc_config->handle, ini_path, flags, NULL);
+            mc_config->shared = mc_config_cache_get (ini_path, flags, &st);
+            if (mc_config->shared != NULL)
+            {
+                g_key_file_free (mc_config->handle);
+                mc_config->handle = mc_config->shared->handle;
+            }
+            else
+                g_key_file_load_from_file (mc_config->handle, ini_path, flags, NULL);
         }
         vfs_path_free (vpath);
     }
@@ -152,11 +292,52 @@ mc_config_deinit (mc_config_t * mc_config)
     if (mc_config != NULL)
     {
         g_free (mc_config->ini_path);
-        g_key_file_free (mc_config->handle);
+        if (mc_config->shared != NULL)
+            mc_config_shared_unref (mc_config->shared);
+        else
+            g_key_file_free (mc_config->handle);
         g_free (mc_config);
     }
 }
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+/**
+ * Get own copy of the shared file before changing the config.
+ * All functions which change the config call it.
+ */
+
+void
+mc_config_unshare (mc_config_t * mc_config)
+{
+    GKeyFile *handle;
+    gchar *data;
+    gsize len;
+
+    if (mc_config == NULL || mc_config->shared == NULL)
+        return;
+
+    data = g_key_file_to_data (mc_config->handle, &len, NULL);
+    handle = g_key_file_new ();
+    g_key_file_load_from_data (handle, data, len, mc_config->shared->flags, NULL);
+    g_free (data);
+
+    mc_config_shared_unref (mc_config->shared);
+    mc_config->shared = NULL;
+    mc_config->handle = handle;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+/**
+ * Free all cached files. Configs which use them are still valid.
+ */
+
+void
+mc_config_cache_free (void)
+{
+    while (config_cache != NULL)
+        mc_config_cache_remove (config_cache);
+}
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
 gboolean
@@ -186,6 +367,8 @@ mc_config_del_key (mc_config_t * mc_config, const char *group, const gchar * par
 {
     if (!mc_config || !group || !param)
         return FALSE;
+
+    mc_config_unshare (mc_config);
 #if GLIB_CHECK_VERSION (2, 15, 0)
     return g_key_file_remove_key (mc_config->handle, group, param, NULL);
 #else
@@ -202,6 +385,8 @@ mc_config_del_group (mc_config_t * mc_config, const char *group)
     if (!mc_config || !group)
         return FALSE;
 
+    mc_config_unshare (mc_config);
+
 #if GLIB_CHECK_VERSION (2, 15, 0)
     return g_key_file_remove_group (mc_config->handle, group, NULL);
 #else
@@ -228,6 +413,8 @@ mc_config_read_file (mc_config_t * mc_config, const gchar * ini_path, gboolean r
     if (tmp_config == NULL)
         return FALSE;
 
+    mc_config_unshare (mc_config);
+
     groups = mc_config_get_groups (tmp_config, NULL);
     ok = (*groups != NULL);
 
@@ -76,6 +76,7 @@ mc_config_set_string_raw (mc_config_t * mc_config, const gchar * group,
     if (!mc_config || !group || !param || !value)
         return;
 
+    mc_config_unshare (mc_config);
     g_key_file_set_string (mc_config->handle, group, param, value);
 }
 
@@ -88,6 +89,7 @@ mc_config_set_string_raw_value (mc_config_t * mc_config, const gchar * group,
     if (!mc_config || !group || !param || !value)
         return;
 
+    mc_config_unshare (mc_config);
     g_key_file_set_value (mc_config->handle, group, param, value);
 }
 
@@ -104,6 +106,7 @@ mc_config_set_string (const mc_config_t * mc_config, const gchar * group,
 
     buffer = mc_config_normalize_before_save (value);
 
+    mc_config_unshare ((mc_config_t *) mc_config);
     g_key_file_set_string (mc_config->handle, group, param, buffer);
 
     g_free (buffer);
@@ -118,6 +121,7 @@ mc_config_set_bool (mc_config_t * mc_config, const gchar * group,
     if (!mc_config || !group || !param)
         return;
 
+    mc_config_unshare (mc_config);
     g_key_file_set_boolean (mc_config->handle, group, param, value);
 }
 
@@ -129,6 +133,7 @@ mc_config_set_int (mc_config_t * mc_config, const gchar * group, const gchar * p
     if (!mc_config || !group || !param)
         return;
 
+    mc_config_unshare (mc_config);
     g_key_file_set_integer (mc_config->handle, group, param, value);
 }
 
@@ -142,6 +147,7 @@ mc_config_set_string_list (mc_config_t * mc_config, const gchar * group,
     if (!mc_config || !group || !param || !value || length == 0)
         return;
 
+    mc_config_unshare (mc_config);
     g_key_file_set_string_list (mc_config->handle, group, param, value, length);
 }
 
@@ -155,6 +161,7 @@ mc_config_set_bool_list (mc_config_t * mc_config, const gchar * group,
     if (!mc_config || !group || !param || !value || length == 0)
         return;
 
+    mc_config_unshare (mc_config);
     g_key_file_set_boolean_list (mc_config->handle, group, param, value, length);
 }
 
@@ -167,6 +174,7 @@ mc_config_set_int_list (mc_config_t * mc_config, const gchar * group,
     if (!mc_config || !group || !param || !value || length == 0)
         return;
 
+    mc_config_unshare (mc_config);
     g_key_file_set_integer_list (mc_config->handle, group, param, value, length);
 }
 
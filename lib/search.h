@@ -19,8 +19,14 @@ typedef mc_search_cbret_t (*mc_search_fn) (const void *user_data, gsize char_off
                                            int *current_char);
 typedef mc_search_cbret_t (*mc_update_fn) (const void *user_data, gsize char_offset);
 
+typedef const char *(*mc_search_get_str_fn) (gsize index, gsize * len, gpointer user_data);
+
 #define MC_SEARCH__NUM_REPLACE_ARGS 64
 
+/* bitmap returned by mc_search_run_batch() */
+#define MC_SEARCH_BITMAP_SIZE(n) (((n) + 7) / 8)
+#define MC_SEARCH_BITMAP_TEST(bitmap, i) (((bitmap)[(i) >> 3] & (1 << ((i) & 7))) != 0)
+
 #ifdef SEARCH_TYPE_GLIB
 #define mc_search_matchinfo_t GMatchInfo
 #else
@@ -47,6 +53,15 @@ typedef enum
     MC_SEARCH_T_GLOB
 } mc_search_type_t;
 
+/* flags of compiled pattern in cache */
+typedef enum
+{
+    MC_SEARCH_F_NONE = 0,
+    MC_SEARCH_F_CASE_SENSITIVE = 1 << 0,
+    MC_SEARCH_F_ENTIRE_LINE = 1 << 1,
+    MC_SEARCH_F_WHOLE_WORDS = 1 << 2
+} mc_search_flags_t;
+
 enum mc_search_cbret_t
 {
     MC_SEARCH_CB_OK = 0,
@@ -139,6 +154,13 @@ gboolean mc_search_prepare (mc_search_t * mc_search);
 gboolean mc_search_run (mc_search_t * mc_search, const void *user_data, gsize start_search,
                         gsize end_search, gsize * found_len);
 
+guint8 *mc_search_run_batch (mc_search_t * mc_search, gsize count, mc_search_get_str_fn get_str,
+                             gpointer user_data, gsize * found);
+
+mc_search_t *mc_search_cache_get (const gchar * pattern, const gchar * pattern_charset,
+                                  mc_search_type_t type, mc_search_flags_t flags);
+void mc_search_cache_free (void);
+
 gboolean mc_search_is_type_avail (mc_search_type_t);
 
 const mc_search_type_str_t *mc_search_types_list_get (size_t * num);
@@ -55,6 +55,52 @@ const char *STR_E_RPL_INVALID_TOKEN = N_("Invalid token number %d");
 
 /*** file scope functions ************************************************************************/
 
+#ifdef HAVE_CHARSET
+/**
+ * Recode string between single-byte codepage and UTF-8 using precomputed tables.
+ *
+ * @return newly allocated string or NULL if tables are not applicable
+ */
+
+static gchar *
+mc_search__recode_str_by_table (const char *str, gsize str_len,
+                                const char *charset_from, const char *charset_to,
+                                gsize * bytes_written)
+{
+    const codepage_table_t *table;
+    GString *buff;
+    gboolean ok;
+
+    if (str_isutf8 (charset_to))
+    {
+        table = get_codepage_table (get_codepage_index (charset_from));
+        if (table == NULL)
+            return NULL;
+        buff = g_string_sized_new (str_len * 2);
+        ok = convert_buf_from_8bit_to_utf (table, str, str_len, buff);
+    }
+    else if (str_isutf8 (charset_from))
+    {
+        table = get_codepage_table (get_codepage_index (charset_to));
+        if (table == NULL)
+            return NULL;
+        buff = g_string_sized_new (str_len);
+        ok = convert_buf_from_utf_to_8bit (table, str, str_len, buff);
+    }
+    else
+        return NULL;
+
+    if (!ok)
+    {
+        g_string_free (buff, TRUE);
+        return NULL;
+    }
+
+    *bytes_written = buff->len;
+    return g_string_free (buff, FALSE);
+}
+#endif /* HAVE_CHARSET */
+
 /*** public functions ****************************************************************************/
 
 gchar *
@@ -72,6 +118,12 @@ mc_search__recode_str (const char *str, gsize str_len,
         return g_strndup (str, str_len);
     }
 
+#ifdef HAVE_CHARSET
+    ret = mc_search__recode_str_by_table (str, str_len, charset_from, charset_to, bytes_written);
+    if (ret != NULL)
+        return ret;
+#endif
+
     conv = g_iconv_open (charset_to, charset_from);
     if (conv == INVALID_CONV)
     {
@@ -907,6 +907,54 @@ mc_search__run_regex (mc_search_t * lc_mc_search, const void *user_data,
     return FALSE;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Match whole single-line string against prepared conditions.
+ * Same as mc_search__run_regex() without copying of string into regex_buffer and
+ * without allocation of match info, so it is used for matching of many short strings.
+ */
+
+gboolean
+mc_search__match_regex_str (mc_search_t * lc_mc_search, const char *str, gsize len)
+{
+    gsize loop1;
+
+    for (loop1 = 0; loop1 < lc_mc_search->conditions->len; loop1++)
+    {
+        mc_search_cond_t *mc_search_cond;
+#ifdef SEARCH_TYPE_GLIB
+        GError *mcerror = NULL;
+#endif
+
+        mc_search_cond = (mc_search_cond_t *) g_ptr_array_index (lc_mc_search->conditions, loop1);
+
+        if (mc_search_cond->regex_handle == NULL)
+            continue;
+
+#ifdef SEARCH_TYPE_GLIB
+        if (g_regex_match_full (mc_search_cond->regex_handle, str, len, 0,
+                                G_REGEX_MATCH_NEWLINE_ANY, NULL, &mcerror))
+            return TRUE;
+
+        if (mcerror != NULL)
+        {
+            lc_mc_search->error = MC_SEARCH_E_REGEX;
+            g_free (lc_mc_search->error_str);
+            lc_mc_search->error_str =
+                str_conv_gerror_message (mcerror, _("Regular expression error"));
+            g_error_free (mcerror);
+            return FALSE;
+        }
+#else /* SEARCH_TYPE_GLIB */
+        if (pcre_exec (mc_search_cond->regex_handle, lc_mc_search->regex_match_info, str, len, 0,
+                       0, lc_mc_search->iovector, MC_SEARCH__NUM_REPLACE_ARGS) >= 0)
+            return TRUE;
+#endif /* SEARCH_TYPE_GLIB */
+    }
+
+    return FALSE;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 GString *
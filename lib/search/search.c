@@ -43,6 +43,9 @@
 
 /*** file scope macro definitions ****************************************************************/
 
+/* maximum number of compiled patterns kept by mc_search_cache_get() */
+#define MC_SEARCH_CACHE_SIZE 16
+
 /*** file scope type declarations ****************************************************************/
 
 /*** file scope variables ************************************************************************/
@@ -55,6 +58,9 @@ static const mc_search_type_str_t mc_search__list_types[] = {
     {NULL, -1}
 };
 
+/* compiled patterns, most recently used first */
+static GQueue *mc_search_cache = NULL;
+
 /*** file scope functions ************************************************************************/
 
 static mc_search_cond_t *
@@ -120,6 +126,28 @@ mc_search__conditions_free (GPtrArray * array)
     g_ptr_array_free (array, TRUE);
 }
 
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+mc_search__cache_match (const mc_search_t * lc_mc_search, const gchar * pattern,
+                        const gchar * charset, mc_search_type_t type, mc_search_flags_t flags)
+{
+    if (lc_mc_search->search_type != type
+        || lc_mc_search->is_case_sensitive != ((flags & MC_SEARCH_F_CASE_SENSITIVE) != 0)
+        || lc_mc_search->is_entire_line != ((flags & MC_SEARCH_F_ENTIRE_LINE) != 0)
+        || lc_mc_search->whole_words != ((flags & MC_SEARCH_F_WHOLE_WORDS) != 0))
+        return FALSE;
+
+#ifdef HAVE_CHARSET
+    if (g_strcmp0 (lc_mc_search->original_charset, charset) != 0)
+        return FALSE;
+#else
+    (void) charset;
+#endif
+
+    return (strcmp (lc_mc_search->original, pattern) == 0);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /*** public functions ****************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -299,6 +327,151 @@ mc_search_run (mc_search_t * lc_mc_search, const void *user_data,
     return ret;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/* Test many strings against one pattern.
+ *
+ * @param lc_mc_search search descriptor
+ * @param count number of strings
+ * @param get_str function that returns string with specified index and its length.
+ *        If it returns NULL, string is skipped
+ * @param user_data data for #get_str
+ * @param found number of matched strings. May be NULL
+ *
+ * @return bitmap of MC_SEARCH_BITMAP_SIZE(count) bytes, bit is set for every matched string.
+ *         Use MC_SEARCH_BITMAP_TEST() to check it and g_free() to free it.
+ *         NULL if nothing was tested.
+ */
+
+guint8 *
+mc_search_run_batch (mc_search_t * lc_mc_search, gsize count, mc_search_get_str_fn get_str,
+                     gpointer user_data, gsize * found)
+{
+    guint8 *bitmap;
+    gboolean direct;
+    gsize i, n = 0;
+
+    if (found != NULL)
+        *found = 0;
+
+    if (lc_mc_search == NULL || count == 0 || !mc_search_is_type_avail (lc_mc_search->search_type))
+        return NULL;
+
+    if (lc_mc_search->conditions == NULL && !mc_search_prepare (lc_mc_search))
+        return NULL;
+
+    /* single-line strings are matched by regex directly, without per-string allocations */
+    direct = (lc_mc_search->search_type == MC_SEARCH_T_REGEX
+              || lc_mc_search->search_type == MC_SEARCH_T_GLOB) && lc_mc_search->search_fn == NULL;
+
+    bitmap = g_new0 (guint8, MC_SEARCH_BITMAP_SIZE (count));
+
+    for (i = 0; i < count; i++)
+    {
+        const char *str;
+        gsize len = 0;
+        gboolean ret;
+
+        str = get_str (i, &len, user_data);
+        if (str == NULL)
+            continue;
+
+        if (direct && memchr (str, '\n', len) == NULL)
+            ret = mc_search__match_regex_str (lc_mc_search, str, len);
+        else
+            ret = mc_search_run (lc_mc_search, str, 0, len, NULL);
+
+        if (ret)
+        {
+            bitmap[i >> 3] |= 1 << (i & 7);
+            n++;
+        }
+        else if (lc_mc_search->error == MC_SEARCH_E_REGEX)
+            break;
+    }
+
+    if (found != NULL)
+        *found = n;
+
+    return bitmap;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/* Get compiled pattern from cache. Pattern is compiled and added to cache at first request.
+ *
+ * @param pattern string to search
+ * @param pattern_charset charset of #pattern. If NULL then cp_display will be used
+ * @param type search type
+ * @param flags search flags
+ *
+ * @return search descriptor owned by cache. It is valid until next call of mc_search_cache_get()
+ *         or mc_search_cache_free(). NULL if pattern is empty or cannot be compiled.
+ */
+
+mc_search_t *
+mc_search_cache_get (const gchar * pattern, const gchar * pattern_charset, mc_search_type_t type,
+                     mc_search_flags_t flags)
+{
+    const gchar *charset = pattern_charset;
+    mc_search_t *lc_mc_search;
+    GList *l;
+
+    if (pattern == NULL || *pattern == '\0')
+        return NULL;
+
+#ifdef HAVE_CHARSET
+    if (charset == NULL || *charset == '\0')
+        charset = cp_display;
+#endif
+
+    if (mc_search_cache == NULL)
+        mc_search_cache = g_queue_new ();
+
+    for (l = mc_search_cache->head; l != NULL; l = g_list_next (l))
+        if (mc_search__cache_match ((mc_search_t *) l->data, pattern, charset, type, flags))
+        {
+            if (l != mc_search_cache->head)
+            {
+                g_queue_unlink (mc_search_cache, l);
+                g_queue_push_head_link (mc_search_cache, l);
+            }
+            return (mc_search_t *) l->data;
+        }
+
+    lc_mc_search = mc_search_new (pattern, -1, charset);
+    lc_mc_search->search_type = type;
+    lc_mc_search->is_case_sensitive = (flags & MC_SEARCH_F_CASE_SENSITIVE) != 0;
+    lc_mc_search->is_entire_line = (flags & MC_SEARCH_F_ENTIRE_LINE) != 0;
+    lc_mc_search->whole_words = (flags & MC_SEARCH_F_WHOLE_WORDS) != 0;
+
+    if (!mc_search_is_type_avail (type) || !mc_search_prepare (lc_mc_search))
+    {
+        mc_search_free (lc_mc_search);
+        return NULL;
+    }
+
+    if (g_queue_get_length (mc_search_cache) >= MC_SEARCH_CACHE_SIZE)
+        mc_search_free ((mc_search_t *) g_queue_pop_tail (mc_search_cache));
+
+    g_queue_push_head (mc_search_cache, lc_mc_search);
+
+    return lc_mc_search;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+mc_search_cache_free (void)
+{
+    if (mc_search_cache == NULL)
+        return;
+
+    while (!g_queue_is_empty (mc_search_cache))
+        mc_search_free ((mc_search_t *) g_queue_pop_head (mc_search_cache));
+
+    g_queue_free (mc_search_cache);
+    mc_search_cache = NULL;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 gboolean
@@ -409,25 +582,21 @@ gboolean
 mc_search (const gchar * pattern, const gchar * pattern_charset, const gchar * str,
            mc_search_type_t type)
 {
-    gboolean ret;
     mc_search_t *search;
+    mc_search_flags_t flags = MC_SEARCH_F_CASE_SENSITIVE;
 
     if (str == NULL)
         return FALSE;
 
-    search = mc_search_new (pattern, -1, pattern_charset);
+    if (type == MC_SEARCH_T_GLOB)
+        flags |= MC_SEARCH_F_ENTIRE_LINE;
+
+    /* same patterns are tested against many strings: don't compile them every time */
+    search = mc_search_cache_get (pattern, pattern_charset, type, flags);
     if (search == NULL)
         return FALSE;
 
-    search->search_type = type;
-    search->is_case_sensitive = TRUE;
-
-    if (type == MC_SEARCH_T_GLOB)
-        search->is_entire_line = TRUE;
-
-    ret = mc_search_run (search, str, 0, strlen (str), NULL);
-    mc_search_free (search);
-    return ret;
+    return mc_search_run (search, str, 0, strlen (str), NULL);
 }
 
 /* --------------------------------------------------------------------------------------------- */
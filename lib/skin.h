@@ -133,6 +133,9 @@ gboolean mc_skin_init (const gchar * skin_override, GError ** error);
 void mc_skin_deinit (void);
 
 int mc_skin_color_get (const gchar *, const gchar *);
+int mc_skin_color_intern (const gchar * group, const gchar * name);
+int mc_skin_color_get_by_id (int id);
+void mc_skin_color_ids_free (void);
 
 void mc_skin_lines_parse_ini_file (mc_skin_t *);
 
@@ -41,8 +41,112 @@ int mc_skin_color__cache[MC_SKIN_COLOR_CACHE_COUNT];
 
 /*** file scope type declarations ****************************************************************/
 
+typedef struct
+{
+    const char *group;
+    const char *name;
+} mc_skin_color_name_t;
+
+/* Interned color which isn't in mc_skin_color__cache */
+typedef struct
+{
+    gchar *group;
+    gchar *name;
+    int pair_index;
+} mc_skin_color_id_t;
+
 /*** file scope variables ************************************************************************/
 
+/* Skin colors of mc_skin_color__cache. Index in this table is color ID and cache index. */
+/* *INDENT-OFF* */
+static const mc_skin_color_name_t mc_skin_color_cached_names[MC_SKIN_COLOR_CACHE_COUNT] =
+{
+    { "skin", "terminal_default_color" },       /* DEFAULT_COLOR */
+    { "core", "_default_" },                    /* NORMAL_COLOR */
+    { "core", "marked" },                       /* MARKED_COLOR */
+    { "core", "selected" },                     /* SELECTED_COLOR */
+    { "core", "markselect" },                   /* MARKED_SELECTED_COLOR */
+    { "core", "disabled" },                     /* DISABLED_COLOR */
+    { "core", "reverse" },                      /* REVERSE_COLOR */
+    { "core", "commandlinemark" },              /* COMMAND_MARK_COLOR */
+    { "core", "header" },                       /* HEADER_COLOR */
+
+    { "dialog", "_default_" },                  /* COLOR_NORMAL */
+    { "dialog", "dfocus" },                     /* COLOR_FOCUS */
+    { "dialog", "dhotnormal" },                 /* COLOR_HOT_NORMAL */
+    { "dialog", "dhotfocus" },                  /* COLOR_HOT_FOCUS */
+    { "dialog", "dtitle" },                     /* COLOR_TITLE */
+
+    { "error", "_default_" },                   /* ERROR_COLOR */
+    { "error", "errdfocus" },                   /* ERROR_FOCUS */
+    { "error", "errdhotnormal" },               /* ERROR_HOT_NORMAL */
+    { "error", "errdhotfocus" },                /* ERROR_HOT_FOCUS */
+    { "error", "errdtitle" },                   /* ERROR_TITLE */
+
+    { "menu", "_default_" },                    /* MENU_ENTRY_COLOR */
+    { "menu", "menusel" },                      /* MENU_SELECTED_COLOR */
+    { "menu", "menuhot" },                      /* MENU_HOT_COLOR */
+    { "menu", "menuhotsel" },                   /* MENU_HOTSEL_COLOR */
+    { "menu", "menuinactive" },                 /* MENU_INACTIVE_COLOR */
+
+    { "popupmenu", "_default_" },               /* PMENU_ENTRY_COLOR */
+    { "popupmenu", "menusel" },                 /* PMENU_SELECTED_COLOR */
+    { NULL, NULL },                             /* PMENU_HOT_COLOR: not implemented yet */
+    { NULL, NULL },                             /* PMENU_HOTSEL_COLOR: not implemented yet */
+    { "popupmenu", "menutitle" },               /* PMENU_TITLE_COLOR */
+
+    { "buttonbar", "hotkey" },                  /* BUTTONBAR_HOTKEY_COLOR */
+    { "buttonbar", "button" },                  /* BUTTONBAR_BUTTON_COLOR */
+
+    { "statusbar", "_default_" },               /* STATUSBAR_COLOR */
+
+    { "core", "gauge" },                        /* GAUGE_COLOR */
+    { "core", "input" },                        /* INPUT_COLOR */
+    { "core", "inputunchanged" },               /* INPUT_UNCHANGED_COLOR */
+    { "core", "inputmark" },                    /* INPUT_MARK_COLOR */
+    { "core", "inputhistory" },                 /* INPUT_HISTORY_COLOR */
+    { "core", "commandhistory" },               /* COMMAND_HISTORY_COLOR */
+
+    { "help", "_default_" },                    /* HELP_NORMAL_COLOR */
+    { "help", "helpitalic" },                   /* HELP_ITALIC_COLOR */
+    { "help", "helpbold" },                     /* HELP_BOLD_COLOR */
+    { "help", "helplink" },                     /* HELP_LINK_COLOR */
+    { "help", "helpslink" },                    /* HELP_SLINK_COLOR */
+    { "help", "helptitle" },                    /* HELP_TITLE_COLOR */
+
+    { "viewer", "_default_" },                  /* VIEW_NORMAL_COLOR */
+    { "viewer", "viewbold" },                   /* VIEW_BOLD_COLOR */
+    { "viewer", "viewunderline" },              /* VIEW_UNDERLINED_COLOR */
+    { "viewer", "viewselected" },               /* VIEW_SELECTED_COLOR */
+
+    { "editor", "_default_" },                  /* EDITOR_NORMAL_COLOR */
+    { "editor", "editbold" },                   /* EDITOR_BOLD_COLOR */
+    { "editor", "editmarked" },                 /* EDITOR_MARKED_COLOR */
+    { "editor", "editwhitespace" },             /* EDITOR_WHITESPACE_COLOR */
+    { "editor", "editrightmargin" },            /* EDITOR_RIGHT_MARGIN_COLOR */
+    { "editor", "editbg" },                     /* EDITOR_BACKGROUND */
+    { "editor", "editframe" },                  /* EDITOR_FRAME */
+    { "editor", "editframeactive" },            /* EDITOR_FRAME_ACTIVE */
+    { "editor", "editframedrag" },              /* EDITOR_FRAME_DRAG */
+    { "editor", "editlinestate" },              /* LINE_STATE_COLOR */
+    { "editor", "bookmark" },                   /* BOOK_MARK_COLOR */
+    { "editor", "bookmarkfound" },              /* BOOK_MARK_FOUND_COLOR */
+
+    { "diffviewer", "added" },                  /* DFF_ADD_COLOR */
+    { "diffviewer", "changedline" },            /* DFF_CHG_COLOR */
+    { "diffviewer", "changednew" },             /* DFF_CHH_COLOR */
+    { "diffviewer", "changed" },                /* DFF_CHD_COLOR */
+    { "diffviewer", "removed" },                /* DFF_DEL_COLOR */
+    { "diffviewer", "error" }                   /* DFF_ERROR_COLOR */
+};
+/* *INDENT-ON* */
+
+/* color ID by "group.name" */
+static GHashTable *mc_skin_color__ids = NULL;
+
+/* interned colors with IDs starting from MC_SKIN_COLOR_CACHE_COUNT */
+static GArray *mc_skin_color__interned = NULL;
+
 /*** file scope functions ************************************************************************/
 
 static mc_skin_color_t *
@@ -182,82 +286,56 @@ mc_skin_color_set_default_for_terminal (mc_skin_t * mc_skin)
 static void
 mc_skin_color_cache_init (void)
 {
-    DEFAULT_COLOR = mc_skin_color_get ("skin", "terminal_default_color");
-    NORMAL_COLOR = mc_skin_color_get ("core", "_default_");
-    MARKED_COLOR = mc_skin_color_get ("core", "marked");
-    SELECTED_COLOR = mc_skin_color_get ("core", "selected");
-    MARKED_SELECTED_COLOR = mc_skin_color_get ("core", "markselect");
-    DISABLED_COLOR = mc_skin_color_get ("core", "disabled");
-    REVERSE_COLOR = mc_skin_color_get ("core", "reverse");
-    HEADER_COLOR = mc_skin_color_get ("core", "header");
-    COMMAND_MARK_COLOR = mc_skin_color_get ("core", "commandlinemark");
-
-    COLOR_NORMAL = mc_skin_color_get ("dialog", "_default_");
-    COLOR_FOCUS = mc_skin_color_get ("dialog", "dfocus");
-    COLOR_HOT_NORMAL = mc_skin_color_get ("dialog", "dhotnormal");
-    COLOR_HOT_FOCUS = mc_skin_color_get ("dialog", "dhotfocus");
-    COLOR_TITLE = mc_skin_color_get ("dialog", "dtitle");
-
-    ERROR_COLOR = mc_skin_color_get ("error", "_default_");
-    ERROR_FOCUS = mc_skin_color_get ("error", "errdfocus");
-    ERROR_HOT_NORMAL = mc_skin_color_get ("error", "errdhotnormal");
-    ERROR_HOT_FOCUS = mc_skin_color_get ("error", "errdhotfocus");
-    ERROR_TITLE = mc_skin_color_get ("error", "errdtitle");
-
-    MENU_ENTRY_COLOR = mc_skin_color_get ("menu", "_default_");
-    MENU_SELECTED_COLOR = mc_skin_color_get ("menu", "menusel");
-    MENU_HOT_COLOR = mc_skin_color_get ("menu", "menuhot");
-    MENU_HOTSEL_COLOR = mc_skin_color_get ("menu", "menuhotsel");
-    MENU_INACTIVE_COLOR = mc_skin_color_get ("menu", "menuinactive");
-
-    PMENU_ENTRY_COLOR = mc_skin_color_get ("popupmenu", "_default_");
-    PMENU_SELECTED_COLOR = mc_skin_color_get ("popupmenu", "menusel");
-    PMENU_TITLE_COLOR = mc_skin_color_get ("popupmenu", "menutitle");
-
-    BUTTONBAR_HOTKEY_COLOR = mc_skin_color_get ("buttonbar", "hotkey");
-    BUTTONBAR_BUTTON_COLOR = mc_skin_color_get ("buttonbar", "button");
-
-    STATUSBAR_COLOR = mc_skin_color_get ("statusbar", "_default_");
-
-    GAUGE_COLOR = mc_skin_color_get ("core", "gauge");
-    INPUT_COLOR = mc_skin_color_get ("core", "input");
-    INPUT_HISTORY_COLOR = mc_skin_color_get ("core", "inputhistory");
-    COMMAND_HISTORY_COLOR = mc_skin_color_get ("core", "commandhistory");
-    INPUT_MARK_COLOR = mc_skin_color_get ("core", "inputmark");
-    INPUT_UNCHANGED_COLOR = mc_skin_color_get ("core", "inputunchanged");
-
-    HELP_NORMAL_COLOR = mc_skin_color_get ("help", "_default_");
-    HELP_ITALIC_COLOR = mc_skin_color_get ("help", "helpitalic");
-    HELP_BOLD_COLOR = mc_skin_color_get ("help", "helpbold");
-    HELP_LINK_COLOR = mc_skin_color_get ("help", "helplink");
-    HELP_SLINK_COLOR = mc_skin_color_get ("help", "helpslink");
-    HELP_TITLE_COLOR = mc_skin_color_get ("help", "helptitle");
-
-    VIEW_NORMAL_COLOR = mc_skin_color_get ("viewer", "_default_");
-    VIEW_BOLD_COLOR = mc_skin_color_get ("viewer", "viewbold");
-    VIEW_UNDERLINED_COLOR = mc_skin_color_get ("viewer", "viewunderline");
-    VIEW_SELECTED_COLOR = mc_skin_color_get ("viewer", "viewselected");
-
-    EDITOR_NORMAL_COLOR = mc_skin_color_get ("editor", "_default_");
-    EDITOR_BOLD_COLOR = mc_skin_color_get ("editor", "editbold");
-    EDITOR_MARKED_COLOR = mc_skin_color_get ("editor", "editmarked");
-    EDITOR_WHITESPACE_COLOR = mc_skin_color_get ("editor", "editwhitespace");
-    EDITOR_RIGHT_MARGIN_COLOR = mc_skin_color_get ("editor", "editrightmargin");
-    LINE_STATE_COLOR = mc_skin_color_get ("editor", "editlinestate");
-    EDITOR_BACKGROUND = mc_skin_color_get ("editor", "editbg");
-    EDITOR_FRAME = mc_skin_color_get ("editor", "editframe");
-    EDITOR_FRAME_ACTIVE = mc_skin_color_get ("editor", "editframeactive");
-    EDITOR_FRAME_DRAG = mc_skin_color_get ("editor", "editframedrag");
-
-    BOOK_MARK_COLOR = mc_skin_color_get ("editor", "bookmark");
-    BOOK_MARK_FOUND_COLOR = mc_skin_color_get ("editor", "bookmarkfound");
-
-    DFF_ADD_COLOR = mc_skin_color_get ("diffviewer", "added");
-    DFF_CHG_COLOR = mc_skin_color_get ("diffviewer", "changedline");
-    DFF_CHH_COLOR = mc_skin_color_get ("diffviewer", "changednew");
-    DFF_CHD_COLOR = mc_skin_color_get ("diffviewer", "changed");
-    DFF_DEL_COLOR = mc_skin_color_get ("diffviewer", "removed");
-    DFF_ERROR_COLOR = mc_skin_color_get ("diffviewer", "error");
+    size_t i;
+
+    for (i = 0; i < MC_SKIN_COLOR_CACHE_COUNT; i++)
+    {
+        const mc_skin_color_name_t *c = &mc_skin_color_cached_names[i];
+
+        mc_skin_color__cache[i] = (c->group != NULL) ? mc_skin_color_get (c->group, c->name) : 0;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+mc_skin_color_ids_init (void)
+{
+    size_t i;
+
+    if (mc_skin_color__ids != NULL)
+        return;
+
+    mc_skin_color__ids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    mc_skin_color__interned = g_array_new (FALSE, FALSE, sizeof (mc_skin_color_id_t));
+
+    for (i = 0; i < MC_SKIN_COLOR_CACHE_COUNT; i++)
+    {
+        const mc_skin_color_name_t *c = &mc_skin_color_cached_names[i];
+
+        if (c->group != NULL)
+            g_hash_table_insert (mc_skin_color__ids, g_strdup_printf ("%s.%s", c->group, c->name),
+                                 GINT_TO_POINTER (i));
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Resolve all interned colors of current skin to color pairs. */
+
+static void
+mc_skin_color_ids_resolve (void)
+{
+    guint i;
+
+    mc_skin_color_cache_init ();
+
+    if (mc_skin_color__interned != NULL)
+        for (i = 0; i < mc_skin_color__interned->len; i++)
+        {
+            mc_skin_color_id_t *c = &g_array_index (mc_skin_color__interned, mc_skin_color_id_t, i);
+
+            c->pair_index = mc_skin_color_get (c->group, c->name);
+        }
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -338,7 +416,7 @@ mc_skin_color_parse_ini_file (mc_skin_t * mc_skin)
     }
     g_strfreev (orig_groups);
 
-    mc_skin_color_cache_init ();
+    mc_skin_color_ids_resolve ();
     return TRUE;
 }
 
@@ -355,3 +433,92 @@ mc_skin_color_get (const gchar * group, const gchar * name)
 }
 
 /* --------------------------------------------------------------------------------------------- */
+/**
+ * Get integer ID of skin color.
+ * ID doesn't change when skin is switched, so it can be resolved once and stored in widget.
+ * Colors of mc_skin_color__cache have IDs equal to their cache indexes.
+ *
+ * @param group skin section
+ * @param name key in skin section
+ *
+ * @return ID of color for mc_skin_color_get_by_id()
+ */
+
+int
+mc_skin_color_intern (const gchar * group, const gchar * name)
+{
+    gchar *kname;
+    gpointer id;
+    mc_skin_color_id_t c;
+
+    mc_skin_color_ids_init ();
+
+    kname = g_strdup_printf ("%s.%s", group, name);
+    if (g_hash_table_lookup_extended (mc_skin_color__ids, kname, NULL, &id))
+    {
+        g_free (kname);
+        return GPOINTER_TO_INT (id);
+    }
+
+    c.group = g_strdup (group);
+    c.name = g_strdup (name);
+    c.pair_index = (mc_skin__default.colors != NULL) ? mc_skin_color_get (group, name) : 0;
+    g_array_append_val (mc_skin_color__interned, c);
+
+    id = GINT_TO_POINTER (MC_SKIN_COLOR_CACHE_COUNT + mc_skin_color__interned->len - 1);
+    g_hash_table_insert (mc_skin_color__ids, kname, id);
+
+    return GPOINTER_TO_INT (id);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get color pair of skin color by its ID.
+ * Colors are resolved once when skin is loaded, so this is a lookup in array.
+ *
+ * @param id ID returned by mc_skin_color_intern()
+ *
+ * @return color pair index
+ */
+
+int
+mc_skin_color_get_by_id (int id)
+{
+    if (id >= 0 && id < MC_SKIN_COLOR_CACHE_COUNT)
+        return mc_skin_color__cache[id];
+
+    id -= MC_SKIN_COLOR_CACHE_COUNT;
+    if (mc_skin_color__interned == NULL || (guint) id >= mc_skin_color__interned->len)
+        return 0;
+
+    return g_array_index (mc_skin_color__interned, mc_skin_color_id_t, id).pair_index;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Free the table of interned colors. IDs got before are invalid after that.
+ */
+
+void
+mc_skin_color_ids_free (void)
+{
+    guint i;
+
+    if (mc_skin_color__ids == NULL)
+        return;
+
+    for (i = 0; i < mc_skin_color__interned->len; i++)
+    {
+        mc_skin_color_id_t *c = &g_array_index (mc_skin_color__interned, mc_skin_color_id_t, i);
+
+        g_free (c->group);
+        g_free (c->name);
+    }
+
+    g_array_free (mc_skin_color__interned, TRUE);
+    mc_skin_color__interned = NULL;
+    g_hash_table_destroy (mc_skin_color__ids);
+    mc_skin_color__ids = NULL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -37,6 +37,7 @@
 #include <config.h>
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "lib/global.h"
 #include "lib/strutil.h"
@@ -50,8 +51,50 @@ char *user_old_timeformat = NULL;       /* time format string for older dates */
 
 /*** file scope macro definitions ****************************************************************/
 
+#define TIMEFMT_BUF_LEN (MB_LEN_MAX * MAX_I18NTIMELENGTH + 1)
+
+/* space for expanded date parts of format in cache */
+#define TIMEFMT_TEXT_LEN 64
+
+/* max number of time conversions in splittable format */
+#define TIMEFMT_PIECES 8
+
+/* number of cached intervals of local time, must be power of 2 */
+#define TIMEFMT_SLOTS 128
+
+/* how often (in seconds) the time zone is checked for changes */
+#define TIMEFMT_ZONE_CHECK 60
+
+/* POSIX says the cutoff is 6 months old; approximate this by 6*30 days */
+#define TIMEFMT_OLD_AGE (6L * 30L * 24L * 60L * 60L)
+
+/* Allow a 1 hour slop factor for what is considered "the future",
+   to allow for NFS server/client clock disagreement */
+#define TIMEFMT_FUTURE_SLOP (60L * 60L)
+
 /*** file scope type declarations ****************************************************************/
 
+/* format split to date parts and time conversions */
+typedef struct
+{
+    char *format;               /* copy of source format string */
+    gboolean split;             /* FALSE if format has conversions we can't expand ourselves */
+    int count;                  /* number of pieces */
+    char *date[TIMEFMT_PIECES + 1];     /* date part of format before every time conversion */
+    char conv[TIMEFMT_PIECES + 1];      /* time conversion: H, M, S, k, R, T or '\0' */
+} timefmt_format_t;
+
+/* interval of time [start, end) within one day with constant UTC offset */
+typedef struct
+{
+    time_t start;
+    time_t end;
+    struct tm tm;               /* broken-down local time of start */
+    int expanded[2];            /* 0: not yet, 1: expanded, -1: failed */
+    char text[2][TIMEFMT_TEXT_LEN];     /* expanded date parts of recent and old formats */
+    unsigned char len[2][TIMEFMT_PIECES + 1];   /* lengths of expanded date parts */
+} timefmt_slot_t;
+
 /*** file scope variables ************************************************************************/
 
 /*
@@ -61,7 +104,395 @@ char *user_old_timeformat = NULL;       /* time format string for older dates */
  */
 static size_t i18n_timelength_cache = MAX_I18NTIMELENGTH + 1;
 
+/* recent and old formats */
+static timefmt_format_t timefmt_formats[2];
+
+static timefmt_slot_t timefmt_slots[TIMEFMT_SLOTS];
+
+/* state of time zone at the last check */
+static time_t timefmt_zone_checked = 0;
+static long timefmt_zone_offset = 0;
+static int timefmt_zone_isdst = -1;
+
 /*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+timefmt_cache_flush (void)
+{
+    size_t i;
+
+    for (i = 0; i < TIMEFMT_SLOTS; i++)
+        timefmt_slots[i].start = timefmt_slots[i].end = 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Split format to date parts which are the same during a day and time conversions
+ * which are expanded for every time.
+ */
+
+static void
+timefmt_compile (timefmt_format_t * f, const char *format)
+{
+    const char *p, *chunk;
+    int i;
+
+    for (i = 0; i < f->count; i++)
+        g_free (f->date[i]);
+    g_free (f->format);
+
+    f->format = g_strdup (format);
+    f->split = TRUE;
+    f->count = 0;
+
+    for (p = chunk = format; *p != '\0' && f->split; p++)
+    {
+        if (*p != '%')
+            continue;
+
+        p++;
+        if (*p == '\0')
+        {
+            /* incomplete conversion at the end */
+            f->split = FALSE;
+            break;
+        }
+
+        if (strchr ("HMSkRT", *p) != NULL)
+        {
+            if (f->count == TIMEFMT_PIECES)
+                f->split = FALSE;
+            else
+            {
+                f->date[f->count] = g_strndup (chunk, p - 1 - chunk);
+                f->conv[f->count] = *p;
+                f->count++;
+                chunk = p + 1;
+            }
+        }
+        /* time conversions depending on locale or with flags and modifiers */
+        else if (strchr ("IlpPrXcsEO_-0^#+", *p) != NULL || g_ascii_isdigit (*p))
+            f->split = FALSE;
+    }
+
+    if (f->split)
+    {
+        f->date[f->count] = g_strdup (chunk);
+        f->conv[f->count] = '\0';
+        f->count++;
+    }
+    else
+    {
+        for (i = 0; i < f->count; i++)
+            g_free (f->date[i]);
+        f->count = 0;
+    }
+
+    for (i = 0; i < TIMEFMT_SLOTS; i++)
+        timefmt_slots[i].expanded[f - timefmt_formats] = 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Get UTC offset of local time in seconds */
+
+static long
+timefmt_utc_offset (time_t t, const struct tm *lt)
+{
+    struct tm *gt;
+    long days;
+
+    gt = gmtime (&t);
+    if (gt == NULL)
+        return 0;
+
+    days = lt->tm_yday - gt->tm_yday;
+    if (lt->tm_year != gt->tm_year)
+        days = lt->tm_year < gt->tm_year ? -1 : 1;
+
+    return ((days * 24 + lt->tm_hour - gt->tm_hour) * 60 + lt->tm_min - gt->tm_min) * 60
+        + lt->tm_sec - gt->tm_sec;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Drop cached intervals if time zone was changed */
+
+static void
+timefmt_check_zone (time_t current_time)
+{
+    struct tm *lt, tm;
+    long offset;
+
+    if (timefmt_zone_isdst != -1 && current_time >= timefmt_zone_checked
+        && current_time < timefmt_zone_checked + TIMEFMT_ZONE_CHECK)
+        return;
+
+    timefmt_zone_checked = current_time;
+
+    lt = localtime (&current_time);
+    if (lt == NULL)
+        return;
+
+    tm = *lt;
+    offset = timefmt_utc_offset (current_time, &tm);
+
+    if (offset != timefmt_zone_offset || tm.tm_isdst != timefmt_zone_isdst)
+    {
+        timefmt_zone_offset = offset;
+        timefmt_zone_isdst = tm.tm_isdst;
+        timefmt_cache_flush ();
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Check that local time at t is the same day as in tm and has given time of day */
+
+static gboolean
+timefmt_check_time (time_t t, const struct tm *tm, int hour, int min, int sec)
+{
+    struct tm *lt;
+
+    lt = localtime (&t);
+
+    return (lt != NULL && lt->tm_year == tm->tm_year && lt->tm_yday == tm->tm_yday
+            && lt->tm_hour == hour && lt->tm_min == min && lt->tm_sec == sec
+            && lt->tm_isdst == tm->tm_isdst);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Put interval of local time containing 'when' to slot. The whole day is taken if UTC offset
+ * isn't changed during the day, otherwise the hour. On DST transition and leap second nothing
+ * is cached.
+ *
+ * @return TRUE if interval is cached
+ */
+
+static gboolean
+timefmt_fill_slot (timefmt_slot_t * slot, time_t when, const struct tm *tm)
+{
+    time_t start;
+
+    slot->start = slot->end = 0;
+    slot->expanded[0] = slot->expanded[1] = 0;
+
+    if (tm->tm_sec > 59)
+        return FALSE;
+
+    start = when - (tm->tm_hour * 60 + tm->tm_min) * 60 - tm->tm_sec;
+    if (timefmt_check_time (start, tm, 0, 0, 0)
+        && timefmt_check_time (start + 24 * 60 * 60 - 1, tm, 23, 59, 59))
+        slot->end = start + 24 * 60 * 60;
+    else
+    {
+        start = when - tm->tm_min * 60 - tm->tm_sec;
+        if (!timefmt_check_time (start, tm, tm->tm_hour, 0, 0)
+            || !timefmt_check_time (start + 60 * 60 - 1, tm, tm->tm_hour, 59, 59))
+            return FALSE;
+        slot->end = start + 60 * 60;
+    }
+
+    slot->start = start;
+    slot->tm = *tm;
+    slot->tm.tm_min = slot->tm.tm_sec = 0;
+    if (slot->end - start != 60 * 60)
+        slot->tm.tm_hour = 0;
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Convert time to broken-down local time using cached intervals.
+ *
+ * @param when time to convert
+ * @param tm result
+ * @param slot cached interval containing 'when' or NULL
+ *
+ * @return FALSE if time can't be converted
+ */
+
+static gboolean
+timefmt_localtime (time_t when, struct tm *tm, timefmt_slot_t ** slot)
+{
+    timefmt_slot_t *s;
+    struct tm *lt;
+    time_t day;
+
+    /* index is day in time zone at the last check */
+    day = (when + timefmt_zone_offset) / (24 * 60 * 60);
+    if (when + timefmt_zone_offset < 0)
+        day--;
+    s = &timefmt_slots[(size_t) day & (TIMEFMT_SLOTS - 1)];
+
+    if (when >= s->start && when < s->end)
+    {
+        long sec;
+
+        sec = (long) (when - s->start) + s->tm.tm_hour * 60 * 60;
+        *tm = s->tm;
+        tm->tm_hour = sec / (60 * 60);
+        tm->tm_min = sec / 60 % 60;
+        tm->tm_sec = sec % 60;
+        *slot = s;
+        return TRUE;
+    }
+
+    lt = localtime (&when);
+    if (lt == NULL)
+        return FALSE;
+
+    *tm = *lt;
+    *slot = timefmt_fill_slot (s, when, tm) ? s : NULL;
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Expand date parts of format once for cached interval */
+
+static gboolean
+timefmt_expand (timefmt_slot_t * slot, int k)
+{
+    const timefmt_format_t *f = &timefmt_formats[k];
+    size_t pos = 0;
+    int i;
+
+    if (slot->expanded[k] != 0)
+        return (slot->expanded[k] > 0);
+
+    slot->expanded[k] = -1;
+
+    for (i = 0; i < f->count; i++)
+    {
+        size_t n;
+
+        n = strftime (slot->text[k] + pos, sizeof (slot->text[k]) - pos, f->date[i], &slot->tm);
+        /* empty result is ambiguous, don't cache it */
+        if (n == 0 && f->date[i][0] != '\0')
+            return FALSE;
+
+        slot->len[k][i] = n;
+        pos += n;
+    }
+
+    slot->expanded[k] = 1;
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Print number 0..99 with two chars */
+
+static char *
+timefmt_put_2digits (char *buf, int n, char pad)
+{
+    buf[0] = (n < 10) ? pad : (char) ('0' + n / 10);
+    buf[1] = (char) ('0' + n % 10);
+    return buf + 2;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Print time conversion, return number of printed chars */
+
+static size_t
+timefmt_put_time (char *buf, char conv, const struct tm *tm)
+{
+    char *p = buf;
+
+    switch (conv)
+    {
+    case 'H':
+        p = timefmt_put_2digits (p, tm->tm_hour, '0');
+        break;
+    case 'M':
+        p = timefmt_put_2digits (p, tm->tm_min, '0');
+        break;
+    case 'S':
+        p = timefmt_put_2digits (p, tm->tm_sec, '0');
+        break;
+    case 'k':
+        p = timefmt_put_2digits (p, tm->tm_hour, ' ');
+        break;
+    case 'R':
+    case 'T':
+        p = timefmt_put_2digits (p, tm->tm_hour, '0');
+        *p++ = ':';
+        p = timefmt_put_2digits (p, tm->tm_min, '0');
+        if (conv == 'T')
+        {
+            *p++ = ':';
+            p = timefmt_put_2digits (p, tm->tm_sec, '0');
+        }
+        break;
+    default:
+        break;
+    }
+
+    return (size_t) (p - buf);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Format file time relative to current time. Local time is taken from the cache of
+ * day intervals, date parts of format are expanded once per interval.
+ */
+
+static const char *
+file_date_at (time_t when, time_t current_time)
+{
+    static char timebuf[TIMEFMT_BUF_LEN];
+    const char *fmt;
+    int k;
+    struct tm tm;
+    timefmt_slot_t *slot;
+
+    /* Show the year instead of the time of day for old and future files */
+    k = (current_time > when + TIMEFMT_OLD_AGE || current_time < when - TIMEFMT_FUTURE_SLOP) ? 1 : 0;
+    fmt = (k != 0) ? user_old_timeformat : user_recent_timeformat;
+
+    if (timefmt_formats[k].format == NULL || strcmp (timefmt_formats[k].format, fmt) != 0)
+        timefmt_compile (&timefmt_formats[k], fmt);
+
+    timefmt_check_zone (current_time);
+
+    if (!timefmt_localtime (when, &tm, &slot))
+    {
+        g_strlcpy (timebuf, INVALID_TIME_TEXT, sizeof (timebuf));
+        return timebuf;
+    }
+
+    if (slot != NULL && timefmt_formats[k].split && timefmt_expand (slot, k))
+    {
+        const timefmt_format_t *f = &timefmt_formats[k];
+        const char *text = slot->text[k];
+        size_t pos = 0;
+        int i;
+
+        for (i = 0; i < f->count; i++)
+        {
+            /* 8 is the longest time conversion */
+            if (pos + slot->len[k][i] + 8 >= sizeof (timebuf))
+                break;
+
+            memcpy (timebuf + pos, text, slot->len[k][i]);
+            pos += slot->len[k][i];
+            text += slot->len[k][i];
+            pos += timefmt_put_time (timebuf + pos, f->conv[i], &tm);
+        }
+
+        if (i == f->count)
+        {
+            timebuf[pos] = '\0';
+            return timebuf;
+        }
+    }
+
+    if (strftime (timebuf, sizeof (timebuf), fmt, &tm) == 0)
+        timebuf[0] = '\0';
+
+    return timebuf;
+}
+
+/* --------------------------------------------------------------------------------------------- */
 
 /*** public functions ****************************************************************************/
 
@@ -119,26 +550,7 @@ i18n_checktimelength (void)
 const char *
 file_date (time_t when)
 {
-    static char timebuf[MB_LEN_MAX * MAX_I18NTIMELENGTH + 1];
-    time_t current_time = time ((time_t) 0);
-    const char *fmt;
-
-    if (current_time > when + 6L * 30L * 24L * 60L * 60L        /* Old. */
-        || current_time < when - 60L * 60L)     /* In the future. */
-        /* The file is fairly old or in the future.
-           POSIX says the cutoff is 6 months old;
-           approximate this by 6*30 days.
-           Allow a 1 hour slop factor for what is considered "the future",
-           to allow for NFS server/client clock disagreement.
-           Show the year instead of the time of day.  */
-
-        fmt = user_old_timeformat;
-    else
-        fmt = user_recent_timeformat;
-
-    FMT_LOCALTIME (timebuf, sizeof (timebuf), fmt, when);
-
-    return timebuf;
+    return file_date_at (when, time (NULL));
 }
 
 /* --------------------------------------------------------------------------------------------- */
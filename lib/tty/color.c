@@ -59,58 +59,77 @@ gboolean use_colors = FALSE;
 
 /*** file scope variables ************************************************************************/
 
+/* allocated color pairs, keyed by (ifg, ibg, attr) */
 static GHashTable *mc_tty_color__hashtable = NULL;
 
+/* allocated color pairs by pair index, NULL for free index */
+static GPtrArray *mc_tty_color__pairs = NULL;
+
+/* no free pair index below this one */
+static size_t mc_tty_color__first_free = 0;
+
 /*** file scope functions ************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
 
-static gboolean
-tty_color_free_condition_cb (gpointer key, gpointer value, gpointer user_data)
+static guint
+tty_color_pair_hash (gconstpointer key)
 {
-    gboolean is_temp_color;
-    tty_color_pair_t *mc_color_pair;
-    (void) key;
+    const tty_color_pair_t *p = (const tty_color_pair_t *) key;
 
-    is_temp_color = user_data != NULL;
-    mc_color_pair = (tty_color_pair_t *) value;
-    return (mc_color_pair->is_temp == is_temp_color);
+    return ((guint) p->ifg * 31 + (guint) p->ibg) * 31 + (guint) p->attr;
 }
 
 /* --------------------------------------------------------------------------------------------- */
 
-static void
-tty_color_free_all (gboolean is_temp_color)
+static gboolean
+tty_color_pair_equal (gconstpointer a, gconstpointer b)
 {
-    g_hash_table_foreach_remove (mc_tty_color__hashtable, tty_color_free_condition_cb,
-                                 is_temp_color ? GSIZE_TO_POINTER (1) : NULL);
+    const tty_color_pair_t *pa = (const tty_color_pair_t *) a;
+    const tty_color_pair_t *pb = (const tty_color_pair_t *) b;
+
+    return pa->ifg == pb->ifg && pa->ibg == pb->ibg && pa->attr == pb->attr;
 }
 
 /* --------------------------------------------------------------------------------------------- */
 
 static gboolean
-tty_color_get_next_cpn_cb (gpointer key, gpointer value, gpointer user_data)
+tty_color_free_condition_cb (gpointer key, gpointer value, gpointer user_data)
 {
-    size_t cp;
+    gboolean is_temp_color;
     tty_color_pair_t *mc_color_pair;
     (void) key;
 
-    cp = GPOINTER_TO_SIZE (user_data);
+    is_temp_color = user_data != NULL;
     mc_color_pair = (tty_color_pair_t *) value;
+    if (mc_color_pair->is_temp != is_temp_color)
+        return FALSE;
+
+    g_ptr_array_index (mc_tty_color__pairs, mc_color_pair->pair_index) = NULL;
+    if (mc_color_pair->pair_index < mc_tty_color__first_free)
+        mc_tty_color__first_free = mc_color_pair->pair_index;
 
-    return (cp == mc_color_pair->pair_index);
+    return TRUE;
 }
 
 /* --------------------------------------------------------------------------------------------- */
 
+static void
+tty_color_free_all (gboolean is_temp_color)
+{
+    g_hash_table_foreach_remove (mc_tty_color__hashtable, tty_color_free_condition_cb,
+                                 is_temp_color ? GSIZE_TO_POINTER (1) : NULL);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Get the lowest free pair index. */
+
 static size_t
 tty_color_get_next__color_pair_number (void)
 {
-    size_t cp_count, cp;
+    size_t cp;
 
-    cp_count = g_hash_table_size (mc_tty_color__hashtable);
-    for (cp = 0; cp < cp_count; cp++)
-        if (g_hash_table_find (mc_tty_color__hashtable, tty_color_get_next_cpn_cb,
-                               GSIZE_TO_POINTER (cp)) == NULL)
+    for (cp = mc_tty_color__first_free; cp < mc_tty_color__pairs->len; cp++)
+        if (g_ptr_array_index (mc_tty_color__pairs, cp) == NULL)
             break;
 
     return cp;
@@ -124,7 +143,10 @@ void
 tty_init_colors (gboolean disable, gboolean force)
 {
     tty_color_init_lib (disable, force);
-    mc_tty_color__hashtable = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+    mc_tty_color__hashtable =
+        g_hash_table_new_full (tty_color_pair_hash, tty_color_pair_equal, NULL, g_free);
+    mc_tty_color__pairs = g_ptr_array_new ();
+    mc_tty_color__first_free = 0;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -138,6 +160,7 @@ tty_colors_done (void)
     g_free (tty_color_defaults__attrs);
 
     g_hash_table_destroy (mc_tty_color__hashtable);
+    g_ptr_array_free (mc_tty_color__pairs, TRUE);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -154,9 +177,8 @@ int
 tty_try_alloc_color_pair2 (const char *fg, const char *bg, const char *attrs,
                            gboolean is_temp_color)
 {
-    gchar *color_pair;
+    tty_color_pair_t key;
     tty_color_pair_t *mc_color_pair;
-    int ifg, ibg, attr;
 
     if (fg == NULL || !strcmp (fg, "base"))
         fg = tty_color_defaults__fg;
@@ -165,39 +187,34 @@ tty_try_alloc_color_pair2 (const char *fg, const char *bg, const char *attrs,
     if (attrs == NULL || !strcmp (attrs, "base"))
         attrs = tty_color_defaults__attrs;
 
-    ifg = tty_color_get_index_by_name (fg);
-    ibg = tty_color_get_index_by_name (bg);
-    attr = tty_attr_get_bits (attrs);
-
-    color_pair = g_strdup_printf ("%d.%d.%d", ifg, ibg, attr);
-    if (color_pair == NULL)
-        return 0;
-
-    mc_color_pair =
-        (tty_color_pair_t *) g_hash_table_lookup (mc_tty_color__hashtable, (gpointer) color_pair);
+    key.ifg = tty_color_get_index_by_name (fg);
+    key.ibg = tty_color_get_index_by_name (bg);
+    key.attr = tty_attr_get_bits (attrs);
 
+    mc_color_pair = (tty_color_pair_t *) g_hash_table_lookup (mc_tty_color__hashtable, &key);
     if (mc_color_pair != NULL)
-    {
-        g_free (color_pair);
         return mc_color_pair->pair_index;
-    }
 
     mc_color_pair = g_try_new0 (tty_color_pair_t, 1);
     if (mc_color_pair == NULL)
-    {
-        g_free (color_pair);
         return 0;
-    }
 
     mc_color_pair->is_temp = is_temp_color;
-    mc_color_pair->ifg = ifg;
-    mc_color_pair->ibg = ibg;
-    mc_color_pair->attr = attr;
+    mc_color_pair->ifg = key.ifg;
+    mc_color_pair->ibg = key.ibg;
+    mc_color_pair->attr = key.attr;
     mc_color_pair->pair_index = tty_color_get_next__color_pair_number ();
 
     tty_color_try_alloc_pair_lib (mc_color_pair);
 
-    g_hash_table_insert (mc_tty_color__hashtable, (gpointer) color_pair, (gpointer) mc_color_pair);
+    g_hash_table_insert (mc_tty_color__hashtable, (gpointer) mc_color_pair,
+                         (gpointer) mc_color_pair);
+
+    if (mc_color_pair->pair_index == mc_tty_color__pairs->len)
+        g_ptr_array_add (mc_tty_color__pairs, mc_color_pair);
+    else
+        g_ptr_array_index (mc_tty_color__pairs, mc_color_pair->pair_index) = mc_color_pair;
+    mc_tty_color__first_free = mc_color_pair->pair_index + 1;
 
     return mc_color_pair->pair_index;
 }
@@ -0,0 +1,760 @@
+/*
+   Waiting for terminal input, channels, timers and completions.
+
+   Copyright (C) 2014
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \file event.c
+ *  \brief Source: waiting for terminal input, channels, timers and completions
+ *
+ *  On Linux descriptors are waited for with epoll. They are registered once and stay
+ *  registered while the set of descriptors doesn't change, so the main loop doesn't rebuild
+ *  fd_set for every key press. Timeout is set with timerfd to keep microsecond precision
+ *  of select(). Other systems and descriptors that epoll refuses use select().
+ *
+ *  Background threads post completions with tty_post_completion(). The main thread is woken
+ *  up with eventfd (or a pipe) and runs the callbacks.
+ */
+
+#include <config.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#if defined (HAVE_SYS_EPOLL_H) && defined (HAVE_SYS_EVENTFD_H) && defined (HAVE_SYS_TIMERFD_H)
+#define EVENT_USE_EPOLL 1
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#endif
+
+#include "lib/global.h"
+
+#include "event.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+/* number of ready descriptors got with one epoll_wait() call */
+#define EVENT_EPOLL_MAX_EVENTS 32
+
+/*** file scope type declarations ****************************************************************/
+
+typedef struct
+{
+    guint id;
+    gint64 interval;
+    gint64 deadline;
+    tty_timer_fn callback;
+    void *data;
+} event_timer_t;
+
+typedef struct
+{
+    tty_completion_fn callback;
+    void *data;
+} event_completion_t;
+
+/*** file scope variables ************************************************************************/
+
+/* descriptors to wait for */
+static GArray *wait_fds = NULL;
+/* descriptors ready after the last wait */
+static GArray *ready_fds = NULL;
+
+/* read and write ends of wakeup channel, the same descriptor for eventfd */
+static int wakeup_fd[2] = { -1, -1 };
+
+/* posted completions in reverse order */
+static GSList *completions = NULL;
+#ifdef HAVE_GLIB_THREADS
+static GMutex completions_lock;
+#endif
+
+static GSList *timers = NULL;
+static guint last_timer_id = 0;
+
+#ifdef EVENT_USE_EPOLL
+static int epoll_fd = -1;
+static int timer_fd = -1;
+/* descriptors registered in epoll_fd, except timer_fd */
+static GArray *epoll_fds = NULL;
+#endif
+
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+fd_array_has (GArray * fds, int fd)
+{
+    guint i;
+
+    for (i = 0; i < fds->len; i++)
+        if (g_array_index (fds, int, i) == fd)
+            return TRUE;
+
+    return FALSE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+fd_array_remove (GArray * fds, int fd)
+{
+    guint i;
+
+    for (i = 0; i < fds->len; i++)
+        if (g_array_index (fds, int, i) == fd)
+        {
+            g_array_remove_index (fds, i);
+            break;
+        }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+event_init_arrays (void)
+{
+    if (wait_fds == NULL)
+    {
+        wait_fds = g_array_new (FALSE, FALSE, sizeof (int));
+        ready_fds = g_array_new (FALSE, FALSE, sizeof (int));
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+event_wakeup_init (void)
+{
+#ifdef EVENT_USE_EPOLL
+    wakeup_fd[0] = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeup_fd[0] != -1)
+    {
+        wakeup_fd[1] = wakeup_fd[0];
+        return;
+    }
+#endif
+
+    if (pipe (wakeup_fd) == 0)
+    {
+        int i;
+
+        for (i = 0; i < 2; i++)
+        {
+            fcntl (wakeup_fd[i], F_SETFL, fcntl (wakeup_fd[i], F_GETFL) | O_NONBLOCK);
+            fcntl (wakeup_fd[i], F_SETFD, FD_CLOEXEC);
+        }
+    }
+    else
+        wakeup_fd[0] = wakeup_fd[1] = -1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+event_wakeup (void)
+{
+    if (wakeup_fd[1] != -1)
+    {
+        ssize_t ret;
+
+        if (wakeup_fd[1] == wakeup_fd[0])
+        {
+            guint64 one = 1;
+
+            ret = write (wakeup_fd[1], &one, sizeof (one));
+        }
+        else
+            ret = write (wakeup_fd[1], "", 1);
+
+        /* full pipe is already enough to wake up */
+        (void) ret;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+event_wakeup_drain (void)
+{
+    char buf[64];
+
+    while (read (wakeup_fd[0], buf, sizeof (buf)) > 0)
+        ;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+event_run_completions (void)
+{
+    GSList *list, *l;
+    gboolean ran;
+
+#ifdef HAVE_GLIB_THREADS
+    g_mutex_lock (&completions_lock);
+#endif
+    list = completions;
+    completions = NULL;
+#ifdef HAVE_GLIB_THREADS
+    g_mutex_unlock (&completions_lock);
+#endif
+
+    ran = (list != NULL);
+    list = g_slist_reverse (list);
+
+    for (l = list; l != NULL; l = g_slist_next (l))
+    {
+        event_completion_t *c = (event_completion_t *) l->data;
+
+        c->callback (c->data);
+        g_free (c);
+    }
+
+    g_slist_free (list);
+
+    return ran;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static event_timer_t *
+event_next_timer (void)
+{
+    event_timer_t *next = NULL;
+    GSList *l;
+
+    for (l = timers; l != NULL; l = g_slist_next (l))
+    {
+        event_timer_t *t = (event_timer_t *) l->data;
+
+        if (next == NULL || t->deadline < next->deadline)
+            next = t;
+    }
+
+    return next;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+event_run_timers (void)
+{
+    gint64 now;
+
+    now = g_get_monotonic_time ();
+
+    while (TRUE)
+    {
+        event_timer_t *t;
+
+        t = event_next_timer ();
+        if (t == NULL || t->deadline > now)
+            break;
+
+        /* callback can delete the timer */
+        t->deadline = now + t->interval;
+        t->callback (t->data);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+event_select_wait (gint64 wait_time)
+{
+    fd_set select_set;
+    struct timeval time_out;
+    struct timeval *time_addr = NULL;
+    int top_fd = -1, ret;
+    guint i;
+
+    FD_ZERO (&select_set);
+    for (i = 0; i < wait_fds->len; i++)
+    {
+        int fd = g_array_index (wait_fds, int, i);
+
+        FD_SET (fd, &select_set);
+        top_fd = max (top_fd, fd);
+    }
+
+    if (wait_time >= 0)
+    {
+        time_out.tv_sec = wait_time / G_USEC_PER_SEC;
+        time_out.tv_usec = wait_time % G_USEC_PER_SEC;
+        time_addr = &time_out;
+    }
+
+    ret = select (top_fd + 1, &select_set, NULL, NULL, time_addr);
+
+    g_array_set_size (ready_fds, 0);
+    if (ret > 0)
+        for (i = 0; i < wait_fds->len; i++)
+        {
+            int fd = g_array_index (wait_fds, int, i);
+
+            if (FD_ISSET (fd, &select_set))
+                g_array_append_val (ready_fds, fd);
+        }
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef EVENT_USE_EPOLL
+/** Switch to select() for good */
+
+static void
+event_epoll_close (void)
+{
+    if (epoll_fd != -1)
+    {
+        close (epoll_fd);
+        epoll_fd = -1;
+    }
+
+    if (timer_fd != -1)
+    {
+        close (timer_fd);
+        timer_fd = -1;
+    }
+
+    if (epoll_fds != NULL)
+    {
+        g_array_free (epoll_fds, TRUE);
+        epoll_fds = NULL;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+event_epoll_init (void)
+{
+    struct epoll_event ev;
+
+    epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+    if (epoll_fd == -1)
+        return;
+
+    timer_fd = timerfd_create (CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+    memset (&ev, 0, sizeof (ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = timer_fd;
+
+    if (timer_fd == -1 || epoll_ctl (epoll_fd, EPOLL_CTL_ADD, timer_fd, &ev) != 0)
+    {
+        event_epoll_close ();
+        return;
+    }
+
+    epoll_fds = g_array_new (FALSE, FALSE, sizeof (int));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Make registered descriptors the same as wait_fds. Usually there is nothing to do. */
+
+static gboolean
+event_epoll_sync (void)
+{
+    guint i;
+
+    if (epoll_fds->len == wait_fds->len
+        && memcmp (epoll_fds->data, wait_fds->data, wait_fds->len * sizeof (int)) == 0)
+        return TRUE;
+
+    /* descriptor could be closed already */
+    for (i = 0; i < epoll_fds->len; i++)
+        epoll_ctl (epoll_fd, EPOLL_CTL_DEL, g_array_index (epoll_fds, int, i), NULL);
+    g_array_set_size (epoll_fds, 0);
+
+    for (i = 0; i < wait_fds->len; i++)
+    {
+        struct epoll_event ev;
+        int fd = g_array_index (wait_fds, int, i);
+
+        memset (&ev, 0, sizeof (ev));
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+
+        /* EPERM: regular files and some special ones can't be waited with epoll */
+        if (epoll_ctl (epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0 && errno != EEXIST)
+            return FALSE;
+
+        g_array_append_val (epoll_fds, fd);
+    }
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+event_epoll_wait (gint64 wait_time)
+{
+    struct epoll_event events[EVENT_EPOLL_MAX_EVENTS];
+    struct itimerspec its;
+    int timeout_ms = -1;
+    int ret, i, n = 0;
+
+    if (!event_epoll_sync ())
+    {
+        event_epoll_close ();
+        return event_select_wait (wait_time);
+    }
+
+    /* always rearm timer: it resets the expiration of the previous wait */
+    memset (&its, 0, sizeof (its));
+    if (wait_time == 0)
+        timeout_ms = 0;
+    else if (wait_time > 0)
+    {
+        its.it_value.tv_sec = wait_time / G_USEC_PER_SEC;
+        its.it_value.tv_nsec = (wait_time % G_USEC_PER_SEC) * 1000;
+    }
+
+    if (timerfd_settime (timer_fd, 0, &its, NULL) != 0 && wait_time > 0)
+        timeout_ms = (int) ((wait_time + 999) / 1000);
+
+    ret = epoll_wait (epoll_fd, events, EVENT_EPOLL_MAX_EVENTS, timeout_ms);
+
+    g_array_set_size (ready_fds, 0);
+    for (i = 0; i < ret; i++)
+    {
+        if (events[i].data.fd == timer_fd)
+        {
+            guint64 expirations;
+            ssize_t r;
+
+            r = read (timer_fd, &expirations, sizeof (expirations));
+            (void) r;
+        }
+        else
+        {
+            g_array_append_val (ready_fds, events[i].data.fd);
+            n++;
+        }
+    }
+
+    return (ret < 0) ? -1 : n;
+}
+#endif /* EVENT_USE_EPOLL */
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+void
+tty_event_init (void)
+{
+    event_init_arrays ();
+
+    if (wakeup_fd[0] == -1)
+        event_wakeup_init ();
+
+#ifdef EVENT_USE_EPOLL
+    if (epoll_fd == -1)
+        event_epoll_init ();
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+tty_event_done (void)
+{
+#ifdef EVENT_USE_EPOLL
+    event_epoll_close ();
+#endif
+
+    if (wakeup_fd[0] != -1)
+    {
+        close (wakeup_fd[0]);
+        if (wakeup_fd[1] != wakeup_fd[0])
+            close (wakeup_fd[1]);
+        wakeup_fd[0] = wakeup_fd[1] = -1;
+    }
+
+    g_slist_free_full (timers, g_free);
+    timers = NULL;
+
+    g_slist_free_full (completions, g_free);
+    completions = NULL;
+
+    if (wait_fds != NULL)
+    {
+        g_array_free (wait_fds, TRUE);
+        wait_fds = NULL;
+        g_array_free (ready_fds, TRUE);
+        ready_fds = NULL;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+gboolean
+tty_event_is_epoll (void)
+{
+#ifdef EVENT_USE_EPOLL
+    return (epoll_fd != -1);
+#else
+    return FALSE;
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+tty_event_reset (void)
+{
+    event_init_arrays ();
+
+    g_array_set_size (wait_fds, 0);
+    g_array_set_size (ready_fds, 0);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+tty_event_add_fd (int fd)
+{
+    event_init_arrays ();
+
+    if (fd >= 0 && !fd_array_has (wait_fds, fd))
+        g_array_append_val (wait_fds, fd);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+tty_event_remove_fd (int fd)
+{
+    event_init_arrays ();
+
+    fd_array_remove (wait_fds, fd);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Forget that descriptor is registered: it was closed and its number can be reused.
+ */
+
+void
+tty_event_forget_fd (int fd)
+{
+#ifdef EVENT_USE_EPOLL
+    if (epoll_fd != -1 && fd_array_has (epoll_fds, fd))
+    {
+        epoll_ctl (epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+        fd_array_remove (epoll_fds, fd);
+    }
+#else
+    (void) fd;
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Wait until some descriptor of the set is ready, timeout expires or completion is posted.
+ *
+ * @param timeout time to wait, NULL to wait infinitely
+ * @param completed if not NULL, idle timers and posted completions are run while waiting,
+ *                  TRUE is stored here if some completion was run
+ * @return number of ready descriptors, 0 if timeout expired or only completions were run,
+ *         -1 on error as select() does
+ */
+
+int
+tty_event_wait (struct timeval *timeout, gboolean * completed)
+{
+    gint64 end_time = -1;
+
+    event_init_arrays ();
+
+    if (timeout != NULL)
+        end_time = g_get_monotonic_time () + timeout->tv_sec * G_USEC_PER_SEC + timeout->tv_usec;
+
+    if (completed != NULL)
+    {
+        *completed = FALSE;
+        tty_event_add_fd (wakeup_fd[0]);
+    }
+
+    while (TRUE)
+    {
+        gint64 wait_time = -1;
+        gboolean by_timer = FALSE;
+        int ret;
+
+        if (end_time >= 0 || (completed != NULL && timers != NULL))
+        {
+            gint64 now;
+
+            now = g_get_monotonic_time ();
+
+            if (end_time >= 0)
+                wait_time = max (end_time - now, 0);
+
+            if (completed != NULL && timers != NULL)
+            {
+                gint64 timer_time;
+
+                timer_time = max (event_next_timer ()->deadline - now, 0);
+                if (wait_time < 0 || timer_time < wait_time)
+                {
+                    wait_time = timer_time;
+                    by_timer = TRUE;
+                }
+            }
+        }
+
+#ifdef EVENT_USE_EPOLL
+        if (epoll_fd != -1)
+            ret = event_epoll_wait (wait_time);
+        else
+#endif
+            ret = event_select_wait (wait_time);
+
+        if (ret < 0)
+            return ret;
+
+        if (completed != NULL)
+        {
+            event_run_timers ();
+
+            if (tty_event_is_ready (wakeup_fd[0]))
+            {
+                tty_event_clear_ready (wakeup_fd[0]);
+                ret--;
+                event_wakeup_drain ();
+                *completed = event_run_completions ();
+            }
+        }
+
+        if (ret != 0 || (completed != NULL && *completed))
+            return ret;
+
+        /* timeout of caller is expired */
+        if (wait_time >= 0 && !by_timer)
+            return 0;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+gboolean
+tty_event_is_ready (int fd)
+{
+    return (fd >= 0 && ready_fds != NULL && fd_array_has (ready_fds, fd));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+tty_event_clear_ready (int fd)
+{
+    if (ready_fds != NULL)
+        fd_array_remove (ready_fds, fd);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Post completion from any thread. Callback will be called in the main thread when it waits
+ * for events in tty_event_wait().
+ */
+
+void
+tty_post_completion (tty_completion_fn callback, void *data)
+{
+    event_completion_t *c;
+    gboolean was_empty;
+
+    c = g_new (event_completion_t, 1);
+    c->callback = callback;
+    c->data = data;
+
+#ifdef HAVE_GLIB_THREADS
+    g_mutex_lock (&completions_lock);
+#endif
+    was_empty = (completions == NULL);
+    completions = g_slist_prepend (completions, c);
+#ifdef HAVE_GLIB_THREADS
+    g_mutex_unlock (&completions_lock);
+#endif
+
+    /* main thread isn't woken up yet */
+    if (was_empty)
+        event_wakeup ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Add timer called every @interval microseconds while the main thread waits for events.
+ *
+ * @return identifier of timer for tty_delete_idle_timer()
+ */
+
+guint
+tty_add_idle_timer (gint64 interval, tty_timer_fn callback, void *data)
+{
+    event_timer_t *t;
+
+    g_return_val_if_fail (interval > 0, 0);
+
+    t = g_new (event_timer_t, 1);
+    t->id = ++last_timer_id;
+    t->interval = interval;
+    t->deadline = g_get_monotonic_time () + interval;
+    t->callback = callback;
+    t->data = data;
+
+    timers = g_slist_prepend (timers, t);
+
+    return t->id;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+tty_delete_idle_timer (guint id)
+{
+    GSList *l;
+
+    for (l = timers; l != NULL; l = g_slist_next (l))
+    {
+        event_timer_t *t = (event_timer_t *) l->data;
+
+        if (t->id == id)
+        {
+            timers = g_slist_delete_link (timers, l);
+            g_free (t);
+            break;
+        }
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,49 @@
+/** \file event.h
+ *  \brief Header: waiting for terminal input, channels, timers and completions
+ */
+
+#ifndef MC__TTY_EVENT_H
+#define MC__TTY_EVENT_H
+
+#include <sys/time.h>           /* struct timeval */
+
+#include "lib/global.h"         /* <glib.h> */
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+/* Callback of completion posted by background thread, called in the main thread */
+typedef void (*tty_completion_fn) (void *data);
+
+/* Callback of idle timer, called in the main thread while it waits for events */
+typedef void (*tty_timer_fn) (void *data);
+
+/*** enums ***************************************************************************************/
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+/*** global variables defined in .c file *********************************************************/
+
+/*** declarations of public functions ************************************************************/
+
+void tty_event_init (void);
+void tty_event_done (void);
+gboolean tty_event_is_epoll (void);
+
+/* Set of descriptors to wait for, it replaces fd_set and select() in key.c */
+void tty_event_reset (void);
+void tty_event_add_fd (int fd);
+void tty_event_remove_fd (int fd);
+void tty_event_forget_fd (int fd);
+int tty_event_wait (struct timeval *timeout, gboolean * completed);
+gboolean tty_event_is_ready (int fd);
+void tty_event_clear_ready (int fd);
+
+/* Can be called from any thread */
+void tty_post_completion (tty_completion_fn callback, void *data);
+
+guint tty_add_idle_timer (gint64 interval, tty_timer_fn callback, void *data);
+void tty_delete_idle_timer (guint id);
+
+/*** inline functions ****************************************************************************/
+
+#endif /* MC__TTY_EVENT_H */
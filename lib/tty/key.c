@@ -52,6 +52,7 @@
 #include "tty-internal.h"       /* mouse_enabled */
 #include "mouse.h"
 #include "key.h"
+#include "event.h"
 
 #include "lib/widget.h"         /* mc_refresh() */
 
@@ -550,30 +551,22 @@ static const key_code_name_t *key_conv_tab_sorted[G_N_ELEMENTS (key_name_conv_ta
 /*** file scope functions ************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
 
-static int
-add_selects (fd_set * select_set)
+static void
+add_selects (void)
 {
-    int top_fd = 0;
-
     if (disabled_channels == 0)
     {
         SelectList *p;
 
         for (p = select_list; p != NULL; p = p->next)
-        {
-            FD_SET (p->fd, select_set);
-            if (p->fd > top_fd)
-                top_fd = p->fd;
-        }
+            tty_event_add_fd (p->fd);
     }
-
-    return top_fd;
 }
 
 /* --------------------------------------------------------------------------------------------- */
 
 static void
-check_selects (fd_set * select_set)
+check_selects (void)
 {
     if (disabled_channels == 0)
     {
@@ -585,9 +578,9 @@ check_selects (fd_set * select_set)
 
             retry = FALSE;
             for (p = select_list; p; p = p->next)
-                if (FD_ISSET (p->fd, select_set))
+                if (tty_event_is_ready (p->fd))
                 {
-                    FD_CLR (p->fd, select_set);
+                    tty_event_clear_ready (p->fd);
                     (*p->callback) (p->fd, p->info);
                     retry = TRUE;
                     break;
@@ -604,16 +597,16 @@ static void
 try_channels (int set_timeout)
 {
     struct timeval time_out;
-    static fd_set select_set;
 
     while (1)
     {
         struct timeval *timeptr = NULL;
-        int maxfdp, v;
+        gboolean completed;
+        int v;
 
-        FD_ZERO (&select_set);
-        FD_SET (input_fd, &select_set); /* Add stdin */
-        maxfdp = max (add_selects (&select_set), input_fd);
+        tty_event_reset ();
+        tty_event_add_fd (input_fd);    /* Add stdin */
+        add_selects ();
 
         if (set_timeout)
         {
@@ -622,11 +615,12 @@ try_channels (int set_timeout)
             timeptr = &time_out;
         }
 
-        v = select (maxfdp + 1, &select_set, NULL, NULL, timeptr);
+        /* wait for the same descriptors as tty_get_event() does to keep them registered */
+        v = tty_event_wait (timeptr, &completed);
         if (v > 0)
         {
-            check_selects (&select_set);
-            if (FD_ISSET (input_fd, &select_set))
+            check_selects ();
+            if (tty_event_is_ready (input_fd))
                 break;
         }
     }
@@ -1331,6 +1325,8 @@ init_key (void)
     /* load some additional keys (e.g. direct Alt-? support) */
     load_xtra_key_defines ();
 
+    tty_event_init ();
+
 #ifdef __QNX__
     if ((term != NULL) && (strncmp (term, "qnx", 3) == 0))
     {
@@ -1381,6 +1377,7 @@ done_key (void)
 {
     k_dispose (keys);
     s_dispose (select_list);
+    tty_event_done ();
 
 #ifdef HAVE_TEXTMODE_X11_SUPPORT
     if (x11_display)
@@ -1401,6 +1398,9 @@ add_select_channel (int fd, select_fn callback, void *info)
     new->info = info;
     new->next = select_list;
     select_list = new;
+
+    /* descriptor number could be used by the closed one */
+    tty_event_forget_fd (fd);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -1412,6 +1412,8 @@ delete_select_channel (int fd)
     SelectList *p_prev = NULL;
     SelectList *p_next;
 
+    tty_event_forget_fd (fd);
+
     while (p != NULL)
         if (p->fd == fd)
         {
@@ -1945,7 +1947,7 @@ int
 tty_get_event (struct Gpm_Event *event, gboolean redo_event, gboolean block)
 {
     int c;
-    int flag = 0;               /* Return value from select */
+    int flag = 0;               /* Return value from tty_event_wait */
 #ifdef HAVE_LIBGPM
     static struct Gpm_Event ev; /* Mouse event */
 #endif
@@ -1977,27 +1979,22 @@ tty_get_event (struct Gpm_Event *event, gboolean redo_event, gboolean block)
     /* Repeat if using mouse */
     while (pending_keys == NULL)
     {
-        int nfd;
-        fd_set select_set;
+        gboolean completed;
 
-        FD_ZERO (&select_set);
-        FD_SET (input_fd, &select_set);
-        nfd = max (add_selects (&select_set), max (0, input_fd)) + 1;
+        tty_event_reset ();
+        tty_event_add_fd (input_fd);
+        add_selects ();
 
 #ifdef HAVE_LIBGPM
         if (mouse_enabled && (use_mouse_p == MOUSE_GPM))
         {
             if (gpm_fd >= 0)
-            {
-                FD_SET (gpm_fd, &select_set);
-                nfd = max (nfd, gpm_fd + 1);
-            }
+                tty_event_add_fd (gpm_fd);
             else
             {
                 if (mouse_fd >= 0)      /* error indicative */
                 {
-                    if (FD_ISSET (mouse_fd, &select_set))
-                        FD_CLR (mouse_fd, &select_set);
+                    tty_event_remove_fd (mouse_fd);
                     mouse_fd = gpm_fd;
                 }
                 /* gpm_fd == -2 means under some X terminal */
@@ -2046,12 +2043,16 @@ tty_get_event (struct Gpm_Event *event, gboolean redo_event, gboolean block)
         }
 
         tty_enable_interrupt_key ();
-        flag = select (nfd, &select_set, NULL, NULL, time_addr);
+        flag = tty_event_wait (time_addr, &completed);
         tty_disable_interrupt_key ();
 
-        /* select timed out: it could be for any of the following reasons:
+        /* completions of background jobs could change something on the screen */
+        if (completed)
+            return EV_NONE;
+
+        /* wait timed out: it could be for any of the following reasons:
          * redo_event -> it was because of the MOU_REPEAT handler
-         * !block     -> we did not block in the select call
+         * !block     -> we did not block in the wait call
          * else       -> 10 second timeout to check the vfs status.
          */
         if (flag == 0)
@@ -2065,16 +2066,16 @@ tty_get_event (struct Gpm_Event *event, gboolean redo_event, gboolean block)
         if (flag == -1 && errno == EINTR)
             return EV_NONE;
 
-        check_selects (&select_set);
+        check_selects ();
 
-        if (FD_ISSET (input_fd, &select_set))
+        if (tty_event_is_ready (input_fd))
             break;
 #ifdef HAVE_LIBGPM
         if (mouse_enabled && use_mouse_p == MOUSE_GPM)
         {
             if (gpm_fd >= 0)
             {
-                if (FD_ISSET (gpm_fd, &select_set))
+                if (tty_event_is_ready (gpm_fd))
                 {
                     int status;
 
@@ -2087,8 +2088,11 @@ tty_get_event (struct Gpm_Event *event, gboolean redo_event, gboolean block)
                     }
                     else if (status == 0)       /* connection closed; -1 == error */
                     {
-                        if (mouse_fd >= 0 && FD_ISSET (mouse_fd, &select_set))
-                            FD_CLR (mouse_fd, &select_set);
+                        if (mouse_fd >= 0)
+                            tty_event_clear_ready (mouse_fd);
+
+                        /* new connection can get the same descriptor */
+                        tty_event_forget_fd (gpm_fd);
 
                         /* Try to reopen gpm_mouse connection */
                         disable_mouse ();
@@ -2100,8 +2104,7 @@ tty_get_event (struct Gpm_Event *event, gboolean redo_event, gboolean block)
             {
                 if (mouse_fd >= 0)      /* error indicative */
                 {
-                    if (FD_ISSET (mouse_fd, &select_set))
-                        FD_CLR (mouse_fd, &select_set);
+                    tty_event_clear_ready (mouse_fd);
                     mouse_fd = gpm_fd;
                 }
                 /* gpm_fd == -2 means under some X terminal */
@@ -39,6 +39,7 @@ extern char *rmcup;
 char *mc_tty_normalize_from_utf8 (const char *);
 void tty_init_xterm_support (gboolean is_xterm);
 int tty_lowlevel_getch (void);
+void tty_print_nchars (const char *s, int bytes, int width);
 
 /*** inline functions ****************************************************************************/
 #endif /* MC_TTY_INTERNAL_H */
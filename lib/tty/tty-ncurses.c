@@ -596,6 +596,16 @@ tty_print_alt_char (int c, gboolean single)
     mc_curs_col++;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/** Print characters in the terminal encoding, all of them are on the screen */
+
+void
+tty_print_nchars (const char *s, int bytes, int width)
+{
+    addnstr (s, bytes);
+    mc_curs_col += width;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 void
@@ -704,6 +704,17 @@ tty_print_anychar (int c)
     }
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/** Print characters in the terminal encoding, all of them are on the screen */
+
+void
+tty_print_nchars (const char *s, int bytes, int width)
+{
+    (void) width;
+
+    SLsmg_write_nchars ((char *) s, (unsigned int) bytes);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 void
@@ -42,9 +42,11 @@
 
 #include "lib/global.h"
 #include "lib/strutil.h"
+#include "lib/util.h"           /* is_printable() */
 
 #include "tty.h"
 #include "tty-internal.h"
+#include "color.h"              /* tty_setcolor() */
 #include "mouse.h"              /* use_mouse_p */
 #include "win.h"
 
@@ -183,6 +185,89 @@ tty_print_one_vline (gboolean single)
     tty_print_alt_char (ACS_VLINE, single);
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Print row of character cells from the current cursor position.
+ *
+ * Adjacent cells of the same color are written as one string: one color change and one write
+ * per run instead of those per character as with tty_print_anychar().
+ *
+ * @param cells characters and their colors
+ * @param len number of cells
+ */
+
+void
+tty_print_cells (const tty_cell_t * cells, int len)
+{
+    char buf[BUF_1K];
+    int y, x;
+    int i = 0;
+
+    tty_getyx (&y, &x);
+
+    while (i < len)
+    {
+        int color, start;
+        int bytes = 0, width = 0;
+
+        color = cells[i].color;
+        if (color >= 0)
+            tty_setcolor (color);
+        else
+            tty_lowlevel_setcolor (-color);
+
+        /* Unicode character on 8-bit display is converted by tty_print_anychar() */
+        if (!mc_global.utf8_display && cells[i].ch > 255)
+        {
+            tty_print_anychar (cells[i].ch);
+            tty_getyx (&y, &x);
+            i++;
+            continue;
+        }
+
+        for (start = i; i < len && cells[i].color == color; i++)
+        {
+            int c = cells[i].ch;
+
+            if (bytes + UTF8_CHAR_LEN > (int) sizeof (buf))
+                break;
+
+            if (c <= 255 && !is_printable (c))
+                c = '.';
+
+            if (mc_global.utf8_display)
+            {
+                bytes += g_unichar_to_utf8 ((gunichar) c, buf + bytes);
+
+                if (g_unichar_iswide (c))
+                    width += 2;
+                else if (!g_unichar_iszerowidth (c))
+                    width++;
+            }
+            else if (c > 255)
+                break;
+            else
+            {
+                buf[bytes++] = (char) c;
+                width++;
+            }
+        }
+
+        if (y >= 0 && y < LINES && x >= 0 && x + width <= COLS)
+            tty_print_nchars (buf, bytes, width);
+        else
+        {
+            int j;
+
+            /* partially visible run is clipped by tty_print_anychar() */
+            for (j = start; j < i; j++)
+                tty_print_anychar (cells[j].ch);
+        }
+
+        x += width;
+    }
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 void
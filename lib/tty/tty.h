@@ -59,6 +59,13 @@ typedef enum
 
 /*** structures declarations (and typedefs of structures)*****************************************/
 
+/* Character cell for tty_print_cells() */
+typedef struct
+{
+    int ch;                     /* character as for tty_print_anychar() */
+    int color;                  /* color pair, negative one is set by tty_lowlevel_setcolor() */
+} tty_cell_t;
+
 /*** global variables defined in .c file *********************************************************/
 
 extern int mc_tty_frm[];
@@ -117,6 +124,7 @@ extern void tty_display_8bit (gboolean what);
 extern void tty_print_char (int c);
 extern void tty_print_alt_char (int c, gboolean single);
 extern void tty_print_anychar (int c);
+extern void tty_print_cells (const tty_cell_t * cells, int len);
 extern void tty_print_string (const char *s);
 extern void tty_printf (const char *s, ...);
 
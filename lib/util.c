@@ -571,6 +571,59 @@ string_perm (mode_t mode_bits)
     return mode;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/** Keep attributes of file shown in panels */
+
+void
+file_stat_from_stat (file_stat_t * fst, const struct stat *st)
+{
+    fst->size = st->st_size;
+    fst->ino = st->st_ino;
+    fst->dev = st->st_dev;
+#ifdef HAVE_STRUCT_STAT_ST_RDEV
+    fst->rdev = st->st_rdev;
+#else
+    fst->rdev = 0;
+#endif
+#ifdef HAVE_STRUCT_STAT_ST_BLOCKS
+    fst->blocks = st->st_blocks;
+#else
+    fst->blocks = 0;
+#endif
+    fst->mtime = st->st_mtime;
+    fst->atime = st->st_atime;
+    fst->ctime = st->st_ctime;
+    fst->nlink = st->st_nlink;
+    fst->uid = st->st_uid;
+    fst->gid = st->st_gid;
+    fst->mode = st->st_mode;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Make struct stat from kept attributes, the rest of fields is zeroed */
+
+void
+file_stat_to_stat (const file_stat_t * fst, struct stat *st)
+{
+    memset (st, 0, sizeof (*st));
+    st->st_size = fst->size;
+    st->st_ino = fst->ino;
+    st->st_dev = fst->dev;
+#ifdef HAVE_STRUCT_STAT_ST_RDEV
+    st->st_rdev = fst->rdev;
+#endif
+#ifdef HAVE_STRUCT_STAT_ST_BLOCKS
+    st->st_blocks = fst->blocks;
+#endif
+    st->st_mtime = fst->mtime;
+    st->st_atime = fst->atime;
+    st->st_ctime = fst->ctime;
+    st->st_nlink = fst->nlink;
+    st->st_uid = fst->uid;
+    st->st_gid = fst->gid;
+    st->st_mode = fst->mode;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 const char *
@@ -53,13 +53,30 @@ enum compression_type
 
 /*** structures declarations (and typedefs of structures)*****************************************/
 
+/* Attributes of file shown in panels: a part of struct stat */
+typedef struct
+{
+    off_t size;
+    ino_t ino;
+    dev_t dev;
+    dev_t rdev;                 /* device type for special files */
+    blkcnt_t blocks;
+    time_t mtime;
+    time_t atime;
+    time_t ctime;
+    nlink_t nlink;
+    uid_t uid;
+    gid_t gid;
+    mode_t mode;
+} file_stat_t;
+
 /* keys are set only during sorting */
 typedef struct
 {
     /* File attributes */
     size_t fnamelen;
-    char *fname;
-    struct stat st;
+    char *fname;                /* owned by string storage of directory list */
+    file_stat_t st;
     /* key used for comparing names */
     char *sort_key;
     /* key used for comparing extensions */
@@ -112,6 +129,8 @@ const char *size_trunc_sep (uintmax_t size, gboolean use_si);
  * Units: size units (0=bytes, 1=Kbytes, 2=Mbytes, etc.) */
 void size_trunc_len (char *buffer, unsigned int len, uintmax_t size, int units, gboolean use_si);
 const char *string_perm (mode_t mode_bits);
+void file_stat_from_stat (file_stat_t * fst, const struct stat *st);
+void file_stat_to_stat (const file_stat_t * fst, struct stat *st);
 
 const char *extension (const char *);
 const char *unix_error_string (int error_num);
@@ -137,7 +156,7 @@ char *load_mc_home_file (const char *from, const char *filename, char **allocate
 /* uid/gid managing */
 void init_groups (void);
 void destroy_groups (void);
-int get_user_permissions (struct stat *buf);
+int get_user_permissions (uid_t st_uid, gid_t st_gid);
 
 void init_uid_gid_cache (void);
 char *get_group (int);
@@ -1036,7 +1036,7 @@ mc_realpath (const char *path, char *resolved_path)
  */
 
 int
-get_user_permissions (struct stat *st)
+get_user_permissions (uid_t st_uid, gid_t st_gid)
 {
     static gboolean initialized = FALSE;
     static gid_t *groups;
@@ -1070,12 +1070,12 @@ get_user_permissions (struct stat *st)
         initialized = TRUE;
     }
 
-    if (st->st_uid == uid || uid == 0)
+    if (st_uid == uid || uid == 0)
         return 0;
 
     for (i = 0; i < ngroups; i++)
     {
-        if (st->st_gid == groups[i])
+        if (st_gid == groups[i])
             return 1;
     }
 
@@ -288,7 +288,8 @@ history_save (struct mc_config_t *cfg, const char *name, GList * h)
 char *
 history_show (GList ** history, Widget * widget, int current)
 {
-    GList *z, *hlist = NULL, *hi;
+    GList *z, *hlist = NULL;
+    int idx, len;
     size_t maxlen, count = 0;
     char *r = NULL;
     WDialog *query_dlg;
@@ -367,9 +368,9 @@ history_show (GList ** history, Widget * widget, int current)
 
     /* get modified history from dialog */
     z = NULL;
-    for (hi = listbox_get_first_link (query_list); hi != NULL; hi = g_list_next (hi))
+    for (idx = 0, len = listbox_get_length (query_list); idx < len; idx++)
     {
-        WLEntry *entry = LENTRY (hi->data);
+        WLEntry *entry = listbox_get_nth_item (query_list, idx);
 
         /* history is being reverted here again */
         z = g_list_prepend (z, entry->text);
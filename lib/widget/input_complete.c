@@ -102,6 +102,8 @@ static WInput *input;
 static int min_end;
 static int start = 0;
 static int end = 0;
+/* position of the first completion that matches the current input */
+static int first_match = 0;
 
 /*** file scope functions ************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -1045,23 +1047,19 @@ query_callback (Widget * w, Widget * sender, widget_msg_t msg, int parm, void *d
             {
                 int new_end;
                 int i;
-                GList *e;
 
                 new_end = str_get_prev_char (&input->buffer[end]) - input->buffer;
 
-                for (i = 0, e = listbox_get_first_link (LISTBOX (h->current->data));
-                     e != NULL; i++, e = g_list_next (e))
+                /* shorter prefix can match entries before current one: search from the top */
+                i = listbox_search_prefix (LISTBOX (h->current->data), input->buffer + start,
+                                           new_end - start, 0);
+                if (i >= 0)
                 {
-                    WLEntry *le = LENTRY (e->data);
-
-                    if (strncmp (input->buffer + start, le->text, new_end - start) == 0)
-                    {
-                        listbox_select_entry (LISTBOX (h->current->data), i);
-                        end = new_end;
-                        input_handle_char (input, parm);
-                        widget_redraw (WIDGET (h->current->data));
-                        break;
-                    }
+                    first_match = i;
+                    listbox_select_entry (LISTBOX (h->current->data), i);
+                    end = new_end;
+                    input_handle_char (input, parm);
+                    widget_redraw (WIDGET (h->current->data));
                 }
             }
             return MSG_HANDLED;
@@ -1084,7 +1082,7 @@ query_callback (Widget * w, Widget * sender, widget_msg_t msg, int parm, void *d
             else
             {
                 static char buff[MB_LEN_MAX] = "";
-                GList *e;
+                WListbox *l = LISTBOX (h->current->data);
                 int i;
                 int need_redraw = 0;
                 int low = 4096;
@@ -1101,18 +1099,22 @@ query_callback (Widget * w, Widget * sender, widget_msg_t msg, int parm, void *d
                     return MSG_HANDLED;
                 }
 
-                for (i = 0, e = listbox_get_first_link (LISTBOX (h->current->data));
-                     e != NULL; i++, e = g_list_next (e))
+                /* entries matching longer prefix can't be above the first one
+                   matching the current prefix */
+                for (i = listbox_search_prefix (l, input->buffer + start, end - start,
+                                                first_match);
+                     i >= 0;
+                     i = listbox_search_prefix (l, input->buffer + start, end - start, i + 1))
                 {
-                    WLEntry *le = LENTRY (e->data);
+                    WLEntry *le = listbox_get_nth_item (l, i);
 
-                    if (strncmp (input->buffer + start, le->text, end - start) == 0
-                        && strncmp (&le->text[end - start], buff, bl) == 0)
+                    if (strncmp (&le->text[end - start], buff, bl) == 0)
                     {
                         if (need_redraw == 0)
                         {
                             need_redraw = 1;
-                            listbox_select_entry (LISTBOX (h->current->data), i);
+                            first_match = i;
+                            listbox_select_entry (l, i);
                             last_text = le->text;
                         }
                         else
@@ -1253,6 +1255,7 @@ complete_engine (WInput * in, int what_to_do)
                 w = COLS;
             input = in;
             min_end = end;
+            first_match = 0;
             query_height = h;
             query_width = w;
             query_dlg = dlg_create (TRUE, y, x, query_height, query_width,
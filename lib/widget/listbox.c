@@ -35,6 +35,7 @@
 #include <config.h>
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "lib/global.h"
 
@@ -58,25 +59,67 @@ const global_keymap_t *listbox_map = NULL;
 
 /*** file scope functions ************************************************************************/
 
-static int
-listbox_entry_cmp (const void *a, const void *b, void *user_data)
+static void
+listbox_entry_free (void *data)
 {
-    const WLEntry *ea = (const WLEntry *) a;
-    const WLEntry *eb = (const WLEntry *) b;
+    WLEntry *e = data;
+    g_free (e->text);
+    g_free (e);
+}
 
-    (void) user_data;
+/* --------------------------------------------------------------------------------------------- */
 
-    return strcmp (ea->text, eb->text);
+static inline WLEntry *
+listbox_entry (const WListbox * l, int pos)
+{
+    return LENTRY (g_ptr_array_index (l->list, pos));
 }
 
 /* --------------------------------------------------------------------------------------------- */
+/** Insert entry into the list at the given position */
 
 static void
-listbox_entry_free (void *data)
+listbox_insert_at (WListbox * l, WLEntry * e, int pos)
 {
-    WLEntry *e = data;
-    g_free (e->text);
-    g_free (e);
+    int length;
+
+    length = (int) l->list->len;
+    pos = CLAMP (pos, 0, length);
+
+    g_ptr_array_add (l->list, e);
+    if (pos < length)
+    {
+        memmove (&l->list->pdata[pos + 1], &l->list->pdata[pos],
+                 (length - pos) * sizeof (gpointer));
+        l->list->pdata[pos] = e;
+    }
+
+    if (e->hotkey != 0)
+        l->hotkeys++;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find position to insert the entry to keep list sorted.
+ * Like g_queue_insert_sorted(), new entry is placed before the first entry that is not less.
+ */
+
+static int
+listbox_sorted_pos (const WListbox * l, const char *text)
+{
+    int lo = 0, hi = (int) l->list->len;
+
+    while (lo < hi)
+    {
+        int mid = lo + (hi - lo) / 2;
+
+        if (strcmp (listbox_entry (l, mid)->text, text) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -97,7 +140,7 @@ listbox_drawscroll (WListbox * l)
     else
         tty_print_char ('^');
 
-    length = g_queue_get_length (l->list);
+    length = listbox_get_length (l);
 
     /* Are we at the bottom? */
     widget_move (w, max_line, w->cols);
@@ -107,7 +150,7 @@ listbox_drawscroll (WListbox * l)
         tty_print_char ('v');
 
     /* Now draw the nice relative pointer */
-    if (!g_queue_is_empty (l->list))
+    if (length != 0)
         line = 1 + ((l->pos * (w->lines - 2)) / length);
 
     for (i = 1; i < max_line; i++)
@@ -137,20 +180,14 @@ listbox_draw (WListbox * l, gboolean focused)
             : h->color[DLG_COLOR_FOCUS];
     /* *INDENT-ON* */
 
-    int length = 0;
-    GList *le = NULL;
+    int length;
     int pos;
     int i;
     int sel_line = -1;
 
-    if (l->list != NULL)
-    {
-        length = g_queue_get_length (l->list);
-        le = g_queue_peek_nth_link (l->list, (guint) l->top);
-    }
-
-    /*    pos = (le == NULL) ? 0 : g_list_position (l->list, le); */
-    pos = (le == NULL) ? 0 : l->top;
+    length = listbox_get_length (l);
+    /* only visible entries are drawn */
+    pos = l->top;
 
     for (i = 0; i < w->lines; i++)
     {
@@ -167,12 +204,9 @@ listbox_draw (WListbox * l, gboolean focused)
 
         widget_move (l, i, 1);
 
-        if (l->list != NULL && le != NULL && (i == 0 || pos < length))
+        if (pos < length)
         {
-            WLEntry *e = LENTRY (le->data);
-
-            text = e->text;
-            le = g_list_next (le);
+            text = listbox_entry (l, pos)->text;
             pos++;
         }
 
@@ -193,18 +227,16 @@ listbox_draw (WListbox * l, gboolean focused)
 static int
 listbox_check_hotkey (WListbox * l, int key)
 {
-    if (!listbox_is_empty (l))
+    /* long lists (history, find results) usually have no hotkeys at all */
+    if (!listbox_is_empty (l) && l->hotkeys != 0)
     {
-        int i;
-        GList *le;
+        int i, length;
 
-        for (i = 0, le = g_queue_peek_head_link (l->list); le != NULL; i++, le = g_list_next (le))
-        {
-            WLEntry *e = LENTRY (le->data);
+        length = listbox_get_length (l);
 
-            if (e->hotkey == key)
+        for (i = 0; i < length; i++)
+            if (listbox_entry (l, i)->hotkey == key)
                 return i;
-        }
     }
 
     return (-1);
@@ -221,7 +253,7 @@ listbox_select_pos (WListbox * l, int base, int pos)
     base += pos;
 
     if (!listbox_is_empty (l))
-        last = g_queue_get_length (l->list) - 1;
+        last = listbox_get_length (l) - 1;
 
     base = min (base, last);
 
@@ -233,7 +265,7 @@ listbox_select_pos (WListbox * l, int base, int pos)
 static void
 listbox_fwd (WListbox * l)
 {
-    if ((guint) l->pos + 1 >= g_queue_get_length (l->list))
+    if (l->pos + 1 >= listbox_get_length (l))
         listbox_select_first (l);
     else
         listbox_select_entry (l, l->pos + 1);
@@ -260,7 +292,7 @@ listbox_execute_cmd (WListbox * l, unsigned long command)
     Widget *w = WIDGET (l);
     int length;
 
-    if (l->list == NULL || g_queue_is_empty (l->list))
+    if (listbox_is_empty (l))
         return MSG_NOT_HANDLED;
 
     switch (command)
@@ -282,7 +314,7 @@ listbox_execute_cmd (WListbox * l, unsigned long command)
             listbox_back (l);
         break;
     case CK_PageDown:
-        length = g_queue_get_length (l->list);
+        length = listbox_get_length (l);
         for (i = 0; i < w->lines - 1 && l->pos < length - 1; i++)
             listbox_fwd (l);
         break;
@@ -291,7 +323,7 @@ listbox_execute_cmd (WListbox * l, unsigned long command)
         {
             gboolean is_last, is_more;
 
-            length = g_queue_get_length (l->list);
+            length = listbox_get_length (l);
 
             is_last = (l->pos + 1 >= length);
             is_more = (l->top + w->lines >= length);
@@ -354,26 +386,26 @@ listbox_append_item (WListbox * l, WLEntry * e, listbox_append_t pos)
 {
     if (l->list == NULL)
     {
-        l->list = g_queue_new ();
+        l->list = g_ptr_array_new ();
         pos = LISTBOX_APPEND_AT_END;
     }
 
     switch (pos)
     {
     case LISTBOX_APPEND_AT_END:
-        g_queue_push_tail (l->list, e);
+        listbox_insert_at (l, e, (int) l->list->len);
         break;
 
     case LISTBOX_APPEND_BEFORE:
-        g_queue_insert_before (l->list, g_queue_peek_nth_link (l->list, (guint) l->pos), e);
+        listbox_insert_at (l, e, l->pos);
         break;
 
     case LISTBOX_APPEND_AFTER:
-        g_queue_insert_after (l->list, g_queue_peek_nth_link (l->list, (guint) l->pos), e);
+        listbox_insert_at (l, e, l->pos + 1);
         break;
 
     case LISTBOX_APPEND_SORTED:
-        g_queue_insert_sorted (l->list, e, (GCompareDataFunc) listbox_entry_cmp, NULL);
+        listbox_insert_at (l, e, listbox_sorted_pos (l, e->text));
         break;
 
     default:
@@ -556,6 +588,7 @@ listbox_new (int y, int x, int height, int width, gboolean deletable, lcback_fn
     widget_init (w, y, x, height, width, listbox_callback, listbox_event);
 
     l->list = NULL;
+    l->hotkeys = 0;
     l->top = l->pos = 0;
     l->deletable = deletable;
     l->callback = callback;
@@ -574,16 +607,46 @@ listbox_search_text (WListbox * l, const char *text)
 {
     if (!listbox_is_empty (l))
     {
-        int i;
-        GList *le;
+        int i, length;
 
-        for (i = 0, le = g_queue_peek_head_link (l->list); le != NULL; i++, le = g_list_next (le))
-        {
-            WLEntry *e = LENTRY (le->data);
+        length = listbox_get_length (l);
 
-            if (strcmp (e->text, text) == 0)
+        for (i = 0; i < length; i++)
+            if (strcmp (listbox_entry (l, i)->text, text) == 0)
+                return i;
+    }
+
+    return (-1);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find the first entry starting with the given prefix.
+ *
+ * Search is started from position @from. Any entry that starts with a longer prefix
+ * also starts with a shorter one, so type-ahead search can continue from the entry
+ * found for the previous prefix instead of the start of list.
+ *
+ * @param l WListbox object
+ * @param prefix text to search
+ * @param len length of prefix in bytes
+ * @param from position to start search from
+ *
+ * @return position of found entry or -1 if not found
+ */
+
+int
+listbox_search_prefix (const WListbox * l, const char *prefix, size_t len, int from)
+{
+    if (!listbox_is_empty (l))
+    {
+        int i, length;
+
+        length = listbox_get_length (l);
+
+        for (i = MAX (from, 0); i < length; i++)
+            if (strncmp (listbox_entry (l, i)->text, prefix, len) == 0)
                 return i;
-        }
     }
 
     return (-1);
@@ -605,10 +668,9 @@ void
 listbox_select_last (WListbox * l)
 {
     int lines = WIDGET (l)->lines;
-    int length = 0;
+    int length;
 
-    if (!listbox_is_empty (l))
-        length = g_queue_get_length (l->list);
+    length = listbox_get_length (l);
 
     l->pos = length > 0 ? length - 1 : 0;
     l->top = length > lines ? length - lines : 0;
@@ -619,37 +681,26 @@ listbox_select_last (WListbox * l)
 void
 listbox_select_entry (WListbox * l, int dest)
 {
-    GList *le;
-    int pos;
-    gboolean top_seen = FALSE;
-
     if (listbox_is_empty (l) || dest < 0)
         return;
 
-    /* Special case */
-    for (pos = 0, le = g_queue_peek_head_link (l->list); le != NULL; pos++, le = g_list_next (le))
+    if (dest >= listbox_get_length (l))
     {
-        if (pos == l->top)
-            top_seen = TRUE;
+        /* If we are unable to find it, set decent values */
+        l->pos = l->top = 0;
+        return;
+    }
 
-        if (pos == dest)
-        {
-            l->pos = dest;
-            if (!top_seen)
-                l->top = l->pos;
-            else
-            {
-                int lines = WIDGET (l)->lines;
+    l->pos = dest;
+    if (l->pos < l->top)
+        l->top = l->pos;
+    else
+    {
+        int lines = WIDGET (l)->lines;
 
-                if (l->pos - l->top >= lines)
-                    l->top = l->pos - lines + 1;
-            }
-            return;
-        }
+        if (l->pos - l->top >= lines)
+            l->top = l->pos - lines + 1;
     }
-
-    /* If we are unable to find it, set decent values */
-    l->pos = l->top = 0;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -678,24 +729,18 @@ listbox_get_current (WListbox * l, char **string, void **extra)
 WLEntry *
 listbox_get_nth_item (const WListbox * l, int pos)
 {
-    if (!listbox_is_empty (l) && pos >= 0)
-    {
-        GList *item;
-
-        item = g_queue_peek_nth_link (l->list, (guint) pos);
-        if (item != NULL)
-            return LENTRY (item->data);
-    }
+    if (pos >= 0 && pos < listbox_get_length (l))
+        return listbox_entry (l, pos);
 
     return NULL;
 }
 
 /* --------------------------------------------------------------------------------------------- */
 
-GList *
-listbox_get_first_link (const WListbox * l)
+int
+listbox_get_length (const WListbox * l)
 {
-    return (l == NULL || l->list == NULL) ? NULL : g_queue_peek_head_link (l->list);
+    return (l == NULL || l->list == NULL) ? 0 : (int) l->list->len;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -705,14 +750,15 @@ listbox_remove_current (WListbox * l)
 {
     if (!listbox_is_empty (l))
     {
-        GList *current;
+        WLEntry *current;
         int length;
 
-        current = g_queue_peek_nth_link (l->list, (guint) l->pos);
-        listbox_entry_free (LENTRY (current->data));
-        g_queue_delete_link (l->list, current);
+        current = LENTRY (g_ptr_array_remove_index (l->list, (guint) l->pos));
+        if (current->hotkey != 0)
+            l->hotkeys--;
+        listbox_entry_free (current);
 
-        length = g_queue_get_length (l->list);
+        length = listbox_get_length (l);
 
         if (length == 0)
             l->top = l->pos = 0;
@@ -726,7 +772,7 @@ listbox_remove_current (WListbox * l)
 gboolean
 listbox_is_empty (const WListbox * l)
 {
-    return (l == NULL || l->list == NULL || g_queue_is_empty (l->list));
+    return (l == NULL || l->list == NULL || l->list->len == 0);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -740,10 +786,10 @@ listbox_set_list (WListbox * l, GList * list)
     {
         GList *ll;
 
-        l->list = g_queue_new ();
+        l->list = g_ptr_array_sized_new (g_list_length (list));
 
         for (ll = list; ll != NULL; ll = g_list_next (ll))
-            g_queue_push_tail (l->list, ll->data);
+            listbox_insert_at (l, LENTRY (ll->data), (int) l->list->len);
 
         g_list_free (list);
     }
@@ -758,11 +804,12 @@ listbox_remove_list (WListbox * l)
     {
         if (l->list != NULL)
         {
-            g_queue_foreach (l->list, (GFunc) listbox_entry_free, NULL);
-            g_queue_free (l->list);
+            g_ptr_array_foreach (l->list, (GFunc) listbox_entry_free, NULL);
+            g_ptr_array_free (l->list, TRUE);
         }
 
         l->list = NULL;
+        l->hotkeys = 0;
         l->pos = l->top = 0;
     }
 }
@@ -45,7 +45,8 @@ typedef struct WLEntry
 typedef struct WListbox
 {
     Widget widget;
-    GQueue *list;               /* Pointer to the list of WLEntry */
+    GPtrArray *list;            /* Array of WLEntry */
+    int hotkeys;                /* Number of entries with hotkey */
     int pos;                    /* The current element displayed */
     int top;                    /* The first element displayed */
     gboolean allow_duplicates;  /* Do we allow duplicates on the list? */
@@ -63,12 +64,13 @@ extern const global_keymap_t *listbox_map;
 
 WListbox *listbox_new (int y, int x, int height, int width, gboolean deletable, lcback_fn callback);
 int listbox_search_text (WListbox * l, const char *text);
+int listbox_search_prefix (const WListbox * l, const char *prefix, size_t len, int from);
 void listbox_select_first (WListbox * l);
 void listbox_select_last (WListbox * l);
 void listbox_select_entry (WListbox * l, int dest);
 void listbox_get_current (WListbox * l, char **string, void **extra);
 WLEntry *listbox_get_nth_item (const WListbox * l, int pos);
-GList *listbox_get_first_link (const WListbox * l);
+int listbox_get_length (const WListbox * l);
 void listbox_remove_current (WListbox * l);
 gboolean listbox_is_empty (const WListbox * l);
 void listbox_set_list (WListbox * l, GList * list);
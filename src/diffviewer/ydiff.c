@@ -3536,7 +3536,7 @@ dview_diff_cmd (const void *f0, const void *f1)
             const WPanel *panel1 = (const WPanel *) f1;
 
             file0 = vfs_path_append_new (panel0->cwd_vpath, selection (panel0)->fname, NULL);
-            is_dir0 = S_ISDIR (selection (panel0)->st.st_mode);
+            is_dir0 = S_ISDIR (selection (panel0)->st.mode);
             if (is_dir0)
             {
                 message (D_ERROR, MSG_ERROR, _("\"%s\" is a directory"),
@@ -3545,7 +3545,7 @@ dview_diff_cmd (const void *f0, const void *f1)
             }
 
             file1 = vfs_path_append_new (panel1->cwd_vpath, selection (panel1)->fname, NULL);
-            is_dir1 = S_ISDIR (selection (panel1)->st.st_mode);
+            is_dir1 = S_ISDIR (selection (panel1)->st.mode);
             if (is_dir1)
             {
                 message (D_ERROR, MSG_ERROR, _("\"%s\" is a directory"),
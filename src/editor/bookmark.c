@@ -58,81 +58,176 @@
 /*** file scope functions ************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
 
-/** note, if there is more than one bookmark on a line, then they are
-   appended after each other and the last one is always the one found
-   by book_mark_found() i.e. last in is the one seen */
+/* Book marks are kept in a treap ordered by line number. Book marks on the same line are
+   ordered by time of insertion. The shift of line numbers is applied lazily: the shift of
+   a node is added to line numbers of all its descendants, so line number of any book mark is
+   its own line number plus shifts of all its ancestors. Therefore book marks after a line
+   are shifted in O(log n) when a line is inserted or deleted. */
 
-static edit_book_mark_t *
-double_marks (WEdit * edit, edit_book_mark_t * p)
+/* --------------------------------------------------------------------------------------------- */
+/** apply pending shift of node to its children */
+
+static void
+book_mark_push (edit_book_mark_t * p)
 {
-    (void) edit;
+    if (p->shift != 0)
+    {
+        if (p->left != NULL)
+        {
+            p->left->line += p->shift;
+            p->left->shift += p->shift;
+        }
+        if (p->right != NULL)
+        {
+            p->right->line += p->shift;
+            p->right->shift += p->shift;
+        }
+        p->shift = 0;
+    }
+}
 
-    if (p->next != NULL)
-        while (p->next->line == p->line)
-            p = p->next;
-    return p;
+/* --------------------------------------------------------------------------------------------- */
+/** split tree into book marks on or before @line and book marks after @line */
+
+static void
+book_mark_split (edit_book_mark_t * p, long line, edit_book_mark_t ** before,
+                 edit_book_mark_t ** after)
+{
+    if (p == NULL)
+    {
+        *before = NULL;
+        *after = NULL;
+        return;
+    }
+
+    book_mark_push (p);
+
+    if (p->line <= line)
+    {
+        *before = p;
+        book_mark_split (p->right, line, &p->right, after);
+    }
+    else
+    {
+        *after = p;
+        book_mark_split (p->left, line, before, &p->left);
+    }
 }
 
 /* --------------------------------------------------------------------------------------------- */
-/** returns the first bookmark on or before this line */
+/** join two trees: all book marks of @before are not after book marks of @after */
 
-edit_book_mark_t *
-book_mark_find (WEdit * edit, long line)
+static edit_book_mark_t *
+book_mark_merge (edit_book_mark_t * before, edit_book_mark_t * after)
 {
-    edit_book_mark_t *p;
+    if (before == NULL)
+        return after;
+    if (after == NULL)
+        return before;
 
-    if (edit->book_mark == NULL)
+    if (before->priority > after->priority)
     {
-        /* must have an imaginary top bookmark at line -1 to make things less complicated  */
-        edit->book_mark = g_new0 (edit_book_mark_t, 1);
-        edit->book_mark->line = -1;
-        return edit->book_mark;
+        book_mark_push (before);
+        before->right = book_mark_merge (before->right, after);
+        return before;
     }
 
-    for (p = edit->book_mark; p != NULL; p = p->next)
+    book_mark_push (after);
+    after->left = book_mark_merge (before, after->left);
+    return after;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** collect book marks in order, line numbers of collected book marks are absolute */
+
+static void
+book_mark_collect (edit_book_mark_t * p, GPtrArray * marks)
+{
+    if (p != NULL)
     {
-        if (p->line > line)
-            break;              /* gone past it going downward */
+        book_mark_push (p);
+        book_mark_collect (p->left, marks);
+        g_ptr_array_add (marks, p);
+        book_mark_collect (p->right, marks);
+    }
+}
 
-        if (p->next != NULL)
-        {
-            if (p->next->line > line)
-            {
-                edit->book_mark = p;
-                return double_marks (edit, p);
-            }
-        }
-        else
-        {
-            edit->book_mark = p;
-            return double_marks (edit, p);
-        }
+/* --------------------------------------------------------------------------------------------- */
+/** build tree from ordered book marks */
+
+static edit_book_mark_t *
+book_mark_build (GPtrArray * marks)
+{
+    edit_book_mark_t *root = NULL;
+    guint i;
+
+    for (i = 0; i < marks->len; i++)
+    {
+        edit_book_mark_t *p = (edit_book_mark_t *) g_ptr_array_index (marks, i);
+
+        p->left = p->right = NULL;
+        p->shift = 0;
+        root = book_mark_merge (root, p);
     }
 
-    for (p = edit->book_mark; p != NULL; p = p->prev)
+    return root;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+book_mark_free (edit_book_mark_t * p)
+{
+    if (p != NULL)
     {
-        if (p->next != NULL && p->next->line <= line)
-            break;              /* gone past it going upward */
+        book_mark_free (p->left);
+        book_mark_free (p->right);
+        g_free (p);
+    }
+}
 
-        if (p->line <= line)
-        {
-            if (p->next != NULL)
-            {
-                if (p->next->line > line)
-                {
-                    edit->book_mark = p;
-                    return double_marks (edit, p);
-                }
-            }
-            else
-            {
-                edit->book_mark = p;
-                return double_marks (edit, p);
-            }
-        }
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+book_mark_has_color (const edit_book_mark_t * p, long shift, long line, int c)
+{
+    while (p != NULL)
+    {
+        long l;
+
+        l = p->line + shift;
+        shift += p->shift;
+
+        if (l < line)
+            p = p->right;
+        else if (l > line)
+            p = p->left;
+        else
+            return (p->c == c || book_mark_has_color (p->left, shift, line, c)
+                    || book_mark_has_color (p->right, shift, line, c));
     }
 
-    return NULL;                /* can't get here */
+    return FALSE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** shift line numbers of book marks after this line */
+
+static void
+book_mark_shift (WEdit * edit, long line, long delta)
+{
+    edit_book_mark_t *before, *after;
+
+    if (edit->book_mark == NULL)
+        return;
+
+    book_mark_split (edit->book_mark, line, &before, &after);
+    if (after != NULL)
+    {
+        after->line += delta;
+        after->shift += delta;
+    }
+    edit->book_mark = book_mark_merge (before, after);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -151,53 +246,90 @@ book_mark_find (WEdit * edit, long line)
 gboolean
 book_mark_query_color (WEdit * edit, long line, int c)
 {
-    if (edit->book_mark != NULL)
+    return book_mark_has_color (edit->book_mark, 0, line, c);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find nearest book mark after this line
+ *
+ * @return line of book mark, -1 if there is no book marks after this line
+ */
+
+long
+book_mark_next (WEdit * edit, long line)
+{
+    const edit_book_mark_t *p = edit->book_mark;
+    long shift = 0, ret = -1;
+
+    while (p != NULL)
     {
-        edit_book_mark_t *p;
+        long l;
+
+        l = p->line + shift;
+        shift += p->shift;
 
-        for (p = book_mark_find (edit, line); p != NULL; p = p->prev)
+        if (l > line)
         {
-            if (p->line != line)
-                return FALSE;
-            if (p->c == c)
-                return TRUE;
+            ret = l;
+            p = p->left;
         }
+        else
+            p = p->right;
     }
 
-    return FALSE;
+    return ret;
 }
 
 /* --------------------------------------------------------------------------------------------- */
-/** insert a bookmark at this line */
+/**
+ * Find nearest book mark before this line
+ *
+ * @return line of book mark, -1 if there is no book marks before this line
+ */
 
-void
-book_mark_insert (WEdit * edit, long line, int c)
+long
+book_mark_prev (WEdit * edit, long line)
 {
-    edit_book_mark_t *p, *q;
+    const edit_book_mark_t *p = edit->book_mark;
+    long shift = 0, ret = -1;
 
-    p = book_mark_find (edit, line);
-#if 0
-    if (p->line == line)
+    while (p != NULL)
     {
-        /* already exists, so just change the color */
-        if (p->c != c)
+        long l;
+
+        l = p->line + shift;
+        shift += p->shift;
+
+        if (l < line)
         {
-            p->c = c;
-            edit->force |= REDRAW_LINE;
+            ret = l;
+            p = p->right;
         }
-        return;
+        else
+            p = p->left;
     }
-#endif
-    /* create list entry */
-    q = g_new (edit_book_mark_t, 1);
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** insert a bookmark at this line */
+
+void
+book_mark_insert (WEdit * edit, long line, int c)
+{
+    edit_book_mark_t *before, *after, *q;
+
+    /* create tree node */
+    q = g_new0 (edit_book_mark_t, 1);
     q->line = line;
     q->c = c;
-    q->next = p->next;
-    /* insert into list */
-    q->prev = p;
-    if (p->next != NULL)
-        p->next->prev = q;
-    p->next = q;
+    q->priority = g_random_int ();
+
+    /* the last inserted book mark is the last one on the line */
+    book_mark_split (edit->book_mark, line, &before, &after);
+    edit->book_mark = book_mark_merge (book_mark_merge (before, q), after);
 
     edit->force |= REDRAW_LINE;
 }
@@ -215,33 +347,43 @@ book_mark_insert (WEdit * edit, long line, int c)
 gboolean
 book_mark_clear (WEdit * edit, long line, int c)
 {
-    edit_book_mark_t *p, *q;
+    edit_book_mark_t *before, *on_line, *after;
     gboolean r = FALSE;
 
     if (edit->book_mark == NULL)
         return r;
 
-    for (p = book_mark_find (edit, line); p != NULL; p = q)
+    book_mark_split (edit->book_mark, line, &on_line, &after);
+    book_mark_split (on_line, line - 1, &before, &on_line);
+
+    if (on_line != NULL)
     {
-        q = p->prev;
-        if (p->line == line && (p->c == c || c == -1))
+        GPtrArray *marks;
+        guint i;
+
+        marks = g_ptr_array_new ();
+        book_mark_collect (on_line, marks);
+
+        /* remove the last inserted one */
+        for (i = marks->len; i != 0; i--)
         {
-            r = TRUE;
-            edit->book_mark = p->prev;
-            p->prev->next = p->next;
-            if (p->next != NULL)
-                p->next->prev = p->prev;
-            g_free (p);
-            edit->force |= REDRAW_LINE;
-            break;
+            edit_book_mark_t *p = (edit_book_mark_t *) g_ptr_array_index (marks, i - 1);
+
+            if (p->c == c || c == -1)
+            {
+                g_ptr_array_remove_index (marks, i - 1);
+                g_free (p);
+                r = TRUE;
+                edit->force |= REDRAW_LINE;
+                break;
+            }
         }
+
+        on_line = book_mark_build (marks);
+        g_ptr_array_free (marks, TRUE);
     }
-    /* if there is only our dummy book mark left, clear it for speed */
-    if (edit->book_mark->line == -1 && edit->book_mark->next == NULL)
-    {
-        g_free (edit->book_mark);
-        edit->book_mark = NULL;
-    }
+
+    edit->book_mark = book_mark_merge (book_mark_merge (before, on_line), after);
     return r;
 }
 
@@ -251,29 +393,35 @@ book_mark_clear (WEdit * edit, long line, int c)
 void
 book_mark_flush (WEdit * edit, int c)
 {
-    edit_book_mark_t *p, *q;
-
     if (edit->book_mark == NULL)
         return;
 
-    while (edit->book_mark->prev != NULL)
-        edit->book_mark = edit->book_mark->prev;
-
-    for (q = edit->book_mark->next; q != NULL; q = p)
+    if (c == -1)
     {
-        p = q->next;
-        if (q->c == c || c == -1)
-        {
-            q->prev->next = q->next;
-            if (p != NULL)
-                p->prev = q->prev;
-            g_free (q);
-        }
+        book_mark_free (edit->book_mark);
+        edit->book_mark = NULL;
     }
-    if (edit->book_mark->next == NULL)
+    else
     {
-        g_free (edit->book_mark);
-        edit->book_mark = NULL;
+        GPtrArray *marks;
+        guint i, j;
+
+        marks = g_ptr_array_new ();
+        book_mark_collect (edit->book_mark, marks);
+
+        for (i = 0, j = 0; i < marks->len; i++)
+        {
+            edit_book_mark_t *p = (edit_book_mark_t *) g_ptr_array_index (marks, i);
+
+            if (p->c == c)
+                g_free (p);
+            else
+                g_ptr_array_index (marks, j++) = p;
+        }
+        g_ptr_array_set_size (marks, j);
+
+        edit->book_mark = book_mark_build (marks);
+        g_ptr_array_free (marks, TRUE);
     }
 
     edit->force |= REDRAW_PAGE;
@@ -285,14 +433,7 @@ book_mark_flush (WEdit * edit, int c)
 void
 book_mark_inc (WEdit * edit, long line)
 {
-    if (edit->book_mark != NULL)
-    {
-        edit_book_mark_t *p;
-
-        p = book_mark_find (edit, line);
-        for (p = p->next; p != NULL; p = p->next)
-            p->line++;
-    }
+    book_mark_shift (edit, line, 1);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -301,14 +442,7 @@ book_mark_inc (WEdit * edit, long line)
 void
 book_mark_dec (WEdit * edit, long line)
 {
-    if (edit->book_mark != NULL)
-    {
-        edit_book_mark_t *p;
-
-        p = book_mark_find (edit, line);
-        for (p = p->next; p != NULL; p = p->next)
-            p->line--;
-    }
+    book_mark_shift (edit, line, -1);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -322,15 +456,30 @@ book_mark_serialize (WEdit * edit, int color)
 
     if (edit->book_mark != NULL)
     {
-        edit_book_mark_t *p;
+        GPtrArray *marks;
+        guint i;
 
         if (edit->serialized_bookmarks == NULL)
             edit->serialized_bookmarks = g_array_sized_new (FALSE, FALSE, sizeof (size_t),
                                                             MAX_SAVED_BOOKMARKS);
 
-        for (p = book_mark_find (edit, 0); p != NULL; p = p->next)
+        /* collecting makes line numbers absolute, tree remains valid */
+        marks = g_ptr_array_new ();
+        book_mark_collect (edit->book_mark, marks);
+
+        for (i = 0; i < marks->len; i++)
+        {
+            const edit_book_mark_t *p = (edit_book_mark_t *) g_ptr_array_index (marks, i);
+
             if (p->c == color && p->line >= 0)
-                g_array_append_val (edit->serialized_bookmarks, p->line);
+            {
+                size_t line = (size_t) p->line;
+
+                g_array_append_val (edit->serialized_bookmarks, line);
+            }
+        }
+
+        g_ptr_array_free (marks, TRUE);
     }
 }
 
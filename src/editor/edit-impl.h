@@ -168,6 +168,7 @@ void edit_update_curs_row (WEdit * edit);
 void edit_update_curs_col (WEdit * edit);
 void edit_find_bracket (WEdit * edit);
 gboolean edit_reload_line (WEdit * edit, const vfs_path_t * filename_vpath, long line);
+int edit_file_status_msg_update (status_msg_t * sm);
 void edit_set_codeset (WEdit * edit);
 
 void edit_block_copy_cmd (WEdit * edit);
@@ -270,7 +271,8 @@ int edit_get_syntax_color (WEdit * edit, off_t byte_index);
 
 void book_mark_insert (WEdit * edit, long line, int c);
 gboolean book_mark_query_color (WEdit * edit, long line, int c);
-struct edit_book_mark_t *book_mark_find (WEdit * edit, long line);
+long book_mark_next (WEdit * edit, long line);
+long book_mark_prev (WEdit * edit, long line);
 gboolean book_mark_clear (WEdit * edit, long line, int c);
 void book_mark_flush (WEdit * edit, int c);
 void book_mark_inc (WEdit * edit, long line);
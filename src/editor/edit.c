@@ -83,6 +83,7 @@ int option_return_does_auto_indent = 1;
 int option_backspace_through_tabs = 0;
 int option_fake_half_tabs = 1;
 int option_save_mode = EDIT_QUICK_SAVE;
+int option_save_sync = 0;
 int option_save_position = 1;
 int option_max_undo = 32768;
 int option_persistent_selections = 1;
@@ -147,7 +148,6 @@ edit_load_status_update_cb (status_msg_t * sm)
 {
     simple_status_msg_t *ssm = SIMPLE_STATUS_MSG (sm);
     edit_buffer_read_file_status_msg_t *rsm = (edit_buffer_read_file_status_msg_t *) sm;
-    Widget *wd = WIDGET (sm->dlg);
 
     if (verbose)
         label_set_textv (ssm->label, _("Loading: %3d%%"),
@@ -155,18 +155,7 @@ edit_load_status_update_cb (status_msg_t * sm)
     else
         label_set_text (ssm->label, _("Loading..."));
 
-    if (rsm->first)
-    {
-        int wd_width;
-        Widget *lw = WIDGET (ssm->label);
-
-        wd_width = max (wd->cols, lw->cols + 6);
-        widget_set_size (wd, wd->y, wd->x, wd->lines, wd_width);
-        widget_set_size (lw, lw->y, wd->x + (wd->cols - lw->cols) / 2, lw->lines, lw->cols);
-        rsm->first = FALSE;
-    }
-
-    return status_msg_common_update (sm);
+    return edit_file_status_msg_update (sm);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -1745,6 +1734,38 @@ edit_insert_column_from_file (WEdit * edit, int file, off_t * start_pos, off_t *
 /* --------------------------------------------------------------------------------------------- */
 /*** public functions ****************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
+/**
+ * Common part of status message callbacks of file loading and saving: fit the dialog to the label
+ * set by caller and process events.
+ *
+ * @param sm status message of type edit_buffer_read_file_status_msg_t
+ *
+ * @return B_CANCEL if user aborted the operation
+ */
+
+int
+edit_file_status_msg_update (status_msg_t * sm)
+{
+    simple_status_msg_t *ssm = SIMPLE_STATUS_MSG (sm);
+    edit_buffer_read_file_status_msg_t *rsm = (edit_buffer_read_file_status_msg_t *) sm;
+    Widget *wd = WIDGET (sm->dlg);
+
+    if (rsm->first)
+    {
+        int wd_width;
+        Widget *lw = WIDGET (ssm->label);
+
+        wd_width = max (wd->cols, lw->cols + 6);
+        widget_set_size (wd, wd->y, wd->x, wd->lines, wd_width);
+        widget_set_size (lw, lw->y, wd->x + (wd->cols - lw->cols) / 2, lw->lines, lw->cols);
+        rsm->first = FALSE;
+    }
+
+    return status_msg_common_update (sm);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
 
 /** User edit menu, like user menu (F2) but only in editor. */
 
@@ -2124,6 +2145,7 @@ edit_init (WEdit * edit, int y, int x, int lines, int cols, const vfs_path_t * f
 #ifdef HAVE_CHARSET
     edit->utf8 = FALSE;
     edit->converter = str_cnv_from_term;
+    edit->cp_table = NULL;
     edit_set_codeset (edit);
 #endif
 
@@ -2264,7 +2286,10 @@ edit_set_codeset (WEdit * edit)
     }
 
     if (cp_id != NULL)
+    {
         edit->utf8 = str_isutf8 (cp_id);
+        edit->cp_table = get_codepage_table (get_codepage_index (cp_id));
+    }
 }
 #endif
 
@@ -3695,34 +3720,19 @@ edit_execute_cmd (WEdit * edit, unsigned long command, int char_for_insertion)
         edit->force |= REDRAW_PAGE;
         break;
     case CK_BookmarkNext:
-        if (edit->book_mark != NULL)
-        {
-            edit_book_mark_t *p;
-
-            p = book_mark_find (edit, edit->buffer.curs_line);
-            if (p->next != NULL)
-            {
-                p = p->next;
-                if (p->line >= edit->start_line + w->lines || p->line < edit->start_line)
-                    edit_move_display (edit, p->line - w->lines / 2);
-                edit_move_to_line (edit, p->line);
-            }
-        }
-        break;
     case CK_BookmarkPrev:
-        if (edit->book_mark != NULL)
         {
-            edit_book_mark_t *p;
+            long line;
 
-            p = book_mark_find (edit, edit->buffer.curs_line);
-            while (p->line == edit->buffer.curs_line)
-                if (p->prev != NULL)
-                    p = p->prev;
-            if (p->line >= 0)
+            if (command == CK_BookmarkNext)
+                line = book_mark_next (edit, edit->buffer.curs_line);
+            else
+                line = book_mark_prev (edit, edit->buffer.curs_line);
+            if (line >= 0)
             {
-                if (p->line >= edit->start_line + w->lines || p->line < edit->start_line)
-                    edit_move_display (edit, p->line - w->lines / 2);
-                edit_move_to_line (edit, p->line);
+                if (line >= edit->start_line + w->lines || line < edit->start_line)
+                    edit_move_display (edit, line - w->lines / 2);
+                edit_move_to_line (edit, line);
             }
         }
         break;
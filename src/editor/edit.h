@@ -44,6 +44,7 @@ extern int option_cursor_beyond_eol;
 extern gboolean option_cursor_after_inserted_block;
 extern int option_line_state;
 extern int option_save_mode;
+extern int option_save_sync;
 extern int option_save_position;
 extern int option_syntax_highlighting;
 extern int option_group_undo;
@@ -31,9 +31,13 @@
 
 #include <config.h>
 
+#include <errno.h>
+#include <limits.h>             /* IOV_MAX */
 #include <stdlib.h>
 #include <string.h>
 #include <sys/types.h>
+#include <sys/uio.h>            /* writev() */
+#include <unistd.h>
 
 #include "lib/global.h"
 
@@ -95,6 +99,13 @@
 /* Buffer mask (used to find cursor position relative to the buffer) */
 #define M_EDIT_BUF_SIZE (EDIT_BUF_SIZE - 1)
 
+/* Number of buffers written by one writev() call */
+#if defined (IOV_MAX) && IOV_MAX < 64
+#define EDIT_BUF_IOV_MAX IOV_MAX
+#else
+#define EDIT_BUF_IOV_MAX 64
+#endif
+
 /*** file scope type declarations ****************************************************************/
 
 /*** file scope variables ************************************************************************/
@@ -131,6 +142,77 @@ edit_buffer_get_byte_ptr (const edit_buffer_t * buf, off_t byte_index)
     return (char *) b + (byte_index & M_EDIT_BUF_SIZE);
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+  * Get data of buffer in file order: all buffers of b1 from begin to end,
+  * then all buffers of b2 from end to begin.
+  *
+  * @param buf pointer to editor buffer
+  * @param i index of buffer, from 0 to b1->len + b2->len - 1
+  * @param iov data of buffer
+  */
+static void
+edit_buffer_get_block (const edit_buffer_t * buf, guint i, struct iovec *iov)
+{
+    if (i < buf->b1->len)
+    {
+        iov->iov_base = g_ptr_array_index (buf->b1, i);
+        /* last buffer of b1 is partially filled */
+        if (i == buf->b1->len - 1)
+            iov->iov_len = ((buf->curs1 - 1) & M_EDIT_BUF_SIZE) + 1;
+        else
+            iov->iov_len = EDIT_BUF_SIZE;
+    }
+    else
+    {
+        char *b;
+
+        i = buf->b2->len - 1 - (i - buf->b1->len);
+        b = (char *) g_ptr_array_index (buf->b2, i);
+        /* last buffer of b2 is partially filled and its data is at the end */
+        if (i == buf->b2->len - 1)
+            iov->iov_len = ((buf->curs2 - 1) & M_EDIT_BUF_SIZE) + 1;
+        else
+            iov->iov_len = EDIT_BUF_SIZE;
+        iov->iov_base = b + EDIT_BUF_SIZE - iov->iov_len;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+  * Write all data of buffers, continue after short writes.
+  *
+  * @return FALSE on error
+  */
+static gboolean
+edit_buffer_writev_all (int fd, struct iovec *iov, int iovcnt, off_t * written)
+{
+    while (iovcnt > 0)
+    {
+        ssize_t sz;
+
+        sz = writev (fd, iov, iovcnt);
+        if (sz == -1 && errno == EINTR)
+            continue;
+        if (sz <= 0)
+            return FALSE;
+
+        *written += sz;
+
+        /* skip written buffers */
+        for (; iovcnt > 0 && (size_t) sz >= iov->iov_len; iov++, iovcnt--)
+            sz -= iov->iov_len;
+
+        if (iovcnt > 0)
+        {
+            iov->iov_base = (char *) iov->iov_base + sz;
+            iov->iov_len -= sz;
+        }
+    }
+
+    return TRUE;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /*** public functions ****************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -814,6 +896,60 @@ edit_buffer_write_file (edit_buffer_t * buf, int fd)
     return ret;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Write editor buffer content to local file using vectored I/O: up to EDIT_BUF_IOV_MAX buffers
+ * are written by one system call.
+ *
+ * @param buf pointer to editor buffer
+ * @param fd file descriptor of local file, not a VFS one
+ * @param sm status message, its 'loaded' member is the number of written bytes
+ * @param aborted set to TRUE if user has aborted the writing
+ *
+ * @return number of written bytes
+ */
+
+off_t
+edit_buffer_writev_file (edit_buffer_t * buf, int fd, edit_buffer_read_file_status_msg_t * sm,
+                         gboolean * aborted)
+{
+    struct iovec iov[EDIT_BUF_IOV_MAX];
+    int iovcnt = 0;
+    guint i, n;
+    off_t ret = 0;
+    status_msg_t *s = STATUS_MSG (sm);
+
+    *aborted = FALSE;
+
+    n = buf->b1->len + buf->b2->len;
+
+    for (i = 0; i < n; i++)
+    {
+        edit_buffer_get_block (buf, i, &iov[iovcnt]);
+        iovcnt++;
+
+        if (iovcnt == EDIT_BUF_IOV_MAX || i == n - 1)
+        {
+            if (!edit_buffer_writev_all (fd, iov, iovcnt, &ret))
+                break;
+
+            iovcnt = 0;
+
+            if (s != NULL && s->update != NULL)
+            {
+                sm->loaded = ret;
+                if (s->update (s) == B_CANCEL)
+                {
+                    *aborted = TRUE;
+                    break;
+                }
+            }
+        }
+    }
+
+    return ret;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /**
  * Calculate percentage of specified character offset
@@ -60,6 +60,8 @@ off_t edit_buffer_move_backward (const edit_buffer_t * buf, off_t current, long
 off_t edit_buffer_read_file (edit_buffer_t * buf, int fd, off_t size,
                              edit_buffer_read_file_status_msg_t * sm, gboolean * aborted);
 off_t edit_buffer_write_file (edit_buffer_t * buf, int fd);
+off_t edit_buffer_writev_file (edit_buffer_t * buf, int fd,
+                               edit_buffer_read_file_status_msg_t * sm, gboolean * aborted);
 
 int edit_buffer_calc_percent (const edit_buffer_t * buf, off_t offset);
 
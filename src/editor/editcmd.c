@@ -49,6 +49,9 @@
 #include <sys/stat.h>
 #include <stdlib.h>
 #include <fcntl.h>
+#ifdef HAVE_SYS_XATTR_H
+#include <sys/xattr.h>
+#endif
 
 #include "lib/global.h"
 #include "lib/tty/tty.h"
@@ -180,6 +183,233 @@ edit_save_mode_callback (Widget * w, Widget * sender, widget_msg_t msg, int parm
 
 /* --------------------------------------------------------------------------------------------- */
 
+static int
+edit_save_status_update_cb (status_msg_t * sm)
+{
+    simple_status_msg_t *ssm = SIMPLE_STATUS_MSG (sm);
+    edit_buffer_read_file_status_msg_t *rsm = (edit_buffer_read_file_status_msg_t *) sm;
+
+    if (verbose)
+        label_set_textv (ssm->label, _("Saving: %3d%%"),
+                         edit_buffer_calc_percent (rsm->buf, rsm->loaded));
+    else
+        label_set_text (ssm->label, _("Saving..."));
+
+    return edit_file_status_msg_update (sm);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** File is rewritten in place in quick save mode, so there is no Abort button */
+
+static void
+edit_quick_save_status_init_cb (status_msg_t * sm)
+{
+    simple_status_msg_t *ssm = SIMPLE_STATUS_MSG (sm);
+    Widget *wd = WIDGET (sm->dlg);
+
+    ssm->label = label_new (2, 3, "");
+    add_widget_autopos (sm->dlg, ssm->label, WPOS_KEEP_TOP | WPOS_CENTER_HORZ, NULL);
+    widget_set_size (wd, wd->y, wd->x, 5, wd->cols);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+edit_quick_save_status_update_cb (status_msg_t * sm)
+{
+    /* Esc doesn't abort writing either: the file would be left truncated */
+    (void) edit_save_status_update_cb (sm);
+    return B_ENTER;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Copy extended attributes (ACLs, security labels, user attributes) of file to new one */
+
+static void
+edit_save_copy_xattrs (const char *filename, int fd)
+{
+#if defined (HAVE_SYS_XATTR_H) && defined (HAVE_LISTXATTR)
+    ssize_t list_len;
+    char *list, *name;
+
+    list_len = listxattr (filename, NULL, 0);
+    if (list_len <= 0)
+        return;
+
+    list = g_malloc (list_len);
+    list_len = listxattr (filename, list, list_len);
+
+    for (name = list; list_len > 0 && name < list + list_len; name += strlen (name) + 1)
+    {
+        ssize_t value_len;
+        char *value;
+
+        value_len = getxattr (filename, name, NULL, 0);
+        if (value_len < 0)
+            continue;
+
+        value = g_malloc (value_len + 1);
+        value_len = getxattr (filename, name, value, value_len);
+        /* failure isn't fatal: we may be not allowed to set some attributes */
+        if (value_len >= 0)
+            (void) fsetxattr (fd, name, value, value_len, 0);
+        g_free (value);
+    }
+
+    g_free (list);
+#else
+    (void) filename;
+    (void) fd;
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Flush data of the file to the disk */
+
+static gboolean
+edit_save_sync (int fd)
+{
+#ifdef HAVE_FDATASYNC
+    return (fdatasync (fd) == 0);
+#else
+    return (fsync (fd) == 0);
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Flush the directory of renamed file to the disk */
+
+static void
+edit_save_sync_dir (const char *filename)
+{
+    char *dirname;
+    int fd;
+
+    dirname = g_path_get_dirname (filename);
+    fd = open (dirname, O_RDONLY);
+    g_free (dirname);
+
+    if (fd != -1)
+    {
+        (void) fsync (fd);
+        close (fd);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Save buffer to local file without VFS: all buffers are written by writev() in large batches
+ * to a temporary file in the same directory, which atomically replaces the original one.
+ * In quick save mode, the file is rewritten in place and saving can't be aborted: on write error
+ * the file is left truncated, as it is when saving through VFS.
+ *
+ * @return 1 on success, 0 on error, -1 on abort
+ */
+
+static int
+edit_save_file_local (WEdit * edit, const vfs_path_t * filename_vpath, int this_save_mode)
+{
+    const char *filename, *savename;
+    vfs_path_t *savename_vpath = NULL;
+    int fd;
+    off_t filelen;
+    gboolean existed, ok, aborted;
+    edit_buffer_read_file_status_msg_t rsm;
+    struct stat st;
+
+    filename = vfs_path_get_by_index (filename_vpath, -1)->path;
+    /* new file gets mode from open() and umask, not the default one of editor */
+    existed = (stat (filename, &st) == 0);
+
+    if (this_save_mode == EDIT_QUICK_SAVE)
+    {
+        savename = filename;
+        fd = open (filename, O_CREAT | O_WRONLY | O_TRUNC | O_BINARY, edit->stat1.st_mode);
+    }
+    else
+    {
+        char *savedir, *saveprefix;
+
+        savedir = g_path_get_dirname (filename);
+        saveprefix = g_build_filename (savedir, "cooledit", (char *) NULL);
+        g_free (savedir);
+        fd = mc_mkstemps (&savename_vpath, saveprefix, NULL);
+        g_free (saveprefix);
+        if (savename_vpath == NULL)
+            return 0;
+
+        savename = vfs_path_get_by_index (savename_vpath, -1)->path;
+        edit_save_copy_xattrs (filename, fd);
+    }
+
+    if (fd == -1)
+        return 0;
+
+    if (existed)
+    {
+        (void) fchown (fd, edit->stat1.st_uid, edit->stat1.st_gid);
+        (void) fchmod (fd, edit->stat1.st_mode & 07777);
+    }
+
+    rsm.first = TRUE;
+    rsm.buf = &edit->buffer;
+    rsm.loaded = 0;
+
+    if (this_save_mode == EDIT_QUICK_SAVE)
+        status_msg_init (STATUS_MSG (&rsm), _("Save file"), 1.0, edit_quick_save_status_init_cb,
+                         edit_quick_save_status_update_cb, NULL);
+    else
+        status_msg_init (STATUS_MSG (&rsm), _("Save file"), 1.0, simple_status_msg_init_cb,
+                         edit_save_status_update_cb, NULL);
+
+    filelen = edit_buffer_writev_file (&edit->buffer, fd, &rsm, &aborted);
+
+    status_msg_deinit (STATUS_MSG (&rsm));
+
+    ok = (filelen == edit->buffer.size);
+    if (ok && option_save_sync)
+        ok = edit_save_sync (fd);
+    if (close (fd) != 0)
+        ok = FALSE;
+
+    if (ok && this_save_mode == EDIT_DO_BACKUP)
+    {
+        char *backup;
+
+#ifdef HAVE_ASSERT_H
+        assert (option_backup_ext != NULL);
+#endif
+        /* keep the original file in place until the new one replaces it */
+        backup = g_strconcat (filename, option_backup_ext, (char *) NULL);
+        (void) unlink (backup);
+        ok = (link (filename, backup) == 0 || rename (filename, backup) == 0);
+        g_free (backup);
+    }
+
+    if (ok && this_save_mode != EDIT_QUICK_SAVE)
+    {
+        ok = (rename (savename, filename) == 0);
+        if (ok && option_save_sync)
+            edit_save_sync_dir (filename);
+    }
+
+    if (!ok)
+    {
+        /* original file is untouched */
+        if (this_save_mode != EDIT_QUICK_SAVE)
+            (void) unlink (savename);
+        vfs_path_free (savename_vpath);
+        return aborted ? -1 : 0;
+    }
+
+    vfs_path_free (savename_vpath);
+
+    /* Update the file information, especially the mtime. */
+    return (mc_stat (filename_vpath, &edit->stat1) == -1) ? 0 : 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
 /*  If 0 (quick save) then  a) create/truncate <filename> file,
    b) save to <filename>;
    if 1 (safe save) then   a) save to <tempnam>,
@@ -275,6 +505,20 @@ edit_save_file (WEdit * edit, const vfs_path_t * filename_vpath)
         }
     }
 
+    /* Local file without line break conversion and filters: write it directly */
+    if (edit->lb == LB_ASIS && vfs_file_is_local (real_filename_vpath)
+        && vfs_path_elements_count (real_filename_vpath) == 1)
+    {
+        p = edit_get_write_filter (real_filename_vpath, real_filename_vpath);
+        if (p == NULL)
+        {
+            rv = edit_save_file_local (edit, real_filename_vpath, this_save_mode);
+            vfs_path_free (real_filename_vpath);
+            return rv;
+        }
+        g_free (p);
+    }
+
     if (this_save_mode != EDIT_QUICK_SAVE)
     {
         char *savedir, *saveprefix;
@@ -1651,6 +1895,7 @@ edit_save_mode_cmd (void)
                          &edit_save_mode_input_id, FALSE, FALSE, INPUT_COMPLETE_NONE),
             QUICK_SEPARATOR (TRUE),
             QUICK_CHECKBOX (N_("Check &POSIX new line"), &option_check_nl_at_eof, NULL),
+            QUICK_CHECKBOX (N_("Flush to dis&k"), &option_save_sync, NULL),
             QUICK_BUTTONS_OK_CANCEL,
             QUICK_END
             /* *INDENT-ON* */
@@ -3525,6 +3770,8 @@ edit_get_match_keyword_cmd (WEdit * edit)
     for (i = 0; i < MAX_DEFINITIONS; i++)
     {
         def_hash[i].filename = NULL;
+        def_hash[i].fullpath = NULL;
+        def_hash[i].short_define = NULL;
     }
 
     /* search start of word to be completed */
@@ -521,6 +521,8 @@ editcmd_dialog_select_definition_show (WEdit * edit, char *match_expr, int max_l
     for (i = 0; i < MAX_DEFINITIONS; i++)
     {
         g_free (def_hash[i].filename);
+        g_free (def_hash[i].fullpath);
+        g_free (def_hash[i].short_define);
     }
 
     /* destroy dialog before return */
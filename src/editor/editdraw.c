@@ -387,6 +387,8 @@ print_to_widget (WEdit * edit, long row, int start_col, int start_col_real,
     Widget *w = WIDGET (edit);
 
     struct line_s *p;
+    tty_cell_t cells[MAX_LINE_LEN];
+    int n;
 
     int x = start_col_real;
     int x1 = start_col + EDIT_TEXT_HORIZONTAL_OFFSET + option_line_state_width;
@@ -446,6 +448,7 @@ print_to_widget (WEdit * edit, long row, int start_col, int start_col_real,
 
     edit_move (x1, y);
     i = 1;
+    n = 0;
     for (p = line; p->ch != 0; p++)
     {
         int style;
@@ -468,32 +471,37 @@ print_to_widget (WEdit * edit, long row, int start_col, int start_col_real,
             color = 0;
         }
 
+        /* syntax colors are set by tty_lowlevel_setcolor() */
         if (style & MOD_WHITESPACE)
         {
             if (style & MOD_MARKED)
             {
                 textchar = ' ';
-                tty_setcolor (EDITOR_MARKED_COLOR);
+                color = EDITOR_MARKED_COLOR;
             }
             else
-                tty_setcolor (EDITOR_WHITESPACE_COLOR);
+                color = EDITOR_WHITESPACE_COLOR;
         }
         else if (style & MOD_BOLD)
-            tty_setcolor (EDITOR_BOLD_COLOR);
+            color = EDITOR_BOLD_COLOR;
         else if (style & MOD_MARKED)
-            tty_setcolor (EDITOR_MARKED_COLOR);
+            color = EDITOR_MARKED_COLOR;
         else
-            tty_lowlevel_setcolor (color);
+            color = -color;
 
         if (show_right_margin)
         {
             if (i > option_word_wrap_line_length + edit->start_col)
-                tty_setcolor (EDITOR_RIGHT_MARGIN_COLOR);
+                color = EDITOR_RIGHT_MARGIN_COLOR;
             i++;
         }
 
-        tty_print_anychar (textchar);
+        cells[n].ch = (int) textchar;
+        cells[n].color = color;
+        n++;
     }
+
+    tty_print_cells (cells, n);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -513,6 +521,9 @@ edit_draw_this_line (WEdit * edit, off_t b, long row, long start_col, long end_c
     int abn_style;
     int book_mark = 0;
     char line_stat[LINE_STATE_WIDTH + 1] = "\0";
+#ifdef HAVE_CHARSET
+    const codepage_table_t *display_table = get_codepage_table (mc_global.display_codepage);
+#endif
 
     if (row > w->lines - 1 - EDIT_TEXT_VERTICAL_OFFSET - 2 * (edit->fullscreen ? 0 : 1))
         return;
@@ -724,7 +735,8 @@ edit_draw_this_line (WEdit * edit, off_t b, long row, long start_col, long end_c
                     {
                         if (!edit->utf8)
                         {
-                            c = convert_from_8bit_to_utf_c ((unsigned char) c, edit->converter);
+                            c = convert_from_8bit_to_utf_t (edit->cp_table, (unsigned char) c,
+                                                            edit->converter);
                         }
                         else
                         {
@@ -736,7 +748,7 @@ edit_draw_this_line (WEdit * edit, off_t b, long row, long start_col, long end_c
                         }
                     }
                     else if (edit->utf8)
-                        c = convert_from_utf_to_current_c (c, edit->converter);
+                        c = convert_from_utf_to_current_t (display_table, c, edit->converter);
                     else
                         c = convert_to_display_c (c);
 #endif
@@ -7,6 +7,9 @@
 
 #include "lib/search.h"         /* mc_search_t */
 #include "lib/widget.h"         /* Widget */
+#ifdef HAVE_CHARSET
+#include "lib/charsets.h"       /* codepage_table_t */
+#endif
 
 #include "edit-impl.h"
 #include "editbuffer.h"
@@ -29,13 +32,16 @@ typedef enum
 
 /*** structures declarations (and typedefs of structures)*****************************************/
 
+/* node of tree of book marks, see bookmark.c */
 typedef struct edit_book_mark_t edit_book_mark_t;
 struct edit_book_mark_t
 {
-    long line;                  /* line number */
+    long line;                  /* line number, without shifts of ancestors */
     int c;                      /* color */
-    edit_book_mark_t *next;
-    edit_book_mark_t *prev;
+    long shift;                 /* shift of line numbers of descendants */
+    guint32 priority;
+    edit_book_mark_t *left;
+    edit_book_mark_t *right;
 };
 
 typedef struct edit_syntax_rule_t edit_syntax_rule_t;
@@ -81,6 +87,7 @@ struct WEdit
     /* multibyte support */
     gboolean utf8;              /* It's multibyte file codeset */
     GIConv converter;
+    const codepage_table_t *cp_table;   /* precomputed tables of 8-bit codeset */
     char charbuf[4 + 1];
     int charpoint;
 #endif
@@ -6,6 +6,9 @@
    or, if etags utility not installed:
    $ find . -type f -name "*.[ch]" | ctags --c-kinds=+p --fields=+iaS --extra=+q -e -L-
 
+   Files in format of Exuberant or Universal ctags are supported too:
+   $ find . -type f -name "*.[ch]" | ctags --c-kinds=+p --fields=+n -f TAGS -L-
+
    Copyright (C) 2009-2014
    Free Software Foundation, Inc.
 
@@ -36,6 +39,7 @@
 #include <inttypes.h>
 #include <string.h>
 #include <ctype.h>
+#include <sys/stat.h>
 
 #include "lib/global.h"
 #include "lib/util.h"           /* canonicalize_pathname() */
@@ -46,10 +50,35 @@
 
 /*** file scope macro definitions ****************************************************************/
 
+#define ETAGS_IS_NAME_CHAR(c) (isalnum ((unsigned char) (c)) || (c) == '_' || (c) == '$')
+
 /*** file scope type declarations ****************************************************************/
 
+/* One tag. Details are read from the tags file on demand */
+typedef struct
+{
+    const char *name;
+    const char *filename;       /* etags: from section header; NULL for ctags */
+    off_t offset;               /* offset of tag line in tags file */
+} etags_tag_t;
+
+/* Tags of one file, sorted by name */
+typedef struct
+{
+    char *tagfile;
+    dev_t dev;
+    ino_t ino;
+    time_t mtime;
+    off_t size;
+    gboolean ctags;             /* file is in ctags format */
+    GStringChunk *strings;
+    GArray *tags;
+} etags_index_t;
+
 /*** file scope variables ************************************************************************/
 
+static etags_index_t *etags_index = NULL;
+
 /*** file scope functions ************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
 
@@ -85,7 +114,7 @@ parse_define (char *buf, char **long_name, char **short_name, long *line)
             }
             else if (c == 0x7F)
             {
-                def_state = in_shortname;
+                def_state = in_shortname_first_char;
             }
             else
             {
@@ -164,12 +193,159 @@ parse_define (char *buf, char **long_name, char **short_name, long *line)
 }
 
 /* --------------------------------------------------------------------------------------------- */
-/*** public functions ****************************************************************************/
+/**
+ * Read whole line of any length.
+ *
+ * @return FALSE at end of file
+ */
+
+static gboolean
+etags_read_line (FILE * f, GString * line)
+{
+    char buf[BUF_LARGE];
+
+    g_string_set_size (line, 0);
+
+    while (fgets (buf, sizeof (buf), f) != NULL)
+    {
+        g_string_append (line, buf);
+        if (line->str[line->len - 1] == '\n')
+            break;
+    }
+
+    return line->len != 0;
+}
+
 /* --------------------------------------------------------------------------------------------- */
+/**
+ * Get implicit tag name of etags definition: the last identifier of pattern.
+ * "int main (" -> "main"
+ */
 
-int
-etags_set_definition_hash (const char *tagfile, const char *start_path,
-                           const char *match_func, etags_hash_t * def_hash)
+static gboolean
+etags_implicit_name (const char *pattern, size_t len, const char **name, size_t * name_len)
+{
+    const char *end, *start;
+
+    end = pattern + len;
+    while (end > pattern && !ETAGS_IS_NAME_CHAR (end[-1]))
+        end--;
+
+    start = end;
+    while (start > pattern && ETAGS_IS_NAME_CHAR (start[-1]))
+        start--;
+
+    *name = start;
+    *name_len = (size_t) (end - start);
+    return *name_len != 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+etags_index_add (etags_index_t * idx, const char *name, size_t name_len, const char *filename,
+                 off_t offset)
+{
+    etags_tag_t tag;
+    char *tmp;
+
+    tmp = g_strndup (name, name_len);
+    tag.name = g_string_chunk_insert_const (idx->strings, tmp);
+    g_free (tmp);
+    tag.filename = filename;
+    tag.offset = offset;
+    g_array_append_val (idx->tags, tag);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Add definition from etags file:
+ * pattern<DEL>[name<SOH>]line,offset
+ */
+
+static void
+etags_index_add_etags_line (etags_index_t * idx, const char *line, const char *filename,
+                            off_t offset)
+{
+    const char *del, *soh;
+    const char *name;
+    size_t name_len;
+
+    del = strchr (line, 0x7F);
+    if (del == NULL)
+        return;
+
+    soh = strchr (del + 1, 0x01);
+    if (soh != NULL && soh > del + 1)
+    {
+        /* explicit name */
+        name = del + 1;
+        name_len = (size_t) (soh - name);
+    }
+    else if (!etags_implicit_name (line, (size_t) (del - line), &name, &name_len))
+        return;
+
+    etags_index_add (idx, name, name_len, filename, offset);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Add definition from ctags file:
+ * name<TAB>file<TAB>address[;"<TAB>fields]
+ */
+
+static void
+etags_index_add_ctags_line (etags_index_t * idx, const char *line, off_t offset)
+{
+    const char *tab;
+
+    /* pseudo tags */
+    if (strncmp (line, "!_TAG_", 6) == 0)
+        return;
+
+    tab = strchr (line, '\t');
+    if (tab == NULL || tab == line)
+        return;
+
+    etags_index_add (idx, line, (size_t) (tab - line), NULL, offset);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+etags_tag_cmp (gconstpointer a, gconstpointer b)
+{
+    const etags_tag_t *ta = (const etags_tag_t *) a;
+    const etags_tag_t *tb = (const etags_tag_t *) b;
+    int ret;
+
+    ret = strcmp (ta->name, tb->name);
+    if (ret == 0)
+        /* keep order of definitions in file */
+        ret = (ta->offset > tb->offset) - (ta->offset < tb->offset);
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+etags_index_free (etags_index_t * idx)
+{
+    if (idx == NULL)
+        return;
+
+    g_free (idx->tagfile);
+    g_string_chunk_free (idx->strings);
+    g_array_free (idx->tags, TRUE);
+    g_free (idx);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Read tags file and build sorted index of tag names */
+
+static etags_index_t *
+etags_index_load (const char *tagfile, const struct stat *st)
 {
     /* *INDENT-OFF* */
     enum
@@ -180,82 +356,383 @@ etags_set_definition_hash (const char *tagfile, const char *start_path,
     } state = start;
     /* *INDENT-ON* */
 
+    etags_index_t *idx;
     FILE *f;
-    static char buf[BUF_LARGE];
+    GString *line;
+    const char *filename = NULL;
+    off_t offset = 0;
 
-    char *chekedstr = NULL;
-
-    int num = 0;                /* returned value */
-    int pos;
-    char *filename = NULL;
-
-    if (!match_func || !tagfile)
-        return 0;
-
-    /* open file with positions */
     f = fopen (tagfile, "r");
     if (f == NULL)
-        return 0;
+        return NULL;
+
+    idx = g_new0 (etags_index_t, 1);
+    idx->tagfile = g_strdup (tagfile);
+    idx->dev = st->st_dev;
+    idx->ino = st->st_ino;
+    idx->mtime = st->st_mtime;
+    idx->size = st->st_size;
+    idx->strings = g_string_chunk_new (BUF_MEDIUM * 64);
+    idx->tags = g_array_new (FALSE, FALSE, sizeof (etags_tag_t));
+
+    line = g_string_sized_new (BUF_LARGE);
 
-    while (fgets (buf, sizeof (buf), f))
+    while (etags_read_line (f, line))
     {
+        off_t line_offset = offset;
+
+        offset += (off_t) line->len;
+
+        if (line_offset == 0)
+            /* etags file starts with form feed */
+            idx->ctags = line->str[0] != 0x0C;
+
+        if (idx->ctags)
+        {
+            etags_index_add_ctags_line (idx, line->str, line_offset);
+            continue;
+        }
+
         switch (state)
         {
         case start:
-            if (buf[0] == 0x0C)
-            {
+            if (line->str[0] == 0x0C)
                 state = in_filename;
-            }
             break;
         case in_filename:
-            pos = strcspn (buf, ",");
-            g_free (filename);
-            filename = g_malloc (pos + 2);
-            g_strlcpy (filename, (char *) buf, pos + 1);
-            state = in_define;
+            {
+                char *comma;
+
+                /* filename,size */
+                comma = strrchr (line->str, ',');
+                if (comma != NULL)
+                    *comma = '\0';
+                filename = g_string_chunk_insert_const (idx->strings, line->str);
+                state = in_define;
+            }
             break;
         case in_define:
-            if (buf[0] == 0x0C)
-            {
+            if (line->str[0] == 0x0C)
                 state = in_filename;
-                break;
-            }
-            /* check if the filename matches the define pos */
-            chekedstr = strstr (buf, match_func);
-            if (chekedstr)
+            else
+                etags_index_add_etags_line (idx, line->str, filename, line_offset);
+            break;
+        }
+    }
+
+    g_string_free (line, TRUE);
+    fclose (f);
+
+    g_array_sort (idx->tags, etags_tag_cmp);
+
+    return idx;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Get index of tags file. Index is rebuilt if file was changed */
+
+static etags_index_t *
+etags_index_get (const char *tagfile)
+{
+    struct stat st;
+
+    if (stat (tagfile, &st) != 0)
+        return NULL;
+
+    if (etags_index != NULL && (strcmp (etags_index->tagfile, tagfile) != 0
+                                || etags_index->dev != st.st_dev || etags_index->ino != st.st_ino
+                                || etags_index->mtime != st.st_mtime
+                                || etags_index->size != st.st_size))
+    {
+        etags_index_free (etags_index);
+        etags_index = NULL;
+    }
+
+    if (etags_index == NULL)
+        etags_index = etags_index_load (tagfile, &st);
+
+    return etags_index;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Index of first tag which name isn't less than @name */
+
+static guint
+etags_index_lower_bound (const etags_index_t * idx, const char *name)
+{
+    guint lo = 0, hi = idx->tags->len;
+
+    while (lo < hi)
+    {
+        guint mid;
+
+        mid = lo + (hi - lo) / 2;
+        if (strcmp (g_array_index (idx->tags, etags_tag_t, mid).name, name) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find line number by ctags search pattern: /^text$/
+ *
+ * @return line number, 0 if not found
+ */
+
+static long
+etags_find_pattern_line (const char *fullpath, const char *address)
+{
+    GString *text, *line;
+    gboolean bol, eol = FALSE;
+    const char *p;
+    FILE *f;
+    long num, ret = 0;
+
+    /* pattern is enclosed in slashes or question marks */
+    p = address + 1;
+    bol = *p == '^';
+    if (bol)
+        p++;
+
+    text = g_string_sized_new (BUF_SMALL);
+    for (; *p != '\0' && *p != address[0]; p++)
+    {
+        if (*p == '\\' && p[1] != '\0')
+            p++;
+        else if (*p == '$' && p[1] == address[0])
+        {
+            eol = TRUE;
+            continue;
+        }
+        g_string_append_c (text, *p);
+    }
+
+    f = fopen (fullpath, "r");
+    if (f == NULL)
+    {
+        g_string_free (text, TRUE);
+        return 0;
+    }
+
+    line = g_string_sized_new (BUF_LARGE);
+
+    for (num = 1; ret == 0 && etags_read_line (f, line); num++)
+    {
+        if (line->str[line->len - 1] == '\n')
+            g_string_truncate (line, line->len - 1);
+
+        if (eol && bol)
+        {
+            if (strcmp (line->str, text->str) == 0)
+                ret = num;
+        }
+        else if (bol)
+        {
+            if (strncmp (line->str, text->str, text->len) == 0)
+                ret = num;
+        }
+        else if (eol)
+        {
+            if (line->len >= text->len
+                && strcmp (line->str + line->len - text->len, text->str) == 0)
+                ret = num;
+        }
+        else if (strstr (line->str, text->str) != NULL)
+            ret = num;
+    }
+
+    g_string_free (line, TRUE);
+    g_string_free (text, TRUE);
+    fclose (f);
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Read details of tag from tags file */
+
+static gboolean
+etags_fill_definition (const etags_index_t * idx, const etags_tag_t * tag, FILE * f,
+                       GString * line, const char *start_path, etags_hash_t * def)
+{
+    const char *filename;
+    char *short_define;
+    long line_num = 0;
+    char *pattern = NULL;
+
+    if (fseeko (f, tag->offset, SEEK_SET) != 0 || !etags_read_line (f, line))
+        return FALSE;
+
+    g_strchomp (line->str);
+
+    if (!idx->ctags)
+    {
+        char *longname, *shortname;
+
+        if (!parse_define (line->str, &longname, &shortname, &line_num))
+            return FALSE;
+
+        filename = tag->filename;
+        short_define = g_strdup (shortname[0] != '\0' ? shortname : longname);
+    }
+    else
+    {
+        char *file, *address, *fields;
+
+        /* name<TAB>file<TAB>address;"<TAB>fields
+           search pattern in address can contain tabs */
+        file = strchr (line->str, '\t');
+        address = file == NULL ? NULL : strchr (file + 1, '\t');
+        if (address == NULL)
+            return FALSE;
+
+        *file++ = '\0';
+        *address++ = '\0';
+
+        fields = address;
+        if (address[0] == '/' || address[0] == '?')
+        {
+            /* skip search pattern: it can contain ;" */
+            for (fields++; *fields != '\0' && *fields != address[0]; fields++)
+                if (*fields == '\\' && fields[1] != '\0')
+                    fields++;
+        }
+
+        fields = strstr (fields, ";\"");
+        if (fields != NULL)
+            *fields = '\0';
+
+        filename = g_string_chunk_insert_const (idx->strings, file);
+        short_define = g_strdup (line->str);
+
+        if (isdigit ((unsigned char) address[0]))
+            line_num = atol (address);
+        else
+        {
+            if (address[0] == '/' || address[0] == '?')
+                pattern = g_strdup (address);
+
+            if (fields != NULL)
             {
-                char *longname = NULL;
-                char *shortname = NULL;
-                long line = 0;
+                char *n;
 
-                parse_define (chekedstr, &longname, &shortname, &line);
-                if (num < MAX_DEFINITIONS - 1)
-                {
-                    def_hash[num].filename_len = strlen (filename);
-                    def_hash[num].fullpath =
-                        mc_build_filename (start_path, filename, (char *) NULL);
-
-                    canonicalize_pathname (def_hash[num].fullpath);
-                    def_hash[num].filename = g_strdup (filename);
-                    if (shortname)
-                    {
-                        def_hash[num].short_define = g_strdup (shortname);
-                    }
-                    else
-                    {
-                        def_hash[num].short_define = g_strdup (longname);
-                    }
-                    def_hash[num].line = line;
-                    num++;
-                }
+                n = strstr (fields + 2, "\tline:");
+                if (n != NULL)
+                    line_num = atol (n + 6);
             }
-            break;
         }
     }
 
-    g_free (filename);
+    def->filename_len = strlen (filename);
+    def->fullpath = mc_build_filename (start_path, filename, (char *) NULL);
+    canonicalize_pathname (def->fullpath);
+    def->filename = g_strdup (filename);
+    def->short_define = short_define;
+
+    if (line_num == 0 && pattern != NULL)
+        line_num = etags_find_pattern_line (def->fullpath, pattern);
+    def->line = line_num;
+
+    g_free (pattern);
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find definitions in tags file.
+ *
+ * Tags file is indexed once and reindexed only if it was changed.
+ *
+ * @param tagfile tags file in etags or ctags format
+ * @param start_path directory of tags file, file names are relative to it
+ * @param name name of tag
+ * @param prefix if TRUE, find tags which names start with @name, otherwise exact name
+ * @param def_hash array for found definitions
+ * @param max_num size of @def_hash
+ *
+ * @return number of found definitions
+ */
+
+int
+etags_find_definitions (const char *tagfile, const char *start_path, const char *name,
+                        gboolean prefix, etags_hash_t * def_hash, int max_num)
+{
+    etags_index_t *idx;
+    GString *line;
+    FILE *f;
+    size_t name_len;
+    guint i;
+    int num = 0;
+
+    if (tagfile == NULL || name == NULL || *name == '\0')
+        return 0;
+
+    idx = etags_index_get (tagfile);
+    if (idx == NULL)
+        return 0;
+
+    i = etags_index_lower_bound (idx, name);
+    if (i >= idx->tags->len)
+        return 0;
+
+    f = fopen (tagfile, "r");
+    if (f == NULL)
+        return 0;
+
+    line = g_string_sized_new (BUF_LARGE);
+    name_len = strlen (name);
+
+    for (; i < idx->tags->len && num < max_num; i++)
+    {
+        const etags_tag_t *tag = &g_array_index (idx->tags, etags_tag_t, i);
+
+        if (prefix ? strncmp (tag->name, name, name_len) != 0 : strcmp (tag->name, name) != 0)
+            break;
+
+        if (etags_fill_definition (idx, tag, f, line, start_path, &def_hash[num]))
+            num++;
+    }
+
+    g_string_free (line, TRUE);
     fclose (f);
+
+    return num;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find definitions of @match_func. If there are no such definitions,
+ * find definitions which names start with @match_func.
+ */
+
+int
+etags_set_definition_hash (const char *tagfile, const char *start_path,
+                           const char *match_func, etags_hash_t * def_hash)
+{
+    int num;
+
+    num = etags_find_definitions (tagfile, start_path, match_func, FALSE, def_hash,
+                                  MAX_DEFINITIONS - 1);
+    if (num == 0)
+        num = etags_find_definitions (tagfile, start_path, match_func, TRUE, def_hash,
+                                      MAX_DEFINITIONS - 1);
+
     return num;
 }
 
 /* --------------------------------------------------------------------------------------------- */
+
+void
+etags_free_index (void)
+{
+    etags_index_free (etags_index);
+    etags_index = NULL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
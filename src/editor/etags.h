@@ -30,8 +30,11 @@ typedef struct etags_hash_struct
 /*** declarations of public functions ************************************************************/
 
 
+int etags_find_definitions (const char *tagfile, const char *start_path, const char *name,
+                            gboolean prefix, etags_hash_t * def_hash, int max_num);
 int etags_set_definition_hash (const char *tagfile, const char *start_path,
                                const char *match_func, etags_hash_t * def_hash);
+void etags_free_index (void);
 
 /*** inline functions ****************************************************************************/
 #endif /* MC__EDIT_ETAGS_H */
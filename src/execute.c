@@ -243,10 +243,14 @@ execute_get_opts_from_cfg (const char *command, const char *default_str)
         if (cfg == NULL)
             return g_strdup (default_str);
 
+        /* don't pass the default value to keep the cached config unchanged */
         str_from_config =
-            mc_config_get_string_raw (cfg, CONFIG_EXT_EDITOR_VIEWER_SECTION, command, default_str);
+            mc_config_get_string_raw (cfg, CONFIG_EXT_EDITOR_VIEWER_SECTION, command, NULL);
 
         mc_config_deinit (cfg);
+
+        if (str_from_config == NULL)
+            str_from_config = g_strdup (default_str);
     }
 
     return str_from_config;
@@ -49,6 +49,7 @@
 #include "dir.h"
 #include "midnight.h"           /* current_panel */
 #include "chmod.h"
+#include "chattr.h"
 
 #include "achown.h"
 
@@ -101,6 +102,7 @@ static WButton *b_att[3];       /* permission */
 static WButton *b_user, *b_group;       /* owner */
 static WLabel *l_filename;
 static WLabel *l_mode;
+static chattr_checks_t recursive_checks;
 
 static int flag_pos;
 static int x_toggle;
@@ -629,7 +631,7 @@ static void
 init_chown_advanced (void)
 {
     int i;
-    int dlg_h = 12;
+    int dlg_h = 13;
     int dlg_w = 74;
     int y;
 
@@ -692,7 +694,9 @@ init_chown_advanced (void)
     l_mode = label_new (BY + 2, 3, "");
     add_widget (ch_dlg, l_mode);
 
-    y = BY + 3;
+    chattr_checks_add (ch_dlg, BY + 3, 3, &recursive_checks);
+
+    y = BY + 4;
     if (!single_set)
     {
         i = BUTTONS_PERM;
@@ -767,54 +771,63 @@ next_file (void)
 
 /* --------------------------------------------------------------------------------------------- */
 
+/**
+ * Convert flags of dialog to the change applied to every entry.
+ *
+ * @param sf stat with owner and group selected in dialog
+ */
+
 static void
-apply_advanced_chowns (struct stat *sf)
+init_chattr_op (chattr_op_t * op, const struct stat *sf)
 {
-    vfs_path_t *vpath;
-    char *lc_fname;
-    gid_t a_gid = sf->st_gid;
-    uid_t a_uid = sf->st_uid;
+    int i;
 
-    lc_fname = current_panel->dir.list[current_file].fname;
-    vpath = vfs_path_from_str (lc_fname);
-    need_update = end_chown = TRUE;
-    if (mc_chmod (vpath, get_mode ()) == -1)
-        message (D_ERROR, MSG_ERROR, _("Cannot chmod \"%s\"\n%s"),
-                 lc_fname, unix_error_string (errno));
-    /* call mc_chown only, if mc_chmod didn't fail */
-    else if (mc_chown (vpath, (ch_flags[9] == '+') ? sf->st_uid : (uid_t) (-1),
-                       (ch_flags[10] == '+') ? sf->st_gid : (gid_t) (-1)) == -1)
-        message (D_ERROR, MSG_ERROR, _("Cannot chown \"%s\"\n%s"),
-                 lc_fname, unix_error_string (errno));
-    do_file_mark (current_panel, current_file, 0);
-    vfs_path_free (vpath);
+    chattr_op_init (op);
 
-    do
+    op->change_mode = TRUE;
+    for (i = 0; i < 9; i++)
     {
-        lc_fname = next_file ();
-        vpath = vfs_path_from_str (lc_fname);
+        if (ch_flags[i] == '+')
+            op->or_mask |= 1 << (8 - i);
+        else if (ch_flags[i] == '-')
+            op->and_mask &= ~(mode_t) (1 << (8 - i));
+    }
 
-        if (mc_stat (vpath, sf) != 0)
-        {
-            vfs_path_free (vpath);
-            break;
-        }
+    if (ch_flags[9] == '+')
+        op->uid = sf->st_uid;
+    if (ch_flags[10] == '+')
+        op->gid = sf->st_gid;
 
-        ch_cmode = sf->st_mode;
+    op->targets = chattr_checks_get_targets (&recursive_checks);
+}
 
-        if (mc_chmod (vpath, get_mode ()) == -1)
-            message (D_ERROR, MSG_ERROR, _("Cannot chmod \"%s\"\n%s"),
-                     lc_fname, unix_error_string (errno));
-        /* call mc_chown only, if mc_chmod didn't fail */
-        else if (mc_chown (vpath, (ch_flags[9] == '+') ? a_uid : (uid_t) (-1),
-                           (ch_flags[10] == '+') ? a_gid : (gid_t) (-1)) == -1)
-            message (D_ERROR, MSG_ERROR, _("Cannot chown \"%s\"\n%s"),
-                     lc_fname, unix_error_string (errno));
+/* --------------------------------------------------------------------------------------------- */
 
-        do_file_mark (current_panel, current_file, 0);
+static void
+apply_advanced_chowns (struct stat *sf)
+{
+    chattr_op_t op;
+
+    need_update = end_chown = TRUE;
+
+    init_chattr_op (&op, sf);
+
+    do
+    {
+        vfs_path_t *vpath;
+        FileProgressStatus status;
+
+        vpath = vfs_path_from_str (next_file ());
+        status = chattr_apply (&op, OP_CHOWN, vpath);
         vfs_path_free (vpath);
+        do_file_mark (current_panel, current_file, 0);
+
+        if (status == FILE_ABORT)
+            break;
     }
     while (current_panel->marked != 0);
+
+    chattr_op_deinit (&op);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -871,7 +884,16 @@ chown_advanced_cmd (void)
 
         case B_ENTER:
             need_update = TRUE;
-            if (mc_chmod (vpath, get_mode ()) == -1)
+            if (chattr_checks_get_targets (&recursive_checks) != 0)
+            {
+                chattr_op_t op;
+
+                init_chattr_op (&op, sf_stat);
+                if (chattr_apply (&op, OP_CHOWN, vpath) == FILE_ABORT)
+                    end_chown = TRUE;
+                chattr_op_deinit (&op);
+            }
+            else if (mc_chmod (vpath, get_mode ()) == -1)
                 message (D_ERROR, MSG_ERROR, _("Cannot chmod \"%s\"\n%s"),
                          fname, unix_error_string (errno));
             /* call mc_chown only, if mc_chmod didn't fail */
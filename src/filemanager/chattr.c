@@ -0,0 +1,925 @@
+/*
+   Recursive change of permissions and ownership.
+
+   Copyright (C) 2014
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \file src/filemanager/chattr.c
+ *  \brief Source: recursive change of permissions and ownership
+ *
+ *  Used by Chmod, Chown and Advanced chown commands to apply one change to the marked
+ *  entries and, optionally, to files and/or subdirectories below them.
+ *
+ *  On local filesystems the tree is walked with directory descriptors and entries are
+ *  changed with fchownat() and fchmodat() relative to them. If the type of entry is
+ *  reported by readdir() and entry isn't changed, it isn't stat'ed at all. Other VFS
+ *  are walked with mc_opendir() and changed with mc_chown() and mc_chmod().
+ *
+ *  Entries that already have the requested mode and owner are not touched. Symbolic
+ *  links below the selected entries are neither followed nor changed. Permissions of
+ *  directory are changed before its contents unless the change removes read or search
+ *  access, then after them.
+ *
+ *  Local trees are walked by a worker thread if threads are available. The main thread
+ *  keeps the progress dialog: the worker posts completions with tty_post_completion()
+ *  to wake it up, and waits for it while the user answers an error.
+ *
+ *  Errors are reported with file_error(), so Skip, Skip all, Retry and Abort work like
+ *  in other file operations.
+ */
+
+#include <config.h>
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "lib/global.h"
+#include "lib/timer.h"
+#include "lib/tty/event.h"      /* tty_post_completion() */
+#include "lib/vfs/vfs.h"
+#include "lib/widget.h"
+
+#include "filegui.h"
+#include "file.h"               /* file_error() */
+
+#include "chattr.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+#if defined (HAVE_OPENAT) && defined (HAVE_FSTATAT) && defined (HAVE_FDOPENDIR) \
+    && defined (HAVE_FCHMODAT) && defined (HAVE_FCHOWNAT)
+#define CHATTR_LOCAL 1
+#endif
+
+#if defined (CHATTR_LOCAL) && defined (HAVE_GLIB_THREADS)
+#define CHATTR_THREADED 1
+#endif
+
+/* interval between progress dialog updates, in microseconds */
+#define CHATTR_UPDATE_INTERVAL (G_USEC_PER_SEC / 10)
+
+/* permission bits that can be changed */
+#define CHATTR_MODE_MASK 07777
+
+/* bits required to list directory and to reach its entries */
+#define CHATTR_DIR_ACCESS (S_IRUSR | S_IXUSR | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH)
+
+#ifndef O_DIRECTORY
+#define O_DIRECTORY 0
+#endif
+
+#ifndef O_NOFOLLOW
+#define O_NOFOLLOW 0
+#endif
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+/*** file scope type declarations ****************************************************************/
+
+#ifdef CHATTR_THREADED
+/* State of local tree walk shared by the worker thread and the main thread */
+struct chattr_worker_struct
+{
+    GMutex lock;
+    GCond cond;
+    chattr_op_t *op;
+    const char *root;           /* path of the selected directory */
+    FileProgressStatus status;  /* result of walk */
+    gboolean finished;
+
+    /* progress */
+    size_t count;
+    char *path;                 /* directory shown in progress dialog */
+    gint64 last_wakeup;
+    FileProgressStatus button;  /* FILE_SKIP or FILE_ABORT pressed by user */
+    gboolean suspended;
+
+    /* error to be shown by the main thread */
+    gboolean error_pending;
+    const char *error_format;
+    char *error_path;
+    int error;
+    FileProgressStatus answer;
+};
+#endif /* CHATTR_THREADED */
+
+/*** file scope variables ************************************************************************/
+
+static const char *chattr_check_text[] = {
+    N_("&Files in subdirectories"),
+    N_("Subdirect&ories")
+};
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static mode_t
+chattr_new_mode (const chattr_op_t * op, mode_t mode)
+{
+    return ((mode & op->and_mask) | op->or_mask) & CHATTR_MODE_MASK;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Whether mode should be set. Successful change of owner may reset set-user-ID and set-group-ID
+ * bits, so they are set again even if mode hasn't been changed by the mask.
+ */
+
+static gboolean
+chattr_mode_changed (const chattr_op_t * op, const struct stat *st, gboolean chowned)
+{
+    mode_t mode;
+
+    if (!op->change_mode)
+        return FALSE;
+
+    mode = chattr_new_mode (op, st->st_mode);
+
+    return mode != (st->st_mode & CHATTR_MODE_MASK)
+        || (chowned && (mode & (S_ISUID | S_ISGID)) != 0);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+chattr_owner_changed (const chattr_op_t * op, const struct stat *st)
+{
+    return (op->uid != (uid_t) (-1) && op->uid != st->st_uid)
+        || (op->gid != (gid_t) (-1) && op->gid != st->st_gid);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Whether directory should be changed after its contents: otherwise it could become
+ * unreadable before it is walked.
+ */
+
+static gboolean
+chattr_dir_late (const chattr_op_t * op, const struct stat *st)
+{
+    return op->change_mode && (st->st_mode & ~chattr_new_mode (op, st->st_mode)
+                               & CHATTR_DIR_ACCESS) != 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Ask user what to do with error. Called in the main thread.
+ *
+ * @return FILE_RETRY, FILE_SKIP, FILE_SKIPALL or FILE_ABORT
+ */
+
+static FileProgressStatus
+chattr_ask (chattr_op_t * op, const char *format, const char *path, int error)
+{
+    FileProgressStatus status;
+
+    if (op->ctx->skip_all)
+        return FILE_SKIPALL;
+
+    errno = error;
+    status = file_error (_(format), path);
+
+    if (status == FILE_SKIPALL)
+        op->ctx->skip_all = TRUE;
+
+    return status;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef CHATTR_THREADED
+/** Called in the main thread: completion only ends waiting for events */
+
+static void
+chattr_worker_wakeup (void *data)
+{
+    (void) data;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Pass error to the main thread and wait for answer of user. Called in the worker thread. */
+
+static FileProgressStatus
+chattr_worker_error (chattr_worker_t * w, const char *format, const char *path, int error)
+{
+    FileProgressStatus status;
+
+    g_mutex_lock (&w->lock);
+    if (w->button == FILE_ABORT)
+        status = FILE_ABORT;
+    else
+    {
+        w->error_format = format;
+        w->error_path = g_strdup (path);
+        w->error = error;
+        w->error_pending = TRUE;
+        g_cond_broadcast (&w->cond);
+        tty_post_completion (chattr_worker_wakeup, NULL);
+
+        while (w->error_pending)
+            g_cond_wait (&w->cond, &w->lock);
+        status = w->answer;
+    }
+    g_mutex_unlock (&w->lock);
+
+    return status;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Count processed entry, wake up the main thread from time to time to show progress.
+ * Called in the worker thread.
+ */
+
+static FileProgressStatus
+chattr_worker_progress (chattr_worker_t * w, const char *path)
+{
+    FileProgressStatus status;
+    gint64 now;
+    gboolean wakeup = FALSE;
+
+    now = g_get_monotonic_time ();
+
+    g_mutex_lock (&w->lock);
+    w->count++;
+    if (w->count == 1 || now - w->last_wakeup >= CHATTR_UPDATE_INTERVAL)
+    {
+        g_free (w->path);
+        w->path = g_strdup (path);
+        w->last_wakeup = now;
+        wakeup = TRUE;
+        g_cond_broadcast (&w->cond);
+    }
+
+    while (w->suspended && w->button != FILE_ABORT)
+        g_cond_wait (&w->cond, &w->lock);
+
+    status = w->button;
+    /* Skip is applied to one directory */
+    if (status == FILE_SKIP)
+        w->button = FILE_CONT;
+    g_mutex_unlock (&w->lock);
+
+    if (wakeup)
+        tty_post_completion (chattr_worker_wakeup, NULL);
+
+    return status;
+}
+#endif /* CHATTR_THREADED */
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Ask user what to do with error.
+ *
+ * @param dir_path path of directory that contains the entry, or NULL if name is full path
+ * @return FILE_RETRY, FILE_SKIP, FILE_SKIPALL or FILE_ABORT
+ */
+
+static FileProgressStatus
+chattr_error (chattr_op_t * op, const char *format, const char *dir_path, const char *name,
+              int error)
+{
+    FileProgressStatus status;
+    char *path;
+
+    path = dir_path == NULL ? g_strdup (name) : g_build_filename (dir_path, name, (char *) NULL);
+#ifdef CHATTR_THREADED
+    if (op->worker != NULL)
+        status = chattr_worker_error (op->worker, format, path, error);
+    else
+#endif
+        status = chattr_ask (op, format, path, error);
+    g_free (path);
+
+    return status;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Count processed entry. Update progress dialog and check its buttons from time to time.
+ *
+ * @param path path shown in progress dialog
+ */
+
+static FileProgressStatus
+chattr_progress (chattr_op_t * op, const char *path)
+{
+    guint64 now;
+    FileProgressStatus status;
+
+#ifdef CHATTR_THREADED
+    if (op->worker != NULL)
+        return chattr_worker_progress (op->worker, path);
+#endif
+
+    op->count++;
+
+    now = mc_timer_elapsed (op->timer);
+    if (op->count != 1 && now - op->last_update < CHATTR_UPDATE_INTERVAL)
+        return FILE_CONT;
+
+    op->last_update = now;
+    file_progress_show_path (op->ctx, path);
+    file_progress_show_count (op->ctx, op->count, 0);
+    status = check_progress_buttons (op->ctx);
+    mc_refresh ();
+
+    return status;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Change one entry with VFS calls. Owner is changed first: it may reset set-user-ID
+ * and set-group-ID bits.
+ */
+
+static FileProgressStatus
+chattr_vfs_set (chattr_op_t * op, const vfs_path_t * vpath, const struct stat *st)
+{
+    gboolean chowned = FALSE;
+
+    if (chattr_owner_changed (op, st))
+    {
+        while (mc_chown (vpath, op->uid, op->gid) != 0)
+        {
+            FileProgressStatus status;
+
+            status = chattr_error (op, N_("Cannot chown \"%s\"\n%s"), NULL,
+                                   vfs_path_as_str (vpath), errno);
+            if (status != FILE_RETRY)
+                return status;
+        }
+
+        chowned = TRUE;
+    }
+
+    if (chattr_mode_changed (op, st, chowned))
+        while (mc_chmod (vpath, chattr_new_mode (op, st->st_mode)) != 0)
+        {
+            FileProgressStatus status;
+
+            status = chattr_error (op, N_("Cannot chmod \"%s\"\n%s"), NULL,
+                                   vfs_path_as_str (vpath), errno);
+            if (status != FILE_RETRY)
+                return status;
+        }
+
+    return FILE_CONT;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Change contents of directory with VFS calls.
+ */
+
+static FileProgressStatus
+chattr_vfs_walk (chattr_op_t * op, const vfs_path_t * vpath)
+{
+    DIR *dir;
+    struct dirent *dirent;
+    FileProgressStatus status = FILE_CONT;
+
+    while ((dir = mc_opendir (vpath)) == NULL)
+    {
+        status = chattr_error (op, N_("Cannot open directory \"%s\"\n%s"), NULL,
+                               vfs_path_as_str (vpath), errno);
+        if (status != FILE_RETRY)
+            return status;
+    }
+
+    while (status != FILE_ABORT && (dirent = mc_readdir (dir)) != NULL)
+    {
+        vfs_path_t *entry_vpath;
+        struct stat st;
+
+        if (DIR_IS_DOT (dirent->d_name) || DIR_IS_DOTDOT (dirent->d_name))
+            continue;
+
+        status = chattr_progress (op, vfs_path_as_str (vpath));
+        if (status != FILE_CONT)
+            break;
+
+        entry_vpath = vfs_path_append_new (vpath, dirent->d_name, NULL);
+
+        while (mc_lstat (entry_vpath, &st) != 0)
+        {
+            status = chattr_error (op, N_("Cannot stat file \"%s\"\n%s"), NULL,
+                                   vfs_path_as_str (entry_vpath), errno);
+            if (status != FILE_RETRY)
+                break;
+        }
+        /* stat succeeded after retry */
+        if (status == FILE_RETRY)
+            status = FILE_CONT;
+
+        if (status != FILE_CONT || S_ISLNK (st.st_mode))
+        {
+            /* entry is skipped */
+        }
+        else if (!S_ISDIR (st.st_mode))
+        {
+            if ((op->targets & CHATTR_FILES) != 0)
+                status = chattr_vfs_set (op, entry_vpath, &st);
+        }
+        else
+        {
+            gboolean late;
+
+            late = (op->targets & CHATTR_DIRS) != 0 && chattr_dir_late (op, &st);
+
+            if ((op->targets & CHATTR_DIRS) != 0 && !late)
+                status = chattr_vfs_set (op, entry_vpath, &st);
+            if (status != FILE_ABORT)
+                status = chattr_vfs_walk (op, entry_vpath);
+            if (status != FILE_ABORT && late)
+                status = chattr_vfs_set (op, entry_vpath, &st);
+        }
+
+        vfs_path_free (entry_vpath);
+
+        if (status != FILE_ABORT)
+            status = FILE_CONT;
+    }
+
+    mc_closedir (dir);
+
+    return status == FILE_ABORT ? FILE_ABORT : FILE_CONT;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef CHATTR_LOCAL
+/**
+ * Change one entry of local directory.
+ *
+ * @param dir_fd descriptor of directory that contains the entry
+ * @param dir_path path of directory, used in error messages
+ */
+
+static FileProgressStatus
+chattr_local_set (chattr_op_t * op, int dir_fd, const char *name, const char *dir_path,
+                  const struct stat *st)
+{
+    gboolean chowned = FALSE;
+
+    if (chattr_owner_changed (op, st))
+    {
+        while (fchownat (dir_fd, name, op->uid, op->gid, AT_SYMLINK_NOFOLLOW) != 0)
+        {
+            FileProgressStatus status;
+
+            status = chattr_error (op, N_("Cannot chown \"%s\"\n%s"), dir_path, name, errno);
+            if (status != FILE_RETRY)
+                return status;
+        }
+
+        chowned = TRUE;
+    }
+
+    if (chattr_mode_changed (op, st, chowned))
+        while (fchmodat (dir_fd, name, chattr_new_mode (op, st->st_mode), 0) != 0)
+        {
+            FileProgressStatus status;
+
+            status = chattr_error (op, N_("Cannot chmod \"%s\"\n%s"), dir_path, name, errno);
+            if (status != FILE_RETRY)
+                return status;
+        }
+
+    return FILE_CONT;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Open local directory without following symlink. Retry while user asks.
+ *
+ * @param dir_fd descriptor of directory that contains the entry, or AT_FDCWD
+ * @param path full path of directory, used in error messages
+ * @return directory stream or NULL; then status is set to FILE_SKIP, FILE_SKIPALL
+ *         or FILE_ABORT
+ */
+
+static DIR *
+chattr_local_opendir (chattr_op_t * op, int dir_fd, const char *name, const char *path,
+                      FileProgressStatus * status)
+{
+    while (TRUE)
+    {
+        int fd;
+        int error;
+
+        fd = openat (dir_fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC | O_NOCTTY);
+        if (fd != -1)
+        {
+            DIR *dir;
+
+            dir = fdopendir (fd);
+            if (dir != NULL)
+                return dir;
+
+            error = errno;
+            close (fd);
+        }
+        else
+            error = errno;
+
+        *status = chattr_error (op, N_("Cannot open directory \"%s\"\n%s"), NULL, path, error);
+        if (*status != FILE_RETRY)
+            return NULL;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Change contents of local directory.
+ *
+ * @param path full path of directory, shown in progress dialog and used in error messages
+ */
+
+static FileProgressStatus
+chattr_local_walk (chattr_op_t * op, DIR * dir, const char *path)
+{
+    struct dirent *dirent;
+    FileProgressStatus status = FILE_CONT;
+
+    while (status != FILE_ABORT && (dirent = readdir (dir)) != NULL)
+    {
+        const char *name = dirent->d_name;
+        struct stat st;
+
+        if (DIR_IS_DOT (name) || DIR_IS_DOTDOT (name))
+            continue;
+
+        status = chattr_progress (op, path);
+        if (status != FILE_CONT)
+            break;
+
+#ifdef HAVE_STRUCT_DIRENT_D_TYPE
+        /* skip files without stat if only directories are changed */
+        if ((op->targets & CHATTR_FILES) == 0 && dirent->d_type != DT_UNKNOWN
+            && dirent->d_type != DT_DIR)
+            continue;
+#endif
+
+        while (fstatat (dirfd (dir), name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+        {
+            status = chattr_error (op, N_("Cannot stat file \"%s\"\n%s"), path, name, errno);
+            if (status != FILE_RETRY)
+                break;
+        }
+        /* stat succeeded after retry */
+        if (status == FILE_RETRY)
+            status = FILE_CONT;
+
+        if (status != FILE_CONT || S_ISLNK (st.st_mode))
+        {
+            /* entry is skipped */
+        }
+        else if (!S_ISDIR (st.st_mode))
+        {
+            if ((op->targets & CHATTR_FILES) != 0)
+                status = chattr_local_set (op, dirfd (dir), name, path, &st);
+        }
+        else
+        {
+            gboolean late;
+            char *sub_path;
+            DIR *sub;
+
+            late = (op->targets & CHATTR_DIRS) != 0 && chattr_dir_late (op, &st);
+
+            if ((op->targets & CHATTR_DIRS) != 0 && !late)
+                status = chattr_local_set (op, dirfd (dir), name, path, &st);
+
+            sub_path = g_build_filename (path, name, (char *) NULL);
+
+            if (status != FILE_ABORT)
+            {
+                sub = chattr_local_opendir (op, dirfd (dir), name, sub_path, &status);
+                if (sub != NULL)
+                {
+                    status = chattr_local_walk (op, sub, sub_path);
+                    closedir (sub);
+                }
+            }
+
+            if (status != FILE_ABORT && late)
+                status = chattr_local_set (op, dirfd (dir), name, path, &st);
+
+            g_free (sub_path);
+        }
+
+        if (status != FILE_ABORT)
+            status = FILE_CONT;
+    }
+
+    return status == FILE_ABORT ? FILE_ABORT : FILE_CONT;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static FileProgressStatus
+chattr_local_tree (chattr_op_t * op, const char *path)
+{
+    DIR *dir;
+    FileProgressStatus status = FILE_CONT;
+
+    dir = chattr_local_opendir (op, AT_FDCWD, path, path, &status);
+    if (dir == NULL)
+        return status;
+
+    status = chattr_local_walk (op, dir, path);
+    closedir (dir);
+
+    return status;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef CHATTR_THREADED
+static gpointer
+chattr_worker (gpointer data)
+{
+    chattr_worker_t *w = (chattr_worker_t *) data;
+    FileProgressStatus status;
+
+    status = chattr_local_tree (w->op, w->root);
+
+    g_mutex_lock (&w->lock);
+    w->status = status;
+    w->finished = TRUE;
+    g_cond_broadcast (&w->cond);
+    g_mutex_unlock (&w->lock);
+
+    tty_post_completion (chattr_worker_wakeup, NULL);
+
+    return NULL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Walk local tree in the worker thread. The main thread shows progress, handles buttons
+ * of progress dialog and asks user about errors until the worker finishes.
+ *
+ * @return FALSE if thread can't be created
+ */
+
+static gboolean
+chattr_local_tree_threaded (chattr_op_t * op, const char *path, FileProgressStatus * status)
+{
+    chattr_worker_t w;
+    GThread *thread;
+
+    memset (&w, 0, sizeof (w));
+    g_mutex_init (&w.lock);
+    g_cond_init (&w.cond);
+    w.op = op;
+    w.root = path;
+    w.count = op->count;
+    w.button = FILE_CONT;
+
+    op->worker = &w;
+    thread = g_thread_try_new ("chattr", chattr_worker, &w, NULL);
+    if (thread == NULL)
+    {
+        op->worker = NULL;
+        g_cond_clear (&w.cond);
+        g_mutex_clear (&w.lock);
+        return FALSE;
+    }
+
+    g_mutex_lock (&w.lock);
+
+    while (!w.finished || w.error_pending)
+    {
+        char *shown;
+        FileProgressStatus button;
+
+        if (w.error_pending)
+        {
+            FileProgressStatus answer;
+
+            g_mutex_unlock (&w.lock);
+            answer = chattr_ask (op, w.error_format, w.error_path, w.error);
+            g_mutex_lock (&w.lock);
+
+            g_free (w.error_path);
+            w.error_path = NULL;
+            w.answer = answer;
+            w.error_pending = FALSE;
+            if (answer == FILE_ABORT)
+                w.button = FILE_ABORT;
+            g_cond_broadcast (&w.cond);
+            continue;
+        }
+
+        op->count = w.count;
+        shown = g_strdup (w.path);
+
+        if (op->ctx->ui == NULL)
+        {
+            /* nothing to show: just wait for the worker */
+            g_cond_wait (&w.cond, &w.lock);
+            g_free (shown);
+            continue;
+        }
+
+        g_mutex_unlock (&w.lock);
+
+        if (shown != NULL)
+            file_progress_show_path (op->ctx, shown);
+        file_progress_show_count (op->ctx, op->count, 0);
+        mc_refresh ();
+        g_free (shown);
+
+        /* wait for key or for completion posted by worker */
+        button = wait_progress_buttons (op->ctx);
+
+        g_mutex_lock (&w.lock);
+        if ((button == FILE_SKIP || button == FILE_ABORT) && w.button != FILE_ABORT)
+            w.button = button;
+        w.suspended = op->ctx->suspended;
+        g_cond_broadcast (&w.cond);
+    }
+
+    *status = w.status;
+    op->count = w.count;
+    g_mutex_unlock (&w.lock);
+
+    g_thread_join (thread);
+    op->worker = NULL;
+
+    g_free (w.path);
+    g_cond_clear (&w.cond);
+    g_mutex_clear (&w.lock);
+
+    return TRUE;
+}
+#endif /* CHATTR_THREADED */
+#endif /* CHATTR_LOCAL */
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+void
+chattr_op_init (chattr_op_t * op)
+{
+    memset (op, 0, sizeof (*op));
+    op->and_mask = ~op->and_mask;
+    op->uid = (uid_t) (-1);
+    op->gid = (gid_t) (-1);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+chattr_op_deinit (chattr_op_t * op)
+{
+    if (op->ctx != NULL)
+    {
+        file_op_end ();
+        file_op_context_destroy (op->ctx);
+        op->ctx = NULL;
+    }
+    if (op->timer != NULL)
+        mc_timer_destroy (op->timer);
+    op->timer = NULL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Change the selected entry and, if op->targets is not 0 and the entry is a directory,
+ * the entries below it. Symlink given as vpath is followed like mc_chmod() does.
+ * Progress dialog is shown on the first call, unless op->ctx is already set.
+ *
+ * @return FILE_ABORT if user aborted the operation, FILE_CONT otherwise
+ */
+
+FileProgressStatus
+chattr_apply (chattr_op_t * op, FileOperation operation, const vfs_path_t * vpath)
+{
+    struct stat st, lst;
+    gboolean descend, late;
+    FileProgressStatus status = FILE_CONT;
+
+    if (op->ctx == NULL)
+    {
+        op->ctx = file_op_context_new (operation);
+        file_op_begin ();
+        file_op_context_create_ui (op->ctx, FALSE, FILEGUI_DIALOG_DELETE_ITEM);
+    }
+
+    if (op->timer == NULL)
+        op->timer = mc_timer_new ();
+
+    if (chattr_progress (op, vfs_path_as_str (vpath)) == FILE_ABORT)
+        return FILE_ABORT;
+
+    while (mc_stat (vpath, &st) != 0)
+    {
+        status = chattr_error (op, N_("Cannot stat file \"%s\"\n%s"), NULL,
+                               vfs_path_as_str (vpath), errno);
+        if (status != FILE_RETRY)
+            return status == FILE_ABORT ? FILE_ABORT : FILE_CONT;
+    }
+
+    descend = op->targets != 0 && S_ISDIR (st.st_mode) && mc_lstat (vpath, &lst) == 0
+        && S_ISDIR (lst.st_mode);
+    late = descend && chattr_dir_late (op, &st);
+
+    if (!late)
+        status = chattr_vfs_set (op, vpath, &st);
+
+    if (descend && status != FILE_ABORT)
+    {
+#ifdef CHATTR_LOCAL
+        if (vfs_file_is_local (vpath))
+        {
+            const char *path = vfs_path_get_by_index (vpath, -1)->path;
+
+#ifdef CHATTR_THREADED
+            if (!chattr_local_tree_threaded (op, path, &status))
+#endif
+                status = chattr_local_tree (op, path);
+        }
+        else
+#endif
+            status = chattr_vfs_walk (op, vpath);
+    }
+
+    if (late && status != FILE_ABORT)
+        status = chattr_vfs_set (op, vpath, &st);
+
+    return status == FILE_ABORT ? FILE_ABORT : FILE_CONT;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Add checkboxes of recursive mode in one row. Both are unchecked.
+ */
+
+void
+chattr_checks_add (WDialog * h, int y, int x, chattr_checks_t * checks)
+{
+    static gboolean i18n = FALSE;
+
+    if (!i18n)
+    {
+#ifdef ENABLE_NLS
+        size_t i;
+
+        for (i = 0; i < G_N_ELEMENTS (chattr_check_text); i++)
+            chattr_check_text[i] = _(chattr_check_text[i]);
+#endif /* ENABLE_NLS */
+        i18n = TRUE;
+    }
+
+    checks->files = check_new (y, x, 0, chattr_check_text[0]);
+    add_widget (h, checks->files);
+    checks->dirs = check_new (y, x + WIDGET (checks->files)->cols + 2, 0, chattr_check_text[1]);
+    add_widget (h, checks->dirs);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+chattr_checks_get_targets (const chattr_checks_t * checks)
+{
+    int targets = 0;
+
+    if ((checks->files->state & C_BOOL) != 0)
+        targets |= CHATTR_FILES;
+    if ((checks->dirs->state & C_BOOL) != 0)
+        targets |= CHATTR_DIRS;
+
+    return targets;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,78 @@
+/** \file  chattr.h
+ *  \brief Header: recursive change of permissions and ownership
+ */
+
+#ifndef MC__CHATTR_H
+#define MC__CHATTR_H
+
+#include <sys/types.h>
+
+#include "lib/global.h"
+#include "lib/timer.h"
+#include "lib/vfs/vfs.h"        /* vfs_path_t */
+#include "lib/widget.h"
+
+#include "fileopctx.h"
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+/*** enums ***************************************************************************************/
+
+/* Which entries below the selected directory are changed */
+typedef enum
+{
+    CHATTR_FILES = 1 << 0,      /* files and other non-directories, except symlinks */
+    CHATTR_DIRS = 1 << 1        /* subdirectories */
+} chattr_targets_t;
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+struct chattr_worker_struct;
+typedef struct chattr_worker_struct chattr_worker_t;
+
+typedef struct
+{
+    /* new mode is (old mode & and_mask) | or_mask */
+    gboolean change_mode;
+    mode_t and_mask;
+    mode_t or_mask;
+
+    /* (uid_t) -1 and (gid_t) -1 keep owner and group */
+    uid_t uid;
+    gid_t gid;
+
+    /* combination of chattr_targets_t flags, 0 for the selected entry only */
+    int targets;
+
+    /* progress: context is created with dialog on first use */
+    file_op_context_t *ctx;
+    size_t count;
+    mc_timer_t *timer;
+    guint64 last_update;
+
+    /* thread that walks local tree now, NULL if it is walked by the caller */
+    chattr_worker_t *worker;
+} chattr_op_t;
+
+/* Checkboxes of recursive mode in chmod and chown dialogs */
+typedef struct
+{
+    WCheck *files;
+    WCheck *dirs;
+} chattr_checks_t;
+
+/*** global variables defined in .c file *********************************************************/
+
+/*** declarations of public functions ************************************************************/
+
+void chattr_op_init (chattr_op_t * op);
+void chattr_op_deinit (chattr_op_t * op);
+FileProgressStatus chattr_apply (chattr_op_t * op, FileOperation operation,
+                                 const vfs_path_t * vpath);
+
+void chattr_checks_add (WDialog * h, int y, int x, chattr_checks_t * checks);
+int chattr_checks_get_targets (const chattr_checks_t * checks);
+
+/*** inline functions ****************************************************************************/
+
+#endif /* MC__CHATTR_H */
@@ -42,6 +42,7 @@
 #include "lib/keybind.h"        /* CK_Cancel */
 
 #include "midnight.h"           /* current_panel */
+#include "chattr.h"
 #include "chmod.h"
 
 /*** global variables ****************************************************************************/
@@ -65,10 +66,11 @@ static gboolean single_set;
 static gboolean mode_change, need_update, end_chmod;
 static int c_file;
 
-static mode_t and_mask, or_mask, c_stat;
+static mode_t c_stat;
 
 static WLabel *statl;
 static WGroupbox *file_gb;
+static chattr_checks_t recursive_checks;
 
 static struct
 {
@@ -300,7 +302,7 @@ init_chmod (const char *fname, const struct stat *sf_stat)
     cols = str_term_width1 (fname) + 2 + 1;
     file_gb_len = max (file_gb_len, cols);
 
-    lines = single_set ? 20 : 23;
+    lines = single_set ? 21 : 24;
     cols = perm_gb_len + file_gb_len + 1 + 6;
 
     if (cols > COLS)
@@ -340,6 +342,8 @@ init_chmod (const char *fname, const struct stat *sf_stat)
     c_fgrp = str_trunc (get_group (sf_stat->st_gid), file_gb_len - 3);
     add_widget (ch_dlg, label_new (y + 6, cols, c_fgrp));
 
+    chattr_checks_add (ch_dlg, PY + check_perm_num + 2, PX, &recursive_checks);
+
     if (!single_set)
     {
         i = 0;
@@ -400,47 +404,26 @@ next_file (void)
 /* --------------------------------------------------------------------------------------------- */
 
 static void
-do_chmod (struct stat *sf)
-{
-    vfs_path_t *vpath;
-    sf->st_mode &= and_mask;
-    sf->st_mode |= or_mask;
-
-    vpath = vfs_path_from_str (current_panel->dir.list[c_file].fname);
-    if (mc_chmod (vpath, sf->st_mode) == -1)
-        message (D_ERROR, MSG_ERROR, _("Cannot chmod \"%s\"\n%s"),
-                 current_panel->dir.list[c_file].fname, unix_error_string (errno));
-
-    vfs_path_free (vpath);
-    do_file_mark (current_panel, c_file, 0);
-}
-
-/* --------------------------------------------------------------------------------------------- */
-
-static void
-apply_mask (struct stat *sf)
+apply_mask (chattr_op_t * op)
 {
     need_update = TRUE;
     end_chmod = TRUE;
 
-    do_chmod (sf);
+    op->change_mode = TRUE;
+    op->targets = chattr_checks_get_targets (&recursive_checks);
 
     do
     {
-        char *fname;
         vfs_path_t *vpath;
-        gboolean ok;
+        FileProgressStatus status;
 
-        fname = next_file ();
-        vpath = vfs_path_from_str (fname);
-        ok = (mc_stat (vpath, sf) == 0);
+        vpath = vfs_path_from_str (next_file ());
+        status = chattr_apply (op, OP_CHMOD, vpath);
         vfs_path_free (vpath);
-        if (!ok)
-            return;
-
-        c_stat = sf->st_mode;
+        do_file_mark (current_panel, c_file, 0);
 
-        do_chmod (sf);
+        if (status == FILE_ABORT)
+            break;
     }
     while (current_panel->marked != 0);
 }
@@ -462,6 +445,7 @@ chmod_cmd (void)
         char *fname;
         int result;
         unsigned int i;
+        chattr_op_t op;
 
         do_refresh ();
 
@@ -486,6 +470,7 @@ chmod_cmd (void)
         c_stat = sf_stat.st_mode;
 
         ch_dlg = init_chmod (fname, &sf_stat);
+        chattr_op_init (&op);
 
         /* do action */
         result = dlg_run (ch_dlg);
@@ -493,7 +478,17 @@ chmod_cmd (void)
         switch (result)
         {
         case B_ENTER:
-            if (mode_change && mc_chmod (vpath, c_stat) == -1)
+            op.targets = chattr_checks_get_targets (&recursive_checks);
+            if (mode_change && op.targets != 0)
+            {
+                /* apply to the tree only the bits toggled in dialog */
+                op.change_mode = TRUE;
+                op.or_mask = c_stat & ~sf_stat.st_mode;
+                op.and_mask = ~(sf_stat.st_mode & ~c_stat);
+                if (chattr_apply (&op, OP_CHMOD, vpath) == FILE_ABORT)
+                    end_chmod = TRUE;
+            }
+            else if (mode_change && mc_chmod (vpath, c_stat) == -1)
                 message (D_ERROR, MSG_ERROR, _("Cannot chmod \"%s\"\n%s"),
                          fname, unix_error_string (errno));
             need_update = TRUE;
@@ -505,44 +500,37 @@ chmod_cmd (void)
 
         case B_ALL:
         case B_MARKED:
-            and_mask = or_mask = 0;
-            and_mask = ~and_mask;
-
             for (i = 0; i < check_perm_num; i++)
                 if (check_perm[i].selected || result == B_ALL)
                 {
                     if (check_perm[i].check->state & C_BOOL)
-                        or_mask |= check_perm[i].mode;
+                        op.or_mask |= check_perm[i].mode;
                     else
-                        and_mask &= ~check_perm[i].mode;
+                        op.and_mask &= ~check_perm[i].mode;
                 }
 
-            apply_mask (&sf_stat);
+            apply_mask (&op);
             break;
 
         case B_SETMRK:
-            and_mask = or_mask = 0;
-            and_mask = ~and_mask;
-
             for (i = 0; i < check_perm_num; i++)
                 if (check_perm[i].selected)
-                    or_mask |= check_perm[i].mode;
+                    op.or_mask |= check_perm[i].mode;
 
-            apply_mask (&sf_stat);
+            apply_mask (&op);
             break;
 
         case B_CLRMRK:
-            and_mask = or_mask = 0;
-            and_mask = ~and_mask;
-
             for (i = 0; i < check_perm_num; i++)
                 if (check_perm[i].selected)
-                    and_mask &= ~check_perm[i].mode;
+                    op.and_mask &= ~check_perm[i].mode;
 
-            apply_mask (&sf_stat);
+            apply_mask (&op);
             break;
         }
 
+        chattr_op_deinit (&op);
+
         if (current_panel->marked != 0 && result != B_CANCEL)
         {
             do_file_mark (current_panel, c_file, 0);
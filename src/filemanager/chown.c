@@ -49,6 +49,7 @@
 /* Needed for the extern declarations of integer parameters */
 #include "chmod.h"
 #include "midnight.h"           /* current_panel */
+#include "chattr.h"
 
 #include "chown.h"
 
@@ -77,6 +78,7 @@ static int need_update, end_chown;
 static int current_file;
 static int single_set;
 static WListbox *l_user, *l_group;
+static chattr_checks_t recursive_checks;
 
 /* *INDENT-OFF* */
 static struct
@@ -208,7 +210,7 @@ init_chown (void)
     single_set = (current_panel->marked < 2) ? 3 : 0;
 
     cols = GW * 3 + 2 + 6;
-    lines = GH + 4 + (single_set ? 2 : 4);
+    lines = GH + 5 + (single_set ? 2 : 4);
 
     ch_dlg =
         dlg_create (TRUE, 0, 0, lines, cols, dialog_colors, chown_callback, NULL, "[Chown]",
@@ -244,6 +246,8 @@ init_chown (void)
         add_widget (ch_dlg, chown_label[i].l);
     }
 
+    chattr_checks_add (ch_dlg, GH + 2, 3, &recursive_checks);
+
     if (!single_set)
     {
         int x;
@@ -291,35 +295,34 @@ chown_done (void)
 
 /* --------------------------------------------------------------------------------------------- */
 
-static void
-do_chown (uid_t u, gid_t g)
-{
-    vfs_path_t *vpath;
-
-    vpath = vfs_path_from_str (current_panel->dir.list[current_file].fname);
-    if (mc_chown (vpath, u, g) == -1)
-        message (D_ERROR, MSG_ERROR, _("Cannot chown \"%s\"\n%s"),
-                 current_panel->dir.list[current_file].fname, unix_error_string (errno));
-
-    vfs_path_free (vpath);
-    do_file_mark (current_panel, current_file, 0);
-}
-
-/* --------------------------------------------------------------------------------------------- */
-
 static void
 apply_chowns (uid_t u, gid_t g)
 {
+    chattr_op_t op;
 
     need_update = end_chown = 1;
-    do_chown (u, g);
+
+    chattr_op_init (&op);
+    op.uid = u;
+    op.gid = g;
+    op.targets = chattr_checks_get_targets (&recursive_checks);
 
     do
     {
-        next_file ();
-        do_chown (u, g);
+        vfs_path_t *vpath;
+        FileProgressStatus status;
+
+        vpath = vfs_path_from_str (next_file ());
+        status = chattr_apply (&op, OP_CHOWN, vpath);
+        vfs_path_free (vpath);
+        do_file_mark (current_panel, current_file, 0);
+
+        if (status == FILE_ABORT)
+            break;
     }
     while (current_panel->marked);
+
+    chattr_op_deinit (&op);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -427,7 +430,19 @@ chown_cmd (void)
 
                     fname_vpath = vfs_path_from_str (fname);
                     need_update = 1;
-                    if (mc_chown (fname_vpath, new_user, new_group) == -1)
+                    if (chattr_checks_get_targets (&recursive_checks) != 0)
+                    {
+                        chattr_op_t op;
+
+                        chattr_op_init (&op);
+                        op.uid = new_user;
+                        op.gid = new_group;
+                        op.targets = chattr_checks_get_targets (&recursive_checks);
+                        if (chattr_apply (&op, OP_CHOWN, fname_vpath) == FILE_ABORT)
+                            end_chown = 1;
+                        chattr_op_deinit (&op);
+                    }
+                    else if (mc_chown (fname_vpath, new_user, new_group) == -1)
                         message (D_ERROR, MSG_ERROR, _("Cannot chown \"%s\"\n%s"),
                                  fname, unix_error_string (errno));
                     vfs_path_free (fname_vpath);
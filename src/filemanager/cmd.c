@@ -94,6 +94,7 @@
 #include "ext.h"                /* regex_command() */
 #include "boxes.h"              /* cd_dialog() */
 #include "dir.h"
+#include "dirsize.h"            /* dirsize_cache_invalidate() */
 
 #include "cmd.h"                /* Our definitions */
 
@@ -129,7 +130,7 @@ static void
 do_view_cmd (gboolean normal)
 {
     /* Directories are viewed by changing to them */
-    if (S_ISDIR (selection (current_panel)->st.st_mode) || link_isdir (selection (current_panel)))
+    if (S_ISDIR (selection (current_panel)->st.mode) || link_isdir (selection (current_panel)))
     {
         vfs_path_t *fname_vpath;
 
@@ -284,7 +285,7 @@ compare_dir (WPanel * panel, WPanel * other, enum CompareMode mode)
         file_mark (panel, i, 0);
 
         /* Skip directories */
-        if (S_ISDIR (source->st.st_mode))
+        if (S_ISDIR (source->st.mode))
             continue;
 
         /* Search the corresponding entry from the other panel */
@@ -304,12 +305,12 @@ compare_dir (WPanel * panel, WPanel * other, enum CompareMode mode)
             if (mode != compare_size_only)
             {
                 /* Older version is not marked */
-                if (source->st.st_mtime < target->st.st_mtime)
+                if (source->st.mtime < target->st.mtime)
                     continue;
             }
 
             /* Newer version with different size is marked */
-            if (source->st.st_size != target->st.st_size)
+            if (source->st.size != target->st.size)
             {
                 do_file_mark (panel, i, 1);
                 continue;
@@ -322,7 +323,7 @@ compare_dir (WPanel * panel, WPanel * other, enum CompareMode mode)
             {
                 /* Thorough compare off, compare only time stamps */
                 /* Mark newer version, don't mark version with the same date */
-                if (source->st.st_mtime > target->st.st_mtime)
+                if (source->st.mtime > target->st.mtime)
                 {
                     do_file_mark (panel, i, 1);
                 }
@@ -335,7 +336,7 @@ compare_dir (WPanel * panel, WPanel * other, enum CompareMode mode)
 
                 src_name = vfs_path_append_new (panel->cwd_vpath, source->fname, NULL);
                 dst_name = vfs_path_append_new (other->cwd_vpath, target->fname, NULL);
-                if (compare_files (src_name, dst_name, source->st.st_size))
+                if (compare_files (src_name, dst_name, source->st.size))
                     do_file_mark (panel, i, 1);
                 vfs_path_free (src_name);
                 vfs_path_free (dst_name);
@@ -1244,7 +1245,7 @@ link_cmd (link_type_t link_type)
 void
 edit_symlink_cmd (void)
 {
-    if (S_ISLNK (selection (current_panel)->st.st_mode))
+    if (S_ISLNK (selection (current_panel)->st.mode))
     {
         char buffer[MC_MAXPATHLEN];
         char *p = NULL;
@@ -1489,7 +1490,7 @@ smart_dirsize_cmd (void)
     file_entry_t *entry;
 
     entry = &(panel->dir.list[panel->selected]);
-    if ((S_ISDIR (entry->st.st_mode) && DIR_IS_DOTDOT (entry->fname)) || panel->dirs_marked)
+    if ((S_ISDIR (entry->st.mode) && DIR_IS_DOTDOT (entry->fname)) || panel->dirs_marked)
         dirsizes_cmd ();
     else
         single_dirsize_cmd ();
@@ -1504,7 +1505,7 @@ single_dirsize_cmd (void)
     file_entry_t *entry;
 
     entry = &(panel->dir.list[panel->selected]);
-    if (S_ISDIR (entry->st.st_mode) && !DIR_IS_DOTDOT (entry->fname))
+    if (S_ISDIR (entry->st.mode) && !DIR_IS_DOTDOT (entry->fname))
     {
         size_t dir_count = 0;
         size_t count = 0;
@@ -1514,13 +1515,16 @@ single_dirsize_cmd (void)
 
         p = vfs_path_from_str (entry->fname);
 
+        /* user asks for the actual size: files could be changed outside of mc */
+        dirsize_cache_invalidate ();
+
         memset (&dsm, 0, sizeof (dsm));
         status_msg_init (STATUS_MSG (&dsm), _("Directory scanning"), 1.0, dirsize_status_init_cb,
                          dirsize_status_update_cb, dirsize_status_deinit_cb);
 
         if (compute_dir_size (p, &dsm, &dir_count, &count, &total, TRUE) == FILE_CONT)
         {
-            entry->st.st_size = (off_t) total;
+            entry->st.size = (off_t) total;
             entry->f.dir_size_computed = 1;
         }
 
@@ -1549,12 +1553,15 @@ dirsizes_cmd (void)
     int i;
     dirsize_status_msg_t dsm;
 
+    /* user asks for the actual sizes: files could be changed outside of mc */
+    dirsize_cache_invalidate ();
+
     memset (&dsm, 0, sizeof (dsm));
     status_msg_init (STATUS_MSG (&dsm), _("Directory scanning"), 1.0, dirsize_status_init_cb,
                      dirsize_status_update_cb, dirsize_status_deinit_cb);
 
     for (i = 0; i < panel->dir.len; i++)
-        if (S_ISDIR (panel->dir.list[i].st.st_mode)
+        if (S_ISDIR (panel->dir.list[i].st.mode)
             && ((panel->dirs_marked && panel->dir.list[i].f.marked)
                 || !panel->dirs_marked) && !DIR_IS_DOTDOT (panel->dir.list[i].fname))
         {
@@ -1570,7 +1577,7 @@ dirsizes_cmd (void)
             if (ok)
                 break;
 
-            panel->dir.list[i].st.st_size = (off_t) total;
+            panel->dir.list[i].st.size = (off_t) total;
             panel->dir.list[i].f.dir_size_computed = 1;
         }
 
@@ -30,6 +30,7 @@
 
 #include <config.h>
 
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -55,12 +56,71 @@
 /*** file scope macro definitions ****************************************************************/
 
 #define MY_ISDIR(x) (\
-    (is_exe (x->st.st_mode) && !(S_ISDIR (x->st.st_mode) || x->f.link_to_dir) && exec_first) \
+    (is_exe (x->st.mode) && !(S_ISDIR (x->st.mode) || x->f.link_to_dir) && exec_first) \
         ? 1 \
-        : ( (S_ISDIR (x->st.st_mode) || x->f.link_to_dir) ? 2 : 0) )
+        : ( (S_ISDIR (x->st.mode) || x->f.link_to_dir) ? 2 : 0) )
+
+#ifdef HAVE_GLIB_THREADS
+#define DIR_LIST_LOADER_THREADED 1
+#endif
+
+/* interval between passing of read entries to the main thread, in microseconds */
+#define DIR_LIST_LOADER_FLUSH_INTERVAL (G_USEC_PER_SEC / 10)
+
+/* size of memory block of string storage */
+#define DIR_LIST_STRINGS_BLOCK_SIZE (64 * 1024)
 
 /*** file scope type declarations ****************************************************************/
 
+/* Strings are allocated sequentially in large blocks and never freed one by one */
+struct dir_list_strings_struct
+{
+    GSList *blocks;             /* allocated blocks, the current one is the first */
+    char *free_space;           /* unused space of the current block */
+    size_t free_len;
+};
+
+/* data for dir_list_match() */
+typedef struct
+{
+    const dir_list *list;
+    gboolean files_only;
+} dir_list_match_t;
+
+/* Operations on local directory used by loader thread */
+typedef struct
+{
+    DIR *(*opendir) (const char *name);
+    struct dirent *(*readdir) (DIR * dirp);
+    int (*closedir) (DIR * dirp);
+    int (*lstat) (const char *path, struct stat * buf);
+    int (*stat) (const char *path, struct stat * buf);
+} dir_local_ops_t;
+
+struct dir_list_loader_struct
+{
+    gint ref_count;
+    vfs_path_t *vpath;
+    char *path;
+    gboolean show_dot_files;
+    gboolean show_backups;
+    dir_list_loader_notify_fn notify;
+    void *data;
+    volatile gint cancelled;
+    gboolean in_background;     /* read by thread, otherwise by dir_list_loader_step() */
+    DIR *dirp;                  /* directory opened by dir_list_loader_step() */
+
+#ifdef DIR_LIST_LOADER_THREADED
+    GMutex lock;
+    GCond cond;
+#endif
+    /* protected by lock */
+    dir_list staging;           /* entries read by thread, but not taken yet */
+    gboolean finished;
+    int error;                  /* errno of failed opendir() */
+    gboolean notified;          /* notify was called and entries weren't taken yet */
+};
+
 /*** file scope variables ************************************************************************/
 
 /* Reverse flag */
@@ -72,11 +132,106 @@ static int case_sensitive = OS_SORT_CASE_SENSITIVE_DEFAULT;
 /* Are the exec_bit files top in list */
 static gboolean exec_first = TRUE;
 
-static dir_list dir_copy = { NULL, 0, 0 };
+static dir_list dir_copy = { NULL, 0, 0, NULL };
+
+/* keys of entries being sorted */
+static dir_list_strings_t *sort_keys = NULL;
+
+#ifdef DIR_LIST_LOADER_THREADED
+static const dir_local_ops_t dir_local_default_ops = {
+    opendir, readdir, closedir, lstat, stat
+};
+
+static const dir_local_ops_t *dir_local_ops = &dir_local_default_ops;
+
+/* FALSE to read all directories by dir_list_loader_step() */
+static gboolean dir_list_loader_threads = TRUE;
+#endif
 
 /*** file scope functions ************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
 
+static char *
+dir_list_strings_add (dir_list_strings_t ** strings, const char *str, size_t len)
+{
+    dir_list_strings_t *s = *strings;
+    char *ret;
+
+    if (s == NULL)
+    {
+        s = g_new0 (dir_list_strings_t, 1);
+        *strings = s;
+    }
+
+    if (s->free_len < len + 1)
+    {
+        size_t block_size;
+
+        /* the rest of current block is wasted */
+        block_size = max ((size_t) DIR_LIST_STRINGS_BLOCK_SIZE, len + 1);
+        s->free_space = g_malloc (block_size);
+        s->free_len = block_size;
+        s->blocks = g_slist_prepend (s->blocks, s->free_space);
+    }
+
+    ret = s->free_space;
+    memcpy (ret, str, len);
+    ret[len] = '\0';
+    s->free_space += len + 1;
+    s->free_len -= len + 1;
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+dir_list_strings_free (dir_list_strings_t * strings)
+{
+    if (strings != NULL)
+    {
+        g_slist_free_full (strings->blocks, g_free);
+        g_free (strings);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Names of entries moved from one list to other one are passed together with their storage */
+
+static void
+dir_list_strings_move (dir_list * dst, dir_list * src)
+{
+    if (src->strings == NULL)
+        return;
+
+    if (dst->strings == NULL)
+        dst->strings = src->strings;
+    else
+    {
+        /* keep the current block of destination first */
+        dst->strings->blocks = g_slist_concat (dst->strings->blocks, src->strings->blocks);
+        g_free (src->strings);
+    }
+
+    src->strings = NULL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Keep sort key until end of sorting */
+
+static char *
+sort_key_keep (char *key)
+{
+    char *ret;
+
+    ret = dir_list_strings_add (&sort_keys, key, strlen (key));
+    str_release_key (key, case_sensitive);
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
 /*
    sort_orders_t sort_orders [SORT_TYPES_TOTAL] = {
    { N_("&Unsorted"),    unsorted },
@@ -132,11 +287,31 @@ clean_sort_keys (dir_list * list, int start, int count)
         file_entry_t *fentry;
 
         fentry = &list->list[i + start];
-        str_release_key (fentry->sort_key, case_sensitive);
         fentry->sort_key = NULL;
-        str_release_key (fentry->second_sort_key, case_sensitive);
         fentry->second_sort_key = NULL;
     }
+
+    dir_list_strings_free (sort_keys);
+    sort_keys = NULL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+dir_name_is_hidden (const char *name, gboolean show_dot_files, gboolean show_backups)
+{
+    return (DIR_IS_DOT (name) || DIR_IS_DOTDOT (name)
+            || (!show_dot_files && name[0] == '.')
+            || (!show_backups && name[strlen (name) - 1] == '~'));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+dir_entry_matches (const file_entry_t * fe, const char *fltr)
+{
+    return (S_ISDIR (fe->st.mode) || fe->f.link_to_dir != 0 || fltr == NULL
+            || mc_search (fltr, NULL, fe->fname, MC_SEARCH_T_GLOB));
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -151,11 +326,8 @@ handle_dirent (struct dirent *dp, const char *fltr, struct stat *buf1, int *link
 {
     vfs_path_t *vpath;
 
-    if (DIR_IS_DOT (dp->d_name) || DIR_IS_DOTDOT (dp->d_name))
-        return FALSE;
-    if (!panels_options.show_dot_files && (dp->d_name[0] == '.'))
-        return FALSE;
-    if (!panels_options.show_backups && dp->d_name[strlen (dp->d_name) - 1] == '~')
+    if (dir_name_is_hidden (dp->d_name, panels_options.show_dot_files,
+                            panels_options.show_backups))
         return FALSE;
 
     vpath = vfs_path_from_str (dp->d_name);
@@ -191,6 +363,21 @@ handle_dirent (struct dirent *dp, const char *fltr, struct stat *buf1, int *link
             || mc_search (fltr, NULL, dp->d_name, MC_SEARCH_T_GLOB));
 }
 
+/* --------------------------------------------------------------------------------------------- */
+
+static const char *
+dir_list_match_get_name (gsize index, gsize * len, gpointer user_data)
+{
+    const dir_list_match_t *m = (const dir_list_match_t *) user_data;
+    const file_entry_t *fe = &m->list->list[index];
+
+    if (DIR_IS_DOTDOT (fe->fname) || (m->files_only && S_ISDIR (fe->st.mode)))
+        return NULL;
+
+    *len = fe->fnamelen;
+    return fe->fname;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /** get info about ".." */
 
@@ -224,25 +411,125 @@ alloc_dir_copy (int size)
 {
     if (dir_copy.size < size)
     {
-        if (dir_copy.list != NULL)
+        g_free (dir_copy.list);
+        dir_copy.list = g_new0 (file_entry_t, size);
+        dir_copy.size = size;
+        dir_copy.len = 0;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef DIR_LIST_LOADER_THREADED
+/** Pass entries read by thread to the staging list */
+
+static void
+dir_list_loader_flush (dir_list_loader_t * loader, dir_list * batch, gboolean finished)
+{
+    gboolean notify;
+
+    g_mutex_lock (&loader->lock);
+
+    if (batch->len != 0)
+    {
+        dir_list *staging = &loader->staging;
+
+        if (staging->len + batch->len > staging->size
+            && !dir_list_grow (staging, staging->len + batch->len - staging->size))
+            finished = TRUE;
+        else
         {
-            int i;
+            /* names are moved */
+            memcpy (&staging->list[staging->len], batch->list, batch->len * sizeof (file_entry_t));
+            staging->len += batch->len;
+            batch->len = 0;
+            dir_list_strings_move (staging, batch);
+        }
+    }
+
+    if (finished)
+        loader->finished = TRUE;
+
+    notify = !loader->notified && (loader->staging.len != 0 || loader->finished);
+    if (notify)
+        loader->notified = TRUE;
 
-            for (i = 0; i < dir_copy.len; i++)
+    g_cond_signal (&loader->cond);
+    g_mutex_unlock (&loader->lock);
+
+    if (notify && loader->notify != NULL && g_atomic_int_get (&loader->cancelled) == 0)
+        loader->notify (loader, loader->data);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Read local directory: it can take long time on network file systems */
+
+static gpointer
+dir_list_loader_thread (gpointer data)
+{
+    dir_list_loader_t *loader = (dir_list_loader_t *) data;
+    dir_list batch = { NULL, 0, 0, NULL };
+    DIR *dirp;
+
+    dirp = dir_local_ops->opendir (loader->path);
+    if (dirp == NULL)
+        loader->error = errno;
+    else
+    {
+        struct dirent *dp;
+        gint64 flush_time;
+
+        flush_time = g_get_monotonic_time () + DIR_LIST_LOADER_FLUSH_INTERVAL;
+
+        while (g_atomic_int_get (&loader->cancelled) == 0
+               && (dp = dir_local_ops->readdir (dirp)) != NULL)
+        {
+            char *full_name;
+            struct stat st;
+            gboolean link_to_dir = FALSE, stale_link = FALSE;
+
+            if (dir_name_is_hidden (dp->d_name, loader->show_dot_files, loader->show_backups))
+                continue;
+
+            full_name = g_build_filename (loader->path, dp->d_name, (char *) NULL);
+
+            /* entries with failed lstat() have zero st_mode as in handle_dirent() */
+            if (dir_local_ops->lstat (full_name, &st) == -1)
+                memset (&st, 0, sizeof (st));
+            else if (S_ISLNK (st.st_mode))
             {
-                file_entry_t *fentry;
+                struct stat st2;
 
-                fentry = &(dir_copy.list)[i];
-                g_free (fentry->fname);
+                if (dir_local_ops->stat (full_name, &st2) == 0)
+                    link_to_dir = S_ISDIR (st2.st_mode);
+                else
+                    stale_link = TRUE;
+            }
+
+            g_free (full_name);
+
+            if (!dir_list_append (&batch, dp->d_name, &st, link_to_dir, stale_link))
+                break;
+
+            if (g_get_monotonic_time () >= flush_time)
+            {
+                dir_list_loader_flush (loader, &batch, FALSE);
+                flush_time = g_get_monotonic_time () + DIR_LIST_LOADER_FLUSH_INTERVAL;
             }
-            g_free (dir_copy.list);
         }
 
-        dir_copy.list = g_new0 (file_entry_t, size);
-        dir_copy.size = size;
-        dir_copy.len = 0;
+        dir_local_ops->closedir (dirp);
     }
+
+    dir_list_loader_flush (loader, &batch, TRUE);
+    dir_list_clean (&batch);
+    g_free (batch.list);
+
+    dir_list_loader_unref (loader);
+
+    return NULL;
 }
+#endif /* DIR_LIST_LOADER_THREADED */
 
 /* --------------------------------------------------------------------------------------------- */
 /*** public functions ****************************************************************************/
@@ -317,12 +604,12 @@ dir_list_append (dir_list * list, const char *fname, const struct stat * st,
 
     fentry = &list->list[list->len];
     fentry->fnamelen = strlen (fname);
-    fentry->fname = g_strndup (fname, fentry->fnamelen);
+    fentry->fname = dir_list_strndup (list, fname, fentry->fnamelen);
     fentry->f.marked = 0;
     fentry->f.link_to_dir = link_to_dir ? 1 : 0;
     fentry->f.stale_link = stale_link ? 1 : 0;
     fentry->f.dir_size_computed = 0;
-    fentry->st = *st;
+    file_stat_from_stat (&fentry->st, st);
     fentry->sort_key = NULL;
     fentry->second_sort_key = NULL;
 
@@ -331,6 +618,23 @@ dir_list_append (dir_list * list, const char *fname, const struct stat * st,
     return TRUE;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Copy string to the storage of directory list. It is freed by dir_list_clean().
+ *
+ * @param list directory list
+ * @param str string
+ * @param len length of string
+ *
+ * @return new string
+ */
+
+char *
+dir_list_strndup (dir_list * list, const char *str, size_t len)
+{
+    return dir_list_strings_add (&list->strings, str, len);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 int
@@ -353,9 +657,9 @@ sort_name (file_entry_t * a, file_entry_t * b)
     {
         /* create key if does not exist, key will be freed after sorting */
         if (a->sort_key == NULL)
-            a->sort_key = str_create_key_for_filename (a->fname, case_sensitive);
+            a->sort_key = sort_key_keep (str_create_key_for_filename (a->fname, case_sensitive));
         if (b->sort_key == NULL)
-            b->sort_key = str_create_key_for_filename (b->fname, case_sensitive);
+            b->sort_key = sort_key_keep (str_create_key_for_filename (b->fname, case_sensitive));
 
         return key_collate (a->sort_key, b->sort_key);
     }
@@ -393,9 +697,11 @@ sort_ext (file_entry_t * a, file_entry_t * b)
         int r;
 
         if (a->second_sort_key == NULL)
-            a->second_sort_key = str_create_key (extension (a->fname), case_sensitive);
+            a->second_sort_key =
+                sort_key_keep (str_create_key (extension (a->fname), case_sensitive));
         if (b->second_sort_key == NULL)
-            b->second_sort_key = str_create_key (extension (b->fname), case_sensitive);
+            b->second_sort_key =
+                sort_key_keep (str_create_key (extension (b->fname), case_sensitive));
 
         r = str_key_collate (a->second_sort_key, b->second_sort_key, case_sensitive);
         if (r)
@@ -417,7 +723,7 @@ sort_time (file_entry_t * a, file_entry_t * b)
 
     if (ad == bd || panels_options.mix_all_files)
     {
-        int result = a->st.st_mtime < b->st.st_mtime ? -1 : a->st.st_mtime > b->st.st_mtime;
+        int result = a->st.mtime < b->st.mtime ? -1 : a->st.mtime > b->st.mtime;
         if (result != 0)
             return result * reverse;
         else
@@ -437,7 +743,7 @@ sort_ctime (file_entry_t * a, file_entry_t * b)
 
     if (ad == bd || panels_options.mix_all_files)
     {
-        int result = a->st.st_ctime < b->st.st_ctime ? -1 : a->st.st_ctime > b->st.st_ctime;
+        int result = a->st.ctime < b->st.ctime ? -1 : a->st.ctime > b->st.ctime;
         if (result != 0)
             return result * reverse;
         else
@@ -457,7 +763,7 @@ sort_atime (file_entry_t * a, file_entry_t * b)
 
     if (ad == bd || panels_options.mix_all_files)
     {
-        int result = a->st.st_atime < b->st.st_atime ? -1 : a->st.st_atime > b->st.st_atime;
+        int result = a->st.atime < b->st.atime ? -1 : a->st.atime > b->st.atime;
         if (result != 0)
             return result * reverse;
         else
@@ -476,7 +782,7 @@ sort_inode (file_entry_t * a, file_entry_t * b)
     int bd = MY_ISDIR (b);
 
     if (ad == bd || panels_options.mix_all_files)
-        return (a->st.st_ino - b->st.st_ino) * reverse;
+        return (a->st.ino - b->st.ino) * reverse;
     else
         return bd - ad;
 }
@@ -493,7 +799,7 @@ sort_size (file_entry_t * a, file_entry_t * b)
     if (ad != bd && !panels_options.mix_all_files)
         return bd - ad;
 
-    result = a->st.st_size < b->st.st_size ? -1 : a->st.st_size > b->st.st_size;
+    result = a->st.size < b->st.size ? -1 : a->st.size > b->st.size;
     if (result != 0)
         return result * reverse;
     else
@@ -526,26 +832,125 @@ dir_list_sort (dir_list * list, GCompareFunc sort, const dir_sort_options_t * so
 }
 
 /* --------------------------------------------------------------------------------------------- */
+/**
+ * Sort entries appended to sorted directory list and merge them into it. Only new entries
+ * are sorted, and the place of each of them is found by binary search, so adding of m entries
+ * to list of n ones takes O(m log m + m log n) comparisons instead of sorting the whole list.
+ *
+ * @param list directory list
+ * @param sorted number of leading entries (including "..") which are already sorted
+ * @param sort sort function
+ * @param sort_op sort options
+ */
 
 void
-dir_list_clean (dir_list * list)
+dir_list_sort_merge (dir_list * list, int sorted, GCompareFunc sort,
+                     const dir_sort_options_t * sort_op)
 {
-    int i;
+    file_entry_t *fresh;
+    int *pos;
+    int dot_dot_found, added, lo, src, dst, i;
 
-    for (i = 0; i < list->len; i++)
+    added = list->len - sorted;
+    if (added <= 0 || sort == (GCompareFunc) unsorted)
+        return;
+
+    dot_dot_found = DIR_IS_DOTDOT (list->list[0].fname) ? 1 : 0;
+    if (sorted <= dot_dot_found)
     {
-        file_entry_t *fentry;
+        dir_list_sort (list, sort, sort_op);
+        return;
+    }
 
-        fentry = &list->list[i];
-        g_free (fentry->fname);
-        fentry->fname = NULL;
+    reverse = sort_op->reverse ? -1 : 1;
+    case_sensitive = sort_op->case_sensitive ? 1 : 0;
+    exec_first = sort_op->exec_first;
+    qsort (&list->list[sorted], added, sizeof (file_entry_t), sort);
+
+    /* new entries are moved aside, sorted part is merged with them from the end */
+    fresh = g_new (file_entry_t, added);
+    memcpy (fresh, &list->list[sorted], added * sizeof (file_entry_t));
+
+    /* places of sorted new entries in the old part don't decrease */
+    pos = g_new (int, added);
+    lo = dot_dot_found;
+    for (i = 0; i < added; i++)
+    {
+        int hi = sorted;
+
+        while (lo < hi)
+        {
+            int mid = lo + (hi - lo) / 2;
+
+            if (sort (&list->list[mid], &fresh[i]) <= 0)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        pos[i] = lo;
+    }
+
+    src = sorted;
+    dst = list->len;
+    for (i = added - 1; i >= 0; i--)
+    {
+        int n = src - pos[i];
+
+        src -= n;
+        dst -= n;
+        memmove (&list->list[dst], &list->list[src], n * sizeof (file_entry_t));
+        list->list[--dst] = fresh[i];
     }
 
+    g_free (pos);
+    g_free (fresh);
+
+    clean_sort_keys (list, dot_dot_found, list->len - dot_dot_found);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+dir_list_clean (dir_list * list)
+{
+    /* all names are freed at once */
+    dir_list_strings_free (list->strings);
+    list->strings = NULL;
+
     list->len = 0;
     /* reduce memory usage */
     dir_list_grow (list, DIR_LIST_MIN_SIZE - list->size);
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Match names of all entries of directory list against pattern.
+ * ".." is never matched.
+ *
+ * @param list directory list
+ * @param search compiled pattern
+ * @param files_only if TRUE, directories are not matched
+ * @param found number of matched entries. May be NULL
+ *
+ * @return bitmap of matched entries (see MC_SEARCH_BITMAP_TEST()) or NULL if nothing was tested.
+ *         Use g_free() to free it.
+ */
+
+guint8 *
+dir_list_match (const dir_list * list, mc_search_t * search, gboolean files_only, int *found)
+{
+    dir_list_match_t m = { list, files_only };
+    guint8 *bitmap;
+    gsize n;
+
+    bitmap = mc_search_run_batch (search, (gsize) list->len, dir_list_match_get_name, &m, &n);
+    if (found != NULL)
+        *found = (int) n;
+
+    return bitmap;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /** Used to set up a directory list when there is no access to a directory */
 
@@ -564,12 +969,12 @@ dir_list_init (dir_list * list)
     fentry = &list->list[0];
     memset (fentry, 0, sizeof (file_entry_t));
     fentry->fnamelen = 2;
-    fentry->fname = g_strndup ("..", fentry->fnamelen);
+    fentry->fname = dir_list_strndup (list, "..", fentry->fnamelen);
     fentry->f.link_to_dir = 0;
     fentry->f.stale_link = 0;
     fentry->f.dir_size_computed = 0;
     fentry->f.marked = 0;
-    fentry->st.st_mode = 040755;
+    fentry->st.mode = 040755;
     list->len = 1;
     return TRUE;
 }
@@ -637,7 +1042,7 @@ dir_list_load (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort,
 
     fentry = &list->list[0];
     if (dir_get_dotdot_stat (vpath, &st))
-        fentry->st = st;
+        file_stat_from_stat (&fentry->st, &st);
 
     dirp = mc_opendir (vpath);
     if (dirp == NULL)
@@ -684,7 +1089,7 @@ if_link_is_exe (const vfs_path_t * full_name_vpath, const file_entry_t * file)
 {
     struct stat b;
 
-    if (S_ISLNK (file->st.st_mode) && mc_stat (full_name_vpath, &b) == 0)
+    if (S_ISLNK (file->st.mode) && mc_stat (full_name_vpath, &b) == 0)
         return is_exe (b.st_mode);
     return TRUE;
 }
@@ -738,6 +1143,7 @@ dir_list_reload (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort,
             marked_cnt++;
         }
     }
+    dir_list_strings_move (&dir_copy, list);
 
     /* Add ".." except to the root directory. The ".." entry
        (if any) must be the first in the list. */
@@ -760,7 +1166,7 @@ dir_list_reload (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort,
             file_entry_t *fentry;
 
             fentry = &list->list[0];
-            fentry->st = st;
+            file_stat_from_stat (&fentry->st, &st);
         }
     }
 
@@ -817,3 +1223,329 @@ dir_list_reload (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort,
 }
 
 /* --------------------------------------------------------------------------------------------- */
+/**
+ * Start reading of directory.
+ *
+ * Local directory is read in the background thread. Virtual file systems aren't thread safe:
+ * mc_readdir() returns static buffer, open handles are kept in the global table, vfs_s caches
+ * are shared with vfs_timeout_handler(), and ftpfs, fish, sftpfs and smbfs ask for passwords
+ * and print messages on the screen. Directories of them, as well as recoded ones, are read
+ * in the main thread by dir_list_loader_step().
+ *
+ * @param vpath directory, the current one of the panel
+ * @param notify function called in the loader thread when new entries can be taken
+ *               with dir_list_loader_take(). It isn't called again until entries are taken.
+ *               It isn't called if directory is read by steps.
+ * @param data user data for @notify
+ *
+ * @return new loader or NULL if directory can't be read partially.
+ *         Use dir_list_loader_cancel() and dir_list_loader_unref() to free it.
+ */
+
+dir_list_loader_t *
+dir_list_loader_new (const vfs_path_t * vpath, dir_list_loader_notify_fn notify, void *data)
+{
+    dir_list_loader_t *loader;
+    const char *vpath_str;
+
+    /* root directory has no ".." to show while the other entries are being read */
+    vpath_str = vfs_path_as_str (vpath);
+    if (vpath_str[0] == PATH_SEP && vpath_str[1] == '\0')
+        return NULL;
+
+    loader = g_new0 (dir_list_loader_t, 1);
+    loader->ref_count = 1;
+    loader->vpath = vfs_path_clone (vpath);
+    loader->path = g_strdup (vpath_str);
+    loader->show_dot_files = panels_options.show_dot_files;
+    loader->show_backups = panels_options.show_backups;
+    loader->notify = notify;
+    loader->data = data;
+
+#ifdef DIR_LIST_LOADER_THREADED
+    g_mutex_init (&loader->lock);
+    g_cond_init (&loader->cond);
+
+    /* names in other encodings are recoded by VFS */
+    if (dir_list_loader_threads && vfs_file_is_local (vpath)
+        && vfs_path_elements_count (vpath) == 1
+        && !vfs_path_element_need_cleanup_converter (vfs_path_get_by_index (vpath, 0)))
+    {
+        GThread *thread;
+
+        /* one reference is owned by the thread */
+        loader->ref_count = 2;
+        loader->in_background = TRUE;
+
+        thread = g_thread_try_new ("dir_list_loader", dir_list_loader_thread, loader, NULL);
+        if (thread != NULL)
+            /* thread isn't joined: it can be blocked by slow file system after cancel */
+            g_thread_unref (thread);
+        else
+        {
+            loader->ref_count = 1;
+            loader->in_background = FALSE;
+        }
+    }
+#endif
+
+    return loader;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+dir_list_loader_t *
+dir_list_loader_ref (dir_list_loader_t * loader)
+{
+    g_atomic_int_inc (&loader->ref_count);
+    return loader;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+dir_list_loader_unref (dir_list_loader_t * loader)
+{
+    if (loader != NULL && g_atomic_int_dec_and_test (&loader->ref_count))
+    {
+        if (loader->dirp != NULL)
+            mc_closedir (loader->dirp);
+        dir_list_clean (&loader->staging);
+        g_free (loader->staging.list);
+#ifdef DIR_LIST_LOADER_THREADED
+        g_mutex_clear (&loader->lock);
+        g_cond_clear (&loader->cond);
+#endif
+        vfs_path_free (loader->vpath);
+        g_free (loader->path);
+        g_free (loader);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Stop reading. Notify function isn't called after this. */
+
+void
+dir_list_loader_cancel (dir_list_loader_t * loader)
+{
+    if (loader != NULL)
+        g_atomic_int_set (&loader->cancelled, 1);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+gboolean
+dir_list_loader_is_cancelled (dir_list_loader_t * loader)
+{
+    return (g_atomic_int_get (&loader->cancelled) != 0);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void *
+dir_list_loader_get_data (const dir_list_loader_t * loader)
+{
+    return loader->data;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Wait until directory is read.
+ *
+ * @param timeout time to wait in microseconds
+ *
+ * @return TRUE if the whole directory is read, FALSE if timeout is expired
+ */
+
+gboolean
+dir_list_loader_wait (dir_list_loader_t * loader, gint64 timeout)
+{
+    gboolean finished;
+#ifdef DIR_LIST_LOADER_THREADED
+    gint64 end_time;
+
+    if (!loader->in_background)
+        return dir_list_loader_step (loader, timeout);
+
+    end_time = g_get_monotonic_time () + timeout;
+
+    g_mutex_lock (&loader->lock);
+    while (!loader->finished && g_cond_wait_until (&loader->cond, &loader->lock, end_time))
+        ;
+    finished = loader->finished;
+    g_mutex_unlock (&loader->lock);
+#else
+    finished = dir_list_loader_step (loader, timeout);
+#endif
+
+    return finished;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Read the next entries of directory which isn't read in background. At least one entry
+ * is read by every call. It is called in the main thread when VFS isn't in use, e.g. by
+ * idle timer of the panel.
+ *
+ * @param timeout time to read entries in microseconds
+ *
+ * @return TRUE if the whole directory is read or reading is cancelled
+ */
+
+gboolean
+dir_list_loader_step (dir_list_loader_t * loader, gint64 timeout)
+{
+    gint64 end_time;
+
+    if (loader->in_background)
+        return dir_list_loader_wait (loader, timeout);
+
+    if (loader->finished)
+        return TRUE;
+
+    if (dir_list_loader_is_cancelled (loader))
+        loader->finished = TRUE;
+    else if (loader->dirp == NULL)
+    {
+        loader->dirp = mc_opendir (loader->vpath);
+        if (loader->dirp == NULL)
+        {
+            loader->error = errno;
+            loader->finished = TRUE;
+        }
+    }
+
+    end_time = g_get_monotonic_time () + timeout;
+
+    while (!loader->finished)
+    {
+        struct dirent *dp;
+
+        dp = mc_readdir (loader->dirp);
+        if (dp == NULL)
+            loader->finished = TRUE;
+        else if (!dir_name_is_hidden (dp->d_name, loader->show_dot_files, loader->show_backups))
+        {
+            vfs_path_t *entry_vpath;
+            struct stat st;
+            gboolean link_to_dir = FALSE, stale_link = FALSE;
+
+            entry_vpath = vfs_path_append_new (loader->vpath, dp->d_name, (char *) NULL);
+
+            /* entries with failed lstat() have zero st_mode as in handle_dirent() */
+            if (mc_lstat (entry_vpath, &st) == -1)
+                memset (&st, 0, sizeof (st));
+            else if (S_ISLNK (st.st_mode))
+            {
+                struct stat st2;
+
+                if (mc_stat (entry_vpath, &st2) == 0)
+                    link_to_dir = S_ISDIR (st2.st_mode);
+                else
+                    stale_link = TRUE;
+            }
+
+            vfs_path_free (entry_vpath);
+
+            if (!dir_list_append (&loader->staging, dp->d_name, &st, link_to_dir, stale_link))
+                loader->finished = TRUE;
+            else if (g_get_monotonic_time () >= end_time)
+                break;
+        }
+    }
+
+    if (loader->finished && loader->dirp != NULL)
+    {
+        mc_closedir (loader->dirp);
+        loader->dirp = NULL;
+    }
+
+    return loader->finished;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Check whether directory is read in the background thread or by dir_list_loader_step() */
+
+gboolean
+dir_list_loader_in_background (const dir_list_loader_t * loader)
+{
+    return loader->in_background;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Set up directory list to take entries of loader: it contains ".." only */
+
+gboolean
+dir_list_loader_init_list (dir_list_loader_t * loader, dir_list * list)
+{
+    struct stat st;
+
+    if (!dir_list_init (list))
+        return FALSE;
+
+    if (dir_get_dotdot_stat (loader->vpath, &st))
+        file_stat_from_stat (&list->list[0].st, &st);
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Move entries read by loader to the directory list. Entries are appended and not sorted.
+ *
+ * @param loader directory loader
+ * @param list directory list, set up with dir_list_loader_init_list() before the first call
+ * @param fltr file name filter
+ * @param error errno of failed directory opening is stored here, 0 if directory was read
+ *
+ * @return TRUE if the whole directory is read and there will be no more entries
+ */
+
+gboolean
+dir_list_loader_take (dir_list_loader_t * loader, dir_list * list, const char *fltr, int *error)
+{
+    dir_list staging;
+    gboolean finished;
+    int i;
+
+#ifdef DIR_LIST_LOADER_THREADED
+    g_mutex_lock (&loader->lock);
+#endif
+    staging = loader->staging;
+    memset (&loader->staging, 0, sizeof (loader->staging));
+    loader->notified = FALSE;
+    finished = loader->finished;
+    *error = loader->error;
+#ifdef DIR_LIST_LOADER_THREADED
+    g_mutex_unlock (&loader->lock);
+#endif
+
+    if (staging.len != 0 && list->len + staging.len > list->size)
+        dir_list_grow (list, list->len + staging.len - list->size);
+
+    /* names of filtered out entries are kept in storage until list is cleaned */
+    for (i = 0; i < staging.len; i++)
+    {
+        file_entry_t *fe = &staging.list[i];
+
+        if (list->len < list->size && dir_entry_matches (fe, fltr))
+            list->list[list->len++] = *fe;
+    }
+
+    dir_list_strings_move (list, &staging);
+    g_free (staging.list);
+
+    if (finished)
+    {
+        /* update directory tree as dir_list_load() does */
+        tree_store_start_check (loader->vpath);
+        for (i = 0; i < list->len; i++)
+            if (S_ISDIR (list->list[i].st.mode) && !DIR_IS_DOTDOT (list->list[i].fname))
+                tree_store_mark_checked (list->list[i].fname);
+        tree_store_end_check ();
+    }
+
+    return finished;
+}
+
+/* --------------------------------------------------------------------------------------------- */
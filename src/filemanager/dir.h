@@ -8,6 +8,7 @@
 #include <sys/stat.h>
 
 #include "lib/global.h"
+#include "lib/search.h"
 #include "lib/util.h"
 #include "lib/vfs/vfs.h"
 
@@ -20,6 +21,11 @@
 
 /*** structures declarations (and typedefs of structures)*****************************************/
 
+/**
+ * Storage of file names of directory list: names are freed all at once
+ */
+typedef struct dir_list_strings_struct dir_list_strings_t;
+
 /**
  * A structure to represent directory content
  */
@@ -28,8 +34,16 @@ typedef struct
     file_entry_t *list; /**< list of file_entry_t objects */
     int size;           /**< number of allocated elements in list (capacity) */
     int len;            /**< number of used elements in list */
+    dir_list_strings_t *strings;        /**< storage of names of entries */
 } dir_list;
 
+/**
+ * Reader of directory content in the background thread
+ */
+typedef struct dir_list_loader_struct dir_list_loader_t;
+
+typedef void (*dir_list_loader_notify_fn) (dir_list_loader_t * loader, void *data);
+
 /**
  * A structure to represent sort options for directory content
  */
@@ -47,16 +61,35 @@ typedef struct dir_sort_options_struct
 gboolean dir_list_grow (dir_list * list, int delta);
 gboolean dir_list_append (dir_list * list, const char *fname, const struct stat *st,
                           gboolean link_to_dir, gboolean stale_link);
+char *dir_list_strndup (dir_list * list, const char *str, size_t len);
 
 void dir_list_load (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort,
                     const dir_sort_options_t * sort_op, const char *fltr);
 void dir_list_reload (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort,
                       const dir_sort_options_t * sort_op, const char *fltr);
 void dir_list_sort (dir_list * list, GCompareFunc sort, const dir_sort_options_t * sort_op);
+void dir_list_sort_merge (dir_list * list, int sorted, GCompareFunc sort,
+                          const dir_sort_options_t * sort_op);
 gboolean dir_list_init (dir_list * list);
 void dir_list_clean (dir_list * list);
+guint8 *dir_list_match (const dir_list * list, mc_search_t * search, gboolean files_only,
+                        int *found);
 gboolean handle_path (const char *path, struct stat *buf1, int *link_to_dir, int *stale_link);
 
+dir_list_loader_t *dir_list_loader_new (const vfs_path_t * vpath, dir_list_loader_notify_fn notify,
+                                        void *data);
+dir_list_loader_t *dir_list_loader_ref (dir_list_loader_t * loader);
+void dir_list_loader_unref (dir_list_loader_t * loader);
+void dir_list_loader_cancel (dir_list_loader_t * loader);
+gboolean dir_list_loader_is_cancelled (dir_list_loader_t * loader);
+void *dir_list_loader_get_data (const dir_list_loader_t * loader);
+gboolean dir_list_loader_wait (dir_list_loader_t * loader, gint64 timeout);
+gboolean dir_list_loader_step (dir_list_loader_t * loader, gint64 timeout);
+gboolean dir_list_loader_in_background (const dir_list_loader_t * loader);
+gboolean dir_list_loader_init_list (dir_list_loader_t * loader, dir_list * list);
+gboolean dir_list_loader_take (dir_list_loader_t * loader, dir_list * list, const char *fltr,
+                               int *error);
+
 /* Sorting functions */
 int unsorted (file_entry_t * a, file_entry_t * b);
 int sort_name (file_entry_t * a, file_entry_t * b);
@@ -0,0 +1,565 @@
+/*
+   Directory size computation on local filesystems.
+
+   Copyright (C) 2014
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \file src/filemanager/dirsize.c
+ *  \brief Source: parallel, cached directory size computation on local filesystems
+ *
+ *  Directories are scanned by a bounded pool of worker threads. Entries are stat'ed
+ *  with fstatat() relative to the directory descriptor, so no vfs_path_t is built per entry.
+ *
+ *  The direct contents of every scanned directory (number and size of files, names of
+ *  subdirectories) are cached by (device, inode) and validated by directory mtime.
+ *  Repeated computations of the same tree stat only directories, not files.
+ *  Changing the size of a file doesn't change the mtime of its directory, so the cache
+ *  is dropped by dirsize_cache_invalidate() after file operations and before sizes are
+ *  computed on explicit request of user.
+ *  Number of cached directories is limited, the least recently used ones are dropped.
+ */
+
+#include <config.h>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "lib/global.h"
+#include "lib/vfs/vfs.h"
+#include "lib/util.h"
+
+#include "dirsize.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+#if defined (HAVE_GLIB_THREADS) && defined (HAVE_FSTATAT) && defined (HAVE_FDOPENDIR)
+#define DIRSIZE_PARALLEL 1
+#endif
+
+/* number of worker threads: scanning is bound by filesystem metadata latency */
+#define DIRSIZE_WORKERS 4
+
+/* maximum number of directories kept in cache */
+#define DIRSIZE_CACHE_SIZE 100000
+
+/* interval between progress dialog updates, in microseconds */
+#define DIRSIZE_UPDATE_INTERVAL (G_USEC_PER_SEC / 10)
+
+#ifndef O_DIRECTORY
+#define O_DIRECTORY 0
+#endif
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+/*** file scope type declarations ****************************************************************/
+
+#ifdef DIRSIZE_PARALLEL
+/* Cached direct contents of one directory */
+typedef struct
+{
+    dev_t dev;
+    ino_t ino;
+    time_t mtime;
+    long mtime_nsec;
+    size_t file_count;
+    uintmax_t total;
+    GPtrArray *subdirs;         /* names of subdirectories */
+    GList lru;                  /* link in queue of entries, the most recently used is first */
+} dirsize_entry_t;
+
+/* State of one tree walk shared by worker threads */
+typedef struct
+{
+    GMutex lock;
+    GCond cond;
+    GQueue jobs;                /* full paths of directories to scan */
+    int busy;                   /* number of workers scanning a directory now */
+    volatile gint cancel;
+
+    size_t dir_count;
+    size_t file_count;
+    uintmax_t total;
+    char *last_dir;             /* last scanned directory, shown in progress dialog */
+} dirsize_walk_t;
+#endif /* DIRSIZE_PARALLEL */
+
+/*** file scope variables ************************************************************************/
+
+#ifdef DIRSIZE_PARALLEL
+static GHashTable *dirsize_cache = NULL;
+static GQueue dirsize_cache_lru = G_QUEUE_INIT;
+static GMutex dirsize_cache_lock;
+#endif
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef DIRSIZE_PARALLEL
+static guint
+dirsize_entry_hash (gconstpointer key)
+{
+    const dirsize_entry_t *e = (const dirsize_entry_t *) key;
+
+    return (guint) e->ino ^ (guint) e->dev;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+dirsize_entry_equal (gconstpointer a, gconstpointer b)
+{
+    const dirsize_entry_t *ea = (const dirsize_entry_t *) a;
+    const dirsize_entry_t *eb = (const dirsize_entry_t *) b;
+
+    return ea->ino == eb->ino && ea->dev == eb->dev;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+dirsize_entry_free (gpointer data)
+{
+    dirsize_entry_t *e = (dirsize_entry_t *) data;
+    guint i;
+
+    for (i = 0; i < e->subdirs->len; i++)
+        g_free (g_ptr_array_index (e->subdirs, i));
+    g_ptr_array_free (e->subdirs, TRUE);
+    g_free (e);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static long
+dirsize_mtime_nsec (const struct stat *st)
+{
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+    return st->st_mtim.tv_nsec;
+#else
+    (void) st;
+    return 0;
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Look up the directory in cache.
+ * If cached data is valid, add it to walk totals and queue subdirectories.
+ *
+ * @return TRUE if directory was found in cache
+ */
+
+static gboolean
+dirsize_cache_use (dirsize_walk_t * w, const char *path, const struct stat *st)
+{
+    dirsize_entry_t key;
+    dirsize_entry_t *e;
+    GPtrArray *jobs = NULL;
+    size_t file_count = 0;
+    uintmax_t total = 0;
+    guint i;
+
+    key.dev = st->st_dev;
+    key.ino = st->st_ino;
+
+    g_mutex_lock (&dirsize_cache_lock);
+    e = dirsize_cache == NULL ? NULL : g_hash_table_lookup (dirsize_cache, &key);
+    if (e != NULL && e->mtime == st->st_mtime && e->mtime_nsec == dirsize_mtime_nsec (st))
+    {
+        g_queue_unlink (&dirsize_cache_lru, &e->lru);
+        g_queue_push_head_link (&dirsize_cache_lru, &e->lru);
+
+        file_count = e->file_count;
+        total = e->total;
+        jobs = g_ptr_array_sized_new (e->subdirs->len);
+        for (i = 0; i < e->subdirs->len; i++)
+            g_ptr_array_add (jobs,
+                             g_build_filename (path, g_ptr_array_index (e->subdirs, i),
+                                               (char *) NULL));
+    }
+    g_mutex_unlock (&dirsize_cache_lock);
+
+    if (jobs == NULL)
+        return FALSE;
+
+    g_mutex_lock (&w->lock);
+    w->dir_count++;
+    w->file_count += file_count;
+    w->total += total;
+    for (i = 0; i < jobs->len; i++)
+        g_queue_push_tail (&w->jobs, g_ptr_array_index (jobs, i));
+    g_cond_broadcast (&w->cond);
+    g_mutex_unlock (&w->lock);
+
+    g_ptr_array_free (jobs, TRUE);
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+dirsize_cache_store (dirsize_entry_t * e)
+{
+    dirsize_entry_t *old;
+
+    g_mutex_lock (&dirsize_cache_lock);
+    if (dirsize_cache == NULL)
+        dirsize_cache =
+            g_hash_table_new_full (dirsize_entry_hash, dirsize_entry_equal, NULL,
+                                   dirsize_entry_free);
+
+    /* key is the part of value: remove old entry before insert new one */
+    old = (dirsize_entry_t *) g_hash_table_lookup (dirsize_cache, e);
+    if (old != NULL)
+    {
+        g_queue_unlink (&dirsize_cache_lru, &old->lru);
+        g_hash_table_remove (dirsize_cache, old);
+    }
+
+    e->lru.data = e;
+    g_hash_table_insert (dirsize_cache, e, e);
+    g_queue_push_head_link (&dirsize_cache_lru, &e->lru);
+
+    while (g_queue_get_length (&dirsize_cache_lru) > DIRSIZE_CACHE_SIZE)
+        g_hash_table_remove (dirsize_cache, g_queue_pop_tail_link (&dirsize_cache_lru)->data);
+
+    g_mutex_unlock (&dirsize_cache_lock);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Scan one directory: count and sum its files and queue its subdirectories.
+ * Called from worker thread without walk lock.
+ */
+
+static void
+dirsize_scan_dir (dirsize_walk_t * w, const char *path)
+{
+    int fd;
+    struct stat st;
+    DIR *dir;
+    struct dirent *dirent;
+    dirsize_entry_t *e;
+    guint i;
+
+    fd = open (path, O_RDONLY | O_DIRECTORY | O_CLOEXEC | O_NOCTTY);
+    if (fd == -1 || fstat (fd, &st) != 0)
+    {
+        if (fd != -1)
+            close (fd);
+        /* count unreadable directory like do_compute_dir_size() does */
+        g_mutex_lock (&w->lock);
+        w->dir_count++;
+        g_mutex_unlock (&w->lock);
+        return;
+    }
+
+    if (dirsize_cache_use (w, path, &st))
+    {
+        close (fd);
+        return;
+    }
+
+    dir = fdopendir (fd);
+    if (dir == NULL)
+    {
+        close (fd);
+        g_mutex_lock (&w->lock);
+        w->dir_count++;
+        g_mutex_unlock (&w->lock);
+        return;
+    }
+
+    e = g_new0 (dirsize_entry_t, 1);
+    e->dev = st.st_dev;
+    e->ino = st.st_ino;
+    e->mtime = st.st_mtime;
+    e->mtime_nsec = dirsize_mtime_nsec (&st);
+    e->subdirs = g_ptr_array_new ();
+
+    while (g_atomic_int_get (&w->cancel) == 0 && (dirent = readdir (dir)) != NULL)
+    {
+        struct stat s;
+
+        if (DIR_IS_DOT (dirent->d_name) || DIR_IS_DOTDOT (dirent->d_name))
+            continue;
+
+#ifdef HAVE_STRUCT_DIRENT_D_TYPE
+        /* size of directory itself is not counted: no need to stat it */
+        if (dirent->d_type == DT_DIR)
+        {
+            g_ptr_array_add (e->subdirs, g_strdup (dirent->d_name));
+            continue;
+        }
+#endif
+
+        if (fstatat (dirfd (dir), dirent->d_name, &s, AT_SYMLINK_NOFOLLOW) != 0)
+            continue;
+
+        if (S_ISDIR (s.st_mode))
+            g_ptr_array_add (e->subdirs, g_strdup (dirent->d_name));
+        else
+        {
+            e->file_count++;
+            e->total += (uintmax_t) s.st_size;
+        }
+    }
+
+    closedir (dir);
+
+    g_mutex_lock (&w->lock);
+    w->dir_count++;
+    w->file_count += e->file_count;
+    w->total += e->total;
+    for (i = 0; i < e->subdirs->len; i++)
+        g_queue_push_tail (&w->jobs,
+                           g_build_filename (path, g_ptr_array_index (e->subdirs, i),
+                                             (char *) NULL));
+    g_free (w->last_dir);
+    w->last_dir = g_strdup (path);
+    g_cond_broadcast (&w->cond);
+    g_mutex_unlock (&w->lock);
+
+    if (g_atomic_int_get (&w->cancel) == 0)
+        dirsize_cache_store (e);
+    else
+        dirsize_entry_free (e);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+dirsize_walk_finished (const dirsize_walk_t * w)
+{
+    return w->busy == 0 && g_queue_is_empty ((GQueue *) & w->jobs);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gpointer
+dirsize_worker (gpointer data)
+{
+    dirsize_walk_t *w = (dirsize_walk_t *) data;
+
+    g_mutex_lock (&w->lock);
+
+    while (TRUE)
+    {
+        char *path;
+
+        while (g_atomic_int_get (&w->cancel) == 0 && g_queue_is_empty (&w->jobs) && w->busy != 0)
+            g_cond_wait (&w->cond, &w->lock);
+
+        if (g_atomic_int_get (&w->cancel) != 0 || g_queue_is_empty (&w->jobs))
+            break;
+
+        path = (char *) g_queue_pop_head (&w->jobs);
+        w->busy++;
+        g_mutex_unlock (&w->lock);
+
+        dirsize_scan_dir (w, path);
+        g_free (path);
+
+        g_mutex_lock (&w->lock);
+        w->busy--;
+    }
+
+    /* wake up other workers and the waiting UI thread */
+    g_cond_broadcast (&w->cond);
+    g_mutex_unlock (&w->lock);
+
+    return NULL;
+}
+#endif /* DIRSIZE_PARALLEL */
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+/**
+ * Check whether the size of directory can be computed by dirsize_local_compute().
+ */
+
+gboolean
+dirsize_local_supported (const vfs_path_t * dirname_vpath)
+{
+#ifdef DIRSIZE_PARALLEL
+    return vfs_file_is_local (dirname_vpath);
+#else
+    (void) dirname_vpath;
+    return FALSE;
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Compute the number of bytes used by the files in a local directory.
+ * Counters are accumulated the same way as compute_dir_size() does.
+ * Progress is reported through callbacks of dsm from the calling (UI) thread.
+ *
+ * @return FILE_CONT if computing is finished, otherwise value returned by update callback
+ */
+
+FileProgressStatus
+dirsize_local_compute (const vfs_path_t * dirname_vpath, dirsize_status_msg_t * dsm,
+                       size_t * ret_dir_count, size_t * ret_marked_count, uintmax_t * ret_total,
+                       gboolean compute_symlinks)
+{
+#ifdef DIRSIZE_PARALLEL
+    status_msg_t *sm = STATUS_MSG (dsm);
+    FileProgressStatus ret = FILE_CONT;
+    const char *path;
+    dirsize_walk_t w;
+    GThread *workers[DIRSIZE_WORKERS];
+    int n_workers, i;
+
+    path = vfs_path_get_by_index (dirname_vpath, -1)->path;
+
+    if (!compute_symlinks)
+    {
+        struct stat s;
+
+        if (lstat (path, &s) != 0)
+            return FILE_CONT;
+
+        /* don't scan symlink to directory */
+        if (S_ISLNK (s.st_mode))
+        {
+            (*ret_marked_count)++;
+            *ret_total += (uintmax_t) s.st_size;
+            return FILE_CONT;
+        }
+    }
+
+    memset (&w, 0, sizeof (w));
+    g_mutex_init (&w.lock);
+    g_cond_init (&w.cond);
+    g_queue_init (&w.jobs);
+    g_queue_push_tail (&w.jobs, g_strdup (path));
+
+    for (i = 0; i < DIRSIZE_WORKERS; i++)
+    {
+        workers[i] = g_thread_try_new ("dirsize", dirsize_worker, &w, NULL);
+        if (workers[i] == NULL)
+            break;
+    }
+    n_workers = i;
+
+    if (n_workers == 0)
+        /* cannot create threads: scan in this thread */
+        dirsize_worker (&w);
+
+    g_mutex_lock (&w.lock);
+
+    while (!dirsize_walk_finished (&w))
+    {
+        gint64 end_time;
+
+        end_time = g_get_monotonic_time () + DIRSIZE_UPDATE_INTERVAL;
+        while (!dirsize_walk_finished (&w) && g_cond_wait_until (&w.cond, &w.lock, end_time))
+            ;
+
+        if (dirsize_walk_finished (&w) || sm->update == NULL)
+            continue;
+
+        dsm->dirname_vpath = vfs_path_from_str (w.last_dir != NULL ? w.last_dir : path);
+        dsm->dir_count = *ret_dir_count + w.dir_count;
+        dsm->total_size = *ret_total + w.total;
+        g_mutex_unlock (&w.lock);
+
+        ret = (FileProgressStatus) sm->update (sm);
+
+        vfs_path_free ((vfs_path_t *) dsm->dirname_vpath);
+        dsm->dirname_vpath = NULL;
+
+        g_mutex_lock (&w.lock);
+        if (ret != FILE_CONT)
+        {
+            g_atomic_int_set (&w.cancel, 1);
+            g_cond_broadcast (&w.cond);
+            break;
+        }
+    }
+
+    g_mutex_unlock (&w.lock);
+
+    for (i = 0; i < n_workers; i++)
+        g_thread_join (workers[i]);
+
+    *ret_dir_count += w.dir_count;
+    *ret_marked_count += w.file_count;
+    *ret_total += w.total;
+
+    g_queue_foreach (&w.jobs, (GFunc) g_free, NULL);
+    g_queue_clear (&w.jobs);
+    g_free (w.last_dir);
+    g_cond_clear (&w.cond);
+    g_mutex_clear (&w.lock);
+
+    return ret;
+#else
+    (void) dirname_vpath;
+    (void) dsm;
+    (void) ret_dir_count;
+    (void) ret_marked_count;
+    (void) ret_total;
+    (void) compute_symlinks;
+    return FILE_CONT;
+#endif /* DIRSIZE_PARALLEL */
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/**
+ * Drop cached contents of all directories: sizes of files can be changed in place.
+ */
+
+void
+dirsize_cache_invalidate (void)
+{
+#ifdef DIRSIZE_PARALLEL
+    g_mutex_lock (&dirsize_cache_lock);
+    if (dirsize_cache != NULL)
+    {
+        g_hash_table_destroy (dirsize_cache);
+        dirsize_cache = NULL;
+        g_queue_init (&dirsize_cache_lru);
+    }
+    g_mutex_unlock (&dirsize_cache_lock);
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+dirsize_cache_free (void)
+{
+    dirsize_cache_invalidate ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,33 @@
+/** \file  dirsize.h
+ *  \brief Header: parallel, cached directory size computation on local filesystems
+ */
+
+#ifndef MC__DIRSIZE_H
+#define MC__DIRSIZE_H
+
+#include "lib/global.h"
+#include "lib/vfs/vfs.h"        /* vfs_path_t */
+
+#include "file.h"               /* dirsize_status_msg_t */
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+/*** enums ***************************************************************************************/
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+/*** global variables defined in .c file *********************************************************/
+
+/*** declarations of public functions ************************************************************/
+
+gboolean dirsize_local_supported (const vfs_path_t * dirname_vpath);
+FileProgressStatus dirsize_local_compute (const vfs_path_t * dirname_vpath,
+                                          dirsize_status_msg_t * dsm, size_t * ret_dir_count,
+                                          size_t * ret_marked_count, uintmax_t * ret_total,
+                                          gboolean compute_symlinks);
+void dirsize_cache_invalidate (void);
+void dirsize_cache_free (void);
+
+/*** inline functions ****************************************************************************/
+
+#endif /* MC__DIRSIZE_H */
@@ -0,0 +1,633 @@
+/*
+   Recursive removal of directories on local filesystems.
+
+   Copyright (C) 2014
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \file src/filemanager/erase.c
+ *  \brief Source: parallel recursive removal of directories on local filesystems
+ *
+ *  Sibling subtrees are removed by a bounded pool of worker threads. Files are removed
+ *  with unlinkat() relative to the descriptor of their directory; the type of entry is
+ *  taken from d_type, so lstat() is called only if filesystem doesn't report it.
+ *
+ *  A directory is removed by the worker that finishes the last of its entries.
+ *  Errors are reported by the calling (UI) thread with file_error(), so Skip, Skip all,
+ *  Retry and Abort work like they do in erase_file() and recursive_erase().
+ *  Other workers are paused while error dialog is shown.
+ */
+
+#include <config.h>
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "lib/global.h"
+#include "lib/vfs/vfs.h"
+#include "lib/widget.h"         /* mc_refresh() */
+
+#include "filegui.h"
+#include "file.h"               /* file_error() */
+
+#include "erase.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+#if defined (HAVE_GLIB_THREADS) && defined (HAVE_UNLINKAT) && defined (HAVE_FSTATAT) \
+    && defined (HAVE_FDOPENDIR)
+#define ERASE_PARALLEL 1
+#endif
+
+/* number of worker threads: removing is bound by filesystem metadata latency */
+#define ERASE_WORKERS 4
+
+/* interval between progress dialog updates, in microseconds */
+#define ERASE_UPDATE_INTERVAL (G_USEC_PER_SEC / 10)
+
+/* number of removed files accumulated by worker before it updates shared counter */
+#define ERASE_COUNT_BATCH 64
+
+#ifndef O_DIRECTORY
+#define O_DIRECTORY 0
+#endif
+
+#ifndef O_NOFOLLOW
+#define O_NOFOLLOW 0
+#endif
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+/*** file scope type declarations ****************************************************************/
+
+#ifdef ERASE_PARALLEL
+/* Directory being removed */
+typedef struct erase_node_t
+{
+    struct erase_node_t *parent;
+    char *path;
+    int pending;                /* subdirectories not removed yet + 1 while directory is read */
+} erase_node_t;
+
+/* State of one removal shared by worker threads */
+typedef struct
+{
+    GMutex lock;
+    GCond cond;
+    GQueue jobs;                /* directories to read */
+    gboolean finished;          /* top directory is processed */
+    volatile gint cancel;
+    volatile gint pause;
+    gboolean threaded;
+
+    gboolean skip_all;
+    gboolean top_unreadable;
+    FileProgressStatus top_status;
+
+    size_t file_count;
+    char *last_dir;             /* last read directory, shown in progress dialog */
+
+    /* error query from worker to UI thread */
+    gboolean query_pending;
+    gboolean reply_ready;
+    const char *query_format;
+    const char *query_path;
+    int query_errno;
+    FileProgressStatus reply;
+} erase_walk_t;
+#endif /* ERASE_PARALLEL */
+
+/*** file scope variables ************************************************************************/
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef ERASE_PARALLEL
+/**
+ * Ask user what to do with error. Called in UI thread without walk lock.
+ */
+
+static FileProgressStatus
+erase_error_dialog (erase_walk_t * w, const char *format, const char *path, int error)
+{
+    FileProgressStatus status;
+
+    errno = error;
+    status = file_error (_(format), path);
+
+    g_mutex_lock (&w->lock);
+    if (status == FILE_SKIPALL)
+        w->skip_all = TRUE;
+    else if (status == FILE_ABORT)
+        g_atomic_int_set (&w->cancel, 1);
+    g_mutex_unlock (&w->lock);
+
+    return status;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Report error to UI thread and wait for the answer. Called in worker thread.
+ *
+ * @return FILE_RETRY, FILE_SKIP, FILE_SKIPALL or FILE_ABORT
+ */
+
+static FileProgressStatus
+erase_error (erase_walk_t * w, const char *format, const char *path, int error)
+{
+    FileProgressStatus status;
+
+    if (!w->threaded)
+    {
+        if (w->skip_all)
+            return FILE_SKIPALL;
+        return erase_error_dialog (w, format, path, error);
+    }
+
+    g_mutex_lock (&w->lock);
+
+    while (w->query_pending && g_atomic_int_get (&w->cancel) == 0)
+        g_cond_wait (&w->cond, &w->lock);
+
+    if (g_atomic_int_get (&w->cancel) != 0)
+        status = FILE_ABORT;
+    else if (w->skip_all)
+        status = FILE_SKIPALL;
+    else
+    {
+        w->query_format = format;
+        w->query_path = path;
+        w->query_errno = error;
+        w->query_pending = TRUE;
+        w->reply_ready = FALSE;
+        g_cond_broadcast (&w->cond);
+
+        while (!w->reply_ready)
+            g_cond_wait (&w->cond, &w->lock);
+
+        status = w->reply;
+        w->query_pending = FALSE;
+        w->reply_ready = FALSE;
+        g_cond_broadcast (&w->cond);
+    }
+
+    g_mutex_unlock (&w->lock);
+
+    return status;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Wait while UI thread is busy with progress dialog or error query */
+
+static void
+erase_wait_unpaused (erase_walk_t * w)
+{
+    if (g_atomic_int_get (&w->pause) == 0)
+        return;
+
+    g_mutex_lock (&w->lock);
+    while (g_atomic_int_get (&w->pause) != 0 && g_atomic_int_get (&w->cancel) == 0)
+        g_cond_wait (&w->cond, &w->lock);
+    g_mutex_unlock (&w->lock);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Remove one entry of directory. Retry while user asks.
+ *
+ * @param dir_fd descriptor of directory that contains the entry
+ * @param name name of entry
+ * @param dir_path path of directory, used in error message
+ * @param flags 0 or AT_REMOVEDIR
+ */
+
+static FileProgressStatus
+erase_entry (erase_walk_t * w, int dir_fd, const char *name, const char *dir_path, int flags)
+{
+    while (unlinkat (dir_fd, name, flags) != 0)
+    {
+        FileProgressStatus status;
+        int error = errno;
+        char *path;
+
+        path = dir_path == NULL ? g_strdup (name) : g_build_filename (dir_path, name, (char *) NULL);
+        if ((flags & AT_REMOVEDIR) != 0)
+            status = erase_error (w, N_("Cannot remove directory \"%s\"\n%s"), path, error);
+        else
+            status = erase_error (w, N_("Cannot delete file \"%s\"\n%s"), path, error);
+        g_free (path);
+
+        if (status != FILE_RETRY)
+            return status;
+    }
+
+    return FILE_CONT;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+erase_add_count (erase_walk_t * w, size_t count)
+{
+    g_mutex_lock (&w->lock);
+    w->file_count += count;
+    g_mutex_unlock (&w->lock);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Drop one pending reference of directory. If there are no more, remove the directory
+ * and drop reference of its parent.
+ */
+
+static void
+erase_node_release (erase_walk_t * w, erase_node_t * node)
+{
+    while (node != NULL)
+    {
+        erase_node_t *parent;
+        FileProgressStatus status = FILE_ABORT;
+
+        g_mutex_lock (&w->lock);
+        node->pending--;
+        if (node->pending > 0)
+        {
+            g_mutex_unlock (&w->lock);
+            break;
+        }
+        g_mutex_unlock (&w->lock);
+
+        if (g_atomic_int_get (&w->cancel) == 0)
+        {
+            erase_wait_unpaused (w);
+            status = erase_entry (w, AT_FDCWD, node->path, NULL, AT_REMOVEDIR);
+        }
+
+        parent = node->parent;
+        if (parent == NULL)
+        {
+            g_mutex_lock (&w->lock);
+            w->top_status = status;
+            w->finished = TRUE;
+            g_cond_broadcast (&w->cond);
+            g_mutex_unlock (&w->lock);
+        }
+
+        g_free (node->path);
+        g_free (node);
+        node = parent;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Read one directory: remove its files and queue its subdirectories.
+ * Called from worker thread without walk lock.
+ */
+
+static void
+erase_scan_dir (erase_walk_t * w, erase_node_t * node)
+{
+    int fd;
+    DIR *dir = NULL;
+    struct dirent *dirent;
+    size_t count = 0;
+
+    if (g_atomic_int_get (&w->cancel) != 0)
+    {
+        erase_node_release (w, node);
+        return;
+    }
+
+    fd = open (node->path, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC | O_NOCTTY);
+    if (fd != -1)
+    {
+        dir = fdopendir (fd);
+        if (dir == NULL)
+            close (fd);
+    }
+
+    if (dir == NULL)
+    {
+        /* like recursive_erase(), don't try to remove unreadable top directory */
+        if (node->parent == NULL)
+        {
+            g_mutex_lock (&w->lock);
+            w->top_unreadable = TRUE;
+            g_mutex_unlock (&w->lock);
+            g_atomic_int_set (&w->cancel, 1);
+        }
+        erase_node_release (w, node);
+        return;
+    }
+
+    g_mutex_lock (&w->lock);
+    g_free (w->last_dir);
+    w->last_dir = g_strdup (node->path);
+    g_mutex_unlock (&w->lock);
+
+    while (g_atomic_int_get (&w->cancel) == 0 && (dirent = readdir (dir)) != NULL)
+    {
+        gboolean is_dir = FALSE;
+
+        if (DIR_IS_DOT (dirent->d_name) || DIR_IS_DOTDOT (dirent->d_name))
+            continue;
+
+        erase_wait_unpaused (w);
+
+#ifdef HAVE_STRUCT_DIRENT_D_TYPE
+        if (dirent->d_type != DT_UNKNOWN)
+            is_dir = dirent->d_type == DT_DIR;
+        else
+#endif
+        {
+            struct stat s;
+
+            /* if lstat fails, try to unlink: error will be reported then */
+            is_dir = fstatat (dirfd (dir), dirent->d_name, &s, AT_SYMLINK_NOFOLLOW) == 0
+                && S_ISDIR (s.st_mode);
+        }
+
+        if (is_dir)
+        {
+            erase_node_t *child;
+
+            child = g_new (erase_node_t, 1);
+            child->parent = node;
+            child->path = g_build_filename (node->path, dirent->d_name, (char *) NULL);
+            child->pending = 1;
+
+            g_mutex_lock (&w->lock);
+            node->pending++;
+            g_queue_push_tail (&w->jobs, child);
+            g_cond_broadcast (&w->cond);
+            g_mutex_unlock (&w->lock);
+            continue;
+        }
+
+        erase_entry (w, dirfd (dir), dirent->d_name, node->path, 0);
+
+        if (++count == ERASE_COUNT_BATCH)
+        {
+            erase_add_count (w, count);
+            count = 0;
+        }
+    }
+
+    closedir (dir);
+
+    if (count != 0)
+        erase_add_count (w, count);
+
+    erase_node_release (w, node);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gpointer
+erase_worker (gpointer data)
+{
+    erase_walk_t *w = (erase_walk_t *) data;
+
+    g_mutex_lock (&w->lock);
+
+    while (TRUE)
+    {
+        erase_node_t *node;
+
+        while (!w->finished && g_queue_is_empty (&w->jobs))
+            g_cond_wait (&w->cond, &w->lock);
+
+        if (w->finished)
+            break;
+
+        node = (erase_node_t *) g_queue_pop_head (&w->jobs);
+        g_mutex_unlock (&w->lock);
+
+        erase_scan_dir (w, node);
+
+        g_mutex_lock (&w->lock);
+    }
+
+    g_mutex_unlock (&w->lock);
+
+    return NULL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Update progress dialog and check its buttons. Workers are paused meanwhile.
+ * Called in UI thread with walk lock held.
+ */
+
+static void
+erase_show_progress (erase_walk_t * w, file_op_total_context_t * tctx, file_op_context_t * ctx,
+                     size_t count_base)
+{
+    char *path;
+    FileProgressStatus status;
+
+    path = g_strdup (w->last_dir);
+    tctx->progress_count = count_base + w->file_count;
+    g_atomic_int_set (&w->pause, 1);
+    g_mutex_unlock (&w->lock);
+
+    if (path != NULL)
+        file_progress_show_deleting (ctx, path, NULL);
+    file_progress_show_count (ctx, tctx->progress_count, ctx->progress_count);
+    status = check_progress_buttons (ctx);
+    mc_refresh ();
+    g_free (path);
+
+    g_mutex_lock (&w->lock);
+    g_atomic_int_set (&w->pause, 0);
+    if (status == FILE_ABORT)
+        g_atomic_int_set (&w->cancel, 1);
+    g_cond_broadcast (&w->cond);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Answer error query of worker.
+ * Called in UI thread with walk lock held.
+ */
+
+static void
+erase_answer_query (erase_walk_t * w)
+{
+    if (g_atomic_int_get (&w->cancel) != 0)
+        w->reply = FILE_ABORT;
+    else if (w->skip_all)
+        w->reply = FILE_SKIPALL;
+    else
+    {
+        const char *format = w->query_format;
+        const char *path = w->query_path;
+        int error = w->query_errno;
+        FileProgressStatus status;
+
+        g_atomic_int_set (&w->pause, 1);
+        g_mutex_unlock (&w->lock);
+
+        status = erase_error_dialog (w, format, path, error);
+
+        g_mutex_lock (&w->lock);
+        g_atomic_int_set (&w->pause, 0);
+        w->reply = status;
+    }
+
+    w->reply_ready = TRUE;
+    g_cond_broadcast (&w->cond);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+erase_query_waits (const erase_walk_t * w)
+{
+    return w->query_pending && !w->reply_ready;
+}
+#endif /* ERASE_PARALLEL */
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+/**
+ * Check whether the directory can be removed by erase_local_tree().
+ */
+
+gboolean
+erase_local_supported (const vfs_path_t * vpath)
+{
+#ifdef ERASE_PARALLEL
+    return vfs_file_is_local (vpath);
+#else
+    (void) vpath;
+    return FALSE;
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Remove local directory with all its contents.
+ * Counters and dialogs are handled the same way as recursive_erase() does.
+ *
+ * @return FILE_CONT if directory is removed, FILE_RETRY if it cannot be read,
+ *         FILE_ABORT if user aborted the operation, otherwise answer to the error
+ *         of top directory removal
+ */
+
+FileProgressStatus
+erase_local_tree (file_op_total_context_t * tctx, file_op_context_t * ctx,
+                  const vfs_path_t * vpath)
+{
+#ifdef ERASE_PARALLEL
+    erase_walk_t w;
+    erase_node_t *top;
+    GThread *workers[ERASE_WORKERS];
+    size_t count_base = tctx->progress_count;
+    FileProgressStatus ret;
+    int n_workers, i;
+
+    memset (&w, 0, sizeof (w));
+    g_mutex_init (&w.lock);
+    g_cond_init (&w.cond);
+    g_queue_init (&w.jobs);
+    w.skip_all = ctx->skip_all;
+    w.threaded = TRUE;
+    w.top_status = FILE_CONT;
+
+    top = g_new (erase_node_t, 1);
+    top->parent = NULL;
+    top->path = g_strdup (vfs_path_get_by_index (vpath, -1)->path);
+    top->pending = 1;
+    g_queue_push_tail (&w.jobs, top);
+
+    for (i = 0; i < ERASE_WORKERS; i++)
+    {
+        workers[i] = g_thread_try_new ("erase", erase_worker, &w, NULL);
+        if (workers[i] == NULL)
+            break;
+    }
+    n_workers = i;
+
+    if (n_workers == 0)
+    {
+        /* cannot create threads: remove in this thread */
+        w.threaded = FALSE;
+        erase_worker (&w);
+    }
+
+    g_mutex_lock (&w.lock);
+
+    while (!w.finished)
+    {
+        gint64 end_time;
+
+        end_time = g_get_monotonic_time () + ERASE_UPDATE_INTERVAL;
+        while (!w.finished && !erase_query_waits (&w)
+               && g_cond_wait_until (&w.cond, &w.lock, end_time))
+            ;
+
+        if (erase_query_waits (&w))
+            erase_answer_query (&w);
+        else if (!w.finished && g_atomic_int_get (&w.cancel) == 0)
+            erase_show_progress (&w, tctx, ctx, count_base);
+    }
+
+    g_mutex_unlock (&w.lock);
+
+    for (i = 0; i < n_workers; i++)
+        g_thread_join (workers[i]);
+
+    tctx->progress_count = count_base + w.file_count;
+    ctx->skip_all = w.skip_all;
+    file_progress_show_count (ctx, tctx->progress_count, ctx->progress_count);
+
+    if (w.top_unreadable)
+        ret = FILE_RETRY;
+    else if (g_atomic_int_get (&w.cancel) != 0)
+        ret = FILE_ABORT;
+    else
+        ret = w.top_status;
+
+    g_free (w.last_dir);
+    g_cond_clear (&w.cond);
+    g_mutex_clear (&w.lock);
+
+    return ret;
+#else
+    (void) tctx;
+    (void) ctx;
+    (void) vpath;
+    return FILE_RETRY;
+#endif /* ERASE_PARALLEL */
+}
+
+/* --------------------------------------------------------------------------------------------- */
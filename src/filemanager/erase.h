@@ -0,0 +1,29 @@
+/** \file  erase.h
+ *  \brief Header: parallel recursive removal of directories on local filesystems
+ */
+
+#ifndef MC__ERASE_H
+#define MC__ERASE_H
+
+#include "lib/global.h"
+#include "lib/vfs/vfs.h"        /* vfs_path_t */
+
+#include "fileopctx.h"
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+/*** enums ***************************************************************************************/
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+/*** global variables defined in .c file *********************************************************/
+
+/*** declarations of public functions ************************************************************/
+
+gboolean erase_local_supported (const vfs_path_t * vpath);
+FileProgressStatus erase_local_tree (file_op_total_context_t * tctx, file_op_context_t * ctx,
+                                     const vfs_path_t * vpath);
+
+/*** inline functions ****************************************************************************/
+
+#endif /* MC__ERASE_H */
@@ -83,6 +83,8 @@
 #include "tree.h"
 #include "midnight.h"           /* current_panel */
 #include "layout.h"             /* rotate_dash() */
+#include "dirsize.h"
+#include "erase.h"
 
 #include "file.h"
 
@@ -91,10 +93,12 @@
 /*** global variables ****************************************************************************/
 
 /* TRANSLATORS: no need to translate 'DialogTitle', it's just a context prefix  */
-const char *op_names[3] = {
+const char *op_names[5] = {
     N_("DialogTitle|Copy"),
     N_("DialogTitle|Move"),
-    N_("DialogTitle|Delete")
+    N_("DialogTitle|Delete"),
+    N_("DialogTitle|Chmod"),
+    N_("DialogTitle|Chown")
 };
 
 /*** file scope macro definitions ****************************************************************/
@@ -169,22 +173,26 @@ static const char *prompt_parts[] = {
 /*** file scope variables ************************************************************************/
 
 /* the hard link cache */
-static GSList *linklist = NULL;
+static GHashTable *linklist = NULL;
 
 /* the files-to-be-erased list */
-static GSList *erase_list = NULL;
+static GQueue erase_list = G_QUEUE_INIT;
 
 /*
- * In copy_dir_dir we use two additional single linked lists: The first -
- * variable name 'parent_dirs' - holds information about already copied
- * directories and is used to detect cyclic symbolic links.
+ * In copy_dir_dir we use two additional tables: The first -
+ * variable name 'parent_dirs' - holds information about directories
+ * being copied now and is used to detect cyclic symbolic links.
  * The second ('dest_dirs' below) holds information about just created
  * target directories and is used to detect when an directory is copied
  * into itself (we don't want to copy infinitly).
- * Both lists don't use the linkcount and name structure members of struct
+ * Both tables don't use the linkcount and name structure members of struct
  * link.
+ *
+ * All tables are keyed by (vfs class, device, inode) of struct link
+ * and live during one panel_operate() call.
  */
-static GSList *dest_dirs = NULL;
+static GHashTable *parent_dirs = NULL;
+static GHashTable *dest_dirs = NULL;
 
 static FileProgressStatus transform_error = FILE_CONT;
 
@@ -275,33 +283,84 @@ free_link (void *data)
 
 /* --------------------------------------------------------------------------------------------- */
 
+static guint
+link_hash (gconstpointer key)
+{
+    const struct link *lnk = (const struct link *) key;
+
+    return (guint) lnk->ino ^ (guint) lnk->dev ^ (GPOINTER_TO_UINT (lnk->vfs) >> 4);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+link_equal (gconstpointer a, gconstpointer b)
+{
+    const struct link *la = (const struct link *) a;
+    const struct link *lb = (const struct link *) b;
+
+    return la->ino == lb->ino && la->dev == lb->dev && la->vfs == lb->vfs;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
 static inline void *
-free_linklist (GSList * lp)
+free_linklist (GHashTable * table)
 {
-    g_slist_free_full (lp, free_link);
+    if (table != NULL)
+        g_hash_table_destroy (table);
 
     return NULL;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/** Add link to the table. Table is created if needed and owns the link then */
+
+static void
+add_to_linklist (GHashTable ** table, struct link *lnk)
+{
+    if (*table == NULL)
+        *table = g_hash_table_new_full (link_hash, link_equal, NULL, free_link);
+
+    g_hash_table_replace (*table, lnk, lnk);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static struct link *
+find_in_linklist (GHashTable * table, const struct vfs_class *class, dev_t dev, ino_t ino)
+{
+    struct link key;
+
+    if (table == NULL)
+        return NULL;
+
+    key.vfs = class;
+    key.dev = dev;
+    key.ino = ino;
+
+    return (struct link *) g_hash_table_lookup (table, &key);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 static gboolean
-is_in_linklist (const GSList * lp, const vfs_path_t * vpath, const struct stat *sb)
+is_in_linklist (GHashTable * table, const vfs_path_t * vpath, const struct stat *sb)
 {
     const struct vfs_class *class;
-    ino_t ino = sb->st_ino;
-    dev_t dev = sb->st_dev;
 
     class = vfs_path_get_last_path_vfs (vpath);
 
-    for (; lp != NULL; lp = g_slist_next (lp))
-    {
-        const struct link *lnk = (const struct link *) lp->data;
+    return find_in_linklist (table, class, sb->st_dev, sb->st_ino) != NULL;
+}
 
-        if (lnk->vfs == class && lnk->ino == ino && lnk->dev == dev)
-            return TRUE;
-    }
-    return FALSE;
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+free_erase_list (void)
+{
+    g_queue_foreach (&erase_list, (GFunc) free_link, NULL);
+    g_queue_clear (&erase_list);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -315,7 +374,6 @@ is_in_linklist (const GSList * lp, const vfs_path_t * vpath, const struct stat *
 static gboolean
 check_hardlinks (const vfs_path_t * src_vpath, const vfs_path_t * dst_vpath, struct stat *pstat)
 {
-    GSList *lp;
     struct link *lnk;
 
     const struct vfs_class *my_vfs;
@@ -328,47 +386,40 @@ check_hardlinks (const vfs_path_t * src_vpath, const vfs_path_t * dst_vpath, str
 
     my_vfs = vfs_path_get_by_index (src_vpath, -1)->class;
 
-    for (lp = linklist; lp != NULL; lp = g_slist_next (lp))
+    lnk = find_in_linklist (linklist, my_vfs, dev, ino);
+    if (lnk != NULL)
     {
-        lnk = (struct link *) lp->data;
-
-        if (lnk->vfs == my_vfs && lnk->ino == ino && lnk->dev == dev)
-        {
-            const struct vfs_class *lp_name_class;
-            int stat_result;
+        const struct vfs_class *lp_name_class;
+        int stat_result;
 
-            lp_name_class = vfs_path_get_last_path_vfs (lnk->src_vpath);
-            stat_result = mc_stat (lnk->src_vpath, &link_stat);
+        lp_name_class = vfs_path_get_last_path_vfs (lnk->src_vpath);
+        stat_result = mc_stat (lnk->src_vpath, &link_stat);
 
-            if (stat_result == 0 && link_stat.st_ino == ino
-                && link_stat.st_dev == dev && lp_name_class == my_vfs)
-            {
-                const struct vfs_class *p_class, *dst_name_class;
-
-                dst_name_class = vfs_path_get_last_path_vfs (dst_vpath);
-                p_class = vfs_path_get_last_path_vfs (lnk->dst_vpath);
+        if (stat_result == 0 && link_stat.st_ino == ino
+            && link_stat.st_dev == dev && lp_name_class == my_vfs)
+        {
+            const struct vfs_class *p_class, *dst_name_class;
 
-                if (dst_name_class == p_class &&
-                    mc_stat (lnk->dst_vpath, &link_stat) == 0 &&
-                    mc_link (lnk->dst_vpath, dst_vpath) == 0)
-                    return TRUE;
-            }
+            dst_name_class = vfs_path_get_last_path_vfs (dst_vpath);
+            p_class = vfs_path_get_last_path_vfs (lnk->dst_vpath);
 
-            message (D_ERROR, MSG_ERROR, _("Cannot make the hardlink"));
-            return FALSE;
+            if (dst_name_class == p_class &&
+                mc_stat (lnk->dst_vpath, &link_stat) == 0 &&
+                mc_link (lnk->dst_vpath, dst_vpath) == 0)
+                return TRUE;
         }
+
+        message (D_ERROR, MSG_ERROR, _("Cannot make the hardlink"));
+        return FALSE;
     }
 
     lnk = g_new0 (struct link, 1);
-    if (lnk != NULL)
-    {
-        lnk->vfs = my_vfs;
-        lnk->ino = ino;
-        lnk->dev = dev;
-        lnk->src_vpath = vfs_path_clone (src_vpath);
-        lnk->dst_vpath = vfs_path_clone (dst_vpath);
-        linklist = g_slist_prepend (linklist, lnk);
-    }
+    lnk->vfs = my_vfs;
+    lnk->ino = ino;
+    lnk->dev = dev;
+    lnk->src_vpath = vfs_path_clone (src_vpath);
+    lnk->dst_vpath = vfs_path_clone (dst_vpath);
+    add_to_linklist (&linklist, lnk);
 
     return FALSE;
 }
@@ -1292,14 +1343,14 @@ panel_compute_totals (const WPanel * panel, dirsize_status_msg_t * sm, size_t *
 
     for (i = 0; i < panel->dir.len; i++)
     {
-        struct stat *s;
+        const file_stat_t *s;
 
         if (!panel->dir.list[i].f.marked)
             continue;
 
         s = &panel->dir.list[i].st;
 
-        if (S_ISDIR (s->st_mode))
+        if (S_ISDIR (s->mode))
         {
             vfs_path_t *p;
             FileProgressStatus status;
@@ -1314,7 +1365,7 @@ panel_compute_totals (const WPanel * panel, dirsize_status_msg_t * sm, size_t *
         else
         {
             (*ret_count)++;
-            *ret_total += (uintmax_t) s->st_size;
+            *ret_total += (uintmax_t) s->size;
         }
     }
 
@@ -2028,13 +2079,13 @@ copy_file_file (file_op_total_context_t * tctx, file_op_context_t * ctx,
 
 FileProgressStatus
 copy_dir_dir (file_op_total_context_t * tctx, file_op_context_t * ctx, const char *s, const char *d,
-              gboolean toplevel, gboolean move_over, gboolean do_delete, GSList * parent_dirs)
+              gboolean toplevel, gboolean move_over, gboolean do_delete)
 {
     struct dirent *next;
     struct stat buf, cbuf;
     DIR *reading;
     FileProgressStatus return_status = FILE_CONT;
-    struct link *lp;
+    struct link *lp, *parent_lp;
     vfs_path_t *src_vpath, *dst_vpath;
     gboolean do_mkdir = TRUE;
 
@@ -2101,11 +2152,11 @@ copy_dir_dir (file_op_total_context_t * tctx, file_op_context_t * ctx, const cha
         goto ret_fast;
     }
 
-    lp = g_new0 (struct link, 1);
-    lp->vfs = vfs_path_get_by_index (src_vpath, -1)->class;
-    lp->ino = cbuf.st_ino;
-    lp->dev = cbuf.st_dev;
-    parent_dirs = g_slist_prepend (parent_dirs, lp);
+    parent_lp = g_new0 (struct link, 1);
+    parent_lp->vfs = vfs_path_get_by_index (src_vpath, -1)->class;
+    parent_lp->ino = cbuf.st_ino;
+    parent_lp->dev = cbuf.st_dev;
+    add_to_linklist (&parent_dirs, parent_lp);
 
   retry_dst_stat:
     /* Now, check if the dest dir exists, if not, create it. */
@@ -2179,7 +2230,7 @@ copy_dir_dir (file_op_total_context_t * tctx, file_op_context_t * ctx, const cha
         lp->vfs = vfs_path_get_by_index (dst_vpath, -1)->class;
         lp->ino = buf.st_ino;
         lp->dev = buf.st_dev;
-        dest_dirs = g_slist_prepend (dest_dirs, lp);
+        add_to_linklist (&dest_dirs, lp);
     }
 
     if (ctx->preserve_uidgid)
@@ -2231,8 +2282,7 @@ copy_dir_dir (file_op_total_context_t * tctx, file_op_context_t * ctx, const cha
              * dir already exists. So, we give the recursive call the flag 0
              * meaning no toplevel.
              */
-            return_status =
-                copy_dir_dir (tctx, ctx, path, mdpath, FALSE, FALSE, do_delete, parent_dirs);
+            return_status = copy_dir_dir (tctx, ctx, path, mdpath, FALSE, FALSE, do_delete);
             g_free (mdpath);
         }
         else
@@ -2253,7 +2303,7 @@ copy_dir_dir (file_op_total_context_t * tctx, file_op_context_t * ctx, const cha
                 lp = g_new0 (struct link, 1);
                 lp->src_vpath = tmp_vpath;
                 lp->st_mode = buf.st_mode;
-                erase_list = g_slist_append (erase_list, lp);
+                g_queue_push_tail (&erase_list, lp);
                 tmp_vpath = NULL;
             }
             else if (S_ISDIR (buf.st_mode))
@@ -2283,8 +2333,8 @@ copy_dir_dir (file_op_total_context_t * tctx, file_op_context_t * ctx, const cha
     }
 
   ret:
-    free_link (parent_dirs->data);
-    g_slist_free_1 (parent_dirs);
+    /* the directory is not a parent of ones copied after it */
+    g_hash_table_remove (parent_dirs, parent_lp);
   ret_fast:
     vfs_path_free (src_vpath);
     vfs_path_free (dst_vpath);
@@ -2349,7 +2399,7 @@ move_dir_dir (file_op_total_context_t * tctx, file_op_context_t * ctx, const cha
     {
         if (move_over)
         {
-            return_status = copy_dir_dir (tctx, ctx, s, d, FALSE, TRUE, TRUE, NULL);
+            return_status = copy_dir_dir (tctx, ctx, s, d, FALSE, TRUE, TRUE);
 
             if (return_status != FILE_CONT)
                 goto ret;
@@ -2392,7 +2442,7 @@ move_dir_dir (file_op_total_context_t * tctx, file_op_context_t * ctx, const cha
         goto ret;
     }
     /* Failed because of filesystem boundary -> copy dir instead */
-    return_status = copy_dir_dir (tctx, ctx, s, d, FALSE, FALSE, TRUE, NULL);
+    return_status = copy_dir_dir (tctx, ctx, s, d, FALSE, FALSE, TRUE);
 
     if (return_status != FILE_CONT)
         goto ret;
@@ -2408,19 +2458,19 @@ move_dir_dir (file_op_total_context_t * tctx, file_op_context_t * ctx, const cha
     mc_refresh ();
     if (ctx->erase_at_end)
     {
+        struct link *lp;
+
         /* Reset progress count before delete to avoid counting files twice */
         tctx->progress_count = tctx->prev_progress_count;
 
-        while (erase_list != NULL && return_status != FILE_ABORT)
+        while (return_status != FILE_ABORT
+               && (lp = (struct link *) g_queue_pop_head (&erase_list)) != NULL)
         {
-            struct link *lp = (struct link *) erase_list->data;
-
             if (S_ISDIR (lp->st_mode))
                 return_status = erase_dir_iff_empty (ctx, lp->src_vpath, tctx->progress_count);
             else
                 return_status = erase_file (tctx, ctx, lp->src_vpath);
 
-            erase_list = g_slist_remove (erase_list, lp);
             free_link (lp);
         }
 
@@ -2430,7 +2480,7 @@ move_dir_dir (file_op_total_context_t * tctx, file_op_context_t * ctx, const cha
     erase_dir_iff_empty (ctx, src_vpath, tctx->progress_count);
 
   ret:
-    erase_list = free_linklist (erase_list);
+    free_erase_list ();
   ret_fast:
     vfs_path_free (src_vpath);
     vfs_path_free (dst_vpath);
@@ -2466,7 +2516,12 @@ erase_dir (file_op_total_context_t * tctx, file_op_context_t * ctx, const vfs_pa
     {                           /* not empty */
         error = query_recursive (ctx, vfs_path_as_str (s_vpath));
         if (error == FILE_CONT)
-            error = recursive_erase (tctx, ctx, s_vpath);
+        {
+            if (erase_local_supported (s_vpath))
+                error = erase_local_tree (tctx, ctx, s_vpath);
+            else
+                error = recursive_erase (tctx, ctx, s_vpath);
+        }
         return error;
     }
 
@@ -2582,6 +2637,10 @@ compute_dir_size (const vfs_path_t * dirname_vpath, dirsize_status_msg_t * sm,
                   size_t * ret_dir_count, size_t * ret_marked_count, uintmax_t * ret_total,
                   gboolean compute_symlinks)
 {
+    if (dirsize_local_supported (dirname_vpath))
+        return dirsize_local_compute (dirname_vpath, sm, ret_dir_count, ret_marked_count,
+                                      ret_total, compute_symlinks);
+
     return do_compute_dir_size (dirname_vpath, sm, ret_dir_count, ret_marked_count, ret_total,
                                 compute_symlinks);
 }
@@ -2628,16 +2687,9 @@ panel_operate (void *source_panel, FileOperation operation, gboolean force_singl
 
     gboolean do_bg = FALSE;     /* do background operation? */
 
-    static gboolean i18n_flag = FALSE;
-    if (!i18n_flag)
-    {
-        for (i = G_N_ELEMENTS (op_names); i-- != 0;)
-            op_names[i] = Q_ (op_names[i]);
-        i18n_flag = TRUE;
-    }
-
     linklist = free_linklist (linklist);
     dest_dirs = free_linklist (dest_dirs);
+    parent_dirs = free_linklist (parent_dirs);
 
     if (single_entry)
     {
@@ -2680,6 +2732,7 @@ panel_operate (void *source_panel, FileOperation operation, gboolean force_singl
     }
 
     ctx = file_op_context_new (operation);
+    file_op_begin ();
 
     /* Show confirmation dialog */
     if (operation != OP_DELETE)
@@ -2790,6 +2843,8 @@ panel_operate (void *source_panel, FileOperation operation, gboolean force_singl
             vfs_path_free (dest_vpath);
             g_free (dest);
             /*          file_op_context_destroy (ctx); */
+            file_op_end ();
+            dirsize_cache_invalidate ();
             return FALSE;
         }
     }
@@ -2798,7 +2853,7 @@ panel_operate (void *source_panel, FileOperation operation, gboolean force_singl
     {
         if (operation == OP_DELETE)
             dialog_type = FILEGUI_DIALOG_DELETE_ITEM;
-        else if (single_entry && S_ISDIR (selection (panel)->st.st_mode))
+        else if (single_entry && S_ISDIR (selection (panel)->st.mode))
             dialog_type = FILEGUI_DIALOG_MULTI_ITEM;
         else if (single_entry || force_single)
             dialog_type = FILEGUI_DIALOG_ONE_ITEM;
@@ -2892,7 +2947,7 @@ panel_operate (void *source_panel, FileOperation operation, gboolean force_singl
                         if (S_ISDIR (src_stat.st_mode))
                             value =
                                 copy_dir_dir (tctx, ctx, vfs_path_as_str (source_with_vpath),
-                                              dest, TRUE, FALSE, FALSE, NULL);
+                                              dest, TRUE, FALSE, FALSE);
                         else
                             value =
                                 copy_file_file (tctx, ctx, vfs_path_as_str (source_with_vpath),
@@ -2951,7 +3006,7 @@ panel_operate (void *source_panel, FileOperation operation, gboolean force_singl
                     continue;   /* Skip the unmarked ones */
 
                 source2 = panel->dir.list[i].fname;
-                src_stat = panel->dir.list[i].st;
+                file_stat_to_stat (&panel->dir.list[i].st, &src_stat);
 
 #ifdef WITH_FULL_PATHS
                 vfs_path_free (source_with_vpath);
@@ -3007,7 +3062,7 @@ panel_operate (void *source_panel, FileOperation operation, gboolean force_singl
                             }
                             if (S_ISDIR (src_stat.st_mode))
                                 value = copy_dir_dir (tctx, ctx, source_with_path_str, temp,
-                                                      TRUE, FALSE, FALSE, NULL);
+                                                      TRUE, FALSE, FALSE);
                             else
                                 value = copy_file_file (tctx, ctx, source_with_path_str, temp);
                             dest_dirs = free_linklist (dest_dirs);
@@ -3072,6 +3127,7 @@ panel_operate (void *source_panel, FileOperation operation, gboolean force_singl
 
     linklist = free_linklist (linklist);
     dest_dirs = free_linklist (dest_dirs);
+    parent_dirs = free_linklist (parent_dirs);
 #ifdef WITH_FULL_PATHS
     vfs_path_free (source_with_vpath);
 #endif /* WITH_FULL_PATHS */
@@ -3097,7 +3153,10 @@ panel_operate (void *source_panel, FileOperation operation, gboolean force_singl
 
     file_op_total_context_destroy (tctx);
   ret_fast:
+    file_op_end ();
     file_op_context_destroy (ctx);
+    /* files can be overwritten in place: sizes of their directories aren't valid */
+    dirsize_cache_invalidate ();
     g_free (source);
 
     return ret_val;
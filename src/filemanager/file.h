@@ -45,8 +45,7 @@ FileProgressStatus move_dir_dir (file_op_total_context_t * tctx, file_op_context
                                  const char *s, const char *d);
 FileProgressStatus copy_dir_dir (file_op_total_context_t * tctx, file_op_context_t * ctx,
                                  const char *s, const char *d,
-                                 gboolean toplevel, gboolean move_over, gboolean do_delete,
-                                 GSList * parent_dirs);
+                                 gboolean toplevel, gboolean move_over, gboolean do_delete);
 FileProgressStatus erase_dir (file_op_total_context_t * tctx, file_op_context_t * ctx,
                               const vfs_path_t * vpath);
 
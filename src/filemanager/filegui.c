@@ -653,11 +653,14 @@ progress_button_callback (WButton * button, int action)
 }
 
 /* --------------------------------------------------------------------------------------------- */
-/*** public functions ****************************************************************************/
-/* --------------------------------------------------------------------------------------------- */
+/**
+ * Process event of progress dialog.
+ *
+ * @param block wait for key, mouse event or completion of background job
+ */
 
-FileProgressStatus
-check_progress_buttons (file_op_context_t * ctx)
+static FileProgressStatus
+progress_buttons_event (file_op_context_t * ctx, gboolean block)
 {
     int c;
     Gpm_Event event;
@@ -670,7 +673,7 @@ check_progress_buttons (file_op_context_t * ctx)
 
   get_event:
     event.x = -1;               /* Don't show the GPM cursor */
-    c = tty_get_event (&event, FALSE, ctx->suspended);
+    c = tty_get_event (&event, FALSE, block || ctx->suspended);
     if (c == EV_NONE)
         return FILE_CONT;
 
@@ -705,6 +708,29 @@ check_progress_buttons (file_op_context_t * ctx)
     }
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+FileProgressStatus
+check_progress_buttons (file_op_context_t * ctx)
+{
+    return progress_buttons_event (ctx, FALSE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Like check_progress_buttons(), but wait for event. Used while operation is performed by
+ * another thread: it returns FILE_CONT when the thread posts completion with
+ * tty_post_completion().
+ */
+
+FileProgressStatus
+wait_progress_buttons (file_op_context_t * ctx)
+{
+    return progress_buttons_event (ctx, TRUE);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /* {{{ File progress display routines */
 
@@ -1097,6 +1123,23 @@ file_progress_show_deleting (file_op_context_t * ctx, const char *s, size_t * co
         (*count)++;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+   show path of processed item in the dialog created with FILEGUI_DIALOG_DELETE_ITEM type
+ */
+
+void
+file_progress_show_path (file_op_context_t * ctx, const char *s)
+{
+    file_op_context_ui_t *ui;
+
+    if (ctx == NULL || ctx->ui == NULL)
+        return;
+
+    ui = ctx->ui;
+    label_set_text (ui->src_file, truncFileStringSecure (ui->op_dlg, s));
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 FileProgressStatus
@@ -28,6 +28,7 @@ char *file_mask_dialog (file_op_context_t * ctx, FileOperation operation,
                         const char *def_text, gboolean * do_bg);
 
 FileProgressStatus check_progress_buttons (file_op_context_t * ctx);
+FileProgressStatus wait_progress_buttons (file_op_context_t * ctx);
 
 void file_progress_show (file_op_context_t * ctx, off_t done, off_t total,
                          const char *stalled_msg, gboolean force_update);
@@ -37,6 +38,7 @@ void file_progress_show_total (file_op_total_context_t * tctx, file_op_context_t
 void file_progress_show_source (file_op_context_t * ctx, const vfs_path_t * s_vpath);
 void file_progress_show_target (file_op_context_t * ctx, const vfs_path_t * path);
 void file_progress_show_deleting (file_op_context_t * ctx, const char *path, size_t * count);
+void file_progress_show_path (file_op_context_t * ctx, const char *path);
 
 /*** inline functions ****************************************************************************/
 #endif /* MC__FILEGUI_H */
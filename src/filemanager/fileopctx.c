@@ -49,6 +49,9 @@
 
 /*** file scope variables ************************************************************************/
 
+/* number of file operations in progress */
+static int running_ops = 0;
+
 /*** file scope functions ************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
 
@@ -68,8 +71,18 @@
 file_op_context_t *
 file_op_context_new (FileOperation op)
 {
+    static gboolean i18n_flag = FALSE;
     file_op_context_t *ctx;
 
+    if (!i18n_flag)
+    {
+        size_t i;
+
+        for (i = G_N_ELEMENTS (op_names); i-- != 0;)
+            op_names[i] = Q_ (op_names[i]);
+        i18n_flag = TRUE;
+    }
+
     ctx = g_new0 (file_op_context_t, 1);
     ctx->operation = op;
     ctx->eta_secs = 0.0;
@@ -106,6 +119,35 @@ file_op_context_destroy (file_op_context_t * ctx)
     }
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Mark start of file operation. Panels don't change their lists until the operation
+ * is finished by file_op_end(), since operations walk them by index.
+ */
+
+void
+file_op_begin (void)
+{
+    running_ops++;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+file_op_end (void)
+{
+    if (running_ops > 0)
+        running_ops--;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+gboolean
+file_op_is_running (void)
+{
+    return (running_ops != 0);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 file_op_total_context_t *
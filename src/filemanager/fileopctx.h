@@ -34,7 +34,9 @@ typedef enum
 {
     OP_COPY = 0,
     OP_MOVE = 1,
-    OP_DELETE = 2
+    OP_DELETE = 2,
+    OP_CHMOD = 3,
+    OP_CHOWN = 4
 } FileOperation;
 
 typedef enum
@@ -179,13 +181,17 @@ typedef struct
 
 /*** global variables defined in .c file *********************************************************/
 
-extern const char *op_names[3];
+extern const char *op_names[5];
 
 /*** declarations of public functions ************************************************************/
 
 file_op_context_t *file_op_context_new (FileOperation op);
 void file_op_context_destroy (file_op_context_t * ctx);
 
+void file_op_begin (void);
+void file_op_end (void);
+gboolean file_op_is_running (void);
+
 file_op_total_context_t *file_op_total_context_new (void);
 void file_op_total_context_destroy (file_op_total_context_t * tctx);
 
@@ -1722,19 +1722,17 @@ do_find (const char *start_dir, ssize_t start_dir_len, const char *ignore_dirs,
     if (return_value == B_PANELIZE && *filename)
     {
         int link_to_dir, stale_link;
-        int i;
+        int i, n;
         struct stat st;
-        GList *entry;
         dir_list *list = &current_panel->dir;
         char *name = NULL;
 
         dir_list_init (list);
 
-        for (i = 0, entry = listbox_get_first_link (find_list); entry != NULL;
-             i++, entry = g_list_next (entry))
+        for (i = 0, n = listbox_get_length (find_list); i < n; i++)
         {
             const char *lc_filename = NULL;
-            WLEntry *le = LENTRY (entry->data);
+            WLEntry *le = listbox_get_nth_item (find_list, i);
             char *p;
 
             if ((le->text == NULL) || (le->data == NULL))
@@ -1779,12 +1777,13 @@ do_find (const char *start_dir, ssize_t start_dir_len, const char *ignore_dirs,
             if (list->len == 0) /* first turn i.e clean old list */
                 panel_clean_dir (current_panel);
             list->list[list->len].fnamelen = strlen (p);
-            list->list[list->len].fname = g_strndup (p, list->list[list->len].fnamelen);
+            list->list[list->len].fname =
+                dir_list_strndup (list, p, list->list[list->len].fnamelen);
             list->list[list->len].f.marked = 0;
             list->list[list->len].f.link_to_dir = link_to_dir;
             list->list[list->len].f.stale_link = stale_link;
             list->list[list->len].f.dir_size_computed = 0;
-            list->list[list->len].st = st;
+            file_stat_from_stat (&list->list[list->len].st, &st);
             list->list[list->len].sort_key = NULL;
             list->list[list->len].second_sort_key = NULL;
             list->len++;
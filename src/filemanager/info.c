@@ -126,7 +126,7 @@ info_show_info (WInfo * info)
 
     my_statfs (&myfs_stats, vfs_path_as_str (current_panel->cwd_vpath));
 
-    st = current_panel->dir.list[current_panel->selected].st;
+    file_stat_to_stat (&current_panel->dir.list[current_panel->selected].st, &st);
 
     /* Print only lines which fit */
 
@@ -51,6 +51,7 @@
 #include "lib/tty/key.h"        /* KEY_M_* masks */
 #include "lib/skin.h"
 #include "lib/util.h"
+#include "lib/logging.h"        /* mc_log_startup_phase() */
 
 #include "lib/vfs/vfs.h"
 
@@ -79,6 +80,7 @@
 
 #ifdef USE_INTERNAL_EDIT
 #include "src/editor/edit.h"
+#include "src/editor/etags.h"   /* etags_free_index() */
 #endif
 
 #ifdef USE_DIFF_VIEW
@@ -749,7 +751,7 @@ put_link (WPanel * panel)
 {
     if (!command_prompt)
         return;
-    if (S_ISLNK (selection (panel)->st.st_mode))
+    if (S_ISLNK (selection (panel)->st.mode))
     {
         char buffer[MC_MAXPATHLEN];
         vfs_path_t *vpath;
@@ -955,6 +957,7 @@ create_panels_and_run_mc (void)
 
     add_widget (midnight_dlg, the_bar);
     midnight_set_buttonbar (the_bar);
+    mc_log_startup_phase ("panels");
 
     /* Run the Midnight Commander if no file was specified in the command line */
     dlg_run (midnight_dlg);
@@ -1431,6 +1434,9 @@ midnight_callback (Widget * w, Widget * sender, widget_msg_t msg, int parm, void
         /* We only need the first idle event to show user menu after start */
         widget_want_idle (w, FALSE);
 
+        mc_log_startup_phase ("first frame");
+        mc_log_startup_done ();
+
         if (boot_current_is_left)
             dlg_select_widget (get_panel_widget (0));
         else
@@ -1750,6 +1756,7 @@ do_nc (void)
 
         setup_mc ();
         mc_filehighlight = mc_fhl_new (TRUE);
+        mc_log_startup_phase ("filehighlight");
         create_panels_and_run_mc ();
         mc_fhl_free (&mc_filehighlight);
 
@@ -1774,6 +1781,7 @@ do_nc (void)
 
 #ifdef USE_INTERNAL_EDIT
     edit_stack_free ();
+    etags_free_index ();
 #endif
 
     if ((quit & SUBSHELL_EXIT) == 0)
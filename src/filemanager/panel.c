@@ -42,6 +42,7 @@
 #include "lib/tty/tty.h"
 #include "lib/tty/mouse.h"      /* For Gpm_Event */
 #include "lib/tty/key.h"        /* XCTRL and ALT macros  */
+#include "lib/tty/event.h"      /* tty_post_completion() */
 #include "lib/skin.h"
 #include "lib/strescape.h"
 #include "lib/mcconfig.h"
@@ -76,6 +77,7 @@
 #include "usermenu.h"
 #include "midnight.h"
 #include "mountlist.h"          /* my_statfs */
+#include "fileopctx.h"          /* file_op_is_running() */
 
 #include "panel.h"
 
@@ -320,6 +322,14 @@ extern int saving_setup;
 #define MARKED_SELECTED 3
 #define STATUS          5
 
+/* Time to wait for background reading of directory before panel is shown partially */
+#define PANEL_LOADER_WAIT_TIME (G_USEC_PER_SEC / 10)
+/* Interval of checks whether entries kept staged by busy panel can be shown */
+#define PANEL_LOADER_RETRY_TIME (G_USEC_PER_SEC / 5)
+/* Interval of reading of VFS directory by steps and time to read it in one step */
+#define PANEL_LOADER_STEP_INTERVAL (G_USEC_PER_SEC / 100)
+#define PANEL_LOADER_STEP_TIME (G_USEC_PER_SEC / 20)
+
 /* This macro extracts the number of available lines in a panel */
 #define llines(p) (WIDGET (p)->lines - 3 - (panels_options.show_mini_info ? 2 : 0))
 
@@ -409,9 +419,10 @@ static void
 add_permission_string (const char *dest, int width, file_entry_t * fe, int attr, int color,
                        int is_octal)
 {
+    tty_cell_t cells[BUF_TINY];
     int i, r, l;
 
-    l = get_user_permissions (&fe->st);
+    l = get_user_permissions (fe->st.uid, fe->st.gid);
 
     if (is_octal)
     {
@@ -426,21 +437,37 @@ add_permission_string (const char *dest, int width, file_entry_t * fe, int attr,
         r = l + 3;
     }
 
-    for (i = 0; i < width; i++)
+    for (i = 0; i < width && i < BUF_TINY; i++)
     {
-        if (i >= l && i < r)
-        {
-            if (attr == SELECTED || attr == MARKED_SELECTED)
-                tty_setcolor (MARKED_SELECTED_COLOR);
-            else
-                tty_setcolor (MARKED_COLOR);
-        }
-        else if (color >= 0)
+        cells[i].ch = (unsigned char) dest[i];
+
+        if (i < l || i >= r)
+            cells[i].color = color;
+        else if (attr == SELECTED || attr == MARKED_SELECTED)
+            cells[i].color = MARKED_SELECTED_COLOR;
+        else
+            cells[i].color = MARKED_COLOR;
+    }
+
+    tty_print_cells (cells, i);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Print fields collected by format_file(): they are shown by one call */
+
+static void
+format_file_flush (char *dest, size_t * len, int color)
+{
+    if (*len != 0)
+    {
+        if (color >= 0)
             tty_setcolor (color);
         else
             tty_lowlevel_setcolor (-color);
 
-        tty_print_char (dest[i]);
+        dest[*len] = '\0';
+        tty_print_string (dest);
+        *len = 0;
     }
 }
 
@@ -505,11 +532,11 @@ string_file_size (file_entry_t * fe, int len)
         return _("UP--DIR");
 
 #ifdef HAVE_STRUCT_STAT_ST_RDEV
-    if (S_ISBLK (fe->st.st_mode) || S_ISCHR (fe->st.st_mode))
-        format_device_number (buffer, len + 1, fe->st.st_rdev);
+    if (S_ISBLK (fe->st.mode) || S_ISCHR (fe->st.mode))
+        format_device_number (buffer, len + 1, fe->st.rdev);
     else
 #endif
-        size_trunc_len (buffer, (unsigned int) len, fe->st.st_size, 0, panels_options.kilobyte_si);
+        size_trunc_len (buffer, (unsigned int) len, fe->st.size, 0, panels_options.kilobyte_si);
 
     return buffer;
 }
@@ -520,10 +547,10 @@ string_file_size (file_entry_t * fe, int len)
 static const char *
 string_file_size_brief (file_entry_t * fe, int len)
 {
-    if (S_ISLNK (fe->st.st_mode) && !fe->f.link_to_dir)
+    if (S_ISLNK (fe->st.mode) && !fe->f.link_to_dir)
         return _("SYMLINK");
 
-    if ((S_ISDIR (fe->st.st_mode) || fe->f.link_to_dir) && !DIR_IS_DOTDOT (fe->fname))
+    if ((S_ISDIR (fe->st.mode) || fe->f.link_to_dir) && !DIR_IS_DOTDOT (fe->fname))
         return _("SUB-DIR");
 
     return string_file_size (fe, len);
@@ -539,9 +566,9 @@ string_file_type (file_entry_t * fe, int len)
 
     (void) len;
 
-    if (S_ISDIR (fe->st.st_mode))
+    if (S_ISDIR (fe->st.mode))
         buffer[0] = PATH_SEP;
-    else if (S_ISLNK (fe->st.st_mode))
+    else if (S_ISLNK (fe->st.mode))
     {
         if (fe->f.link_to_dir)
             buffer[0] = '~';
@@ -550,21 +577,21 @@ string_file_type (file_entry_t * fe, int len)
         else
             buffer[0] = '@';
     }
-    else if (S_ISCHR (fe->st.st_mode))
+    else if (S_ISCHR (fe->st.mode))
         buffer[0] = '-';
-    else if (S_ISSOCK (fe->st.st_mode))
+    else if (S_ISSOCK (fe->st.mode))
         buffer[0] = '=';
-    else if (S_ISDOOR (fe->st.st_mode))
+    else if (S_ISDOOR (fe->st.mode))
         buffer[0] = '>';
-    else if (S_ISBLK (fe->st.st_mode))
+    else if (S_ISBLK (fe->st.mode))
         buffer[0] = '+';
-    else if (S_ISFIFO (fe->st.st_mode))
+    else if (S_ISFIFO (fe->st.mode))
         buffer[0] = '|';
-    else if (S_ISNAM (fe->st.st_mode))
+    else if (S_ISNAM (fe->st.mode))
         buffer[0] = '#';
-    else if (!S_ISREG (fe->st.st_mode))
+    else if (!S_ISREG (fe->st.mode))
         buffer[0] = '?';        /* non-regular of unknown kind */
-    else if (is_exe (fe->st.st_mode))
+    else if (is_exe (fe->st.mode))
         buffer[0] = '*';
     else
         buffer[0] = ' ';
@@ -580,7 +607,7 @@ string_file_mtime (file_entry_t * fe, int len)
 {
     (void) len;
 
-    return file_date (fe->st.st_mtime);
+    return file_date (fe->st.mtime);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -591,7 +618,7 @@ string_file_atime (file_entry_t * fe, int len)
 {
     (void) len;
 
-    return file_date (fe->st.st_atime);
+    return file_date (fe->st.atime);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -602,7 +629,7 @@ string_file_ctime (file_entry_t * fe, int len)
 {
     (void) len;
 
-    return file_date (fe->st.st_ctime);
+    return file_date (fe->st.ctime);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -613,7 +640,7 @@ string_file_permission (file_entry_t * fe, int len)
 {
     (void) len;
 
-    return string_perm (fe->st.st_mode);
+    return string_perm (fe->st.mode);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -626,7 +653,7 @@ string_file_perm_octal (file_entry_t * fe, int len)
 
     (void) len;
 
-    g_snprintf (buffer, sizeof (buffer), "0%06lo", (unsigned long) fe->st.st_mode);
+    g_snprintf (buffer, sizeof (buffer), "0%06lo", (unsigned long) fe->st.mode);
     return buffer;
 }
 
@@ -640,7 +667,7 @@ string_file_nlinks (file_entry_t * fe, int len)
 
     (void) len;
 
-    g_snprintf (buffer, sizeof (buffer), "%16d", (int) fe->st.st_nlink);
+    g_snprintf (buffer, sizeof (buffer), "%16d", (int) fe->st.nlink);
     return buffer;
 }
 
@@ -654,7 +681,7 @@ string_inode (file_entry_t * fe, int len)
 
     (void) len;
 
-    g_snprintf (buffer, sizeof (buffer), "%lu", (unsigned long) fe->st.st_ino);
+    g_snprintf (buffer, sizeof (buffer), "%lu", (unsigned long) fe->st.ino);
     return buffer;
 }
 
@@ -668,7 +695,7 @@ string_file_nuid (file_entry_t * fe, int len)
 
     (void) len;
 
-    g_snprintf (buffer, sizeof (buffer), "%lu", (unsigned long) fe->st.st_uid);
+    g_snprintf (buffer, sizeof (buffer), "%lu", (unsigned long) fe->st.uid);
     return buffer;
 }
 
@@ -682,7 +709,7 @@ string_file_ngid (file_entry_t * fe, int len)
 
     (void) len;
 
-    g_snprintf (buffer, sizeof (buffer), "%lu", (unsigned long) fe->st.st_gid);
+    g_snprintf (buffer, sizeof (buffer), "%lu", (unsigned long) fe->st.gid);
     return buffer;
 }
 
@@ -694,7 +721,7 @@ string_file_owner (file_entry_t * fe, int len)
 {
     (void) len;
 
-    return get_owner (fe->st.st_uid);
+    return get_owner (fe->st.uid);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -705,7 +732,7 @@ string_file_group (file_entry_t * fe, int len)
 {
     (void) len;
 
-    return get_group (fe->st.st_gid);
+    return get_group (fe->st.gid);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -778,9 +805,7 @@ format_file (char *dest, int limit, WPanel * panel, int file_index, int width, i
     format_e *format, *home;
     file_entry_t *fe;
     filename_scroll_flag_t res = FILENAME_NOSCROLL;
-
-    (void) dest;
-    (void) limit;
+    size_t dest_len = 0;        /* fields of the same color are collected in dest */
 
     empty_line = (file_index >= panel->dir.len);
     home = isstatus ? panel->status_format : panel->format;
@@ -843,11 +868,6 @@ format_file (char *dest, int limit, WPanel * panel, int file_index, int width, i
                     perm = 2;
             }
 
-            if (color >= 0)
-                tty_setcolor (color);
-            else
-                tty_lowlevel_setcolor (-color);
-
             if (!isstatus && panel->content_shift > -1)
                 prepared_text =
                     str_fit_to_term (txt + name_offset, len, HIDE_FIT (format->just_mode));
@@ -855,14 +875,39 @@ format_file (char *dest, int limit, WPanel * panel, int file_index, int width, i
                 prepared_text = str_fit_to_term (txt, len, format->just_mode);
 
             if (perm)
+            {
+                format_file_flush (dest, &dest_len, color);
                 add_permission_string (prepared_text, format->field_len, fe, attr, color, perm - 1);
+            }
             else
-                tty_print_string (prepared_text);
+            {
+                size_t text_len;
+
+                text_len = strlen (prepared_text);
+                if (dest_len + text_len >= (size_t) limit)
+                    format_file_flush (dest, &dest_len, color);
+
+                if (text_len < (size_t) limit)
+                {
+                    memcpy (dest + dest_len, prepared_text, text_len);
+                    dest_len += text_len;
+                }
+                else
+                {
+                    if (color >= 0)
+                        tty_setcolor (color);
+                    else
+                        tty_lowlevel_setcolor (-color);
+                    tty_print_string (prepared_text);
+                }
+            }
 
             length += len;
         }
         else
         {
+            format_file_flush (dest, &dest_len, color);
+
             if (attr == SELECTED || attr == MARKED_SELECTED)
                 tty_setcolor (SELECTED_COLOR);
             else
@@ -872,6 +917,8 @@ format_file (char *dest, int limit, WPanel * panel, int file_index, int width, i
         }
     }
 
+    format_file_flush (dest, &dest_len, color);
+
     if (length < width)
     {
         int y, x;
@@ -992,7 +1039,7 @@ display_mini_info (WPanel * panel)
     /* Status resolves links and show them */
     set_colors (panel);
 
-    if (S_ISLNK (panel->dir.list[panel->selected].st.st_mode))
+    if (S_ISLNK (panel->dir.list[panel->selected].st.mode))
     {
         char link_target[MC_MAXPATHLEN];
         vfs_path_t *lc_link_vpath;
@@ -1302,12 +1349,12 @@ show_dir (WPanel * panel)
         if (panel->marked == 0)
         {
             /* Show size of curret file in the bottom of panel */
-            if (S_ISREG (panel->dir.list[panel->selected].st.st_mode))
+            if (S_ISREG (panel->dir.list[panel->selected].st.mode))
             {
                 char buffer[BUF_SMALL];
 
                 g_snprintf (buffer, sizeof (buffer), " %s ",
-                            size_trunc_sep (panel->dir.list[panel->selected].st.st_size,
+                            size_trunc_sep (panel->dir.list[panel->selected].st.size,
                                             panels_options.kilobyte_si));
                 tty_setcolor (NORMAL_COLOR);
                 widget_move (w, w->lines - 1, 4);
@@ -1976,7 +2023,7 @@ maybe_cd (gboolean move_up_dir)
             return MSG_HANDLED;
         }
 
-        if (S_ISDIR (selection (current_panel)->st.st_mode)
+        if (S_ISDIR (selection (current_panel)->st.mode)
             || link_isdir (selection (current_panel)))
         {
             vfs_path_t *vpath;
@@ -2232,7 +2279,7 @@ next_page (WPanel * panel)
 static void
 goto_child_dir (WPanel * panel)
 {
-    if ((S_ISDIR (selection (panel)->st.st_mode) || link_isdir (selection (panel))))
+    if ((S_ISDIR (selection (panel)->st.mode) || link_isdir (selection (panel))))
     {
         vfs_path_t *vpath;
 
@@ -2422,7 +2469,9 @@ panel_select_unselect_files (WPanel * panel, const char *title, const char *hist
 
     char *reg_exp;
     mc_search_t *search;
-    int i;
+    mc_search_flags_t search_flags;
+    guint8 *matched;
+    int i, found;
 
     quick_widget_t quick_widgets[] = {
         /* *INDENT-OFF* */
@@ -2453,23 +2502,28 @@ panel_select_unselect_files (WPanel * panel, const char *title, const char *hist
         return;
     }
 
-    search = mc_search_new (reg_exp, -1, NULL);
-    search->search_type = (shell_patterns != 0) ? MC_SEARCH_T_GLOB : MC_SEARCH_T_REGEX;
-    search->is_entire_line = TRUE;
-    search->is_case_sensitive = case_sens != 0;
+    search_flags = MC_SEARCH_F_ENTIRE_LINE;
+    if (case_sens != 0)
+        search_flags |= MC_SEARCH_F_CASE_SENSITIVE;
 
-    for (i = 0; i < panel->dir.len; i++)
+    search = mc_search_cache_get (reg_exp, NULL,
+                                  (shell_patterns != 0) ? MC_SEARCH_T_GLOB : MC_SEARCH_T_REGEX,
+                                  search_flags);
+
+    /* match all names at once, then mark */
+    matched = dir_list_match (&panel->dir, search, files_only != 0, &found);
+    if (matched != NULL)
     {
-        if (DIR_IS_DOTDOT (panel->dir.list[i].fname))
-            continue;
-        if (S_ISDIR (panel->dir.list[i].st.st_mode) && files_only != 0)
-            continue;
+        for (i = 0; found != 0 && i < panel->dir.len; i++)
+            if (MC_SEARCH_BITMAP_TEST (matched, i))
+            {
+                do_file_mark (panel, i, do_select);
+                found--;
+            }
 
-        if (mc_search_run (search, panel->dir.list[i].fname, 0, panel->dir.list[i].fnamelen, NULL))
-            do_file_mark (panel, i, do_select);
+        g_free (matched);
     }
 
-    mc_search_free (search);
     g_free (reg_exp);
 
     /* result flags */
@@ -2509,7 +2563,7 @@ panel_select_invert_files (WPanel * panel)
     {
         file_entry_t *file = &panel->dir.list[i];
 
-        if (!panels_options.reverse_files_only || !S_ISDIR (file->st.st_mode))
+        if (!panels_options.reverse_files_only || !S_ISDIR (file->st.mode))
             do_file_mark (panel, i, !file->f.marked);
     }
 }
@@ -2528,6 +2582,7 @@ do_search (WPanel * panel, int c_code)
     gboolean wrapped = FALSE;
     char *act;
     mc_search_t *search;
+    mc_search_flags_t search_flags;
     char *reg_exp, *esc_str;
     gboolean is_found = FALSE;
 
@@ -2573,23 +2628,24 @@ do_search (WPanel * panel, int c_code)
 
     reg_exp = g_strdup_printf ("%s*", panel->search_buffer);
     esc_str = strutils_escape (reg_exp, -1, ",|\\{}[]", TRUE);
-    search = mc_search_new (esc_str, -1, NULL);
-    search->search_type = MC_SEARCH_T_GLOB;
-    search->is_entire_line = TRUE;
+    search_flags = MC_SEARCH_F_ENTIRE_LINE;
 
     switch (panels_options.qsearch_mode)
     {
     case QSEARCH_CASE_SENSITIVE:
-        search->is_case_sensitive = TRUE;
+        search_flags |= MC_SEARCH_F_CASE_SENSITIVE;
         break;
     case QSEARCH_CASE_INSENSITIVE:
-        search->is_case_sensitive = FALSE;
         break;
     default:
-        search->is_case_sensitive = panel->sort_info.case_sensitive;
+        if (panel->sort_info.case_sensitive)
+            search_flags |= MC_SEARCH_F_CASE_SENSITIVE;
         break;
     }
 
+    /* pattern is compiled once for all repeated searches of the same text */
+    search = mc_search_cache_get (esc_str, NULL, MC_SEARCH_T_GLOB, search_flags);
+
     sel = panel->selected;
 
     for (i = panel->selected; !wrapped || i != panel->selected; i++)
@@ -2621,7 +2677,6 @@ do_search (WPanel * panel, int c_code)
         str_prev_noncomb_char (&act, panel->search_buffer);
         act[0] = '\0';
     }
-    mc_search_free (search);
     g_free (reg_exp);
     g_free (esc_str);
 }
@@ -2689,7 +2744,7 @@ do_enter_on_file_entry (file_entry_t * fe)
      * Directory or link to directory - change directory.
      * Try the same for the entries on which mc_lstat() has failed.
      */
-    if (S_ISDIR (fe->st.st_mode) || link_isdir (fe) || (fe->st.st_mode == 0))
+    if (S_ISDIR (fe->st.mode) || link_isdir (fe) || (fe->st.mode == 0))
     {
         vfs_path_t *fname_vpath;
 
@@ -2711,7 +2766,7 @@ do_enter_on_file_entry (file_entry_t * fe)
 
     /* Check if the file is executable */
     full_name_vpath = vfs_path_append_new (current_panel->cwd_vpath, fe->fname, NULL);
-    ok = (is_exe (fe->st.st_mode) && if_link_is_exe (full_name_vpath, fe));
+    ok = (is_exe (fe->st.mode) && if_link_is_exe (full_name_vpath, fe));
     vfs_path_free (full_name_vpath);
     if (!ok)
         return FALSE;
@@ -2773,7 +2828,7 @@ chdir_other_panel (WPanel * panel)
     if (get_other_type () != view_listing)
         set_display_type (get_other_index (), view_listing);
 
-    if (S_ISDIR (entry->st.st_mode) || entry->f.link_to_dir)
+    if (S_ISDIR (entry->st.mode) || entry->f.link_to_dir)
         new_dir_vpath = vfs_path_append_new (panel->cwd_vpath, entry->fname, NULL);
     else
     {
@@ -2828,7 +2883,7 @@ chdir_to_readlink (WPanel * panel)
     if (get_other_type () != view_listing)
         return;
 
-    if (!S_ISLNK (panel->dir.list[panel->selected].st.st_mode))
+    if (!S_ISLNK (panel->dir.list[panel->selected].st.mode))
         return;
 
     i = readlink (selection (panel)->fname, buffer, MC_MAXPATHLEN - 1);
@@ -3155,6 +3210,252 @@ subshell_chdir (const vfs_path_t * vpath)
 #endif /* ENABLE_SUBSHELL */
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Take entries read by background loader.
+ *
+ * @return TRUE if the whole directory is read
+ */
+
+static gboolean
+panel_loader_take (WPanel * panel, gboolean show_error)
+{
+    gboolean finished;
+    int sorted, error;
+
+    sorted = panel->dir.len;
+    finished = dir_list_loader_take (panel->loader, &panel->dir, panel->filter, &error);
+
+    /* reloaded entries keep their marks */
+    if (panel->loader_marks != NULL)
+    {
+        int i;
+
+        for (i = sorted; i < panel->dir.len; i++)
+            if (g_hash_table_lookup (panel->loader_marks, panel->dir.list[i].fname) != NULL)
+                panel->dir.list[i].f.marked = 1;
+    }
+
+    /* list is kept sorted, only the new entries are sorted and merged into it */
+    dir_list_sort_merge (&panel->dir, sorted, panel->sort_field->sort_routine,
+                         &panel->sort_info);
+
+    if (finished)
+    {
+        /* completion can be posted already, don't let it touch the panel */
+        panel_cancel_loading (panel);
+
+        if (error != 0 && show_error)
+            message (D_ERROR, MSG_ERROR, _("Cannot read directory contents"));
+    }
+
+    return finished;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Check whether entries read by background loader can be added to the panel now.
+ * File operations and dialogs over the panel keep indexes of dir.list and pointers to
+ * its entries, so the list mustn't be reallocated or re-sorted under them.
+ */
+
+static gboolean
+panel_loader_can_merge (const WPanel * panel)
+{
+    return (top_dlg != NULL && DIALOG (top_dlg->data) == WIDGET (panel)->owner
+            && !file_op_is_running ());
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Show entries read by background loader */
+
+static void
+panel_loader_merge (WPanel * panel)
+{
+    char *current_file = NULL;
+    char *select_name;
+
+    /* keep the file selected by user, otherwise look for the pending one */
+    if (panel->selected > 0)
+        current_file = g_strdup (selection (panel)->fname);
+    select_name = panel->loader_select;
+    panel->loader_select = NULL;
+
+    if (!panel_loader_take (panel, FALSE))
+        panel->loader_select = g_strdup (select_name);
+
+    try_to_select (panel, current_file != NULL ? current_file : select_name);
+    g_free (current_file);
+    g_free (select_name);
+
+    recalculate_panel_summary (panel);
+    panel->dirty = 1;
+
+    widget_redraw (WIDGET (panel));
+    mc_refresh ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Merge entries kept staged while the panel was busy, called by idle timer */
+
+static void
+panel_loader_retry (void *data)
+{
+    WPanel *panel = PANEL (data);
+
+    if (panel_loader_can_merge (panel))
+    {
+        tty_delete_idle_timer (panel->loader_timer);
+        panel->loader_timer = 0;
+        panel_loader_merge (panel);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Called in the main thread when background loader has new entries */
+
+static void
+panel_loader_complete (void *data)
+{
+    dir_list_loader_t *loader = (dir_list_loader_t *) data;
+
+    if (!dir_list_loader_is_cancelled (loader))
+    {
+        WPanel *panel;
+
+        panel = PANEL (dir_list_loader_get_data (loader));
+
+        if (panel_loader_can_merge (panel))
+            panel_loader_merge (panel);
+        else if (panel->loader_timer == 0)
+            /* entries stay staged in loader until the panel is free */
+            panel->loader_timer =
+                tty_add_idle_timer (PANEL_LOADER_RETRY_TIME, panel_loader_retry, panel);
+    }
+
+    dir_list_loader_unref (loader);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Read the next entries of VFS directory, called by idle timer */
+
+static void
+panel_loader_step (void *data)
+{
+    WPanel *panel = PANEL (data);
+
+    /* VFS isn't reentrant: don't read while file operation or dialog uses it */
+    if (panel_loader_can_merge (panel))
+    {
+        dir_list_loader_step (panel->loader, PANEL_LOADER_STEP_TIME);
+        panel_loader_merge (panel);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Called in the loader thread */
+
+static void
+panel_loader_notify (dir_list_loader_t * loader, void *data)
+{
+    (void) data;
+
+    tty_post_completion (panel_loader_complete, dir_list_loader_ref (loader));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Read directory by loader into the cleaned list of the panel.
+ *
+ * @param select_name file to select, it can be read later
+ * @param marks names of entries to mark, owned by panel until directory is read
+ */
+
+static void
+panel_loader_start (WPanel * panel, dir_list_loader_t * loader, const char *select_name,
+                    GHashTable * marks)
+{
+    panel->loader = loader;
+    panel->loader_marks = marks;
+
+    if (!dir_list_loader_init_list (panel->loader, &panel->dir))
+    {
+        panel_cancel_loading (panel);
+        dir_list_load (&panel->dir, panel->cwd_vpath, panel->sort_field->sort_routine,
+                       &panel->sort_info, panel->filter);
+    }
+    else
+    {
+        rotate_dash (TRUE);
+        dir_list_loader_wait (panel->loader, PANEL_LOADER_WAIT_TIME);
+        rotate_dash (FALSE);
+
+        if (!panel_loader_take (panel, TRUE))
+        {
+            panel->loader_select = g_strdup (select_name);
+
+            if (!dir_list_loader_in_background (panel->loader))
+                panel->loader_timer =
+                    tty_add_idle_timer (PANEL_LOADER_STEP_INTERVAL, panel_loader_step, panel);
+        }
+    }
+
+    try_to_select (panel, select_name);
+    recalculate_panel_summary (panel);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Load contents of the current directory of the panel.
+ *
+ * Directory is read partially if it takes long time. Panel stays navigable and shows
+ * the entries read so far, the rest of them are added by panel_loader_complete() or
+ * panel_loader_step().
+ */
+
+static void
+panel_load_dir (WPanel * panel, const char *select_name)
+{
+    dir_list_loader_t *loader;
+
+    loader = dir_list_loader_new (panel->cwd_vpath, panel_loader_notify, panel);
+
+    if (loader != NULL)
+        panel_loader_start (panel, loader, select_name, NULL);
+    else
+    {
+        dir_list_load (&panel->dir, panel->cwd_vpath, panel->sort_field->sort_routine,
+                       &panel->sort_info, panel->filter);
+        try_to_select (panel, select_name);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Names of marked entries of the panel or NULL if there are none */
+
+static GHashTable *
+panel_get_marked_names (const WPanel * panel)
+{
+    GHashTable *marks;
+    int i;
+
+    if (panel->marked == 0)
+        return NULL;
+
+    marks = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+    for (i = 0; i < panel->dir.len; i++)
+        if (panel->dir.list[i].f.marked != 0)
+        {
+            char *name;
+
+            name = g_strdup (panel->dir.list[i].fname);
+            g_hash_table_insert (marks, name, name);
+        }
+
+    return marks;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /**
  * Changes the current directory of the panel.
@@ -3195,9 +3496,7 @@ _do_panel_cd (WPanel * panel, const vfs_path_t * new_dir_vpath, enum cd_enum cd_
     /* Reload current panel */
     panel_clean_dir (panel);
 
-    dir_list_load (&panel->dir, panel->cwd_vpath, panel->sort_field->sort_routine,
-                   &panel->sort_info, panel->filter);
-    try_to_select (panel, get_parent_dir_name (panel->cwd_vpath, olddir_vpath));
+    panel_load_dir (panel, get_parent_dir_name (panel->cwd_vpath, olddir_vpath));
 
     load_hint (0);
     panel->dirty = 1;
@@ -3848,6 +4147,7 @@ reload_panelized (WPanel * panel)
     for (i = 0, j = 0; i < panel->dir.len; i++)
     {
         vfs_path_t *vpath;
+        struct stat st;
 
         if (list->list[i].f.marked)
         {
@@ -3860,10 +4160,10 @@ reload_panelized (WPanel * panel)
             do_file_mark (panel, i, 0);
         }
         vpath = vfs_path_from_str (list->list[i].fname);
-        if (mc_lstat (vpath, &list->list[i].st) != 0)
-            g_free (list->list[i].fname);
-        else
+        /* names of removed entries are kept in storage until list is cleaned */
+        if (mc_lstat (vpath, &st) == 0)
         {
+            file_stat_from_stat (&list->list[i].st, &st);
             if (list->list[i].f.marked)
                 do_file_mark (panel, i, 1);
             if (j != i)
@@ -4107,9 +4407,39 @@ panel_clean_dir (WPanel * panel)
     panel->content_shift = -1;
     panel->max_shift = -1;
 
+    panel_cancel_loading (panel);
     dir_list_clean (&panel->dir);
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/** Stop background reading of directory: panel keeps the entries taken so far */
+
+void
+panel_cancel_loading (WPanel * panel)
+{
+    if (panel->loader != NULL)
+    {
+        dir_list_loader_cancel (panel->loader);
+        dir_list_loader_unref (panel->loader);
+        panel->loader = NULL;
+    }
+
+    if (panel->loader_timer != 0)
+    {
+        tty_delete_idle_timer (panel->loader_timer);
+        panel->loader_timer = 0;
+    }
+
+    g_free (panel->loader_select);
+    panel->loader_select = NULL;
+
+    if (panel->loader_marks != NULL)
+    {
+        g_hash_table_destroy (panel->loader_marks);
+        panel->loader_marks = NULL;
+    }
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /**
  * Set Up panel's current dir object
@@ -4282,6 +4612,7 @@ panel_reload (WPanel * panel)
 {
     struct stat current_stat;
     vfs_path_t *cwd_vpath;
+    dir_list_loader_t *loader;
 
     if (panels_options.fast_reload && stat (vfs_path_as_str (panel->cwd_vpath), &current_stat) == 0
         && current_stat.st_ctime == panel->dir_stat.st_ctime
@@ -4303,14 +4634,40 @@ panel_reload (WPanel * panel)
     memset (&(panel->dir_stat), 0, sizeof (panel->dir_stat));
     show_dir (panel);
 
-    dir_list_reload (&panel->dir, panel->cwd_vpath, panel->sort_field->sort_routine,
-                     &panel->sort_info, panel->filter);
+    /* partially read directory is read again from the beginning */
+    panel_cancel_loading (panel);
 
-    panel->dirty = 1;
-    if (panel->selected >= panel->dir.len)
-        do_select (panel, panel->dir.len - 1);
+    loader = dir_list_loader_new (panel->cwd_vpath, panel_loader_notify, panel);
 
-    recalculate_panel_summary (panel);
+    if (loader != NULL)
+    {
+        char *current_file = NULL;
+        GHashTable *marks;
+
+        /* current entry and marks are kept by name while entries are being read */
+        if (panel->selected < panel->dir.len)
+            current_file = g_strdup (selection (panel)->fname);
+        marks = panel_get_marked_names (panel);
+
+        dir_list_clean (&panel->dir);
+        panel->top_file = 0;
+        panel->selected = 0;
+
+        panel_loader_start (panel, loader, current_file, marks);
+        g_free (current_file);
+    }
+    else
+    {
+        dir_list_reload (&panel->dir, panel->cwd_vpath, panel->sort_field->sort_routine,
+                         &panel->sort_info, panel->filter);
+
+        if (panel->selected >= panel->dir.len)
+            do_select (panel, panel->dir.len - 1);
+
+        recalculate_panel_summary (panel);
+    }
+
+    panel->dirty = 1;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -4496,27 +4853,27 @@ do_file_mark (WPanel * panel, int idx, int mark)
     {
         panel->marked++;
 
-        if (S_ISDIR (panel->dir.list[idx].st.st_mode))
+        if (S_ISDIR (panel->dir.list[idx].st.mode))
         {
             if (panel->dir.list[idx].f.dir_size_computed)
-                panel->total += (uintmax_t) panel->dir.list[idx].st.st_size;
+                panel->total += (uintmax_t) panel->dir.list[idx].st.size;
             panel->dirs_marked++;
         }
         else
-            panel->total += (uintmax_t) panel->dir.list[idx].st.st_size;
+            panel->total += (uintmax_t) panel->dir.list[idx].st.size;
 
         set_colors (panel);
     }
     else
     {
-        if (S_ISDIR (panel->dir.list[idx].st.st_mode))
+        if (S_ISDIR (panel->dir.list[idx].st.mode))
         {
             if (panel->dir.list[idx].f.dir_size_computed)
-                panel->total -= (uintmax_t) panel->dir.list[idx].st.st_size;
+                panel->total -= (uintmax_t) panel->dir.list[idx].st.size;
             panel->dirs_marked--;
         }
         else
-            panel->total -= (uintmax_t) panel->dir.list[idx].st.st_size;
+            panel->total -= (uintmax_t) panel->dir.list[idx].st.size;
 
         panel->marked--;
     }
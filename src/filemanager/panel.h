@@ -92,6 +92,10 @@ typedef struct
 {
     Widget widget;
     dir_list dir;               /* Directory contents */
+    dir_list_loader_t *loader;  /* Background reader of directory contents, if any */
+    char *loader_select;        /* File to select when directory is read */
+    GHashTable *loader_marks;   /* Names of entries marked before reload */
+    guint loader_timer;         /* Timer to show staged entries or read VFS by steps */
 
     int list_type;              /* listing type (was view_type) */
     int active;                 /* If panel is currently selected */
@@ -155,6 +159,7 @@ extern mc_fhl_t *mc_filehighlight;
 
 WPanel *panel_new_with_dir (const char *panel_name, const vfs_path_t * vpath);
 void panel_clean_dir (WPanel * panel);
+void panel_cancel_loading (WPanel * panel);
 
 void panel_reload (WPanel * panel);
 void panel_set_sort_order (WPanel * panel, const panel_field_t * sort_order);
@@ -31,15 +31,21 @@
 #include <config.h>
 
 #include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
+#include <signal.h>
 #include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
 #include "lib/global.h"
 
 #include "lib/skin.h"
+#include "lib/tty/tty.h"        /* mc_refresh() */
+#include "lib/tty/key.h"        /* add_select_channel() */
+#include "lib/tty/event.h"      /* tty_post_completion() */
 #include "lib/vfs/vfs.h"
 #include "lib/mcconfig.h"       /* Load/save directories panelize */
 #include "lib/strutil.h"
@@ -53,6 +59,7 @@
 #include "midnight.h"           /* current_panel */
 #include "layout.h"             /* rotate_dash() */
 #include "panel.h"              /* WPanel */
+#include "treestore.h"          /* tree_store_mark_checked() */
 
 #include "panelize.h"
 
@@ -67,8 +74,54 @@
 #define B_ADD    B_USER
 #define B_REMOVE (B_USER + 1)
 
+#ifdef HAVE_GLIB_THREADS
+#define PANELIZE_THREADED 1
+#endif
+
+/* size of command output chunk read at once */
+#define PANELIZE_READ_SIZE 65536
+
+/* interval between panel redraws while the command runs, in microseconds */
+#define PANELIZE_UPDATE_INTERVAL (G_USEC_PER_SEC / 10)
+
 /*** file scope type declarations ****************************************************************/
 
+/* Name read from the command output and its stat info */
+typedef struct
+{
+    char *name;
+    struct stat st;
+    int link_to_dir;
+    int stale_link;
+    gboolean found;             /* FALSE if lstat() failed: entry is skipped */
+} panelize_entry_t;
+
+/* State of running external panelize command */
+typedef struct
+{
+    pid_t pid;
+    int fd;                     /* command output */
+    GString *line;              /* incomplete last line of the output */
+    gboolean eof;
+    gboolean cancelled;
+    gboolean finished;          /* dialog is stopped */
+
+    WDialog *dlg;
+    WLabel *count_label;
+    gint64 last_update;
+
+#ifdef PANELIZE_THREADED
+    /* names are resolved in batches (GArray of panelize_entry_t) by the worker thread */
+    GThread *worker;
+    const char *root;           /* local directory relative names are resolved against */
+    GAsyncQueue *todo;
+    GAsyncQueue *done;
+    int outstanding;            /* batches passed to the worker and not returned yet */
+    int wake[2];                /* the worker writes to this pipe after each batch */
+    volatile gint cancel;
+#endif
+} panelize_stream_t;
+
 /*** file scope variables ************************************************************************/
 
 static WListbox *l_panelize;
@@ -302,63 +355,519 @@ remove_from_panelize (struct panelize *entry)
 
 /* --------------------------------------------------------------------------------------------- */
 
+#ifdef PANELIZE_THREADED
+/**
+ * Resolve names of one batch like handle_path() does, without VFS calls.
+ * Called from the worker thread, so directories aren't marked in the tree store here.
+ */
+
 static void
-do_external_panelize (char *command)
+panelize_resolve_local (panelize_stream_t * s, GArray * batch)
 {
-    int link_to_dir, stale_link;
-    struct stat st;
-    dir_list *list = &current_panel->dir;
-    char line[MC_MAXPATHLEN];
-    char *name;
-    FILE *external;
+    guint i;
 
-    open_error_pipe ();
-    external = popen (command, "r");
-    if (!external)
+    for (i = 0; i < batch->len; i++)
     {
-        close_error_pipe (D_ERROR, _("Cannot invoke command."));
-        return;
+        panelize_entry_t *e = &g_array_index (batch, panelize_entry_t, i);
+        char *path;
+
+        if (g_atomic_int_get (&s->cancel) != 0)
+            break;
+
+        if (g_path_is_absolute (e->name))
+            path = e->name;
+        else
+            path = g_build_filename (s->root, e->name, (char *) NULL);
+
+        e->found = lstat (path, &e->st) == 0;
+        if (e->found && S_ISLNK (e->st.st_mode))
+        {
+            struct stat st2;
+
+            if (stat (path, &st2) == 0)
+                e->link_to_dir = S_ISDIR (st2.st_mode) ? 1 : 0;
+            else
+                e->stale_link = 1;
+        }
+
+        if (path != e->name)
+            g_free (path);
     }
-    /* Clear the counters and the directory list */
-    panel_clean_dir (current_panel);
+}
 
-    panelize_change_root (current_panel->cwd_vpath);
+/* --------------------------------------------------------------------------------------------- */
 
-    dir_list_init (list);
+static gpointer
+panelize_worker (gpointer data)
+{
+    panelize_stream_t *s = (panelize_stream_t *) data;
 
     while (TRUE)
     {
-        clearerr (external);
-        if (fgets (line, MC_MAXPATHLEN, external) == NULL)
+        GArray *batch;
+
+        batch = (GArray *) g_async_queue_pop (s->todo);
+        /* empty batch is a request to quit */
+        if (batch->len == 0)
         {
-            if (ferror (external) && errno == EINTR)
-                continue;
-            else
-                break;
+            g_array_free (batch, TRUE);
+            break;
         }
-        if (line[strlen (line) - 1] == '\n')
-            line[strlen (line) - 1] = 0;
-        if (strlen (line) < 1)
-            continue;
-        if (line[0] == '.' && line[1] == PATH_SEP)
-            name = line + 2;
-        else
-            name = line;
 
-        if (!handle_path (name, &st, &link_to_dir, &stale_link))
+        panelize_resolve_local (s, batch);
+        g_async_queue_push (s->done, batch);
+
+        /* wake up UI thread, see panelize_stream_resolved() */
+        while (write (s->wake[1], "", 1) == -1 && errno == EINTR)
+            ;
+    }
+
+    return NULL;
+}
+#endif /* PANELIZE_THREADED */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+panelize_batch_free (GArray * batch)
+{
+    guint i;
+
+    for (i = 0; i < batch->len; i++)
+        g_free (g_array_index (batch, panelize_entry_t, i).name);
+
+    g_array_free (batch, TRUE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+panelize_stream_redraw (panelize_stream_t * s, gboolean force)
+{
+    gint64 now;
+
+    label_set_textv (s->count_label, _("Found: %d"), current_panel->dir.len - 1);
+
+    now = g_get_monotonic_time ();
+    if (!force && now - s->last_update < PANELIZE_UPDATE_INTERVAL)
+        return;
+
+    s->last_update = now;
+    rotate_dash (TRUE);
+    send_message (current_panel, NULL, MSG_DRAW, 0, NULL);
+    dlg_redraw (s->dlg);
+    mc_refresh ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Append resolved entries of batch to the panel. The list stays unsorted. */
+
+static void
+panelize_stream_add (panelize_stream_t * s, GArray * batch, gboolean mark_dirs)
+{
+    dir_list *list = &current_panel->dir;
+    guint i;
+
+    for (i = 0; i < batch->len && !s->cancelled; i++)
+    {
+        panelize_entry_t *e = &g_array_index (batch, panelize_entry_t, i);
+
+        if (!e->found)
             continue;
 
-        if (!dir_list_append (list, name, &st, link_to_dir != 0, stale_link != 0))
+        if (mark_dirs && S_ISDIR (e->st.st_mode))
+            tree_store_mark_checked (e->name);
+
+        if (!dir_list_append (list, e->name, &e->st, e->link_to_dir != 0, e->stale_link != 0))
+        {
+            /* out of memory: keep what we have */
+            s->cancelled = TRUE;
             break;
+        }
 
         file_mark (current_panel, list->len - 1, 0);
+    }
+
+    panelize_batch_free (batch);
+    panelize_stream_redraw (s, FALSE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Pass names read from the command output to the worker, or resolve them here. */
+
+static void
+panelize_stream_dispatch (panelize_stream_t * s, GArray * batch)
+{
+    guint i;
+
+    if (batch->len == 0)
+    {
+        g_array_free (batch, TRUE);
+        return;
+    }
+
+#ifdef PANELIZE_THREADED
+    if (s->worker != NULL)
+    {
+        g_async_queue_push (s->todo, batch);
+        s->outstanding++;
+        return;
+    }
+#endif
+
+    for (i = 0; i < batch->len; i++)
+    {
+        panelize_entry_t *e = &g_array_index (batch, panelize_entry_t, i);
 
-        if ((list->len & 31) == 0)
-            rotate_dash (TRUE);
+        e->found = handle_path (e->name, &e->st, &e->link_to_dir, &e->stale_link);
     }
 
+    panelize_stream_add (s, batch, FALSE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+panelize_stream_line (GArray * batch, const char *line)
+{
+    panelize_entry_t e;
+
+    if (line[0] == '\0')
+        return;
+    if (line[0] == '.' && line[1] == PATH_SEP)
+        line += 2;
+    if (DIR_IS_DOT (line) || DIR_IS_DOTDOT (line))
+        return;
+
+    memset (&e, 0, sizeof (e));
+    e.name = g_strdup (line);
+    g_array_append_val (batch, e);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Read available output of the command and split it to lines. */
+
+static void
+panelize_stream_read (panelize_stream_t * s)
+{
+    char buf[PANELIZE_READ_SIZE];
+    ssize_t n;
+    GArray *batch;
+    char *line, *nl;
+
+    n = read (s->fd, buf, sizeof (buf));
+    if (n < 0 && (errno == EINTR || errno == EAGAIN))
+        return;
+
+    batch = g_array_new (FALSE, FALSE, sizeof (panelize_entry_t));
+
+    if (n > 0)
+    {
+        g_string_append_len (s->line, buf, n);
+
+        for (line = s->line->str; (nl = strchr (line, '\n')) != NULL; line = nl + 1)
+        {
+            *nl = '\0';
+            panelize_stream_line (batch, line);
+        }
+
+        g_string_erase (s->line, 0, line - s->line->str);
+    }
+    else
+    {
+        /* end of output: last line may be not terminated */
+        panelize_stream_line (batch, s->line->str);
+        g_string_truncate (s->line, 0);
+        s->eof = TRUE;
+    }
+
+    panelize_stream_dispatch (s, batch);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Wake up the event loop of the dialog stopped from the channel callback */
+
+static void
+panelize_stream_wakeup (void *data)
+{
+    (void) data;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Stop the dialog when all output is read and resolved or the command is cancelled */
+
+static void
+panelize_stream_check (panelize_stream_t * s)
+{
+    if (s->finished)
+        return;
+
+#ifdef PANELIZE_THREADED
+    if (s->eof && s->outstanding == 0)
+#else
+    if (s->eof)
+#endif
+        s->dlg->ret_value = B_ENTER;
+    else if (s->cancelled)
+        s->dlg->ret_value = B_CANCEL;
+    else
+        return;
+
+    s->finished = TRUE;
+    dlg_stop (s->dlg);
+    /* channel callbacks don't end tty_get_event(), completions do */
+    tty_post_completion (panelize_stream_wakeup, NULL);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Called by the event loop when the command output is ready to be read */
+
+static int
+panelize_stream_output (int fd, void *info)
+{
+    panelize_stream_t *s = (panelize_stream_t *) info;
+
+    panelize_stream_read (s);
+    if (s->eof)
+        delete_select_channel (fd);
+
+    panelize_stream_check (s);
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef PANELIZE_THREADED
+/** Called by the event loop when the worker has resolved batches */
+
+static int
+panelize_stream_resolved (int fd, void *info)
+{
+    panelize_stream_t *s = (panelize_stream_t *) info;
+    char tmp[64];
+    GArray *batch;
+
+    while (read (fd, tmp, sizeof (tmp)) == -1 && errno == EINTR)
+        ;
+
+    while (!s->cancelled && (batch = g_async_queue_try_pop (s->done)) != NULL)
+    {
+        s->outstanding--;
+        panelize_stream_add (s, batch, TRUE);
+    }
+
+    panelize_stream_check (s);
+    return 0;
+}
+#endif /* PANELIZE_THREADED */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+panelize_stream_sort (WButton * button, int action)
+{
+    (void) action;
+
+    panel_re_sort (current_panel);
+    panelize_stream_redraw ((panelize_stream_t *) WIDGET (button)->owner->data, TRUE);
+
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+panelize_stream_init_dlg (panelize_stream_t * s)
+{
+    const char *sort_name = N_("S&ort");
+    const char *stop_name = N_("&Stop");
+    int b1_width, b2_width, cols, x;
+
+#ifdef ENABLE_NLS
+    sort_name = _(sort_name);
+    stop_name = _(stop_name);
+#endif
+
+    b1_width = str_term_width1 (sort_name) + 3;
+    b2_width = str_term_width1 (stop_name) + 3;
+    cols = max (40, b1_width + b2_width + 7);
+
+    s->dlg =
+        dlg_create (TRUE, 0, 0, 7, cols, dialog_colors, NULL, NULL,
+                    "[External panelize]", _("External panelize"), DLG_CENTER);
+    s->dlg->data = s;
+
+    s->count_label = label_new (2, 3, "");
+    add_widget (s->dlg, s->count_label);
+    add_widget (s->dlg, hline_new (3, -1, -1));
+
+    x = (cols - b1_width - b2_width - 1) / 2;
+    add_widget (s->dlg, button_new (4, x, B_USER, NORMAL_BUTTON, sort_name, panelize_stream_sort));
+    add_widget (s->dlg, button_new (4, x + b1_width + 1, B_CANCEL, NORMAL_BUTTON, stop_name, NULL));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Start the command with its output redirected to a pipe.
+ *
+ * @return FALSE if the command cannot be started
+ */
+
+static gboolean
+panelize_stream_open (panelize_stream_t * s, const char *command)
+{
+    int fds[2];
+
+    if (pipe (fds) != 0)
+        return FALSE;
+
+    s->pid = fork ();
+    if (s->pid < 0)
+    {
+        close (fds[0]);
+        close (fds[1]);
+        return FALSE;
+    }
+
+    if (s->pid == 0)
+    {
+        int null_fd;
+
+        /* own process group: the command is stopped with all its children */
+        setpgid (0, 0);
+
+        /* the command isn't in foreground and must not read the terminal */
+        null_fd = open ("/dev/null", O_RDONLY);
+        if (null_fd != -1 && null_fd != STDIN_FILENO)
+        {
+            dup2 (null_fd, STDIN_FILENO);
+            close (null_fd);
+        }
+
+        close (fds[0]);
+        if (fds[1] != STDOUT_FILENO)
+        {
+            dup2 (fds[1], STDOUT_FILENO);
+            close (fds[1]);
+        }
+        execl ("/bin/sh", "sh", "-c", command, (char *) NULL);
+        _exit (127);
+    }
+
+    /* set in both processes to avoid race with kill() */
+    setpgid (s->pid, s->pid);
+    close (fds[1]);
+    s->fd = fds[0];
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Show output of the started command in the panel while it runs.
+ *
+ * The output is read by the event loop of a small progress dialog, so the UI stays
+ * responsive and the command can be stopped at any time. Names are stat'ed in batches,
+ * in a worker thread if threads are available and the current directory is local:
+ * VFS isn't thread-safe, so names in VFS directories are resolved by handle_path(). Entries are appended unsorted and the panel
+ * is sorted when the command finishes or the user asks for it.
+ */
+
+static void
+panelize_stream_run (panelize_stream_t * s)
+{
+    s->line = g_string_sized_new (MC_MAXPATHLEN);
+
+#ifdef PANELIZE_THREADED
+    if (vfs_file_is_local (current_panel->cwd_vpath)
+        && vfs_path_elements_count (current_panel->cwd_vpath) == 1
+        && !vfs_path_element_need_cleanup_converter (vfs_path_get_by_index
+                                                      (current_panel->cwd_vpath, 0))
+        && pipe (s->wake) == 0)
+    {
+        s->root = vfs_path_get_by_index (current_panel->cwd_vpath, -1)->path;
+        s->todo = g_async_queue_new ();
+        s->done = g_async_queue_new ();
+        s->worker = g_thread_try_new ("panelize", panelize_worker, s, NULL);
+        if (s->worker == NULL)
+        {
+            g_async_queue_unref (s->todo);
+            g_async_queue_unref (s->done);
+            close (s->wake[0]);
+            close (s->wake[1]);
+        }
+        else
+            add_select_channel (s->wake[0], panelize_stream_resolved, s);
+    }
+#endif
+
+    panelize_stream_init_dlg (s);
+    add_select_channel (s->fd, panelize_stream_output, s);
+    if (dlg_run (s->dlg) != B_ENTER)
+        s->cancelled = TRUE;
+    if (!s->eof)
+        delete_select_channel (s->fd);
+    dlg_destroy (s->dlg);
+
+#ifdef PANELIZE_THREADED
+    if (s->worker != NULL)
+    {
+        GArray *batch;
+
+        g_atomic_int_set (&s->cancel, 1);
+        g_async_queue_push (s->todo, g_array_new (FALSE, FALSE, sizeof (panelize_entry_t)));
+        g_thread_join (s->worker);
+        delete_select_channel (s->wake[0]);
+
+        while ((batch = g_async_queue_try_pop (s->todo)) != NULL)
+            panelize_batch_free (batch);
+        while ((batch = g_async_queue_try_pop (s->done)) != NULL)
+            panelize_batch_free (batch);
+
+        g_async_queue_unref (s->todo);
+        g_async_queue_unref (s->done);
+        close (s->wake[0]);
+        close (s->wake[1]);
+    }
+#endif
+
+    /* the command gets SIGPIPE on next write if it is still running */
+    close (s->fd);
+    /* stop the shell and commands started by it, e.g. all parts of pipeline */
+    if (s->cancelled)
+        kill (-s->pid, SIGTERM);
+
+    g_string_free (s->line, TRUE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+do_external_panelize (char *command)
+{
+    panelize_stream_t s;
+    dir_list *list = &current_panel->dir;
+    int status;
+
+    memset (&s, 0, sizeof (s));
+
+    open_error_pipe ();
+    if (!panelize_stream_open (&s, command))
+    {
+        close_error_pipe (D_ERROR, _("Cannot invoke command."));
+        return;
+    }
+    /* Clear the counters and the directory list */
+    panel_clean_dir (current_panel);
+
+    panelize_change_root (current_panel->cwd_vpath);
+
+    dir_list_init (list);
+
     current_panel->is_panelized = TRUE;
 
+    panelize_stream_run (&s);
+
     if (list->len == 0)
         dir_list_init (list);
     else if (list->list[0].fname[0] == PATH_SEP)
@@ -374,8 +883,13 @@ do_external_panelize (char *command)
         (void) ret;
     }
 
-    if (pclose (external) < 0)
-        message (D_NORMAL, _("External panelize"), _("Pipe close failed"));
+    while (waitpid (s.pid, &status, 0) < 0)
+        if (errno != EINTR)
+        {
+            message (D_NORMAL, _("External panelize"), _("Pipe close failed"));
+            break;
+        }
+
     close_error_pipe (D_NORMAL, NULL);
     try_to_select (current_panel, NULL);
     panel_re_sort (current_panel);
@@ -391,6 +905,7 @@ do_panelize_cd (WPanel * panel)
     dir_list *list;
     gboolean panelized_same;
 
+    panel_cancel_loading (panel);
     dir_list_clean (&panel->dir);
     if (panelized_panel.root_vpath == NULL)
         panelize_change_root (current_panel->cwd_vpath);
@@ -411,8 +926,8 @@ do_panelize_cd (WPanel * panel)
         if (panelized_same || DIR_IS_DOTDOT (panelized_panel.list.list[i].fname))
         {
             list->list[i].fnamelen = panelized_panel.list.list[i].fnamelen;
-            list->list[i].fname = g_strndup (panelized_panel.list.list[i].fname,
-                                             panelized_panel.list.list[i].fnamelen);
+            list->list[i].fname = dir_list_strndup (list, panelized_panel.list.list[i].fname,
+                                                    panelized_panel.list.list[i].fnamelen);
         }
         else
         {
@@ -424,7 +939,7 @@ do_panelize_cd (WPanel * panel)
                                      NULL);
             fname = vfs_path_as_str (tmp_vpath);
             list->list[i].fnamelen = strlen (fname);
-            list->list[i].fname = g_strndup (fname, list->list[i].fnamelen);
+            list->list[i].fname = dir_list_strndup (list, fname, list->list[i].fnamelen);
             vfs_path_free (tmp_vpath);
         }
         list->list[i].f.link_to_dir = panelized_panel.list.list[i].f.link_to_dir;
@@ -476,7 +991,7 @@ panelize_save_panel (WPanel * panel)
     {
         panelized_panel.list.list[i].fnamelen = list->list[i].fnamelen;
         panelized_panel.list.list[i].fname =
-            g_strndup (list->list[i].fname, list->list[i].fnamelen);
+            dir_list_strndup (&panelized_panel.list, list->list[i].fname, list->list[i].fnamelen);
         panelized_panel.list.list[i].f.link_to_dir = list->list[i].f.link_to_dir;
         panelized_panel.list.list[i].f.stale_link = list->list[i].f.stale_link;
         panelized_panel.list.list[i].f.dir_size_computed = list->list[i].f.dir_size_computed;
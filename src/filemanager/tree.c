@@ -67,6 +67,7 @@
 #include "treestore.h"
 #include "cmd.h"
 #include "filegui.h"
+#include "dirsize.h"            /* dirsize_cache_invalidate() */
 
 #include "tree.h"
 
@@ -783,9 +784,10 @@ tree_copy (WTree * tree, const char *default_dest)
         file_op_context_create_ui (ctx, FALSE, FILEGUI_DIALOG_MULTI_ITEM);
         tctx->ask_overwrite = FALSE;
         copy_dir_dir (tctx, ctx, vfs_path_as_str (tree->selected_ptr->name), dest, TRUE, FALSE,
-                      FALSE, NULL);
+                      FALSE);
         file_op_total_context_destroy (tctx);
         file_op_context_destroy (ctx);
+        dirsize_cache_invalidate ();
     }
 
     g_free (dest);
@@ -833,6 +835,7 @@ tree_move (WTree * tree, const char *default_dest)
     move_dir_dir (tctx, ctx, vfs_path_as_str (tree->selected_ptr->name), dest);
     file_op_total_context_destroy (tctx);
     file_op_context_destroy (ctx);
+    dirsize_cache_invalidate ();
 
   ret:
     g_free (dest);
@@ -891,6 +894,7 @@ tree_rmdir (void *data)
         tree_forget (tree);
     file_op_total_context_destroy (tctx);
     file_op_context_destroy (ctx);
+    dirsize_cache_invalidate ();
 }
 
 /* --------------------------------------------------------------------------------------------- */
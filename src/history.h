@@ -35,6 +35,8 @@
 #define MC_HISTORY_VIEW_GOTO_LINE     "mc.view.goto-line"
 #define MC_HISTORY_VIEW_GOTO_ADDR     "mc.view.goto-addr"
 #define MC_HISTORY_VIEW_SEARCH_REGEX  "mc.view.search.regex"
+#define MC_HISTORY_VIEW_FILL_BYTES   "mc.view.fill-bytes"
+#define MC_HISTORY_VIEW_FILL_COUNT   "mc.view.fill-count"
 
 #define MC_HISTORY_FTPFS_ACCOUNT      "mc.vfs.ftp.account"
 
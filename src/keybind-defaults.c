@@ -473,6 +473,8 @@ static const global_keymap_ini_t default_viewer_keymap[] = {
 static const global_keymap_ini_t default_viewer_hex_keymap[] = {
     {"Help", "f1"},
     {"HexEditMode", "f2"},
+    {"HexFill", "alt-f"},
+    {"Paste", "shift-insert"},
     {"Quit", "f3; f10; q; esc"},
     {"HexMode", "f4"},
     {"Goto", "f5"},
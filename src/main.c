@@ -50,6 +50,8 @@
 #include "lib/skin.h"
 #include "lib/filehighlight.h"
 #include "lib/fileloc.h"
+#include "lib/logging.h"        /* mc_log_startup_phase() */
+#include "lib/search.h"        /* mc_search_cache_free() */
 #include "lib/strutil.h"
 #include "lib/util.h"
 #include "lib/vfs/vfs.h"        /* vfs_init(), vfs_shut() */
@@ -58,6 +60,7 @@
 #include "filemanager/treestore.h"      /* tree_store_save */
 #include "filemanager/layout.h" /* command_prompt */
 #include "filemanager/ext.h"    /* flush_extension_file() */
+#include "filemanager/dirsize.h"        /* dirsize_cache_free() */
 #include "filemanager/command.h"        /* cmdline */
 #include "filemanager/panel.h"  /* panalized_panel */
 
@@ -238,6 +241,8 @@ main (int argc, char *argv[])
     char *config_migrate_msg;
     int exit_code = EXIT_FAILURE;
 
+    mc_log_startup_phase ("start");
+
     /* We had LC_CTYPE before, LC_ALL includs LC_TYPE as well */
 #ifdef HAVE_SETLOCALE
     (void) setlocale (LC_ALL, "");
@@ -279,6 +284,8 @@ main (int argc, char *argv[])
     if (!events_init (&mcerror))
         goto startup_exit_falure;
 
+    mc_log_startup_phase ("arguments and events");
+
     mc_config_init_config_paths (&mcerror);
     config_migrated = mc_config_migrate_from_old_place (&mcerror, &config_migrate_msg);
     if (mcerror != NULL)
@@ -287,10 +294,14 @@ main (int argc, char *argv[])
         goto startup_exit_falure;
     }
 
+    mc_log_startup_phase ("config paths");
+
     vfs_init ();
     vfs_plugins_init ();
+    mc_log_startup_phase ("vfs");
 
     load_setup ();
+    mc_log_startup_phase ("setup");
 
     /* Must be done after load_setup because depends on mc_global.vfs.cd_symlinks */
     vfs_setup_work_dir ();
@@ -323,6 +334,12 @@ main (int argc, char *argv[])
         goto startup_exit_falure;
     }
 
+    /* filehighlight.ini is read while the terminal, the skin and the subshell are initialized */
+    if (mc_global.mc_run_mode == MC_RUN_FULL)
+        mc_fhl_prefetch ();
+
+    mc_log_startup_phase ("work dir and arguments");
+
     /* check terminal type
      * $TEMR must be set and not empty
      * mc_global.tty.xterm_flag is used in init_key() and tty_init()
@@ -355,6 +372,7 @@ main (int argc, char *argv[])
     /* Must be done before init_subshell, to set up the terminal size: */
     /* FIXME: Should be removed and LINES and COLS computed on subshell */
     tty_init (!mc_args__nomouse, mc_global.tty.xterm_flag);
+    mc_log_startup_phase ("tty");
 
     /* start check mc_global.display_codepage and mc_global.source_codepage */
     check_codeset ();
@@ -363,6 +381,7 @@ main (int argc, char *argv[])
     load_key_defs ();
 
     load_keymap_defs (!mc_args__nokeymap);
+    mc_log_startup_phase ("keymaps");
 
     macros_list = g_array_new (TRUE, FALSE, sizeof (macros_t));
 
@@ -373,6 +392,7 @@ main (int argc, char *argv[])
     input_set_default_colors ();
     if (mc_global.mc_run_mode == MC_RUN_FULL)
         command_set_default_colors ();
+    mc_log_startup_phase ("colors and skin");
 
     mc_error_message (&mcerror);
 
@@ -380,7 +400,10 @@ main (int argc, char *argv[])
     /* Done here to ensure that the subshell doesn't  */
     /* inherit the file descriptors opened below, etc */
     if (mc_global.tty.use_subshell)
+    {
         init_subshell ();
+        mc_log_startup_phase ("subshell");
+    }
 #endif /* ENABLE_SUBSHELL */
 
     /* Also done after init_subshell, to save any shell init file messages */
@@ -397,6 +420,7 @@ main (int argc, char *argv[])
     /* Done after do_enter_ca_mode (tty_init) because in VTE bracketed mode is
        separate for the normal and alternate screens */
     enable_bracketed_paste ();
+    mc_log_startup_phase ("mouse and terminal modes");
 
     /* subshell_prompt is NULL here */
     mc_prompt = (geteuid () == 0) ? "# " : "$ ";
@@ -413,6 +437,9 @@ main (int argc, char *argv[])
     else
         exit_code = do_nc ()? EXIT_SUCCESS : EXIT_FAILURE;
 
+    /* in case if the first frame wasn't shown */
+    mc_log_startup_done ();
+
     /* Save the tree store */
     (void) tree_store_save ();
 
@@ -422,13 +449,17 @@ main (int argc, char *argv[])
     vfs_shut ();
 
     flush_extension_file ();    /* does only free memory */
+    dirsize_cache_free ();      /* does only free memory */
+    mc_search_cache_free ();    /* does only free memory */
 
     mc_skin_deinit ();
+    mc_skin_color_ids_free ();
     tty_colors_done ();
 
     tty_shutdown ();
 
     done_setup ();
+    mc_config_cache_free ();    /* does only free memory */
 
     if (mc_global.tty.console_flag != '\0' && (quit & SUBSHELL_EXIT) == 0)
         handle_console (CONSOLE_RESTORE);
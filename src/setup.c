@@ -341,6 +341,7 @@ static const struct
     { "editor_backspace_through_tabs", &option_backspace_through_tabs },
     { "editor_fake_half_tabs", &option_fake_half_tabs },
     { "editor_option_save_mode", &option_save_mode },
+    { "editor_option_save_sync", &option_save_sync },
     { "editor_option_save_position", &option_save_position },
     { "editor_option_auto_para_formatting", &option_auto_para_formatting },
     { "editor_option_typewriter_wrap", &option_typewriter_wrap },
@@ -1305,6 +1306,25 @@ load_keymap_defs (gboolean load_from_file)
 #ifdef USE_DIFF_VIEW
     diff_map = (global_keymap_t *) diff_keymap->data;
 #endif
+
+    /* keymaps are looked up on every key press: build lookup tables */
+    keybind_compile_keymap (main_map);
+    keybind_compile_keymap (main_x_map);
+    keybind_compile_keymap (panel_map);
+    keybind_compile_keymap (dialog_map);
+    keybind_compile_keymap (input_map);
+    keybind_compile_keymap (listbox_map);
+    keybind_compile_keymap (tree_map);
+    keybind_compile_keymap (help_map);
+#ifdef USE_INTERNAL_EDIT
+    keybind_compile_keymap (editor_map);
+    keybind_compile_keymap (editor_x_map);
+#endif
+    keybind_compile_keymap (viewer_map);
+    keybind_compile_keymap (viewer_hex_map);
+#ifdef USE_DIFF_VIEW
+    keybind_compile_keymap (diff_map);
+#endif
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -1312,6 +1332,8 @@ load_keymap_defs (gboolean load_from_file)
 void
 free_keymap_defs (void)
 {
+    keybind_free_compiled_keymaps ();
+
     if (main_keymap != NULL)
         g_array_free (main_keymap, TRUE);
     if (main_x_keymap != NULL)
@@ -102,6 +102,9 @@ gboolean update_subshell_prompt = FALSE;
 /* Length of the buffer for all I/O with the subshell */
 #define PTY_BUFFER_SIZE BUF_SMALL       /* Arbitrary; but keep it >= 80 */
 
+/* Length of the buffer for output of the subshell */
+#define PTY_RELAY_SIZE (64 * 1024)
+
 /*** file scope type declarations ****************************************************************/
 
 /* For pipes */
@@ -135,6 +138,9 @@ static const char subshell_switch_key = XCTRL ('o') & 255;
 /* For reading/writing on the subshell's pty */
 static char pty_buffer[PTY_BUFFER_SIZE] = "\0";
 
+/* For relaying output of the subshell to the terminal */
+static char pty_relay_buffer[PTY_RELAY_SIZE];
+
 /* To pass CWD info from the subshell to MC */
 static int subshell_pipe[2];
 
@@ -473,7 +479,8 @@ feed_subshell (int how, int fail_on_error)
 
     while (TRUE)
     {
-        int maxfdp;
+        int maxfdp, ready;
+        gboolean pty_drained = TRUE;
 
         if (!subshell_alive)
             return FALSE;
@@ -490,7 +497,8 @@ feed_subshell (int how, int fail_on_error)
             maxfdp = max (maxfdp, STDIN_FILENO);
         }
 
-        if (select (maxfdp + 1, &read_set, NULL, NULL, wptr) == -1)
+        ready = select (maxfdp + 1, &read_set, NULL, NULL, wptr);
+        if (ready == -1)
         {
             /* Despite using SA_RESTART, we still have to check for this */
             if (errno == EINTR)
@@ -506,32 +514,36 @@ feed_subshell (int how, int fail_on_error)
             exit (EXIT_FAILURE);
         }
 
+        /* timeout */
+        if (ready == 0)
+            return FALSE;
+
         if (FD_ISSET (mc_global.tty.subshell_pty, &read_set))
             /* Read from the subshell, write to stdout */
-
-            /* This loop improves performance by reducing context switches
-               by a factor of 20 or so... unfortunately, it also hangs MC
-               randomly, because of an apparent Linux bug.  Investigate. */
-            /* for (i=0; i<5; ++i)  * FIXME -- experimental */
         {
-            bytes = read (mc_global.tty.subshell_pty, pty_buffer, sizeof (pty_buffer));
+            bytes = subshell_relay_pty (mc_global.tty.subshell_pty,
+                                        how == VISIBLY ? STDOUT_FILENO : -1,
+                                        pty_relay_buffer, sizeof (pty_relay_buffer),
+                                        &pty_drained);
 
             /* The subshell has died */
             if (bytes == -1 && errno == EIO && !subshell_alive)
                 return FALSE;
 
-            if (bytes <= 0)
+            /* EAGAIN: nothing to relay, data was taken by somebody else */
+            if (bytes == 0 || (bytes == -1 && errno != EAGAIN && errno != EWOULDBLOCK))
             {
                 tcsetattr (STDOUT_FILENO, TCSANOW, &shell_mode);
                 fprintf (stderr, "read (subshell_pty...): %s\r\n", unix_error_string (errno));
                 exit (EXIT_FAILURE);
             }
-
-            if (how == VISIBLY)
-                write_all (STDOUT_FILENO, pty_buffer, bytes);
         }
 
-        else if (FD_ISSET (subshell_pipe[READ], &read_set))
+        /* Output of the subshell is relayed by large blocks, so keyboard is served
+           in the same pass to not starve it. But the prompt is read only after all
+           output of command is relayed: otherwise the rest of output would be taken
+           for the prompt by read_subshell_prompt() */
+        if (pty_drained && FD_ISSET (subshell_pipe[READ], &read_set))
             /* Read the subshell's CWD and capture its prompt */
         {
             bytes = read (subshell_pipe[READ], subshell_cwd, MC_MAXPATHLEN + 1);
@@ -555,7 +567,7 @@ feed_subshell (int how, int fail_on_error)
             }
         }
 
-        else if (FD_ISSET (STDIN_FILENO, &read_set))
+        if (FD_ISSET (STDIN_FILENO, &read_set))
             /* Read from stdin, write to the subshell */
         {
             bytes = read (STDIN_FILENO, pty_buffer, sizeof (pty_buffer));
@@ -581,8 +593,6 @@ feed_subshell (int how, int fail_on_error)
             if (pty_buffer[bytes - 1] == '\n' || pty_buffer[bytes - 1] == '\r')
                 subshell_ready = FALSE;
         }
-        else
-            return FALSE;
     }
 }
 
@@ -742,6 +752,65 @@ pty_open_slave (const char *pty_name)
 
 /* --------------------------------------------------------------------------------------------- */
 /*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Relay output of subshell: read pty until no more data is ready or buffer is full,
+ * then write all read data at once.
+ *
+ * @param pty master side of pseudo-terminal
+ * @param out_fd descriptor to write to, -1 to discard output
+ * @param buf buffer
+ * @param size size of buffer
+ * @param drained set to FALSE if reading was stopped because buffer is full, so more
+ *                data may be ready, to TRUE otherwise; can be NULL
+ *
+ * @return number of relayed bytes, 0 on end of file, -1 on error (errno is set)
+ */
+
+ssize_t
+subshell_relay_pty (int pty, int out_fd, char *buf, size_t size, gboolean * drained)
+{
+    size_t len = 0;
+    ssize_t ret = 0;
+    int saved_errno = 0;
+    int flags;
+
+    /* pty is ready to read, so the first read doesn't block anyway */
+    flags = fcntl (pty, F_GETFL);
+    if (flags != -1 && (flags & O_NONBLOCK) == 0)
+        (void) fcntl (pty, F_SETFL, flags | O_NONBLOCK);
+
+    while (len < size)
+    {
+        ret = read (pty, buf + len, size - len);
+        if (ret > 0)
+            len += (size_t) ret;
+        else if (ret == -1 && errno == EINTR)
+            continue;
+        else
+        {
+            saved_errno = errno;
+            break;
+        }
+    }
+
+    if (flags != -1 && (flags & O_NONBLOCK) == 0)
+        (void) fcntl (pty, F_SETFL, flags);
+
+    if (drained != NULL)
+        *drained = len < size;
+
+    if (len != 0)
+    {
+        if (out_fd != -1)
+            (void) write_all (out_fd, buf, len);
+        return (ssize_t) len;
+    }
+
+    errno = saved_errno;
+    return ret;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 /* --------------------------------------------------------------------------------------------- */
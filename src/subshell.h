@@ -46,6 +46,7 @@ gboolean exit_subshell (void);
 void do_subshell_chdir (const vfs_path_t * vpath, gboolean update_prompt);
 void subshell_get_console_attributes (void);
 void sigchld_handler (int sig);
+ssize_t subshell_relay_pty (int pty, int out_fd, char *buf, size_t size, gboolean * drained);
 
 /*** inline functions ****************************************************************************/
 
@@ -143,6 +143,9 @@ static struct vfs_class vfs_extfs_ops;
 static struct archive *first_archive = NULL;
 static int my_errno = 0;
 
+/* plugin directories are scanned at first use, not at startup */
+static gboolean extfs_plugins_loaded = FALSE;
+
 /*** file scope functions ************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
 
@@ -150,6 +153,7 @@ static void extfs_remove_entry (struct entry *e);
 static void extfs_free (vfsid id);
 static void extfs_free_entry (struct entry *e);
 static struct entry *extfs_resolve_symlinks_int (struct entry *entry, GSList * list);
+static void extfs_load_plugins (void);
 
 /* --------------------------------------------------------------------------------------------- */
 
@@ -643,6 +647,10 @@ extfs_which (struct vfs_class *me, const char *path)
 
     (void) me;
 
+    extfs_load_plugins ();
+    if (extfs_plugins == NULL)
+        return -1;
+
     path_len = strlen (path);
 
     for (i = 0; i < extfs_plugins->len; i++)
@@ -1655,19 +1663,52 @@ extfs_get_plugins (const char *where, gboolean silent)
 
 /* --------------------------------------------------------------------------------------------- */
 
+static void
+extfs_load_plugins (void)
+{
+    if (extfs_plugins_loaded)
+        return;
+
+    extfs_plugins_loaded = TRUE;
+
+    /* 1st: scan user directory */
+    (void) extfs_get_plugins (mc_config_get_data_path (), TRUE);
+    /* 2nd: scan system dir. extfs_init() has already warned if there are no directories */
+    (void) extfs_get_plugins (LIBEXECDIR, TRUE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+extfs_plugins_dir_exists (const char *where)
+{
+    char *dirname;
+    gboolean ret;
+
+    dirname = g_build_path (PATH_SEP_STR, where, MC_EXTFS_DIR, (char *) NULL);
+    ret = g_file_test (dirname, G_FILE_TEST_IS_DIR);
+    g_free (dirname);
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
 static int
 extfs_init (struct vfs_class *me)
 {
-    gboolean d1, d2;
-
     (void) me;
 
-    /* 1st: scan user directory */
-    d1 = extfs_get_plugins (mc_config_get_data_path (), TRUE);  /* silent about user dir */
-    /* 2nd: scan system dir */
-    d2 = extfs_get_plugins (LIBEXECDIR, d1);
+    /* Reading all plugins is deferred to the first extfs_which() call, since it opens every file
+       in the directories. Here only check that directories exist to keep the startup warning. */
+    if (extfs_plugins_dir_exists (mc_config_get_data_path ()))
+        return 1;
 
-    return (d1 || d2 ? 1 : 0);
+    if (extfs_plugins_dir_exists (LIBEXECDIR))
+        return 1;
+
+    fprintf (stderr, _("Warning: cannot open %s directory\n"), LIBEXECDIR MC_EXTFS_DIR);
+    return 0;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -1686,17 +1727,22 @@ extfs_done (struct vfs_class *me)
         ar = first_archive;
     }
 
-    for (i = 0; i < extfs_plugins->len; i++)
+    if (extfs_plugins != NULL)
     {
-        extfs_plugin_info_t *info;
+        for (i = 0; i < extfs_plugins->len; i++)
+        {
+            extfs_plugin_info_t *info;
 
-        info = &g_array_index (extfs_plugins, extfs_plugin_info_t, i);
-        g_free (info->path);
-        g_free (info->prefix);
-    }
+            info = &g_array_index (extfs_plugins, extfs_plugin_info_t, i);
+            g_free (info->path);
+            g_free (info->prefix);
+        }
 
-    if (extfs_plugins != NULL)
         g_array_free (extfs_plugins, TRUE);
+        extfs_plugins = NULL;
+    }
+
+    extfs_plugins_loaded = FALSE;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -78,6 +78,15 @@
 
 #define undelfs_stat undelfs_lstat
 
+/* number of block groups scanned as one job */
+#define UNDELFS_CHUNK_GROUPS 16
+
+/* number of worker threads: scanning of inodes and their block lists is CPU bound */
+#define UNDELFS_WORKERS 4
+
+/* interval of updating of progress message, in microseconds */
+#define UNDELFS_UPDATE_INTERVAL (G_USEC_PER_SEC / 10)
+
 /*** file scope type declarations ****************************************************************/
 
 struct deleted_info
@@ -98,8 +107,47 @@ struct lsdel_struct
     int num_blocks;
     int free_blocks;
     int bad_blocks;
+    ext2fs_block_bitmap block_map;      /* shared read-only block bitmap */
 };
 
+/* deleted files found in one chunk of block groups */
+typedef struct
+{
+    struct deleted_info *list;
+    int len;
+    int max;
+} undelfs_chunk_t;
+
+/* state of scanning of inode tables */
+typedef struct
+{
+    const char *fname;
+    ext2fs_block_bitmap block_map;
+    dgrp_t groups;
+    ext2_ino_t inodes_per_group;
+
+    /* results of scanning, in order of block groups */
+    undelfs_chunk_t *chunks;
+    int chunks_num;
+
+    volatile gint next_chunk;   /* next chunk to scan */
+    volatile gint inodes;       /* number of scanned inodes */
+    volatile gint cancel;       /* stop scanning */
+
+    /* first error */
+    const char *error_fmt;
+    long error;
+    /* last error of ext2fs_block_iterate(): such inodes are skipped */
+    volatile gint iterate_error;
+    gboolean no_memory;
+
+#ifdef HAVE_GLIB_THREADS
+    GMutex lock;
+    GCond cond;
+    int running;                /* number of running workers */
+#endif
+} undelfs_scan_t;
+
 typedef struct
 {
     int f_index;                /* file index into delarray */
@@ -122,10 +170,9 @@ typedef struct
 /* We only allow one opened ext2fs */
 static char *ext2_fname;
 static ext2_filsys fs = NULL;
-static struct lsdel_struct lsd;
+/* deleted files sorted by inode number */
 static struct deleted_info *delarray;
-static int num_delarray, max_delarray;
-static char *block_buf;
+static int num_delarray;
 static const char *undelfserr = N_("undelfs: error");
 static int readdir_ptr;
 static int undelfs_usage;
@@ -144,8 +191,7 @@ undelfs_shutdown (void)
     ext2_fname = NULL;
     g_free (delarray);
     delarray = NULL;
-    g_free (block_buf);
-    block_buf = NULL;
+    num_delarray = 0;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -218,122 +264,381 @@ undelfs_lsdel_proc (ext2_filsys _fs, blk_t * block_nr, int blockcnt, void *priva
         return BLOCK_ABORT;
     }
 
-    if (!ext2fs_test_block_bitmap (_fs->block_map, *block_nr))
+    if (!ext2fs_test_block_bitmap (_lsd->block_map, *block_nr))
         _lsd->free_blocks++;
 
     return 0;
 }
 
 /* --------------------------------------------------------------------------------------------- */
-/**
- * Load information about deleted files.
- * Don't abort if there is not enough memory - load as much as we can.
- */
+/** Stop scanning and remember error, it is shown after scanning */
 
-static int
-undelfs_loaddel (void)
+static void
+undelfs_scan_error (undelfs_scan_t * s, const char *fmt, long error)
 {
-    int retval, count;
-    ext2_ino_t ino;
-    struct ext2_inode inode;
-    ext2_inode_scan scan;
-
-    max_delarray = 100;
-    num_delarray = 0;
-    delarray = g_try_malloc (sizeof (struct deleted_info) * max_delarray);
-    if (!delarray)
-    {
-        message (D_ERROR, undelfserr, _("not enough memory"));
-        return 0;
-    }
-    block_buf = g_try_malloc (fs->blocksize * 3);
-    if (!block_buf)
+#ifdef HAVE_GLIB_THREADS
+    g_mutex_lock (&s->lock);
+#endif
+    if (s->error_fmt == NULL)
     {
-        message (D_ERROR, undelfserr, _("while allocating block buffer"));
-        goto free_delarray;
+        s->error_fmt = fmt;
+        s->error = error;
     }
-    retval = ext2fs_open_inode_scan (fs, 0, &scan);
-    if (retval != 0)
+    g_atomic_int_set (&s->cancel, 1);
+#ifdef HAVE_GLIB_THREADS
+    g_mutex_unlock (&s->lock);
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+undelfs_scan_progress (undelfs_scan_t * s, int count)
+{
+#ifdef HAVE_GLIB_THREADS
+    /* message is shown by the main thread */
+    g_atomic_int_add (&s->inodes, count);
+#else
+    s->inodes += count;
+    vfs_print_message (_("undelfs: loading deleted files information %d inodes"), s->inodes);
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Append deleted file to the chunk. Storage grows geometrically.
+ *
+ * @return FALSE if there is not enough memory
+ */
+
+static gboolean
+undelfs_chunk_append (undelfs_chunk_t * chunk, const struct deleted_info *info)
+{
+    if (chunk->len >= chunk->max)
     {
-        message (D_ERROR, undelfserr, _("open_inode_scan: %d"), retval);
-        goto free_block_buf;
+        struct deleted_info *list;
+        int max;
+
+        max = chunk->max == 0 ? 64 : chunk->max * 2;
+        list = g_try_realloc (chunk->list, sizeof (struct deleted_info) * max);
+        if (list == NULL)
+            return FALSE;
+
+        chunk->list = list;
+        chunk->max = max;
     }
-    retval = ext2fs_get_next_inode (scan, &ino, &inode);
+
+    chunk->list[chunk->len++] = *info;
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Scan inodes of one chunk of block groups.
+ *
+ * @return FALSE if scanning should be stopped
+ */
+
+static gboolean
+undelfs_scan_chunk (undelfs_scan_t * s, ext2_filsys wfs, ext2_inode_scan scan, char *buf,
+                    int chunk_index)
+{
+    undelfs_chunk_t *chunk = &s->chunks[chunk_index];
+    dgrp_t group, last_group;
+    ext2_ino_t last_ino;
+    errcode_t retval;
+    int count = 0;
+
+    group = (dgrp_t) chunk_index * UNDELFS_CHUNK_GROUPS;
+    last_group = MIN (group + UNDELFS_CHUNK_GROUPS, s->groups);
+    last_ino = last_group * s->inodes_per_group;
+
+    retval = ext2fs_inode_scan_goto_blockgroup (scan, group);
     if (retval != 0)
     {
-        message (D_ERROR, undelfserr, _("while starting inode scan %d"), retval);
-        goto error_out;
+        undelfs_scan_error (s, N_("while starting inode scan %d"), retval);
+        return FALSE;
     }
-    count = 0;
-    while (ino)
+
+    while (TRUE)
     {
-        if ((count++ % 1024) == 0)
-            vfs_print_message (_("undelfs: loading deleted files information %d inodes"), count);
-        if (inode.i_dtime == 0)
-            goto next;
+        ext2_ino_t ino;
+        struct ext2_inode inode;
+        struct lsdel_struct lsd;
+        struct deleted_info info;
+
+        retval = ext2fs_get_next_inode (scan, &ino, &inode);
+        if (retval != 0)
+        {
+            undelfs_scan_error (s, N_("while doing inode scan %d"), retval);
+            return FALSE;
+        }
+
+        if (ino == 0 || ino > last_ino)
+            break;
+
+        if (++count == 1024)
+        {
+            undelfs_scan_progress (s, count);
+            count = 0;
 
-        if (S_ISDIR (inode.i_mode))
-            goto next;
+            if (g_atomic_int_get (&s->cancel) != 0)
+                return FALSE;
+        }
+
+        if (inode.i_dtime == 0 || S_ISDIR (inode.i_mode))
+            continue;
 
         lsd.inode = ino;
         lsd.num_blocks = 0;
         lsd.free_blocks = 0;
         lsd.bad_blocks = 0;
+        lsd.block_map = s->block_map;
 
-        retval = ext2fs_block_iterate (fs, ino, 0, block_buf, undelfs_lsdel_proc, &lsd);
-        if (retval)
+        retval = ext2fs_block_iterate (wfs, ino, 0, buf, undelfs_lsdel_proc, &lsd);
+        if (retval != 0)
         {
-            message (D_ERROR, undelfserr, _("while calling ext2_block_iterate %d"), retval);
-            goto next;
+            g_atomic_int_set (&s->iterate_error, (gint) retval);
+            continue;
         }
-        if (lsd.free_blocks && !lsd.bad_blocks)
+
+        if (lsd.free_blocks == 0 || lsd.bad_blocks != 0)
+            continue;
+
+        info.ino = ino;
+        info.mode = inode.i_mode;
+        info.uid = inode.i_uid;
+        info.gid = inode.i_gid;
+        info.size = inode.i_size;
+        info.dtime = inode.i_dtime;
+        info.num_blocks = lsd.num_blocks;
+        info.free_blocks = lsd.free_blocks;
+
+        if (!undelfs_chunk_append (chunk, &info))
         {
-            if (num_delarray >= max_delarray)
-            {
-                struct deleted_info *delarray_new = g_try_realloc (delarray,
-                                                                   sizeof (struct deleted_info) *
-                                                                   (max_delarray + 50));
-                if (!delarray_new)
-                {
-                    message (D_ERROR, undelfserr, _("no more memory while reallocating array"));
-                    goto error_out;
-                }
-                delarray = delarray_new;
-                max_delarray += 50;
-            }
-
-            delarray[num_delarray].ino = ino;
-            delarray[num_delarray].mode = inode.i_mode;
-            delarray[num_delarray].uid = inode.i_uid;
-            delarray[num_delarray].gid = inode.i_gid;
-            delarray[num_delarray].size = inode.i_size;
-            delarray[num_delarray].dtime = inode.i_dtime;
-            delarray[num_delarray].num_blocks = lsd.num_blocks;
-            delarray[num_delarray].free_blocks = lsd.free_blocks;
-            num_delarray++;
+            /* keep what is already loaded */
+            s->no_memory = TRUE;
+            g_atomic_int_set (&s->cancel, 1);
+            return FALSE;
         }
+    }
 
-      next:
-        retval = ext2fs_get_next_inode (scan, &ino, &inode);
-        if (retval)
+    undelfs_scan_progress (s, count);
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Take chunks of block groups one by one and scan them.
+ * Every worker uses own file system handle: ext2_filsys and its I/O channel aren't thread safe.
+ * The block bitmap is shared, it is only read here.
+ */
+
+static gpointer
+undelfs_scan_worker (gpointer data)
+{
+    undelfs_scan_t *s = (undelfs_scan_t *) data;
+    ext2_filsys wfs;
+    ext2_inode_scan scan;
+    char *buf;
+    errcode_t retval;
+
+    retval = ext2fs_open (s->fname, 0, 0, 0, unix_io_manager, &wfs);
+    if (retval != 0)
+    {
+        undelfs_scan_error (s, N_("while opening file system %d"), retval);
+        goto done;
+    }
+
+    buf = g_try_malloc (wfs->blocksize * 3);
+    if (buf == NULL)
+    {
+        undelfs_scan_error (s, N_("while allocating block buffer"), 0);
+        goto close_fs;
+    }
+
+    retval = ext2fs_open_inode_scan (wfs, 0, &scan);
+    if (retval != 0)
+    {
+        undelfs_scan_error (s, N_("open_inode_scan: %d"), retval);
+        goto free_buf;
+    }
+
+    while (g_atomic_int_get (&s->cancel) == 0)
+    {
+        int chunk;
+
+#ifdef HAVE_GLIB_THREADS
+        chunk = g_atomic_int_add (&s->next_chunk, 1);
+#else
+        chunk = s->next_chunk++;
+#endif
+        if (chunk >= s->chunks_num || !undelfs_scan_chunk (s, wfs, scan, buf, chunk))
+            break;
+    }
+
+    ext2fs_close_inode_scan (scan);
+  free_buf:
+    g_free (buf);
+  close_fs:
+    ext2fs_close (wfs);
+  done:
+#ifdef HAVE_GLIB_THREADS
+    g_mutex_lock (&s->lock);
+    s->running--;
+    g_cond_broadcast (&s->cond);
+    g_mutex_unlock (&s->lock);
+#endif
+    return NULL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Scan inode tables in worker threads and show progress */
+
+static void
+undelfs_scan_run (undelfs_scan_t * s)
+{
+#ifdef HAVE_GLIB_THREADS
+    GThread *workers[UNDELFS_WORKERS];
+    int n_workers, i;
+
+    g_mutex_init (&s->lock);
+    g_cond_init (&s->cond);
+
+    g_mutex_lock (&s->lock);
+    for (i = 0; i < UNDELFS_WORKERS && i < s->chunks_num; i++)
+    {
+        workers[i] = g_thread_try_new ("undelfs", undelfs_scan_worker, s, NULL);
+        if (workers[i] == NULL)
+            break;
+        s->running++;
+    }
+    n_workers = i;
+
+    if (n_workers == 0)
+    {
+        /* cannot create threads: scan in this thread */
+        s->running++;
+        g_mutex_unlock (&s->lock);
+        undelfs_scan_worker (s);
+        g_mutex_lock (&s->lock);
+    }
+
+    while (s->running != 0)
+    {
+        gint64 end_time;
+
+        end_time = g_get_monotonic_time () + UNDELFS_UPDATE_INTERVAL;
+        if (!g_cond_wait_until (&s->cond, &s->lock, end_time))
+            vfs_print_message (_("undelfs: loading deleted files information %d inodes"),
+                               g_atomic_int_get (&s->inodes));
+    }
+    g_mutex_unlock (&s->lock);
+
+    for (i = 0; i < n_workers; i++)
+        g_thread_join (workers[i]);
+
+    g_cond_clear (&s->cond);
+    g_mutex_clear (&s->lock);
+#else
+    undelfs_scan_worker (s);
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Load information about deleted files.
+ * Don't abort if there is not enough memory - load as much as we can.
+ */
+
+static int
+undelfs_loaddel (void)
+{
+    undelfs_scan_t s;
+    int i, total = 0;
+
+    memset (&s, 0, sizeof (s));
+    s.fname = ext2_fname;
+    s.block_map = fs->block_map;
+    s.groups = fs->group_desc_count;
+    s.inodes_per_group = fs->super->s_inodes_per_group;
+    s.chunks_num = (s.groups + UNDELFS_CHUNK_GROUPS - 1) / UNDELFS_CHUNK_GROUPS;
+
+    s.chunks = g_try_new0 (undelfs_chunk_t, s.chunks_num);
+    if (s.chunks == NULL)
+    {
+        message (D_ERROR, undelfserr, _("not enough memory"));
+        return 0;
+    }
+
+    undelfs_scan_run (&s);
+
+    if (s.error_fmt != NULL)
+        message (D_ERROR, undelfserr, _(s.error_fmt), (int) s.error);
+    else
+    {
+        if (s.iterate_error != 0)
+            message (D_ERROR, undelfserr, _("while calling ext2_block_iterate %d"),
+                     s.iterate_error);
+        if (s.no_memory)
+            message (D_ERROR, undelfserr, _("no more memory while reallocating array"));
+
+        /* chunks are scanned in order of inode numbers: result is sorted */
+        for (i = 0; i < s.chunks_num; i++)
+            total += s.chunks[i].len;
+
+        delarray = g_try_new (struct deleted_info, MAX (total, 1));
+        if (delarray == NULL)
+            message (D_ERROR, undelfserr, _("not enough memory"));
+        else
         {
-            message (D_ERROR, undelfserr, _("while doing inode scan %d"), retval);
-            goto error_out;
+            for (i = 0; i < s.chunks_num; i++)
+                if (s.chunks[i].len != 0)
+                {
+                    memcpy (delarray + num_delarray, s.chunks[i].list,
+                            sizeof (struct deleted_info) * s.chunks[i].len);
+                    num_delarray += s.chunks[i].len;
+                }
         }
     }
+
+    for (i = 0; i < s.chunks_num; i++)
+        g_free (s.chunks[i].list);
+    g_free (s.chunks);
+
+    if (delarray == NULL)
+        return 0;
+
     readdir_ptr = READDIR_PTR_INIT;
-    ext2fs_close_inode_scan (scan);
     return 1;
+}
 
-  error_out:
-    ext2fs_close_inode_scan (scan);
-  free_block_buf:
-    g_free (block_buf);
-    block_buf = NULL;
-  free_delarray:
-    g_free (delarray);
-    delarray = NULL;
-    return 0;
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+undelfs_ino_cmp (const void *key, const void *item)
+{
+    ext2_ino_t ino = *(const ext2_ino_t *) key;
+    const struct deleted_info *info = (const struct deleted_info *) item;
+
+    return (ino > info->ino) - (ino < info->ino);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static long
+undelfs_getindex (char *path)
+{
+    ext2_ino_t inode = atol (path);
+    const struct deleted_info *info;
+
+    if (delarray == NULL)
+        return -1;
+
+    /* delarray is sorted by inode number */
+    info = bsearch (&inode, delarray, num_delarray, sizeof (struct deleted_info), undelfs_ino_cmp);
+
+    return info == NULL ? -1 : (long) (info - delarray);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -440,7 +745,7 @@ static void *
 undelfs_open (const vfs_path_t * vpath, int flags, mode_t mode)
 {
     char *file, *f = NULL;
-    ext2_ino_t inode, i;
+    long i;
     undelfs_file *p = NULL;
     (void) flags;
     (void) mode;
@@ -460,14 +765,10 @@ undelfs_open (const vfs_path_t * vpath, int flags, mode_t mode)
         g_free (f);
         return 0;
     }
-    inode = atol (f);
-
     /* Search the file into delarray */
-    for (i = 0; i < (ext2_ino_t) num_delarray; i++)
+    i = undelfs_getindex (f);
+    if (i != -1)
     {
-        if (inode != delarray[i].ino)
-            continue;
-
         /* Found: setup all the structures needed by read */
         p = (undelfs_file *) g_try_malloc (((gsize) sizeof (undelfs_file)));
         if (!p)
@@ -484,7 +785,7 @@ undelfs_open (const vfs_path_t * vpath, int flags, mode_t mode)
             g_free (f);
             return 0;
         }
-        p->inode = inode;
+        p->inode = delarray[i].ino;
         p->finished = FALSE;
         p->f_index = i;
         p->error_code = 0;
@@ -612,22 +913,6 @@ undelfs_read (void *vfs_info, char *buffer, size_t count)
 
 /* --------------------------------------------------------------------------------------------- */
 
-static long
-undelfs_getindex (char *path)
-{
-    ext2_ino_t inode = atol (path);
-    int i;
-
-    for (i = 0; i < num_delarray; i++)
-    {
-        if (delarray[i].ino == inode)
-            return i;
-    }
-    return -1;
-}
-
-/* --------------------------------------------------------------------------------------------- */
-
 static int
 undelfs_stat_int (int inode_index, struct stat *buf)
 {
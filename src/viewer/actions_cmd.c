@@ -221,11 +221,10 @@ mcview_handle_editkey (mcview_t * view, int key)
 {
     struct hexedit_change_node *node;
     int byte_val;
+    byte b;
 
     /* Has there been a change at this position? */
-    node = view->change_list;
-    while ((node != NULL) && (node->offset != view->hex_cursor))
-        node = node->next;
+    node = mcview_hexedit_find_change (view, view->hex_cursor);
 
     if (!view->hexview_in_text)
     {
@@ -242,7 +241,7 @@ mcview_handle_editkey (mcview_t * view, int key)
             return MSG_NOT_HANDLED;
 
         if (node != NULL)
-            byte_val = node->value;
+            byte_val = node->data->data[view->hex_cursor - node->offset];
         else
             mcview_get_byte (view, view->hex_cursor, &byte_val);
 
@@ -260,22 +259,8 @@ mcview_handle_editkey (mcview_t * view, int key)
             return MSG_NOT_HANDLED;
     }
 
-    if ((view->filename_vpath != NULL)
-        && (*(vfs_path_get_last_path_str (view->filename_vpath)) != '\0')
-        && (view->change_list == NULL))
-        view->locked = lock_file (view->filename_vpath);
-
-    if (node == NULL)
-    {
-        node = g_new (struct hexedit_change_node, 1);
-        node->offset = view->hex_cursor;
-        node->value = byte_val;
-        mcview_enqueue_change (&view->change_list, node);
-    }
-    else
-        node->value = byte_val;
-
-    view->dirty++;
+    b = (byte) byte_val;
+    mcview_hexedit_set_bytes (view, view->hex_cursor, &b, 1);
     mcview_move_right (view, 1);
 
     return MSG_HANDLED;
@@ -339,7 +324,7 @@ mcview_scan_for_file (mcview_t * view, int direction)
             i = view->dir->len - 1;
         if (i == view->dir->len)
             i = 0;
-        if (!S_ISDIR (view->dir->list[i].st.st_mode))
+        if (!S_ISDIR (view->dir->list[i].st.mode))
             break;
     }
 
@@ -402,6 +387,16 @@ mcview_execute_cmd (mcview_t * view, unsigned long command)
         /* Toggle between hexview and hexedit mode */
         mcview_toggle_hexedit_mode (view);
         break;
+    case CK_HexFill:
+        if (!view->hex_mode || !view->hexedit_mode)
+            return MSG_NOT_HANDLED;
+        mcview_hexedit_fill (view);
+        break;
+    case CK_Paste:
+        if (!view->hex_mode || !view->hexedit_mode)
+            return MSG_NOT_HANDLED;
+        mcview_hexedit_paste (view);
+        break;
     case CK_HexMode:
         /* Toggle between hex view and text view */
         mcview_toggle_hex_mode (view);
@@ -605,7 +600,7 @@ mcview_ok_to_quit (mcview_t * view)
 {
     int r;
 
-    if (view->change_list == NULL)
+    if (view->changes == NULL)
         return TRUE;
 
     if (!mc_global.midnight_shutdown)
@@ -382,6 +382,7 @@ mcview_close_datasource (mcview_t * view)
             ;
     }
     view->datasource = DS_NONE;
+    mcview_nroff_index_free (view);
 }
 
 /* --------------------------------------------------------------------------------------------- */
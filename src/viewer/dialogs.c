@@ -270,3 +270,94 @@ mcview_dialog_goto (mcview_t * view, off_t * offset)
     g_free (exp);
     return res;
 }
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Ask pattern and number of bytes to fill in hexedit mode.
+ *
+ * @param pattern bytes to repeat, allocated on success
+ * @param count number of bytes to fill
+ *
+ * @return TRUE if valid values are entered
+ */
+
+gboolean
+mcview_dialog_fill (GByteArray ** pattern, off_t * count)
+{
+    char *bytes = NULL;
+    char *number = NULL;
+    int qd_result;
+    gboolean res;
+
+    {
+        quick_widget_t quick_widgets[] = {
+            /* *INDENT-OFF* */
+            QUICK_LABELED_INPUT (N_("&Bytes (hexadecimal):"), input_label_above,
+                                 INPUT_LAST_TEXT, MC_HISTORY_VIEW_FILL_BYTES, &bytes, NULL,
+                                 FALSE, FALSE, INPUT_COMPLETE_NONE),
+            QUICK_LABELED_INPUT (N_("&Count (decimal):"), input_label_above,
+                                 INPUT_LAST_TEXT, MC_HISTORY_VIEW_FILL_COUNT, &number, NULL,
+                                 FALSE, FALSE, INPUT_COMPLETE_NONE),
+            QUICK_BUTTONS_OK_CANCEL,
+            QUICK_END
+            /* *INDENT-ON* */
+        };
+
+        quick_dialog_t qdlg = {
+            -1, -1, 40,
+            N_("Fill"), "[Internal File Viewer]",
+            quick_widgets, NULL, NULL
+        };
+
+        /* run dialog */
+        qd_result = quick_dialog (&qdlg);
+    }
+
+    *pattern = NULL;
+    *count = 0;
+
+    res = (qd_result != B_CANCEL && bytes != NULL && number != NULL);
+    if (res)
+    {
+        const char *p = bytes;
+        char *error;
+
+        *pattern = g_byte_array_new ();
+
+        /* pattern is a list of hexadecimal bytes separated by spaces: "de ad be ef" */
+        while (res)
+        {
+            unsigned long b;
+            guint8 c;
+
+            while (*p == ' ' || *p == '\t')
+                p++;
+            if (*p == '\0')
+                break;
+
+            b = strtoul (p, &error, 16);
+            res = (error != p && b <= 0xff);
+            c = (guint8) b;
+            g_byte_array_append (*pattern, &c, 1);
+            p = error;
+        }
+
+        res = res && (*pattern)->len != 0;
+        if (res)
+        {
+            *count = (off_t) g_ascii_strtoll (number, &error, 10);
+            res = (*error == '\0' && *count > 0);
+        }
+
+        if (!res)
+        {
+            g_byte_array_free (*pattern, TRUE);
+            *pattern = NULL;
+            message (D_ERROR, MSG_ERROR, _("Invalid bytes or count"));
+        }
+    }
+
+    g_free (bytes);
+    g_free (number);
+    return res;
+}
@@ -46,6 +46,8 @@
 #include "lib/lock.h"           /* lock_file() and unlock_file() */
 #include "lib/util.h"
 #include "lib/widget.h"
+#include "lib/fileloc.h"        /* EDIT_CLIP_FILE */
+#include "lib/mcconfig.h"       /* mc_config_get_full_path() */
 #ifdef HAVE_CHARSET
 #include "lib/charsets.h"
 #endif
@@ -66,6 +68,21 @@ typedef enum
     MARK_CHANGED
 } mark_t;
 
+/* interval of offsets [start, end) to search changes */
+typedef struct
+{
+    off_t start;
+    off_t end;
+} hexedit_range_t;
+
+/* state of saving of changes */
+typedef struct
+{
+    mcview_t *view;
+    int fd;
+    gboolean error;
+} hexedit_save_t;
+
 /*** file scope variables ************************************************************************/
 
 static const char hex_char[] = "0123456789ABCDEF";
@@ -109,19 +126,110 @@ utf8_to_int (char *str, int *char_width, gboolean * result)
 }
 #endif /* HAVE_CHARSET */
 
+/* --------------------------------------------------------------------------------------------- */
+/** Order of ranges in change tree */
+
+static int
+mcview_hexedit_change_cmp (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    const struct hexedit_change_node *na = (const struct hexedit_change_node *) a;
+    const struct hexedit_change_node *nb = (const struct hexedit_change_node *) b;
+
+    (void) user_data;
+
+    return (na->offset < nb->offset) ? -1 : (na->offset > nb->offset) ? 1 : 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Search for range of change tree which intersects the interval */
+
+static int
+mcview_hexedit_change_search (gconstpointer key, gconstpointer user_data)
+{
+    const struct hexedit_change_node *node = (const struct hexedit_change_node *) key;
+    const hexedit_range_t *range = (const hexedit_range_t *) user_data;
+
+    if (node->offset >= range->end)
+        return -1;
+    if (node->offset + (off_t) node->data->len <= range->start)
+        return 1;
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+mcview_hexedit_change_free (gpointer data)
+{
+    struct hexedit_change_node *node = (struct hexedit_change_node *) data;
+
+    g_byte_array_free (node->data, TRUE);
+    g_free (node);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Find range containing changed byte. The last found range is checked first */
+
+static struct hexedit_change_node *
+mcview_hex_get_change (mcview_t * view, struct hexedit_change_node *curr, off_t offset)
+{
+    if (curr != NULL && curr->offset <= offset && offset < curr->offset + (off_t) curr->data->len)
+        return curr;
+
+    return mcview_hexedit_find_change (view, offset);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Write range of changes to file. Stop traversal of change tree on error */
+
+static gboolean
+mcview_hexedit_save_change (gpointer key, gpointer value, gpointer user_data)
+{
+    struct hexedit_change_node *node = (struct hexedit_change_node *) key;
+    hexedit_save_t *save = (hexedit_save_t *) user_data;
+    guint written = 0;
+
+    (void) value;
+
+    if (mc_lseek (save->fd, node->offset, SEEK_SET) == -1)
+    {
+        save->error = TRUE;
+        return TRUE;
+    }
+
+    /* the whole range by one call */
+    while (written < node->data->len)
+    {
+        ssize_t n;
+
+        n = mc_write (save->fd, node->data->data + written, node->data->len - written);
+        if (n <= 0)
+        {
+            save->error = TRUE;
+            return TRUE;
+        }
+        written += (guint) n;
+    }
+
+    for (written = 0; written < node->data->len; written++)
+        mcview_set_byte (save->view, node->offset + written, node->data->data[written]);
+
+    return FALSE;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /** Determine the state of the current byte.
  *
  * @param view viewer object
  * @param from offset
- * @param curr current node
+ * @param curr range of changes containing the current byte or NULL
  */
 
 static mark_t
 mcview_hex_calculate_boldflag (mcview_t * view, off_t from, struct hexedit_change_node *curr)
 {
     return (from == view->hex_cursor) ? MARK_CURSOR
-        : (curr != NULL && from == curr->offset) ? MARK_CHANGED
+        : (curr != NULL) ? MARK_CHANGED
         : (view->search_start <= from && from < view->search_end) ? MARK_SELECTED : MARK_NORMAL;
 }
 
@@ -148,9 +256,10 @@ mcview_display_hex (mcview_t * view)
     off_t from;
     int c;
     mark_t boldflag = MARK_NORMAL;
-    struct hexedit_change_node *curr = view->change_list;
+    struct hexedit_change_node *curr = NULL;
 #ifdef HAVE_CHARSET
     int ch = 0;
+    const codepage_table_t *display_table = get_codepage_table (mc_global.display_codepage);
 #endif /* HAVE_CHARSET */
 
     char hex_buff[10];          /* A temporary buffer for sprintf and mvwaddstr */
@@ -158,12 +267,7 @@ mcview_display_hex (mcview_t * view)
 
     mcview_display_clean (view);
 
-    /* Find the first displayable changed byte */
     from = view->dpy_start;
-    while (curr && (curr->offset < from))
-    {
-        curr = curr->next;
-    }
 
     for (row = 0; mcview_get_byte (view, from, NULL) == TRUE && row < height; row++)
     {
@@ -201,24 +305,25 @@ mcview_display_hex (mcview_t * view)
                 {
                     int cnt;
                     char corr_buf[UTF8_CHAR_LEN + 1];
-                    struct hexedit_change_node *corr = curr;
                     int res;
 
                     res = g_unichar_to_utf8 (ch, (char *) corr_buf);
 
                     for (cnt = 0; cnt < cw; cnt++)
                     {
-                        if (curr != NULL && from + cnt == curr->offset)
+                        struct hexedit_change_node *corr;
+
+                        corr = mcview_hex_get_change (view, curr, from + cnt);
+                        if (corr != NULL)
                         {
                             /* replace only changed bytes in array of multibyte char */
-                            corr_buf[cnt] = curr->value;
-                            curr = curr->next;
+                            corr_buf[cnt] = corr->data->data[from + cnt - corr->offset];
+                            curr = corr;
                         }
                     }
                     corr_buf[res] = '\0';
                     /* Determine the state of the current multibyte char */
                     ch = utf8_to_int ((char *) corr_buf, &cw, &read_res);
-                    curr = corr;
                 }
             }
 #endif /* HAVE_CHARSET */
@@ -233,14 +338,12 @@ mcview_display_hex (mcview_t * view)
             }
 
             /* Determine the state of the current byte */
+            curr = mcview_hex_get_change (view, curr, from);
             boldflag = mcview_hex_calculate_boldflag (view, from, curr);
 
             /* Determine the value of the current byte */
-            if (curr != NULL && from == curr->offset)
-            {
-                c = curr->value;
-                curr = curr->next;
-            }
+            if (curr != NULL)
+                c = curr->data->data[from - curr->offset];
 
             /* Select the color for the hex number */
             tty_setcolor (boldflag == MARK_NORMAL ? VIEW_NORMAL_COLOR :
@@ -302,13 +405,14 @@ mcview_display_hex (mcview_t * view)
             {
                 if (!view->utf8)
                 {
-                    c = convert_from_8bit_to_utf_c ((unsigned char) c, view->converter);
+                    c = convert_from_8bit_to_utf_t (view->cp_table, (unsigned char) c,
+                                                    view->converter);
                 }
                 if (!g_unichar_isprint (c))
                     c = '.';
             }
             else if (view->utf8)
-                ch = convert_from_utf_to_current_c (ch, view->converter);
+                ch = convert_from_utf_to_current_t (display_table, ch, view->converter);
             else
 #endif
             {
@@ -355,14 +459,13 @@ mcview_hexedit_save_changes (mcview_t * view)
 {
     int answer = 0;
 
-    if (view->change_list == NULL)
+    if (view->changes == NULL)
         return TRUE;
 
     while (answer == 0)
     {
         int fp;
         char *text;
-        struct hexedit_change_node *curr, *next;
 
 #ifdef HAVE_ASSERT_H
         assert (view->filename_vpath != NULL);
@@ -371,22 +474,16 @@ mcview_hexedit_save_changes (mcview_t * view)
         fp = mc_open (view->filename_vpath, O_WRONLY);
         if (fp != -1)
         {
-            for (curr = view->change_list; curr != NULL; curr = next)
-            {
-                next = curr->next;
+            hexedit_save_t save = { view, fp, FALSE };
 
-                if (mc_lseek (fp, curr->offset, SEEK_SET) == -1
-                    || mc_write (fp, &(curr->value), 1) != 1)
-                    goto save_error;
-
-                /* delete the saved item from the change list */
-                view->change_list = next;
-                view->dirty++;
-                mcview_set_byte (view, curr->offset, curr->value);
-                g_free (curr);
-            }
+            /* adjacent changes are merged to ranges, every range is written at once */
+            g_tree_foreach (view->changes, mcview_hexedit_save_change, &save);
+            if (save.error)
+                goto save_error;
 
-            view->change_list = NULL;
+            g_tree_destroy (view->changes);
+            view->changes = NULL;
+            mcview_nroff_index_free (view);
 
             if (view->locked)
                 view->locked = unlock_file (view->filename_vpath);
@@ -426,14 +523,11 @@ mcview_toggle_hexedit_mode (mcview_t * view)
 void
 mcview_hexedit_free_change_list (mcview_t * view)
 {
-    struct hexedit_change_node *curr, *next;
-
-    for (curr = view->change_list; curr != NULL; curr = next)
+    if (view->changes != NULL)
     {
-        next = curr->next;
-        g_free (curr);
+        g_tree_destroy (view->changes);
+        view->changes = NULL;
     }
-    view->change_list = NULL;
 
     if (view->locked)
         view->locked = unlock_file (view->filename_vpath);
@@ -443,19 +537,183 @@ mcview_hexedit_free_change_list (mcview_t * view)
 
 /* --------------------------------------------------------------------------------------------- */
 
+/**
+ * Find range of changes containing the byte.
+ *
+ * @param view viewer object
+ * @param offset offset of byte
+ *
+ * @return range or NULL if byte isn't changed
+ */
+
+struct hexedit_change_node *
+mcview_hexedit_find_change (mcview_t * view, off_t offset)
+{
+    hexedit_range_t range = { offset, offset + 1 };
+
+    if (view->changes == NULL)
+        return NULL;
+
+    return (struct hexedit_change_node *) g_tree_search (view->changes,
+                                                         mcview_hexedit_change_search, &range);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Change bytes of file. Ranges of changes overlapping or adjacent to new one are merged with it.
+ *
+ * @param view viewer object
+ * @param offset offset of the first byte
+ * @param data new values of bytes
+ * @param len number of bytes
+ */
+
+void
+mcview_hexedit_set_bytes (mcview_t * view, off_t offset, const byte * data, size_t len)
+{
+    hexedit_range_t range;
+    struct hexedit_change_node *node = NULL, *other;
+    GSList *merged = NULL, *m;
+    off_t end;
+
+    if (len == 0)
+        return;
+
+    if (view->changes == NULL)
+    {
+        if (view->filename_vpath != NULL
+            && *(vfs_path_get_last_path_str (view->filename_vpath)) != '\0')
+            view->locked = lock_file (view->filename_vpath);
+
+        view->changes = g_tree_new_full (mcview_hexedit_change_cmp, NULL,
+                                         mcview_hexedit_change_free, NULL);
+    }
+
+    end = offset + (off_t) len;
+
+    /* take out all ranges to be merged */
+    range.start = offset - 1;
+    range.end = end + 1;
+    while ((other = g_tree_search (view->changes, mcview_hexedit_change_search, &range)) != NULL)
+    {
+        g_tree_steal (view->changes, other);
+
+        /* range started before new bytes is extended, the others are copied to it */
+        if (other->offset <= offset && (node == NULL || other->offset < node->offset))
+        {
+            if (node != NULL)
+                merged = g_slist_prepend (merged, node);
+            node = other;
+        }
+        else
+            merged = g_slist_prepend (merged, other);
+    }
+
+    if (node == NULL)
+    {
+        node = g_new (struct hexedit_change_node, 1);
+        node->offset = offset;
+        node->data = g_byte_array_sized_new (len);
+    }
+
+    for (m = merged; m != NULL; m = g_slist_next (m))
+    {
+        other = (struct hexedit_change_node *) m->data;
+        if (other->offset + (off_t) other->data->len > end)
+            end = other->offset + (off_t) other->data->len;
+    }
+
+    if (node->offset + (off_t) node->data->len < end)
+        g_byte_array_set_size (node->data, (guint) (end - node->offset));
+
+    for (m = merged; m != NULL; m = g_slist_next (m))
+    {
+        other = (struct hexedit_change_node *) m->data;
+        memcpy (node->data->data + (other->offset - node->offset), other->data->data,
+                other->data->len);
+        mcview_hexedit_change_free (other);
+    }
+    g_slist_free (merged);
+
+    memcpy (node->data->data + (offset - node->offset), data, len);
+
+    g_tree_insert (view->changes, node, node);
+    view->dirty++;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Fill bytes from the cursor position with repeated pattern. File size isn't changed.
+ *
+ * @param view viewer object
+ * @param pattern bytes of pattern
+ * @param count number of bytes to fill
+ */
+
 void
-mcview_enqueue_change (struct hexedit_change_node **head, struct hexedit_change_node *node)
+mcview_hexedit_fill_bytes (mcview_t * view, const GByteArray * pattern, off_t count)
 {
-    /* chnode always either points to the head of the list or
-     * to one of the ->next fields in the list. The value at
-     * this location will be overwritten with the new node.   */
-    struct hexedit_change_node **chnode = head;
+    off_t left;
+
+    left = mcview_get_filesize (view) - view->hex_cursor;
+    if (count > left)
+        count = left;
+
+    if (count > 0 && pattern->len != 0)
+    {
+        byte *block;
+        off_t i;
+
+        block = g_malloc ((size_t) count);
+        for (i = 0; i < count; i++)
+            block[i] = pattern->data[i % pattern->len];
+        mcview_hexedit_set_bytes (view, view->hex_cursor, block, (size_t) count);
+        g_free (block);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Fill bytes from the cursor position with pattern entered in dialog */
 
-    while (*chnode != NULL && (*chnode)->offset < node->offset)
-        chnode = &((*chnode)->next);
+void
+mcview_hexedit_fill (mcview_t * view)
+{
+    GByteArray *pattern = NULL;
+    off_t count;
+
+    if (mcview_dialog_fill (&pattern, &count))
+        mcview_hexedit_fill_bytes (view, pattern, count);
+
+    if (pattern != NULL)
+        g_byte_array_free (pattern, TRUE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Overwrite bytes from the cursor position with contents of clipboard file */
+
+void
+mcview_hexedit_paste (mcview_t * view)
+{
+    char *clip_name;
+    gchar *contents;
+    gsize len;
+
+    clip_name = mc_config_get_full_path (EDIT_CLIP_FILE);
+
+    if (g_file_get_contents (clip_name, &contents, &len, NULL))
+    {
+        off_t left;
+
+        /* file size isn't changed */
+        left = mcview_get_filesize (view) - view->hex_cursor;
+        if ((off_t) len > left)
+            len = (gsize) MAX (left, 0);
+
+        mcview_hexedit_set_bytes (view, view->hex_cursor, (const byte *) contents, len);
+        g_free (contents);
+    }
 
-    node->next = *chnode;
-    *chnode = node;
+    g_free (clip_name);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -10,6 +10,9 @@
 #include "lib/search.h"
 #include "lib/widget.h"
 #include "lib/vfs/vfs.h"        /* vfs_path_t */
+#ifdef HAVE_CHARSET
+#include "lib/charsets.h"       /* codepage_table_t */
+#endif
 
 #include "src/keybind-defaults.h"       /* global_keymap_t */
 #include "src/filemanager/dir.h"        /* dir_list */
@@ -53,12 +56,11 @@ typedef enum
 
 /*** structures declarations (and typedefs of structures)*****************************************/
 
-/* A node for building a change list on change_list */
+/* A range of bytes changed in hexedit mode, a node of change tree */
 struct hexedit_change_node
 {
-    struct hexedit_change_node *next;
-    off_t offset;
-    byte value;
+    off_t offset;               /* offset of the first byte */
+    GByteArray *data;           /* new values of bytes */
 };
 
 struct area
@@ -88,6 +90,7 @@ typedef struct
 } coord_cache_t;
 
 struct mcview_nroff_struct;
+struct mcview_nroff_index_struct;
 
 struct mcview_struct
 {
@@ -137,6 +140,7 @@ struct mcview_struct
     gboolean utf8;              /* It's multibyte file codeset */
 
     coord_cache_t *coord_cache; /* Cache for mapping offsets to cursor positions */
+    struct mcview_nroff_index_struct *nroff_index;      /* Nroff sequences found in data */
 
     /* Display information */
     screen_dimen dpy_frame_size;        /* Size of the frame surrounding the real viewer */
@@ -147,7 +151,7 @@ struct mcview_struct
     off_t hex_cursor;           /* Hexview cursor position in file */
     screen_dimen cursor_col;    /* Cursor column */
     screen_dimen cursor_row;    /* Cursor row */
-    struct hexedit_change_node *change_list;    /* Linked list of changes */
+    GTree *changes;             /* Non-overlapping ranges of changes sorted by offset */
     struct area status_area;    /* Where the status line is displayed */
     struct area ruler_area;     /* Where the ruler is displayed */
     struct area data_area;      /* Where the data is displayed */
@@ -172,6 +176,10 @@ struct mcview_struct
 
     /* converter for translation of text */
     GIConv converter;
+#ifdef HAVE_CHARSET
+    /* precomputed tables of 8-bit file codeset, NULL if not available */
+    const codepage_table_t *cp_table;
+#endif
 
     /* handle of search engine */
     mc_search_t *search;
@@ -250,6 +258,7 @@ void mcview_set_datasource_string (mcview_t *, const char *);
 /* dialog.c: */
 gboolean mcview_dialog_search (mcview_t * view);
 gboolean mcview_dialog_goto (mcview_t * view, off_t * offset);
+gboolean mcview_dialog_fill (GByteArray ** pattern, off_t * count);
 
 /* display.c: */
 void mcview_update (mcview_t * view);
@@ -273,7 +282,11 @@ void mcview_display_hex (mcview_t * view);
 gboolean mcview_hexedit_save_changes (mcview_t * view);
 void mcview_toggle_hexedit_mode (mcview_t * view);
 void mcview_hexedit_free_change_list (mcview_t * view);
-void mcview_enqueue_change (struct hexedit_change_node **, struct hexedit_change_node *);
+struct hexedit_change_node *mcview_hexedit_find_change (mcview_t * view, off_t offset);
+void mcview_hexedit_set_bytes (mcview_t * view, off_t offset, const byte * data, size_t len);
+void mcview_hexedit_fill_bytes (mcview_t * view, const GByteArray * pattern, off_t count);
+void mcview_hexedit_fill (mcview_t * view);
+void mcview_hexedit_paste (mcview_t * view);
 
 /* lib.c: */
 void mcview_toggle_magic_mode (mcview_t * view);
@@ -316,6 +329,7 @@ void mcview_nroff_seq_free (mcview_nroff_t **);
 nroff_type_t mcview_nroff_seq_info (mcview_nroff_t *);
 int mcview_nroff_seq_next (mcview_nroff_t *);
 int mcview_nroff_seq_prev (mcview_nroff_t *);
+void mcview_nroff_index_free (mcview_t * view);
 
 
 /* plain.c: */
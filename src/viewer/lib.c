@@ -168,6 +168,7 @@ mcview_init (mcview_t * view)
     view->hexedit_lownibble = FALSE;
     view->locked = FALSE;
     view->coord_cache = NULL;
+    view->nroff_index = NULL;
 
     view->dpy_start = 0;
     view->dpy_text_column = 0;
@@ -175,7 +176,7 @@ mcview_init (mcview_t * view)
     view->hex_cursor = 0;
     view->cursor_col = 0;
     view->cursor_row = 0;
-    view->change_list = NULL;
+    view->changes = NULL;
 
     /* {status,ruler,data}_area are left uninitialized */
 
@@ -268,6 +269,9 @@ mcview_set_codeset (mcview_t * view)
 #ifdef HAVE_CHARSET
     const char *cp_id = NULL;
 
+    /* width of chars in nroff sequences can be changed */
+    mcview_nroff_index_free (view);
+
     view->utf8 = TRUE;
     cp_id =
         get_codepage_id (mc_global.source_codepage >=
@@ -283,6 +287,7 @@ mcview_set_codeset (mcview_t * view)
             view->converter = conv;
         }
         view->utf8 = (gboolean) str_isutf8 (cp_id);
+        view->cp_table = get_codepage_table (get_codepage_index (cp_id));
     }
 #else
     (void) view;
@@ -391,7 +396,7 @@ char *
 mcview_get_title (const WDialog * h, size_t len)
 {
     const mcview_t *view = (const mcview_t *) find_widget_type (h, mcview_callback);
-    const char *modified = view->hexedit_mode && (view->change_list != NULL) ? "(*) " : "    ";
+    const char *modified = view->hexedit_mode && (view->changes != NULL) ? "(*) " : "    ";
     const char *file_label;
     const char *view_filename;
     char *ret_str;
@@ -209,6 +209,9 @@ mcview_new (int y, int x, int lines, int cols, gboolean is_panel)
 
     view->dpy_frame_size = is_panel ? 1 : 0;
     view->converter = str_cnv_from_term;
+#ifdef HAVE_CHARSET
+    view->cp_table = NULL;
+#endif
 
     mcview_init (view);
 
@@ -428,7 +431,7 @@ mcview_load (mcview_t * view, const char *command, const char *file, int start_l
 
     view->hexedit_lownibble = FALSE;
     view->hexview_in_text = FALSE;
-    view->change_list = NULL;
+    view->changes = NULL;
     vfs_path_free (vpath);
     return retval;
 }
@@ -45,13 +45,53 @@
 #include "src/setup.h"          /* option_tab_spacing */
 
 #include "internal.h"
+#include "inlines.h"        /* mcview_may_still_grow() */
 
 /*** global variables ****************************************************************************/
 
 /*** file scope macro definitions ****************************************************************/
 
+/* number of bytes indexed at once */
+#define NROFF_INDEX_BLOCK (64 * 1024)
+
+/* the longest nroff sequence: char, backspace and char again */
+#define NROFF_SEQ_MAX (2 * UTF8_CHAR_LEN + 1)
+
 /*** file scope type declarations ****************************************************************/
 
+/* run of adjacent nroff sequences of the same type and length */
+typedef struct
+{
+    off_t offset;               /* offset of the first sequence */
+    off_t extra;                /* number of overstrike bytes before the run in the chunk */
+    guint32 count;              /* number of sequences */
+    guint8 unit;                /* length of every sequence */
+    guint8 overhead;            /* number of overstrike bytes in every sequence */
+    guint8 type;                /* nroff_type_t */
+} nroff_span_t;
+
+/* Sequences of one block. Indexing starts at the first line of block: state of nroff decoder
+ * is reset by newline, so block is indexed without reading data before it. It ends at the
+ * first line which starts in the next block, so chunks of adjacent blocks join. */
+typedef struct
+{
+    off_t start;                /* offset of the first indexed byte */
+    off_t end;                  /* offset after the last indexed sequence, start if none */
+    off_t extra;                /* number of overstrike bytes in the chunk */
+    GArray *spans;              /* runs of sequences sorted by offset */
+    guint cursor;               /* the last found run */
+} nroff_chunk_t;
+
+/* Index of nroff sequences built lazily by blocks around the offsets in use.
+ * Offsets of text shown without overstrike bytes are called display offsets,
+ * they are counted from the start of chunk. */
+struct mcview_nroff_index_struct
+{
+    GPtrArray *chunks;          /* chunks by block number, NULL if block isn't indexed yet */
+};
+
+typedef struct mcview_nroff_index_struct mcview_nroff_index_t;
+
 /*** file scope variables ************************************************************************/
 
 /*** file scope functions ************************************************************************/
@@ -87,6 +127,371 @@ mcview_nroff_get_char (mcview_nroff_t * nroff, int *ret_val, off_t nroff_index)
     return g_unichar_isprint (c);
 }
 
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+mcview_nroff_chunk_add (nroff_chunk_t * chunk, off_t offset, int unit, int overhead,
+                        nroff_type_t type)
+{
+    nroff_span_t span;
+
+    if (chunk->spans->len != 0)
+    {
+        nroff_span_t *last;
+
+        last = &g_array_index (chunk->spans, nroff_span_t, chunk->spans->len - 1);
+        if (last->type == type && last->unit == unit && last->overhead == overhead
+            && last->offset + (off_t) last->count * unit == offset && last->count < G_MAXUINT32)
+        {
+            last->count++;
+            chunk->extra += overhead;
+            return;
+        }
+    }
+
+    span.offset = offset;
+    span.extra = chunk->extra;
+    span.count = 1;
+    span.unit = (guint8) unit;
+    span.overhead = (guint8) overhead;
+    span.type = (guint8) type;
+    g_array_append_val (chunk->spans, span);
+
+    chunk->extra += overhead;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+mcview_nroff_chunk_free (gpointer data, gpointer user_data)
+{
+    nroff_chunk_t *chunk = (nroff_chunk_t *) data;
+
+    (void) user_data;
+
+    if (chunk != NULL)
+    {
+        g_array_free (chunk->spans, TRUE);
+        g_free (chunk);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Index sequences of one block. They are found by the same way as mcview_nroff_seq_next()
+ * does it from the start of data: newline is never a part of sequence and the sequence
+ * after it doesn't depend on the previous one.
+ * Indexing stops at the end of the next block if there is no newline in it.
+ * Data of pipe is indexed only if it is already read.
+ *
+ * @return chunk or NULL if data isn't available yet
+ */
+
+static nroff_chunk_t *
+mcview_nroff_chunk_build (mcview_t * view, off_t block)
+{
+    nroff_chunk_t *chunk;
+    mcview_nroff_t nroff;
+    off_t limit, cap, start;
+    gboolean line_start = TRUE;
+    int c;
+
+    start = block * NROFF_INDEX_BLOCK;
+    limit = start + NROFF_INDEX_BLOCK;
+    cap = limit + NROFF_INDEX_BLOCK;
+
+    /* don't wait for data of pipe: sequence at the end of chunk must be read completely */
+    if (mcview_may_still_grow (view) && mcview_get_filesize (view) < cap + NROFF_SEQ_MAX)
+        return NULL;
+
+    /* find the first line of block */
+    if (start != 0)
+    {
+        off_t line;
+
+        for (line = start; line < limit; line++)
+            if (!mcview_get_byte (view, line - 1, &c))
+            {
+                line = limit;
+                break;
+            }
+            else if (c == '\n')
+                break;
+
+        start = line;
+    }
+
+    chunk = g_new0 (nroff_chunk_t, 1);
+    chunk->spans = g_array_new (FALSE, FALSE, sizeof (nroff_span_t));
+    chunk->start = start;
+    chunk->end = start;
+
+    if (start >= limit)
+        return chunk;
+
+    memset (&nroff, 0, sizeof (nroff));
+    nroff.view = view;
+    nroff.index = start;
+    mcview_nroff_seq_info (&nroff);
+
+    while (!(nroff.index >= limit && (line_start || nroff.index >= cap)))
+    {
+        off_t offset = nroff.index;
+        nroff_type_t type = nroff.type;
+        int overhead;
+
+        if (!mcview_get_byte (view, offset, &c))
+            break;
+
+        overhead = (type == NROFF_TYPE_BOLD) ? 1 + nroff.char_width : 2;
+        mcview_nroff_seq_next (&nroff);
+
+        if (type != NROFF_TYPE_NONE)
+            mcview_nroff_chunk_add (chunk, offset, (int) (nroff.index - offset), overhead, type);
+
+        line_start = (type == NROFF_TYPE_NONE && c == '\n');
+    }
+
+    chunk->end = nroff.index;
+    return chunk;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Get chunk of block, index block if it isn't indexed yet */
+
+static nroff_chunk_t *
+mcview_nroff_index_block (mcview_t * view, off_t block)
+{
+    mcview_nroff_index_t *idx = view->nroff_index;
+    nroff_chunk_t *chunk;
+
+    if (idx == NULL)
+    {
+        idx = g_new0 (mcview_nroff_index_t, 1);
+        idx->chunks = g_ptr_array_new ();
+        view->nroff_index = idx;
+    }
+
+    if (block < (off_t) idx->chunks->len)
+    {
+        chunk = (nroff_chunk_t *) g_ptr_array_index (idx->chunks, block);
+        if (chunk != NULL)
+            return chunk;
+    }
+
+    chunk = mcview_nroff_chunk_build (view, block);
+    if (chunk != NULL)
+    {
+        if (block >= (off_t) idx->chunks->len)
+            g_ptr_array_set_size (idx->chunks, block + 1);
+        g_ptr_array_index (idx->chunks, block) = chunk;
+    }
+
+    return chunk;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get chunk which contains offset. It is the chunk of block of offset or, for the head of block
+ * before its first line, the chunk of the previous block. At most two blocks are indexed.
+ *
+ * @return chunk or NULL if offset isn't indexed
+ */
+
+static nroff_chunk_t *
+mcview_nroff_index_chunk (mcview_t * view, off_t offset)
+{
+    off_t block;
+    nroff_chunk_t *chunk;
+
+    if (offset < 0)
+        return NULL;
+
+    block = offset / NROFF_INDEX_BLOCK;
+
+    chunk = mcview_nroff_index_block (view, block);
+    if (chunk == NULL)
+        return NULL;
+    if (chunk->start <= offset && offset < chunk->end)
+        return chunk;
+    if (chunk->start <= offset || block == 0)
+        return NULL;
+
+    chunk = mcview_nroff_index_block (view, block - 1);
+    if (chunk != NULL && chunk->start <= offset && offset < chunk->end)
+        return chunk;
+
+    return NULL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Find the last run starting at or before offset */
+
+static const nroff_span_t *
+mcview_nroff_chunk_find (nroff_chunk_t * chunk, off_t offset)
+{
+    const nroff_span_t *spans = (const nroff_span_t *) chunk->spans->data;
+    guint lo, hi;
+
+    if (chunk->spans->len == 0 || spans[0].offset > offset)
+        return NULL;
+
+    /* text is mostly read sequentially */
+    lo = chunk->cursor;
+    if (lo < chunk->spans->len && spans[lo].offset <= offset
+        && (lo + 1 == chunk->spans->len || spans[lo + 1].offset > offset))
+        return &spans[lo];
+
+    lo = 0;
+    hi = chunk->spans->len;
+    while (hi - lo > 1)
+    {
+        guint mid = lo + (hi - lo) / 2;
+
+        if (spans[mid].offset <= offset)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    chunk->cursor = lo;
+    return &spans[lo];
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get number of overstrike bytes in the chunk before offset.
+ *
+ * @return FALSE if offset lies inside of nroff sequence
+ */
+
+static gboolean
+mcview_nroff_chunk_extra (nroff_chunk_t * chunk, off_t offset, off_t * extra)
+{
+    const nroff_span_t *span;
+    off_t n;
+
+    span = mcview_nroff_chunk_find (chunk, offset);
+    if (span == NULL)
+    {
+        *extra = 0;
+        return TRUE;
+    }
+
+    n = (offset - span->offset) / span->unit;
+    if (n >= (off_t) span->count)
+        n = span->count;
+    else if ((offset - span->offset) % span->unit != 0)
+        return FALSE;
+
+    *extra = span->extra + n * span->overhead;
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Get number of overstrike bytes in sequences of the chunk shown before display offset */
+
+static off_t
+mcview_nroff_chunk_display_extra (const nroff_chunk_t * chunk, off_t display_offset)
+{
+    const nroff_span_t *spans = (const nroff_span_t *) chunk->spans->data;
+    const nroff_span_t *span;
+    guint lo = 0, hi = chunk->spans->len;
+    off_t start, width, n;
+
+    if (hi == 0 || spans[0].offset - chunk->start - spans[0].extra >= display_offset)
+        return 0;
+
+    while (hi - lo > 1)
+    {
+        guint mid = lo + (hi - lo) / 2;
+
+        if (spans[mid].offset - chunk->start - spans[mid].extra < display_offset)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    span = &spans[lo];
+    start = span->offset - chunk->start - span->extra;
+    width = span->unit - span->overhead;
+    n = (display_offset - start + width - 1) / width;
+    if (n > (off_t) span->count)
+        n = span->count;
+
+    return span->extra + n * span->overhead;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get number of overstrike bytes in the shown text of given length using index.
+ *
+ * @return FALSE if some part of text isn't indexed
+ */
+
+static gboolean
+mcview_nroff_index_real_len (mcview_t * view, off_t start, off_t length, off_t * ret)
+{
+    *ret = 0;
+
+    while (length > 0)
+    {
+        nroff_chunk_t *chunk;
+        off_t extra, display_start, display_len;
+
+        chunk = mcview_nroff_index_chunk (view, start);
+        if (chunk == NULL || !mcview_nroff_chunk_extra (chunk, start, &extra))
+            return FALSE;
+
+        display_start = start - chunk->start - extra;
+        display_len = chunk->end - chunk->start - chunk->extra;
+
+        if (display_start + length <= display_len)
+        {
+            *ret += mcview_nroff_chunk_display_extra (chunk, display_start + length) - extra;
+            break;
+        }
+
+        /* text goes on in the next chunk */
+        *ret += chunk->extra - extra;
+        length -= display_len - display_start;
+        start = chunk->end;
+    }
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Check whether nroff sequence starts at offset.
+ *
+ * @return length of sequence or 0
+ */
+
+static int
+mcview_nroff_index_sequence (mcview_t * view, off_t offset, nroff_type_t * type, int *overhead)
+{
+    nroff_chunk_t *chunk;
+    const nroff_span_t *span;
+    off_t rel;
+
+    chunk = mcview_nroff_index_chunk (view, offset);
+    if (chunk == NULL)
+        return 0;
+
+    span = mcview_nroff_chunk_find (chunk, offset);
+    if (span == NULL)
+        return 0;
+
+    rel = offset - span->offset;
+    if (rel >= (off_t) span->count * span->unit || rel % span->unit != 0)
+        return 0;
+
+    *type = (nroff_type_t) span->type;
+    *overhead = span->overhead;
+    return span->unit;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /*** public functions ****************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -104,40 +509,49 @@ mcview_display_nroff (mcview_t * view)
     int c;
     int c_prev = 0;
     int c_next = 0;
-    struct hexedit_change_node *curr = view->change_list;
+#ifdef HAVE_CHARSET
+    const codepage_table_t *display_table = get_codepage_table (mc_global.display_codepage);
+#endif
 
     mcview_display_clean (view);
     mcview_display_ruler (view);
 
-    /* Find the first displayable changed byte */
     from = view->dpy_start;
-    while (curr && (curr->offset < from))
-    {
-        curr = curr->next;
-    }
 
     tty_setcolor (VIEW_NORMAL_COLOR);
     for (row = 0, col = 0; row < height;)
     {
+        nroff_type_t type = NROFF_TYPE_NONE;
+        int overhead = 0;
+        int seq_len;
+
+        /* show known nroff sequence as one char */
+        seq_len = mcview_nroff_index_sequence (view, from, &type, &overhead);
+
 #ifdef HAVE_CHARSET
         if (view->utf8)
         {
             gboolean read_res = TRUE;
-            c = mcview_get_utf (view, from, &cw, &read_res);
+            c = mcview_get_utf (view, from + overhead, &cw, &read_res);
             if (!read_res)
                 break;
         }
         else
 #endif
         {
-            if (!mcview_get_byte (view, from, &c))
+            if (!mcview_get_byte (view, from + overhead, &c))
                 break;
         }
         from++;
         if (cw > 1)
             from += cw - 1;
 
-        if (c == '\b')
+        if (seq_len != 0)
+        {
+            from += overhead;
+            tty_setcolor (type == NROFF_TYPE_UNDERLINE ? VIEW_UNDERLINED_COLOR : VIEW_BOLD_COLOR);
+        }
+        else if (c == '\b')
         {
             if (from > 1)
             {
@@ -223,13 +637,14 @@ mcview_display_nroff (mcview_t * view)
             {
                 if (!view->utf8)
                 {
-                    c = convert_from_8bit_to_utf_c ((unsigned char) c, view->converter);
+                    c = convert_from_8bit_to_utf_t (view->cp_table, (unsigned char) c,
+                                                    view->converter);
                 }
                 if (!g_unichar_isprint (c))
                     c = '.';
             }
             else if (view->utf8)
-                c = convert_from_utf_to_current_c (c, view->converter);
+                c = convert_from_utf_to_current_t (display_table, c, view->converter);
             else
                 c = convert_to_display_c (c);
 #endif
@@ -259,9 +674,17 @@ mcview__get_nroff_real_len (mcview_t * view, off_t start, off_t length)
     int ret = 0;
     off_t i = 0;
 
-    if (!view->text_nroff_mode)
+    if (!view->text_nroff_mode || length <= 0)
         return 0;
 
+    /* overstrike bytes in the shown text of given length */
+    {
+        off_t extra;
+
+        if (mcview_nroff_index_real_len (view, start, length, &extra))
+            return (int) extra;
+    }
+
     nroff = mcview_nroff_seq_new_num (view, start);
     if (nroff == NULL)
         return 0;
@@ -323,6 +746,21 @@ mcview_nroff_seq_free (mcview_nroff_t ** nroff)
     *nroff = NULL;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/** Drop index of nroff sequences if data or its encoding is changed */
+
+void
+mcview_nroff_index_free (mcview_t * view)
+{
+    if (view->nroff_index != NULL)
+    {
+        g_ptr_array_foreach (view->nroff_index->chunks, mcview_nroff_chunk_free, NULL);
+        g_ptr_array_free (view->nroff_index->chunks, TRUE);
+        g_free (view->nroff_index);
+        view->nroff_index = NULL;
+    }
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 nroff_type_t
@@ -53,11 +53,69 @@
 
 /*** file scope type declarations ****************************************************************/
 
+/* characters of screen row collected to be printed at once */
+typedef struct
+{
+    tty_cell_t *cells;
+    int len;
+    int size;
+    screen_dimen row;
+    off_t col;                  /* column of the first cell */
+    off_t end;                  /* column next to the last cell */
+} mcview_row_t;
+
 /*** file scope variables ************************************************************************/
 
 /*** file scope functions ************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
 
+static void
+mcview_row_flush (mcview_t * view, mcview_row_t * r)
+{
+    if (r->len != 0)
+    {
+        widget_move (view, view->data_area.top + r->row, view->data_area.left + r->col);
+        tty_print_cells (r->cells, r->len);
+        r->len = 0;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Add character to the row.
+ *
+ * @param col screen column relative to the data area
+ * @param width number of columns the character takes
+ */
+
+static void
+mcview_row_add (mcview_t * view, mcview_row_t * r, screen_dimen row, off_t col, int width,
+                int c, int color)
+{
+    if (r->len != 0 && (row != r->row || col < r->end || r->len + (col - r->end) >= r->size))
+        mcview_row_flush (view, r);
+
+    if (r->len == 0)
+    {
+        r->row = row;
+        r->col = col;
+        r->end = col;
+    }
+
+    /* skipped columns (tabs) are blank */
+    for (; r->end < col; r->end++)
+    {
+        r->cells[r->len].ch = ' ';
+        r->cells[r->len].color = VIEW_NORMAL_COLOR;
+        r->len++;
+    }
+
+    r->cells[r->len].ch = c;
+    r->cells[r->len].color = color;
+    r->len++;
+    r->end += width;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /*** public functions ****************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -74,15 +132,20 @@ mcview_display_text (mcview_t * view)
     int cw = 1;
     int c, prev_ch = 0;
     gboolean last_row = TRUE;
-    struct hexedit_change_node *curr = view->change_list;
+    mcview_row_t r;
+#ifdef HAVE_CHARSET
+    const codepage_table_t *display_table = get_codepage_table (mc_global.display_codepage);
+#endif
 
     mcview_display_clean (view);
     mcview_display_ruler (view);
 
-    /* Find the first displayable changed byte */
+    /* wide and combining characters can take less than one column per cell */
+    r.size = width + 16;
+    r.cells = g_new (tty_cell_t, r.size);
+    r.len = 0;
+
     from = view->dpy_start;
-    while ((curr != NULL) && (curr->offset < from))
-        curr = curr->next;
 
     while (row < height)
     {
@@ -143,26 +206,27 @@ mcview_display_text (mcview_t * view)
             continue;
         }
 
-        if (view->search_start <= from && from < view->search_end)
-            tty_setcolor (SELECTED_COLOR);
-        else
-            tty_setcolor (VIEW_NORMAL_COLOR);
-
         if (((off_t) col >= view->dpy_text_column)
             && ((off_t) col - view->dpy_text_column < (off_t) width))
         {
-            widget_move (view, top + row, left + ((off_t) col - view->dpy_text_column));
+            int color, cols = 1;
+
+            if (view->search_start <= from && from < view->search_end)
+                color = SELECTED_COLOR;
+            else
+                color = VIEW_NORMAL_COLOR;
 
 #ifdef HAVE_CHARSET
             if (mc_global.utf8_display)
             {
                 if (!view->utf8)
-                    c = convert_from_8bit_to_utf_c ((unsigned char) c, view->converter);
+                    c = convert_from_8bit_to_utf_t (view->cp_table, (unsigned char) c,
+                                                    view->converter);
                 if (!g_unichar_isprint (c))
                     c = '.';
             }
             else if (view->utf8)
-                c = convert_from_utf_to_current_c (c, view->converter);
+                c = convert_from_utf_to_current_t (display_table, c, view->converter);
             else
             {
                 c = convert_to_display_c (c);
@@ -174,7 +238,16 @@ mcview_display_text (mcview_t * view)
                 c = '.';
 #endif /* HAVE_CHARSET */
 
-            tty_print_anychar (c);
+#ifdef HAVE_CHARSET
+            if (view->utf8)
+            {
+                if (g_unichar_iswide (c))
+                    cols = 2;
+                else if (g_unichar_iszerowidth (c))
+                    cols = 0;
+            }
+#endif
+            mcview_row_add (view, &r, row, (off_t) col - view->dpy_text_column, cols, c, color);
         }
 
         col++;
@@ -190,6 +263,9 @@ mcview_display_text (mcview_t * view)
 #endif
     }
 
+    mcview_row_flush (view, &r);
+    g_free (r.cells);
+
     view->dpy_end = from;
     if (mcview_show_eof != NULL && mcview_show_eof[0] != '\0')
     {
@@ -0,0 +1,672 @@
+/*
+   Deterministic synthetic fixtures for benchmarks.
+
+   Copyright (C) 2014
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \file fixtures.c
+ *  \brief Source: deterministic synthetic fixtures for benchmarks
+ *
+ *  All fixtures are generated from a fixed seed, so the same build produces byte-identical
+ *  trees, files and archives on every run and timings of different commits are comparable.
+ */
+
+#include <config.h>
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include "lib/global.h"
+
+#include "fixtures.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+#define FIXTURE_BUF_SIZE 65536
+
+/* fixed mtime of all generated entries: 2014-01-01 00:00:00 UTC */
+#define FIXTURE_MTIME 1388534400
+
+#define TAR_BLOCK_SIZE 512
+
+/*** file scope type declarations ****************************************************************/
+
+/*** file scope variables ************************************************************************/
+
+static guint32 fixture_state = 1;
+
+static const char *const fixture_syllables[] = {
+    "ba", "ko", "mi", "re", "tu", "sa", "li", "no", "ve", "da", "xo", "pe", "qu", "zi", "fa", "go"
+};
+
+static const char *const fixture_extensions[] = {
+    ".c", ".h", ".txt", ".tar.gz", ".jpg", ".o", ".so", "", ".sh", ".html", ".py", ".mp3",
+    ".png", ".deb", ".log", "~"
+};
+
+static const char *const fixture_words[] = {
+    "the", "midnight", "commander", "file", "panel", "viewer", "editor", "directory",
+    "archive", "search", "copy", "move", "delete", "select", "pattern", "buffer",
+    "a", "of", "to", "and", "is", "in", "for", "with"
+};
+
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+fixture_write_all (int fd, const void *buf, size_t len)
+{
+    const char *p = (const char *) buf;
+
+    while (len != 0)
+    {
+        ssize_t n;
+
+        n = write (fd, p, len);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return FALSE;
+        }
+
+        p += n;
+        len -= (size_t) n;
+    }
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+fixture_fill (char *buf, size_t len)
+{
+    size_t i;
+
+    for (i = 0; i < len; i++)
+        buf[i] = (char) (fixture_random () >> 24);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+fixture_write_random (int fd, off_t size)
+{
+    char buf[FIXTURE_BUF_SIZE];
+
+    while (size > 0)
+    {
+        size_t n;
+
+        n = (size_t) MIN (size, (off_t) sizeof (buf));
+        fixture_fill (buf, n);
+        if (!fixture_write_all (fd, buf, n))
+            return FALSE;
+        size -= (off_t) n;
+    }
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+fixture_make_file (const char *path, off_t size, mode_t mode)
+{
+    struct utimbuf times = { FIXTURE_MTIME, FIXTURE_MTIME };
+    int fd;
+    gboolean ret;
+
+    fd = open (path, O_WRONLY | O_CREAT | O_TRUNC, mode);
+    if (fd == -1)
+        return FALSE;
+
+    ret = fixture_write_random (fd, size);
+    ret = (close (fd) == 0) && ret;
+
+    return ret && utime (path, &times) == 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** ustar header of one archive member */
+
+static void
+fixture_tar_header (char *block, const char *name, gboolean is_dir, off_t size)
+{
+    unsigned int sum = 0;
+    int i;
+
+    memset (block, 0, TAR_BLOCK_SIZE);
+    g_strlcpy (block, name, 100);
+    g_snprintf (block + 100, 8, "%07o", is_dir ? 0755 : 0644);
+    g_snprintf (block + 108, 8, "%07o", 1000);
+    g_snprintf (block + 116, 8, "%07o", 1000);
+    g_snprintf (block + 124, 12, "%011lo", (unsigned long) size);
+    g_snprintf (block + 136, 12, "%011lo", (unsigned long) FIXTURE_MTIME);
+    block[156] = is_dir ? '5' : '0';
+    memcpy (block + 257, "ustar", 6);
+    memcpy (block + 263, "00", 2);
+    g_strlcpy (block + 265, "user", 32);
+    g_strlcpy (block + 297, "user", 32);
+
+    /* checksum is computed with checksum field filled by spaces */
+    memset (block + 148, ' ', 8);
+    for (i = 0; i < TAR_BLOCK_SIZE; i++)
+        sum += (unsigned char) block[i];
+    g_snprintf (block + 148, 8, "%06o", sum);
+    block[155] = ' ';
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+fixture_tar_member (int fd, const char *name, gboolean is_dir, off_t size)
+{
+    char block[TAR_BLOCK_SIZE];
+    off_t pad;
+
+    fixture_tar_header (block, name, is_dir, size);
+    if (!fixture_write_all (fd, block, sizeof (block)) || !fixture_write_random (fd, size))
+        return FALSE;
+
+    pad = (TAR_BLOCK_SIZE - size % TAR_BLOCK_SIZE) % TAR_BLOCK_SIZE;
+    memset (block, 0, sizeof (block));
+    return fixture_write_all (fd, block, (size_t) pad);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** "newc" (SVR4 without CRC) cpio member */
+
+static gboolean
+fixture_cpio_member (int fd, guint32 ino, const char *name, mode_t mode, off_t size)
+{
+    char header[111];
+    static const char zero[4] = { 0, 0, 0, 0 };
+    size_t name_len, pad;
+
+    name_len = strlen (name) + 1;
+    g_snprintf (header, sizeof (header),
+                "070701%08X%08X%08X%08X%08X%08X%08X%08X%08X%08X%08X%08X%08X",
+                (unsigned int) ino, (unsigned int) mode, 1000U, 1000U,
+                S_ISDIR (mode) ? 2U : 1U, (unsigned int) FIXTURE_MTIME, (unsigned int) size,
+                0U, 0U, 0U, 0U, (unsigned int) name_len, 0U);
+
+    if (!fixture_write_all (fd, header, 110) || !fixture_write_all (fd, name, name_len))
+        return FALSE;
+
+    pad = (4 - (110 + name_len) % 4) % 4;
+    if (!fixture_write_all (fd, zero, pad) || !fixture_write_random (fd, size))
+        return FALSE;
+
+    pad = (size_t) ((4 - size % 4) % 4);
+    return fixture_write_all (fd, zero, pad);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+void
+fixture_seed (guint32 seed)
+{
+    fixture_state = seed != 0 ? seed : 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** xorshift32: same sequence on every platform */
+
+guint32
+fixture_random (void)
+{
+    fixture_state ^= fixture_state << 13;
+    fixture_state ^= fixture_state >> 17;
+    fixture_state ^= fixture_state << 5;
+
+    return fixture_state;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Make file name from number. Names are unique, of different length and with different
+ * extensions, so sorting and file highlighting have some work to do.
+ */
+
+char *
+fixture_name (guint32 n)
+{
+    guint32 h = n * 2654435761U;
+    GString *name;
+    int i, len;
+
+    name = g_string_sized_new (32);
+
+    len = 1 + (int) (h >> 29);
+    for (i = 0; i < len; i++)
+        g_string_append (name, fixture_syllables[(h >> (i * 4)) & 0x0f]);
+
+    if ((h & 0x100) != 0)
+        name->str[0] = g_ascii_toupper (name->str[0]);
+
+    g_string_append_printf (name, "_%06u%s", (unsigned int) n,
+                            fixture_extensions[(h >> 12) % G_N_ELEMENTS (fixture_extensions)]);
+
+    return g_string_free (name, FALSE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Make identifier from number. Names are unique and not sorted by number. */
+
+char *
+fixture_tag_name (guint32 n)
+{
+    guint32 h = n * 2654435761U;
+
+    return g_strdup_printf ("%s%s_%u", fixture_syllables[h >> 28],
+                            fixture_syllables[(h >> 24) & 0x0f], (unsigned int) n);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Relative path of directory (if file is negative) or file in tree made by fixture_make_tree().
+ */
+
+char *
+fixture_tree_name (int dir, int file)
+{
+    char *name, *path;
+
+    if (file < 0)
+        return g_strdup_printf ("d%04d", dir);
+
+    name = fixture_name ((guint32) (dir * 100003 + file));
+    path = g_strdup_printf ("d%04d/%s", dir, name);
+    g_free (name);
+
+    return path;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Make directory with many entries: empty files of different size (sparse), directories,
+ * executables and symlinks.
+ */
+
+gboolean
+fixture_make_flat_dir (const char *path, int files)
+{
+    struct utimbuf times;
+    int i;
+
+    if (g_mkdir_with_parents (path, 0755) != 0)
+        return FALSE;
+
+    for (i = 0; i < files; i++)
+    {
+        char *name, *p;
+        gboolean ok = TRUE;
+
+        name = fixture_name ((guint32) i);
+        p = g_build_filename (path, name, (char *) NULL);
+
+        if (i % 16 == 1)
+            ok = mkdir (p, 0755) == 0;
+        else if (i % 64 == 2)
+        {
+            char *target;
+
+            target = fixture_name ((guint32) i - 2);
+            ok = symlink (target, p) == 0;
+            g_free (target);
+        }
+        else
+        {
+            int fd;
+
+            fd = open (p, O_WRONLY | O_CREAT | O_TRUNC, (i % 8 == 3) ? 0755 : 0644);
+            ok = fd != -1;
+            if (ok)
+            {
+                ok = ftruncate (fd, (off_t) (fixture_random () % (1024 * 1024))) == 0;
+                close (fd);
+            }
+        }
+
+        if (ok && i % 64 != 2)
+        {
+            times.actime = times.modtime = FIXTURE_MTIME - (time_t) (fixture_random () % 1000000);
+            ok = utime (p, &times) == 0;
+        }
+
+        g_free (p);
+        g_free (name);
+
+        if (!ok)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+gboolean
+fixture_make_tree (const char *path, int dirs, int files_per_dir, off_t file_size)
+{
+    int i, j;
+
+    for (i = 0; i < dirs; i++)
+    {
+        char *name, *p;
+        gboolean ok;
+
+        name = fixture_tree_name (i, -1);
+        p = g_build_filename (path, name, (char *) NULL);
+        ok = g_mkdir_with_parents (p, 0755) == 0;
+        g_free (p);
+        g_free (name);
+
+        for (j = 0; ok && j < files_per_dir; j++)
+        {
+            name = fixture_tree_name (i, j);
+            p = g_build_filename (path, name, (char *) NULL);
+            ok = fixture_make_file (p, file_size, 0644);
+            g_free (p);
+            g_free (name);
+        }
+
+        if (!ok)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Tree of empty files in path/a, every one of them has a hardlink of the same name in path/b */
+
+gboolean
+fixture_make_hardlinks (const char *path, int dirs, int files_per_dir)
+{
+    char *a, *b;
+    int i, j;
+    gboolean ok;
+
+    a = g_build_filename (path, "a", (char *) NULL);
+    b = g_build_filename (path, "b", (char *) NULL);
+    ok = fixture_make_tree (a, dirs, files_per_dir, 0);
+
+    for (i = 0; ok && i < dirs; i++)
+    {
+        char *name, *p;
+
+        name = fixture_tree_name (i, -1);
+        p = g_build_filename (b, name, (char *) NULL);
+        ok = g_mkdir_with_parents (p, 0755) == 0;
+        g_free (p);
+        g_free (name);
+
+        for (j = 0; ok && j < files_per_dir; j++)
+        {
+            char *pa, *pb;
+
+            name = fixture_tree_name (i, j);
+            pa = g_build_filename (a, name, (char *) NULL);
+            pb = g_build_filename (b, name, (char *) NULL);
+            ok = link (pa, pb) == 0;
+            g_free (pa);
+            g_free (pb);
+            g_free (name);
+        }
+    }
+
+    g_free (a);
+    g_free (b);
+
+    return ok;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Etags file: every source file has tags named by fixture_tag_name() of sequential numbers */
+
+gboolean
+fixture_make_etags (const char *path, int files, int tags_per_file)
+{
+    GString *buf, *section;
+    int fd, f, t;
+    gboolean ok = TRUE;
+
+    fd = open (path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1)
+        return FALSE;
+
+    buf = g_string_sized_new (FIXTURE_BUF_SIZE + 1024);
+    section = g_string_sized_new (1024);
+
+    for (f = 0; ok && f < files; f++)
+    {
+        long offset = 0;
+
+        g_string_set_size (section, 0);
+        for (t = 0; t < tags_per_file; t++)
+        {
+            char *name;
+
+            name = fixture_tag_name ((guint32) (f * tags_per_file + t));
+            g_string_append_printf (section, "int %s (\x7f%s\x01%d,%ld\n", name, name,
+                                    t * 10 + 1, offset);
+            offset += 100 + (long) (fixture_random () % 200);
+            g_free (name);
+        }
+
+        g_string_append_printf (buf, "\x0c\nsrc/file%04d.c,%u\n", f, (unsigned int) section->len);
+        g_string_append_len (buf, section->str, section->len);
+
+        if (buf->len >= FIXTURE_BUF_SIZE)
+        {
+            ok = fixture_write_all (fd, buf->str, buf->len);
+            g_string_set_size (buf, 0);
+        }
+    }
+
+    if (ok)
+        ok = fixture_write_all (fd, buf->str, buf->len);
+
+    g_string_free (section, TRUE);
+    g_string_free (buf, TRUE);
+    return (close (fd) == 0) && ok;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Text of lines of different length, with some tabs and long lines */
+
+gboolean
+fixture_make_text_file (const char *path, off_t size)
+{
+    GString *buf;
+    int fd;
+    off_t written = 0;
+    gboolean ok = TRUE;
+
+    fd = open (path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1)
+        return FALSE;
+
+    buf = g_string_sized_new (FIXTURE_BUF_SIZE + 1024);
+
+    while (ok && written < size)
+    {
+        guint32 r;
+        int words;
+
+        r = fixture_random ();
+        words = (r % 64 == 0) ? 200 : (int) (r % 16);
+
+        if ((r & 0x300) == 0)
+            g_string_append_c (buf, '\t');
+
+        while (words-- > 0)
+        {
+            g_string_append (buf, fixture_words[fixture_random () % G_N_ELEMENTS (fixture_words)]);
+            g_string_append_c (buf, ' ');
+        }
+        g_string_append_c (buf, '\n');
+
+        if (buf->len >= FIXTURE_BUF_SIZE || written + (off_t) buf->len >= size)
+        {
+            size_t n;
+
+            n = (size_t) MIN ((off_t) buf->len, size - written);
+            ok = fixture_write_all (fd, buf->str, n);
+            written += (off_t) n;
+            g_string_set_size (buf, 0);
+        }
+    }
+
+    g_string_free (buf, TRUE);
+    return (close (fd) == 0) && ok;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+gboolean
+fixture_make_binary_file (const char *path, off_t size)
+{
+    return fixture_make_file (path, size, 0644);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+gboolean
+fixture_make_tar (const char *path, int dirs, int files_per_dir, off_t file_size)
+{
+    char block[TAR_BLOCK_SIZE];
+    int fd, i, j;
+    gboolean ok = TRUE;
+
+    fd = open (path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1)
+        return FALSE;
+
+    for (i = 0; ok && i < dirs; i++)
+    {
+        char *name, *dir_name;
+
+        name = fixture_tree_name (i, -1);
+        dir_name = g_strconcat (name, "/", (char *) NULL);
+        ok = fixture_tar_member (fd, dir_name, TRUE, 0);
+        g_free (dir_name);
+        g_free (name);
+
+        for (j = 0; ok && j < files_per_dir; j++)
+        {
+            name = fixture_tree_name (i, j);
+            ok = fixture_tar_member (fd, name, FALSE, file_size);
+            g_free (name);
+        }
+    }
+
+    /* end of archive: two zero blocks */
+    memset (block, 0, sizeof (block));
+    ok = ok && fixture_write_all (fd, block, sizeof (block))
+        && fixture_write_all (fd, block, sizeof (block));
+
+    return (close (fd) == 0) && ok;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+gboolean
+fixture_make_cpio (const char *path, int dirs, int files_per_dir, off_t file_size)
+{
+    guint32 ino = 1;
+    int fd, i, j;
+    gboolean ok = TRUE;
+
+    fd = open (path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1)
+        return FALSE;
+
+    for (i = 0; ok && i < dirs; i++)
+    {
+        char *name;
+
+        name = fixture_tree_name (i, -1);
+        ok = fixture_cpio_member (fd, ino++, name, S_IFDIR | 0755, 0);
+        g_free (name);
+
+        for (j = 0; ok && j < files_per_dir; j++)
+        {
+            name = fixture_tree_name (i, j);
+            ok = fixture_cpio_member (fd, ino++, name, S_IFREG | 0644, file_size);
+            g_free (name);
+        }
+    }
+
+    ok = ok && fixture_cpio_member (fd, 0, "TRAILER!!!", 0, 0);
+
+    return (close (fd) == 0) && ok;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+fixture_remove_tree (const char *path)
+{
+    struct stat st;
+    DIR *dir;
+    struct dirent *d;
+
+    if (lstat (path, &st) != 0)
+        return;
+
+    if (!S_ISDIR (st.st_mode))
+    {
+        unlink (path);
+        return;
+    }
+
+    dir = opendir (path);
+    if (dir != NULL)
+    {
+        while ((d = readdir (dir)) != NULL)
+            if (!DIR_IS_DOT (d->d_name) && !DIR_IS_DOTDOT (d->d_name))
+            {
+                char *p;
+
+                p = g_build_filename (path, d->d_name, (char *) NULL);
+                fixture_remove_tree (p);
+                g_free (p);
+            }
+
+        closedir (dir);
+    }
+
+    rmdir (path);
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,41 @@
+/** \file  fixtures.h
+ *  \brief Header: deterministic synthetic fixtures for benchmarks
+ */
+
+#ifndef MC__BENCH_FIXTURES_H
+#define MC__BENCH_FIXTURES_H
+
+#include <sys/types.h>
+
+#include "lib/global.h"
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+/*** enums ***************************************************************************************/
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+/*** global variables defined in .c file *********************************************************/
+
+/*** declarations of public functions ************************************************************/
+
+void fixture_seed (guint32 seed);
+guint32 fixture_random (void);
+char *fixture_name (guint32 n);
+char *fixture_tree_name (int dir, int file);
+char *fixture_tag_name (guint32 n);
+
+gboolean fixture_make_flat_dir (const char *path, int files);
+gboolean fixture_make_tree (const char *path, int dirs, int files_per_dir, off_t file_size);
+gboolean fixture_make_hardlinks (const char *path, int dirs, int files_per_dir);
+gboolean fixture_make_etags (const char *path, int files, int tags_per_file);
+gboolean fixture_make_text_file (const char *path, off_t size);
+gboolean fixture_make_binary_file (const char *path, off_t size);
+gboolean fixture_make_tar (const char *path, int dirs, int files_per_dir, off_t file_size);
+gboolean fixture_make_cpio (const char *path, int dirs, int files_per_dir, off_t file_size);
+
+void fixture_remove_tree (const char *path);
+
+/*** inline functions ****************************************************************************/
+
+#endif /* MC__BENCH_FIXTURES_H */
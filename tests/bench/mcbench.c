@@ -0,0 +1,1850 @@
+/*
+   Benchmarks of core hot paths.
+
+   Copyright (C) 2014
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \file mcbench.c
+ *  \brief Source: benchmarks of core hot paths
+ *
+ *  Benchmarks run without terminal on fixtures generated in a temporary directory,
+ *  terminal output is measured on a pseudo-terminal.
+ *  Every benchmark is run several times. Results are printed as tab-separated values,
+ *  one line per benchmark: name, number of iterations, number of items processed in one
+ *  iteration, total and best time of iteration in seconds, and items per second of the
+ *  best iteration. Lines started with '#' are comments.
+ *
+ *  Usage: mcbench [-s SCALE] [-o FILE] [-k] [-l] [BENCHMARK-PREFIX...]
+ */
+
+#include <config.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>       /* getrusage() */
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "lib/global.h"
+#ifdef HAVE_CHARSET
+#include "lib/charsets.h"
+#endif
+#include "lib/fileloc.h"
+#include "lib/filehighlight.h"
+#include "lib/search.h"
+#include "lib/strutil.h"
+#include "lib/util.h"
+#include "lib/tty/tty.h"
+#include "lib/tty/color.h"
+#include "lib/vfs/vfs.h"
+#include "lib/widget.h"
+
+#include "src/vfs/local/local.h"
+#ifdef ENABLE_VFS_CPIO
+#include "src/vfs/cpio/cpio.h"
+#endif
+#ifdef ENABLE_VFS_TAR
+#include "src/vfs/tar/tar.h"
+#endif
+
+#include "src/filemanager/dir.h"
+#include "src/filemanager/file.h"
+#include "src/filemanager/fileopctx.h"
+#include "src/filemanager/layout.h"     /* use_dash() */
+
+#include "src/viewer/mcviewer.h"
+#include "src/viewer/internal.h"
+
+#ifdef ENABLE_SUBSHELL
+#include "src/subshell.h"
+#endif
+
+#ifdef USE_INTERNAL_EDIT
+#include "src/editor/editbuffer.h"
+#include "src/editor/edit-impl.h"       /* book_mark_*() */
+#include "src/editor/editwidget.h"
+#include "src/editor/etags.h"
+#endif
+
+#include "fixtures.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+#define BENCH_SEED 20140101
+
+/* sizes of fixtures for scale 1 */
+#define BENCH_FLAT_FILES 20000
+#define BENCH_HUGE_DIR_ENTRIES 2000000
+#define BENCH_SEARCH_NAMES 200000
+#define BENCH_FHL_ENTRIES 200000
+#define BENCH_TEXT_SIZE (8 * 1024 * 1024)
+#define BENCH_RECODE_PASSES 20000
+#define BENCH_BINARY_SIZE (32 * 1024 * 1024)
+#define BENCH_TREE_DIRS 20
+#define BENCH_TREE_FILES 100
+#define BENCH_TREE_FILE_SIZE 4096
+#define BENCH_HARDLINK_DIRS 500
+#define BENCH_HARDLINK_FILES 100
+#define BENCH_ARCHIVE_DIRS 100
+#define BENCH_ARCHIVE_FILES 100
+#define BENCH_ARCHIVE_FILE_SIZE 1024
+
+#define BENCH_VIEW_LINES 50
+#define BENCH_VIEW_COLS 200
+#define BENCH_VIEW_SCREENS 2000
+
+#define BENCH_RANDOM_READS 1000000
+
+#define BENCH_BOOK_MARKS 200000
+
+#define BENCH_ETAGS_FILES 200
+#define BENCH_ETAGS_TAGS 1000
+#define BENCH_ETAGS_LOOKUPS 10000
+
+/* listbox */
+#define BENCH_LISTBOX_ENTRIES 1000000
+#define BENCH_LISTBOX_LINES 20
+#define BENCH_LISTBOX_ROUNDS 1000
+
+/* screen of pseudo-terminal */
+#define BENCH_TTY_COLS 300
+#define BENCH_TTY_LINES 100
+#define BENCH_TTY_REPAINTS 100
+#define BENCH_TTY_COLORS 4
+
+#if defined(HAVE_GRANTPT) && defined(HAVE_POSIX_OPENPT)
+#define BENCH_TTY 1
+#endif
+
+/* output of command in subshell */
+#define BENCH_RELAY_SIZE (64 * 1024 * 1024)
+#define BENCH_RELAY_LINE 80
+
+#define BENCH_SCALED(x) ((x) * bench_scale)
+
+/*** file scope type declarations ****************************************************************/
+
+typedef enum
+{
+    BENCH_FIXTURE_FLAT = 0,
+    BENCH_FIXTURE_TREE,
+    BENCH_FIXTURE_HARDLINKS,
+    BENCH_FIXTURE_TEXT,
+    BENCH_FIXTURE_BINARY,
+    BENCH_FIXTURE_ETAGS,
+    BENCH_FIXTURE_TAR,
+    BENCH_FIXTURE_CPIO,
+    BENCH_FIXTURE_COUNT
+} bench_fixture_t;
+
+/* state of running benchmark */
+typedef struct
+{
+    int iterations;
+    int done;
+    gboolean running;
+    GTimer *timer;
+    double total;
+    double best;
+    /* number of items processed in one iteration */
+    gsize items;
+    /* additional results printed as comment */
+    char *note;
+} bench_run_t;
+
+typedef struct
+{
+    const char *name;
+    int iterations;
+    void (*run) (bench_run_t * run);
+} bench_t;
+
+typedef struct
+{
+    const char *data;
+    gsize len;
+} bench_text_t;
+
+/*** file scope variables ************************************************************************/
+
+static int bench_scale = 1;
+static char *bench_output = NULL;
+static gboolean bench_list = FALSE;
+static gboolean bench_keep = FALSE;
+
+static char *bench_dir = NULL;
+static vfs_path_t *bench_dir_vpath = NULL;
+static char *bench_fixture_paths[BENCH_FIXTURE_COUNT];
+
+/* *INDENT-OFF* */
+static GOptionEntry bench_options[] =
+{
+    { "scale", 's', 0, G_OPTION_ARG_INT, &bench_scale, "Multiply size of fixtures by N", "N" },
+    { "output", 'o', 0, G_OPTION_ARG_FILENAME, &bench_output, "Write results to FILE", "FILE" },
+    { "keep", 'k', 0, G_OPTION_ARG_NONE, &bench_keep, "Keep generated fixtures", NULL },
+    { "list", 'l', 0, G_OPTION_ARG_NONE, &bench_list, "List benchmarks and exit", NULL },
+    { NULL, '\0', 0, 0, NULL, NULL, NULL }
+};
+/* *INDENT-ON* */
+
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+bench_fatal (const char *what, const char *path)
+{
+    fprintf (stderr, "mcbench: %s: %s\n", what, path);
+    exit (EXIT_FAILURE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** fixtures ***/
+/* --------------------------------------------------------------------------------------------- */
+
+static const char *
+bench_fixture (bench_fixture_t id)
+{
+    char *path;
+    gboolean ok = FALSE;
+
+    if (bench_fixture_paths[id] != NULL)
+        return bench_fixture_paths[id];
+
+    /* every fixture has own seed: it doesn't depend on set and order of benchmarks */
+    fixture_seed (BENCH_SEED + (guint32) id);
+
+    switch (id)
+    {
+    case BENCH_FIXTURE_FLAT:
+        path = g_build_filename (bench_dir, "flat", (char *) NULL);
+        ok = fixture_make_flat_dir (path, BENCH_SCALED (BENCH_FLAT_FILES));
+        break;
+    case BENCH_FIXTURE_TREE:
+        path = g_build_filename (bench_dir, "tree", (char *) NULL);
+        ok = fixture_make_tree (path, BENCH_SCALED (BENCH_TREE_DIRS), BENCH_TREE_FILES,
+                                BENCH_TREE_FILE_SIZE);
+        break;
+    case BENCH_FIXTURE_HARDLINKS:
+        path = g_build_filename (bench_dir, "hardlinks", (char *) NULL);
+        ok = fixture_make_hardlinks (path, BENCH_SCALED (BENCH_HARDLINK_DIRS),
+                                     BENCH_HARDLINK_FILES);
+        break;
+    case BENCH_FIXTURE_TEXT:
+        path = g_build_filename (bench_dir, "text.txt", (char *) NULL);
+        ok = fixture_make_text_file (path, (off_t) BENCH_SCALED (BENCH_TEXT_SIZE));
+        break;
+    case BENCH_FIXTURE_BINARY:
+        path = g_build_filename (bench_dir, "binary.bin", (char *) NULL);
+        ok = fixture_make_binary_file (path, (off_t) BENCH_SCALED (BENCH_BINARY_SIZE));
+        break;
+    case BENCH_FIXTURE_ETAGS:
+        path = g_build_filename (bench_dir, "TAGS", (char *) NULL);
+        ok = fixture_make_etags (path, BENCH_SCALED (BENCH_ETAGS_FILES), BENCH_ETAGS_TAGS);
+        break;
+    case BENCH_FIXTURE_TAR:
+        path = g_build_filename (bench_dir, "archive.tar", (char *) NULL);
+        ok = fixture_make_tar (path, BENCH_SCALED (BENCH_ARCHIVE_DIRS), BENCH_ARCHIVE_FILES,
+                               BENCH_ARCHIVE_FILE_SIZE);
+        break;
+    case BENCH_FIXTURE_CPIO:
+        path = g_build_filename (bench_dir, "archive.cpio", (char *) NULL);
+        ok = fixture_make_cpio (path, BENCH_SCALED (BENCH_ARCHIVE_DIRS), BENCH_ARCHIVE_FILES,
+                                BENCH_ARCHIVE_FILE_SIZE);
+        break;
+    default:
+        path = g_strdup ("?");
+        break;
+    }
+
+    if (!ok)
+        bench_fatal ("cannot create fixture", path);
+
+    bench_fixture_paths[id] = path;
+    return path;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static char *
+bench_fixture_contents (bench_fixture_t id, gsize * len)
+{
+    const char *path;
+    char *data = NULL;
+
+    path = bench_fixture (id);
+    if (!g_file_get_contents (path, &data, len, NULL))
+        bench_fatal ("cannot read fixture", path);
+
+    return data;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** timing ***/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Finish current iteration (if any) and start next one.
+ *
+ * @return FALSE if all iterations are done
+ */
+
+static gboolean
+bench_next (bench_run_t * run)
+{
+    if (run->running)
+    {
+        double elapsed;
+
+        g_timer_stop (run->timer);
+        elapsed = g_timer_elapsed (run->timer, NULL);
+
+        run->total += elapsed;
+        if (run->done == 0 || elapsed < run->best)
+            run->best = elapsed;
+        run->done++;
+        run->running = FALSE;
+    }
+
+    if (run->done >= run->iterations)
+        return FALSE;
+
+    run->running = TRUE;
+    g_timer_start (run->timer);
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Exclude preparation of iteration from timing */
+
+static void
+bench_pause (bench_run_t * run)
+{
+    g_timer_stop (run->timer);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+bench_resume (bench_run_t * run)
+{
+    g_timer_continue (run->timer);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** directory lists ***/
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+bench_dir_list_load (bench_run_t * run)
+{
+    dir_sort_options_t sort_op = { FALSE, TRUE, FALSE };
+    dir_list list = { NULL, 0, 0, NULL };
+    vfs_path_t *vpath;
+
+    vpath = vfs_path_from_str (bench_fixture (BENCH_FIXTURE_FLAT));
+    /* entries are stat'ed relative to current directory */
+    mc_chdir (vpath);
+
+    while (bench_next (run))
+        dir_list_load (&list, vpath, (GCompareFunc) sort_name, &sort_op, NULL);
+
+    run->items = (gsize) list.len;
+
+    mc_chdir (bench_dir_vpath);
+    dir_list_clean (&list);
+    g_free (list.list);
+    vfs_path_free (vpath);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+bench_dir_list_sort (bench_run_t * run, GCompareFunc sort)
+{
+    dir_sort_options_t sort_op = { FALSE, TRUE, FALSE };
+    dir_list list = { NULL, 0, 0, NULL };
+    vfs_path_t *vpath;
+
+    vpath = vfs_path_from_str (bench_fixture (BENCH_FIXTURE_FLAT));
+    mc_chdir (vpath);
+    dir_list_load (&list, vpath, (GCompareFunc) sort_name, &sort_op, NULL);
+    mc_chdir (bench_dir_vpath);
+
+    while (bench_next (run))
+    {
+        int i;
+
+        /* same unsorted order for every iteration; ".." stays at top */
+        bench_pause (run);
+        fixture_seed (BENCH_SEED);
+        for (i = list.len - 1; i > 1; i--)
+        {
+            int j;
+            file_entry_t tmp;
+
+            j = 1 + (int) (fixture_random () % (guint32) i);
+            tmp = list.list[i];
+            list.list[i] = list.list[j];
+            list.list[j] = tmp;
+        }
+        bench_resume (run);
+
+        dir_list_sort (&list, sort, &sort_op);
+    }
+
+    run->items = (gsize) list.len;
+
+    dir_list_clean (&list);
+    g_free (list.list);
+    vfs_path_free (vpath);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+bench_dir_list_sort_name (bench_run_t * run)
+{
+    bench_dir_list_sort (run, (GCompareFunc) sort_name);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+bench_dir_list_sort_ext (bench_run_t * run)
+{
+    bench_dir_list_sort (run, (GCompareFunc) sort_ext);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+bench_dir_list_sort_size (bench_run_t * run)
+{
+    bench_dir_list_sort (run, (GCompareFunc) sort_size);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+bench_dir_list_sort_time (bench_run_t * run)
+{
+    bench_dir_list_sort (run, (GCompareFunc) sort_time);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Peak resident set size of process in kilobytes */
+
+static long
+bench_max_rss (void)
+{
+    struct rusage usage;
+
+    if (getrusage (RUSAGE_SELF, &usage) != 0)
+        return 0;
+
+    return usage.ru_maxrss;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Fill, sort and free list of huge directory as panel does it */
+
+static void
+bench_dir_list_huge (bench_run_t * run)
+{
+    dir_sort_options_t sort_op = { FALSE, TRUE, FALSE };
+    char **names;
+    int i, n;
+    long rss_before, rss_grown = 0;
+
+    n = BENCH_SCALED (BENCH_HUGE_DIR_ENTRIES);
+    names = g_new (char *, n + 1);
+    for (i = 0; i < n; i++)
+        names[i] = fixture_name ((guint32) i);
+    names[n] = NULL;
+
+    rss_before = bench_max_rss ();
+
+    while (bench_next (run))
+    {
+        dir_list list = { NULL, 0, 0, NULL };
+
+        dir_list_init (&list);
+
+        for (i = 0; i < n; i++)
+        {
+            struct stat st;
+
+            memset (&st, 0, sizeof (st));
+            st.st_mode = (i % 16 == 1) ? (S_IFDIR | 0755) : (S_IFREG | 0644);
+            st.st_size = (off_t) i;
+            st.st_mtime = (time_t) (1400000000 + i);
+            dir_list_append (&list, names[i], &st, FALSE, FALSE);
+        }
+
+        dir_list_sort (&list, (GCompareFunc) sort_name, &sort_op);
+
+        if (rss_grown == 0)
+            rss_grown = bench_max_rss () - rss_before;
+
+        dir_list_clean (&list);
+        g_free (list.list);
+    }
+
+    run->items = (gsize) n;
+    run->note = g_strdup_printf ("%d entries of %u bytes, peak RSS grown by %ld KiB", n,
+                                 (unsigned int) sizeof (file_entry_t), rss_grown);
+
+    g_strfreev (names);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** search ***/
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+bench_search_names (bench_run_t * run, const char *pattern, mc_search_type_t type)
+{
+    char **names;
+    gsize i, n;
+
+    n = (gsize) BENCH_SCALED (BENCH_SEARCH_NAMES);
+    names = g_new (char *, n + 1);
+    for (i = 0; i < n; i++)
+        names[i] = fixture_name ((guint32) i);
+    names[n] = NULL;
+
+    while (bench_next (run))
+    {
+        mc_search_t *search;
+
+        /* as in select/unselect of files by pattern */
+        search = mc_search_new (pattern, -1, NULL);
+        search->search_type = type;
+        search->is_entire_line = TRUE;
+        search->is_case_sensitive = FALSE;
+
+        for (i = 0; i < n; i++)
+            mc_search_run (search, names[i], 0, strlen (names[i]), NULL);
+
+        mc_search_free (search);
+    }
+
+    run->items = n;
+    g_strfreev (names);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+bench_search_glob (bench_run_t * run)
+{
+    bench_search_names (run, "*a*_0*.c", MC_SEARCH_T_GLOB);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+bench_search_regex (bench_run_t * run)
+{
+    bench_search_names (run, "^[a-z]+_0[0-9]*[13579]\\.(c|h|txt)$", MC_SEARCH_T_REGEX);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static const char *
+bench_search_batch_get_name (gsize index, gsize * len, gpointer user_data)
+{
+    const char *const *names = (const char *const *) user_data;
+
+    *len = strlen (names[index]);
+    return names[index];
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Match all names at once as dir_list_match() does */
+
+static void
+bench_search_batch (bench_run_t * run)
+{
+    char **names;
+    gsize i, n;
+
+    n = (gsize) BENCH_SCALED (BENCH_SEARCH_NAMES);
+    names = g_new (char *, n + 1);
+    for (i = 0; i < n; i++)
+        names[i] = fixture_name ((guint32) i);
+    names[n] = NULL;
+
+    while (bench_next (run))
+    {
+        mc_search_t *search;
+        guint8 *bitmap;
+        gsize found = 0;
+
+        search = mc_search_cache_get ("*a*_0*.c", NULL, MC_SEARCH_T_GLOB,
+                                      MC_SEARCH_F_ENTIRE_LINE);
+        bitmap = mc_search_run_batch (search, n, bench_search_batch_get_name, names, &found);
+        g_free (bitmap);
+    }
+
+    run->items = n;
+    g_strfreev (names);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static mc_search_cbret_t
+bench_search_text_cb (const void *user_data, gsize char_offset, int *current_char)
+{
+    const bench_text_t *text = (const bench_text_t *) user_data;
+
+    if (char_offset >= text->len)
+        return MC_SEARCH_CB_ABORT;
+
+    *current_char = (unsigned char) text->data[char_offset];
+    return MC_SEARCH_CB_OK;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Search of missing string through whole file, as in viewer and editor */
+
+static void
+bench_search_text (bench_run_t * run)
+{
+    bench_text_t text;
+    char *data;
+
+    data = bench_fixture_contents (BENCH_FIXTURE_TEXT, &text.len);
+    text.data = data;
+
+    while (bench_next (run))
+    {
+        mc_search_t *search;
+
+        search = mc_search_new ("mcbench", -1, NULL);
+        search->search_type = MC_SEARCH_T_NORMAL;
+        search->is_case_sensitive = TRUE;
+        search->search_fn = bench_search_text_cb;
+
+        mc_search_run (search, &text, 0, text.len, NULL);
+        mc_search_free (search);
+    }
+
+    run->items = text.len;
+    g_free (data);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** recoding ***/
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef HAVE_CHARSET
+/** Recode all 8-bit chars of KOI8-R to UTF-8 char by char */
+
+static void
+bench_recode (bench_run_t * run, gboolean use_table)
+{
+    const codepage_table_t *table = NULL;
+    GIConv conv;
+
+    mc_global.share_data_dir = (char *) BENCH_MISC_DIR;
+    mc_global.sysconfig_dir = (char *) BENCH_MISC_DIR;
+    load_codepages_list ();
+
+    conv = str_crt_conv_from ("KOI8-R");
+    if (use_table)
+        table = get_codepage_table (get_codepage_index ("KOI8-R"));
+    if (conv == INVALID_CONV || (use_table && table == NULL))
+        bench_fatal ("cannot recode from", "KOI8-R");
+
+    while (bench_next (run))
+    {
+        long sum = 0;
+        int pass, i;
+
+        for (pass = 0; pass < BENCH_RECODE_PASSES; pass++)
+            for (i = 0; i < 256; i++)
+                sum += use_table ? convert_from_8bit_to_utf_t (table, (unsigned char) i, conv)
+                    : convert_from_8bit_to_utf_c ((char) i, conv);
+
+        (void) sum;
+    }
+
+    run->items = BENCH_RECODE_PASSES * 256;
+
+    str_close_conv (conv);
+    free_codepages_list ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+bench_recode_iconv (bench_run_t * run)
+{
+    bench_recode (run, FALSE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+bench_recode_table (bench_run_t * run)
+{
+    bench_recode (run, TRUE);
+}
+#endif /* HAVE_CHARSET */
+
+/* --------------------------------------------------------------------------------------------- */
+/*** copy ***/
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+bench_copy_large (bench_run_t * run)
+{
+    file_op_context_t *ctx;
+    file_op_total_context_t *tctx;
+    const char *src;
+    char *dst;
+    struct stat st;
+
+    src = bench_fixture (BENCH_FIXTURE_BINARY);
+    dst = g_build_filename (bench_dir, "binary.copy", (char *) NULL);
+
+    ctx = file_op_context_new (OP_COPY);
+    tctx = file_op_total_context_new ();
+
+    while (bench_next (run))
+    {
+        bench_pause (run);
+        unlink (dst);
+        bench_resume (run);
+
+        if (copy_file_file (tctx, ctx, src, dst) != FILE_CONT)
+            bench_fatal ("cannot copy", src);
+    }
+
+    run->items = (stat (src, &st) == 0) ? (gsize) st.st_size : 0;
+
+    unlink (dst);
+    file_op_total_context_destroy (tctx);
+    file_op_context_destroy (ctx);
+    g_free (dst);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+bench_copy_small (bench_run_t * run)
+{
+    file_op_context_t *ctx;
+    file_op_total_context_t *tctx;
+    const char *src_tree;
+    char *dst_tree;
+    int dirs, i, j;
+
+    src_tree = bench_fixture (BENCH_FIXTURE_TREE);
+    dst_tree = g_build_filename (bench_dir, "tree.copy", (char *) NULL);
+    dirs = BENCH_SCALED (BENCH_TREE_DIRS);
+
+    ctx = file_op_context_new (OP_COPY);
+    tctx = file_op_total_context_new ();
+
+    while (bench_next (run))
+    {
+        bench_pause (run);
+        fixture_remove_tree (dst_tree);
+        for (i = 0; i < dirs; i++)
+        {
+            char *name, *p;
+
+            name = fixture_tree_name (i, -1);
+            p = g_build_filename (dst_tree, name, (char *) NULL);
+            g_mkdir_with_parents (p, 0755);
+            g_free (p);
+            g_free (name);
+        }
+        bench_resume (run);
+
+        for (i = 0; i < dirs; i++)
+            for (j = 0; j < BENCH_TREE_FILES; j++)
+            {
+                char *name, *src, *dst;
+                FileProgressStatus status;
+
+                name = fixture_tree_name (i, j);
+                src = g_build_filename (src_tree, name, (char *) NULL);
+                dst = g_build_filename (dst_tree, name, (char *) NULL);
+                status = copy_file_file (tctx, ctx, src, dst);
+                g_free (dst);
+                g_free (name);
+
+                if (status != FILE_CONT)
+                    bench_fatal ("cannot copy", src);
+                g_free (src);
+            }
+    }
+
+    run->items = (gsize) (dirs * BENCH_TREE_FILES);
+
+    fixture_remove_tree (dst_tree);
+    file_op_total_context_destroy (tctx);
+    file_op_context_destroy (ctx);
+    g_free (dst_tree);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Copy tree where every file has a hardlink in another subtree. Tables of copied hardlinks
+ * are kept until the end of file operation in the panel, so there is only one iteration.
+ */
+
+static void
+bench_copy_hardlinks (bench_run_t * run)
+{
+    file_op_context_t *ctx;
+    file_op_total_context_t *tctx;
+    const char *src;
+    char *dst;
+
+    src = bench_fixture (BENCH_FIXTURE_HARDLINKS);
+    dst = g_build_filename (bench_dir, "hardlinks.copy", (char *) NULL);
+
+    ctx = file_op_context_new (OP_COPY);
+    tctx = file_op_total_context_new ();
+
+    while (bench_next (run))
+        if (copy_dir_dir (tctx, ctx, src, dst, TRUE, FALSE, FALSE) != FILE_CONT)
+            bench_fatal ("cannot copy", src);
+
+    run->items = (gsize) (2 * BENCH_SCALED (BENCH_HARDLINK_DIRS) * BENCH_HARDLINK_FILES);
+
+    fixture_remove_tree (dst);
+    file_op_total_context_destroy (tctx);
+    file_op_context_destroy (ctx);
+    g_free (dst);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** viewer ***/
+/* --------------------------------------------------------------------------------------------- */
+/** Page through text file */
+
+static void
+bench_mcview_display_text (bench_run_t * run)
+{
+    mcview_t *view;
+
+    view = mcview_new (0, 0, BENCH_VIEW_LINES, BENCH_VIEW_COLS, FALSE);
+    if (!mcview_load (view, NULL, bench_fixture (BENCH_FIXTURE_TEXT), 0))
+        bench_fatal ("cannot view", bench_fixture (BENCH_FIXTURE_TEXT));
+
+    while (bench_next (run))
+    {
+        int i;
+
+        mcview_moveto_top (view);
+        for (i = 0; i < BENCH_VIEW_SCREENS; i++)
+        {
+            mcview_display_text (view);
+            mcview_move_down (view, view->data_area.height);
+        }
+    }
+
+    run->items = BENCH_VIEW_SCREENS;
+
+    send_message (view, NULL, MSG_DESTROY, 0, NULL);
+    g_free (view);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** editor ***/
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef USE_INTERNAL_EDIT
+static void
+bench_edit_buffer_load (edit_buffer_t * buf)
+{
+    const char *path;
+    vfs_path_t *vpath;
+    struct stat st;
+    gboolean aborted;
+    int fd;
+
+    path = bench_fixture (BENCH_FIXTURE_TEXT);
+    vpath = vfs_path_from_str (path);
+    fd = mc_open (vpath, O_RDONLY);
+    if (fd == -1 || mc_fstat (fd, &st) != 0)
+        bench_fatal ("cannot open", path);
+
+    edit_buffer_init (buf, st.st_size);
+    if (edit_buffer_read_file (buf, fd, st.st_size, NULL, &aborted) != st.st_size)
+        bench_fatal ("cannot read", path);
+
+    mc_close (fd);
+    vfs_path_free (vpath);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Type whole text */
+
+static void
+bench_edit_buffer_insert (bench_run_t * run)
+{
+    char *data;
+    gsize len, i;
+
+    data = bench_fixture_contents (BENCH_FIXTURE_TEXT, &len);
+
+    while (bench_next (run))
+    {
+        edit_buffer_t buf;
+
+        edit_buffer_init (&buf, 0);
+        for (i = 0; i < len; i++)
+            edit_buffer_insert (&buf, (unsigned char) data[i]);
+
+        bench_pause (run);
+        edit_buffer_clean (&buf);
+        bench_resume (run);
+    }
+
+    run->items = len;
+    g_free (data);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Walk over all lines and read random bytes */
+
+static void
+bench_edit_buffer_navigate (bench_run_t * run)
+{
+    edit_buffer_t buf;
+    long lines = 0;
+
+    bench_edit_buffer_load (&buf);
+
+    while (bench_next (run))
+    {
+        off_t p;
+        int i, sum = 0;
+
+        lines = 0;
+        for (p = 0; p < buf.size; p = edit_buffer_get_eol (&buf, p) + 1)
+            lines++;
+
+        fixture_seed (BENCH_SEED);
+        for (i = 0; i < BENCH_RANDOM_READS; i++)
+            sum += edit_buffer_get_byte (&buf, (off_t) (fixture_random () % (guint32) buf.size));
+
+        (void) sum;
+    }
+
+    run->items = (gsize) lines;
+    edit_buffer_clean (&buf);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Delete whole text */
+
+static void
+bench_edit_buffer_delete (bench_run_t * run)
+{
+    off_t size = 0;
+
+    while (bench_next (run))
+    {
+        edit_buffer_t buf;
+
+        bench_pause (run);
+        bench_edit_buffer_load (&buf);
+        size = buf.size;
+        bench_resume (run);
+
+        while (buf.curs2 > 0)
+            edit_buffer_delete (&buf);
+
+        bench_pause (run);
+        edit_buffer_clean (&buf);
+        bench_resume (run);
+    }
+
+    run->items = (gsize) size;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Insert line at the top of file for every book mark and query all of them */
+
+static void
+bench_book_mark_shift (bench_run_t * run)
+{
+    WEdit *edit;
+    long marks, i;
+
+    edit = g_new0 (WEdit, 1);
+    marks = BENCH_SCALED (BENCH_BOOK_MARKS);
+
+    while (bench_next (run))
+    {
+        int sum = 0;
+
+        bench_pause (run);
+        for (i = 0; i < marks; i++)
+            book_mark_insert (edit, i * 2 + 1, 1);
+        bench_resume (run);
+
+        for (i = 0; i < marks; i++)
+            book_mark_inc (edit, 0);
+        for (i = 0; i < marks; i++)
+            sum += book_mark_query_color (edit, marks + i * 2 + 1, 1) ? 1 : 0;
+
+        if (sum != marks)
+            bench_fatal ("book marks are lost", "book_mark_inc");
+
+        bench_pause (run);
+        book_mark_flush (edit, -1);
+        bench_resume (run);
+    }
+
+    run->items = (gsize) marks;
+
+    if (edit->serialized_bookmarks != NULL)
+        g_array_free (edit->serialized_bookmarks, TRUE);
+    g_free (edit);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+bench_etags_free (etags_hash_t * def_hash, int num)
+{
+    int i;
+
+    for (i = 0; i < num; i++)
+    {
+        g_free (def_hash[i].filename);
+        g_free (def_hash[i].fullpath);
+        g_free (def_hash[i].short_define);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Build index of tags file */
+
+static void
+bench_etags_index (bench_run_t * run)
+{
+    etags_hash_t def_hash[MAX_DEFINITIONS];
+    const char *path;
+    char *name;
+
+    path = bench_fixture (BENCH_FIXTURE_ETAGS);
+    name = fixture_tag_name (0);
+
+    while (bench_next (run))
+    {
+        int num;
+
+        etags_free_index ();
+        num = etags_find_definitions (path, bench_dir, name, FALSE, def_hash, MAX_DEFINITIONS);
+        if (num != 1)
+            bench_fatal ("tag not found", name);
+
+        bench_pause (run);
+        bench_etags_free (def_hash, num);
+        bench_resume (run);
+    }
+
+    run->items = (gsize) BENCH_SCALED (BENCH_ETAGS_FILES) * BENCH_ETAGS_TAGS;
+
+    etags_free_index ();
+    g_free (name);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Look up random tags in indexed file */
+
+static void
+bench_etags_lookup (bench_run_t * run)
+{
+    etags_hash_t def_hash[MAX_DEFINITIONS];
+    const char *path;
+    char **names;
+    guint32 tags;
+    int i, num;
+
+    path = bench_fixture (BENCH_FIXTURE_ETAGS);
+    tags = (guint32) BENCH_SCALED (BENCH_ETAGS_FILES) * BENCH_ETAGS_TAGS;
+
+    fixture_seed (BENCH_SEED);
+    names = g_new (char *, BENCH_ETAGS_LOOKUPS + 1);
+    for (i = 0; i < BENCH_ETAGS_LOOKUPS; i++)
+        names[i] = fixture_tag_name (fixture_random () % tags);
+    names[i] = NULL;
+
+    /* index is built before the first iteration */
+    num = etags_find_definitions (path, bench_dir, names[0], FALSE, def_hash, MAX_DEFINITIONS);
+    bench_etags_free (def_hash, num);
+
+    while (bench_next (run))
+        for (i = 0; i < BENCH_ETAGS_LOOKUPS; i++)
+        {
+            num = etags_find_definitions (path, bench_dir, names[i], FALSE, def_hash,
+                                          MAX_DEFINITIONS);
+            if (num != 1)
+                bench_fatal ("tag not found", names[i]);
+            bench_etags_free (def_hash, num);
+        }
+
+    run->items = BENCH_ETAGS_LOOKUPS;
+
+    etags_free_index ();
+    g_strfreev (names);
+}
+#endif /* USE_INTERNAL_EDIT */
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file highlighting ***/
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+bench_mc_fhl_get_color (bench_run_t * run)
+{
+    mc_fhl_t *fhl;
+    char *ini;
+    dir_list list = { NULL, 0, 0, NULL };
+    int i, n;
+
+    fhl = mc_fhl_new (FALSE);
+    ini = g_build_filename (BENCH_MISC_DIR, MC_FHL_INI_FILE, (char *) NULL);
+    if (!mc_fhl_read_ini_file (fhl, ini) || !mc_fhl_parse_ini_file (fhl))
+        bench_fatal ("cannot load", ini);
+    g_free (ini);
+
+    /* all kinds of entries in the same proportions as in fixture_make_flat_dir() */
+    n = BENCH_SCALED (BENCH_FHL_ENTRIES);
+    for (i = 0; i < n; i++)
+    {
+        struct stat st;
+        char *name;
+
+        memset (&st, 0, sizeof (st));
+        if (i % 16 == 1)
+            st.st_mode = S_IFDIR | 0755;
+        else if (i % 64 == 2)
+            st.st_mode = S_IFLNK | 0777;
+        else if (i % 97 == 3)
+            st.st_mode = S_IFCHR | 0600;
+        else
+            st.st_mode = S_IFREG | ((i % 8 == 3) ? 0755 : 0644);
+        st.st_size = (off_t) i;
+
+        name = fixture_name ((guint32) i);
+        dir_list_append (&list, name, &st, FALSE, FALSE);
+        g_free (name);
+    }
+
+    while (bench_next (run))
+    {
+        int sum = 0;
+
+        for (i = 0; i < list.len; i++)
+            sum += mc_fhl_get_color (fhl, &list.list[i]);
+
+        (void) sum;
+    }
+
+    run->items = (gsize) list.len;
+
+    dir_list_clean (&list);
+    g_free (list.list);
+    mc_fhl_free (&fhl);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** widgets ***/
+/* --------------------------------------------------------------------------------------------- */
+/** Jump, keyboard navigation and draw near the end of listbox with many entries */
+
+static void
+bench_listbox_navigate (bench_run_t * run)
+{
+    WDialog owner;
+    WListbox *l;
+    int entries, i;
+
+    memset (&owner, 0, sizeof (owner));
+    owner.color = dialog_colors;
+
+    l = listbox_new (0, 0, BENCH_LISTBOX_LINES, 40, FALSE, NULL);
+    WIDGET (l)->owner = &owner;
+
+    entries = BENCH_SCALED (BENCH_LISTBOX_ENTRIES);
+    for (i = 0; i < entries; i++)
+    {
+        char text[32];
+
+        g_snprintf (text, sizeof (text), "entry %07d", i);
+        listbox_add_item (l, LISTBOX_APPEND_AT_END, 0, text, NULL);
+    }
+
+    while (bench_next (run))
+        for (i = 0; i < BENCH_LISTBOX_ROUNDS; i++)
+        {
+            listbox_select_entry (l, entries - 1 - i);
+            send_message (l, NULL, MSG_DRAW, 0, NULL);
+
+            send_message (l, NULL, MSG_ACTION, CK_Bottom, NULL);
+            send_message (l, NULL, MSG_ACTION, CK_PageUp, NULL);
+            send_message (l, NULL, MSG_ACTION, CK_Up, NULL);
+            send_message (l, NULL, MSG_DRAW, 0, NULL);
+        }
+
+    run->items = BENCH_LISTBOX_ROUNDS;
+
+    send_message (l, NULL, MSG_DESTROY, 0, NULL);
+    g_free (l);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** terminal output ***/
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef BENCH_TTY
+/**
+ * Open new pseudo-terminal.
+ *
+ * @return FALSE if pseudo-terminal isn't available
+ */
+
+static gboolean
+bench_pty_open (int *master, int *slave)
+{
+    const char *slave_name;
+
+    *master = posix_openpt (O_RDWR | O_NOCTTY);
+    if (*master == -1)
+        return FALSE;
+
+    if (grantpt (*master) == -1 || unlockpt (*master) == -1
+        || (slave_name = ptsname (*master)) == NULL
+        || (*slave = open (slave_name, O_RDWR | O_NOCTTY)) == -1)
+    {
+        close (*master);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Replace stdin and stdout with slave side of new pseudo-terminal. Terminal output is counted
+ * by child process which reads the master side.
+ *
+ * @param saved_fds stdin and stdout to restore by bench_tty_close()
+ * @param counter pid of child process
+ * @param result pipe to read number of bytes from
+ *
+ * @return FALSE if pseudo-terminal isn't available
+ */
+
+static gboolean
+bench_tty_open (int saved_fds[2], pid_t * counter, int *result)
+{
+    struct winsize ws;
+    int master, slave, fds[2];
+
+    if (!bench_pty_open (&master, &slave))
+        return FALSE;
+
+    memset (&ws, 0, sizeof (ws));
+    ws.ws_col = BENCH_TTY_COLS;
+    ws.ws_row = BENCH_TTY_LINES;
+    ioctl (slave, TIOCSWINSZ, &ws);
+
+    if (pipe (fds) == -1)
+    {
+        close (slave);
+        close (master);
+        return FALSE;
+    }
+
+    fflush (stdout);
+    *counter = fork ();
+    if (*counter == 0)
+    {
+        char buf[BUF_8K];
+        guint64 total = 0;
+        ssize_t n;
+
+        close (slave);
+        close (fds[0]);
+
+        /* EIO when all slave descriptors are closed */
+        while ((n = read (master, buf, sizeof (buf))) > 0)
+            total += (guint64) n;
+
+        n = write (fds[1], &total, sizeof (total));
+        _exit (n == sizeof (total) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    close (master);
+    close (fds[1]);
+    *result = fds[0];
+
+    if (*counter == -1)
+    {
+        close (slave);
+        close (fds[0]);
+        return FALSE;
+    }
+
+    saved_fds[0] = dup (STDIN_FILENO);
+    saved_fds[1] = dup (STDOUT_FILENO);
+    dup2 (slave, STDIN_FILENO);
+    dup2 (slave, STDOUT_FILENO);
+    close (slave);
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** @return number of bytes written to the pseudo-terminal */
+
+static guint64
+bench_tty_close (const int saved_fds[2], pid_t counter, int result)
+{
+    guint64 total = 0;
+
+    fflush (stdout);
+    dup2 (saved_fds[0], STDIN_FILENO);
+    dup2 (saved_fds[1], STDOUT_FILENO);
+    close (saved_fds[0]);
+    close (saved_fds[1]);
+
+    if (read (result, &total, sizeof (total)) != sizeof (total))
+        total = 0;
+    close (result);
+    waitpid (counter, NULL, 0);
+
+    return total;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Repaint whole screen of pseudo-terminal with text in runs of different colors like in panels.
+ * Calls of terminal library are counted as one for color change and one for every write.
+ */
+
+static void
+bench_tty_print (bench_run_t * run, gboolean use_cells)
+{
+    int saved_fds[2], result;
+    pid_t counter;
+    int colors[BENCH_TTY_COLORS];
+    tty_cell_t *screen;
+    int cols, lines, y, x, i;
+    gsize calls = 0;
+    guint64 bytes;
+
+    if (!bench_tty_open (saved_fds, &counter, &result))
+    {
+        run->note = g_strdup ("pseudo-terminal isn't available");
+        return;
+    }
+
+    tty_init (FALSE, FALSE);
+    tty_init_colors (FALSE, FALSE);
+    colors[0] = tty_try_alloc_color_pair2 ("lightgray", "blue", NULL, FALSE);
+    colors[1] = tty_try_alloc_color_pair2 ("white", "blue", "bold", FALSE);
+    colors[2] = tty_try_alloc_color_pair2 ("brightgreen", "blue", NULL, FALSE);
+    colors[3] = tty_try_alloc_color_pair2 ("black", "cyan", NULL, FALSE);
+
+    cols = min (COLS, BENCH_TTY_COLS);
+    lines = min (LINES, BENCH_TTY_LINES);
+
+    /* runs of 1..32 characters */
+    fixture_seed (BENCH_SEED);
+    screen = g_new (tty_cell_t, cols * lines);
+    for (i = 0; i < cols * lines;)
+    {
+        int color, len;
+
+        color = colors[fixture_random () % BENCH_TTY_COLORS];
+        for (len = 1 + (int) (fixture_random () % 32); len > 0 && i < cols * lines; len--, i++)
+        {
+            screen[i].ch = 'a' + (int) (fixture_random () % 26);
+            screen[i].color = color;
+        }
+    }
+
+    while (bench_next (run))
+    {
+        for (i = 0; i < BENCH_TTY_REPAINTS; i++)
+        {
+            tty_touch_screen ();
+
+            for (y = 0; y < lines; y++)
+            {
+                const tty_cell_t *row = &screen[y * cols];
+
+                tty_gotoyx (y, 0);
+
+                if (use_cells)
+                    tty_print_cells (row, cols);
+                else
+                    for (x = 0; x < cols; x++)
+                    {
+                        tty_setcolor (row[x].color);
+                        tty_print_anychar (row[x].ch);
+                    }
+            }
+
+            tty_refresh ();
+        }
+    }
+
+    for (i = 0; i < cols * lines; i++)
+        if (!use_cells)
+            calls += 2;
+        else if (i % cols == 0 || screen[i].color != screen[i - 1].color)
+            calls += 2;
+
+    g_free (screen);
+    tty_colors_done ();
+    tty_shutdown ();
+
+    bytes = bench_tty_close (saved_fds, counter, result);
+
+    run->items = BENCH_TTY_REPAINTS;
+    run->note = g_strdup_printf ("%dx%d, %" G_GUINT64_FORMAT " bytes and %" G_GSIZE_FORMAT
+                                 " calls per repaint", cols, lines,
+                                 bytes / (guint64) (run->done * BENCH_TTY_REPAINTS), calls);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+bench_tty_print_anychar (bench_run_t * run)
+{
+    bench_tty_print (run, FALSE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+bench_tty_print_cells (bench_run_t * run)
+{
+    bench_tty_print (run, TRUE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Relay output of command from pseudo-terminal like subshell does it. Child process writes
+ * lines of text to the slave side, output is relayed to /dev/null.
+ *
+ * @param size size of relay buffer, BUF_SMALL is read by one call per select() as before
+ */
+
+#ifdef ENABLE_SUBSHELL
+static void
+bench_subshell_relay (bench_run_t * run, size_t size)
+{
+    const guint64 expected = (guint64) BENCH_SCALED (BENCH_RELAY_SIZE);
+    char *buf;
+    int null_fd;
+    gboolean lost = FALSE;
+
+    buf = g_malloc (size);
+    null_fd = open ("/dev/null", O_WRONLY);
+    if (null_fd == -1)
+        bench_fatal ("cannot open", "/dev/null");
+
+    while (bench_next (run))
+    {
+        int master, slave;
+        struct termios mode;
+        pid_t writer;
+        guint64 relayed = 0;
+
+        bench_pause (run);
+        if (!bench_pty_open (&master, &slave))
+            bench_fatal ("cannot open pseudo-terminal", "/dev/ptmx");
+
+        /* don't translate newlines */
+        tcgetattr (slave, &mode);
+        mode.c_oflag &= ~OPOST;
+        mode.c_lflag &= ~(ICANON | ECHO | ISIG);
+        tcsetattr (slave, TCSANOW, &mode);
+        bench_resume (run);
+
+        fflush (stdout);
+        writer = fork ();
+        if (writer == 0)
+        {
+            char block[BUF_8K];
+            guint64 written = 0;
+            size_t i;
+
+            close (master);
+            memset (block, 'x', sizeof (block));
+            for (i = BENCH_RELAY_LINE; i < sizeof (block); i += BENCH_RELAY_LINE + 1)
+                block[i] = '\n';
+
+            while (written < expected)
+            {
+                ssize_t n;
+
+                n = write (slave, block, MIN (sizeof (block), expected - written));
+                if (n <= 0)
+                    _exit (EXIT_FAILURE);
+                written += (guint64) n;
+            }
+            _exit (EXIT_SUCCESS);
+        }
+
+        close (slave);
+        if (writer == -1)
+            bench_fatal ("cannot fork", "writer");
+
+        /* EIO when writer has exited and all data is read */
+        while (TRUE)
+        {
+            fd_set read_set;
+            ssize_t n;
+
+            FD_ZERO (&read_set);
+            FD_SET (master, &read_set);
+            if (select (master + 1, &read_set, NULL, NULL, NULL) == -1)
+                continue;
+
+            n = subshell_relay_pty (master, null_fd, buf, size, NULL);
+            if (n > 0)
+                relayed += (guint64) n;
+            else if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+                break;
+        }
+
+        waitpid (writer, NULL, 0);
+        close (master);
+
+        if (relayed != expected)
+            lost = TRUE;
+    }
+
+    run->items = (gsize) expected;
+    if (lost)
+        run->note = g_strdup ("some output was lost");
+
+    close (null_fd);
+    g_free (buf);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+bench_subshell_relay_large (bench_run_t * run)
+{
+    bench_subshell_relay (run, 64 * 1024);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+bench_subshell_relay_small (bench_run_t * run)
+{
+    bench_subshell_relay (run, BUF_SMALL);
+}
+#endif /* ENABLE_SUBSHELL */
+#endif /* BENCH_TTY */
+
+/* --------------------------------------------------------------------------------------------- */
+/*** archives ***/
+/* --------------------------------------------------------------------------------------------- */
+/** Open archive and read its root directory. Archive is parsed at every iteration */
+
+#if defined(ENABLE_VFS_TAR) || defined(ENABLE_VFS_CPIO)
+static void
+bench_vfs_archive (bench_run_t * run, bench_fixture_t fixture, const char *prefix)
+{
+    dir_sort_options_t sort_op = { FALSE, TRUE, FALSE };
+    dir_list list = { NULL, 0, 0, NULL };
+    char *path;
+    vfs_path_t *vpath;
+
+    path = g_strconcat (bench_fixture (fixture), PATH_SEP_STR, prefix, VFS_PATH_URL_DELIMITER,
+                        (char *) NULL);
+    vpath = vfs_path_from_str (path);
+
+    while (bench_next (run))
+    {
+        const vfs_path_element_t *element;
+        vfsid id;
+
+        if (mc_chdir (vpath) != 0)
+            bench_fatal ("cannot open archive", path);
+        dir_list_load (&list, vpath, (GCompareFunc) sort_name, &sort_op, NULL);
+
+        /* forget parsed archive */
+        bench_pause (run);
+        element = vfs_path_get_by_index (vpath, -1);
+        id = vfs_getid (vpath);
+        mc_chdir (bench_dir_vpath);
+        if (element->class->free != NULL && id != NULL)
+            element->class->free (id);
+        bench_resume (run);
+    }
+
+    run->items = (gsize) (BENCH_SCALED (BENCH_ARCHIVE_DIRS) * (BENCH_ARCHIVE_FILES + 1));
+
+    dir_list_clean (&list);
+    g_free (list.list);
+    vfs_path_free (vpath);
+    g_free (path);
+}
+#endif
+
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef ENABLE_VFS_TAR
+static void
+bench_vfs_tar (bench_run_t * run)
+{
+    bench_vfs_archive (run, BENCH_FIXTURE_TAR, "utar");
+}
+#endif
+
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef ENABLE_VFS_CPIO
+static void
+bench_vfs_cpio (bench_run_t * run)
+{
+    bench_vfs_archive (run, BENCH_FIXTURE_CPIO, "ucpio");
+}
+#endif
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+static const bench_t benchmarks[] =
+{
+    { "dir_list_load", 5, bench_dir_list_load },
+    { "dir_list_sort/name", 5, bench_dir_list_sort_name },
+    { "dir_list_sort/ext", 5, bench_dir_list_sort_ext },
+    { "dir_list_sort/size", 5, bench_dir_list_sort_size },
+    { "dir_list_sort/time", 5, bench_dir_list_sort_time },
+    { "dir_list/huge", 3, bench_dir_list_huge },
+    { "mc_search_run/glob", 3, bench_search_glob },
+    { "mc_search_run/regex", 3, bench_search_regex },
+    { "mc_search_run/text", 3, bench_search_text },
+    { "mc_search_run_batch/glob", 3, bench_search_batch },
+#ifdef HAVE_CHARSET
+    { "recode/iconv", 3, bench_recode_iconv },
+    { "recode/table", 3, bench_recode_table },
+#endif
+    { "copy_file_file/large", 3, bench_copy_large },
+    { "copy_file_file/small", 3, bench_copy_small },
+    { "copy_dir_dir/hardlinks", 1, bench_copy_hardlinks },
+    { "mcview_display_text", 3, bench_mcview_display_text },
+#ifdef USE_INTERNAL_EDIT
+    { "edit_buffer/insert", 3, bench_edit_buffer_insert },
+    { "edit_buffer/navigate", 3, bench_edit_buffer_navigate },
+    { "edit_buffer/delete", 3, bench_edit_buffer_delete },
+    { "book_mark/shift", 3, bench_book_mark_shift },
+    { "etags/index", 3, bench_etags_index },
+    { "etags/lookup", 3, bench_etags_lookup },
+#endif
+    { "mc_fhl_get_color", 5, bench_mc_fhl_get_color },
+    { "listbox/navigate", 3, bench_listbox_navigate },
+#ifdef BENCH_TTY
+    { "tty_repaint/anychar", 3, bench_tty_print_anychar },
+    { "tty_repaint/cells", 3, bench_tty_print_cells },
+#ifdef ENABLE_SUBSHELL
+    { "subshell_relay/large", 3, bench_subshell_relay_large },
+    { "subshell_relay/small", 3, bench_subshell_relay_small },
+#endif
+#endif
+#ifdef ENABLE_VFS_TAR
+    { "vfs_tar/load", 3, bench_vfs_tar },
+#endif
+#ifdef ENABLE_VFS_CPIO
+    { "vfs_cpio/load", 3, bench_vfs_cpio },
+#endif
+};
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+bench_selected (const bench_t * b, int argc, char **argv)
+{
+    int i;
+
+    if (argc < 2)
+        return TRUE;
+
+    for (i = 1; i < argc; i++)
+        if (g_str_has_prefix (b->name, argv[i]))
+            return TRUE;
+
+    return FALSE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+bench_init (void)
+{
+    char *tmpl;
+
+    str_init_strings (NULL);
+
+    vfs_init ();
+    init_localfs ();
+#ifdef ENABLE_VFS_CPIO
+    init_cpiofs ();
+#endif
+#ifdef ENABLE_VFS_TAR
+    init_tarfs ();
+#endif
+    vfs_setup_work_dir ();
+
+    /* no terminal and no user files */
+    use_dash (FALSE);
+    mcview_remember_file_position = FALSE;
+
+    tmpl = g_build_filename (g_get_tmp_dir (), "mcbench-XXXXXX", (char *) NULL);
+    if (mkdtemp (tmpl) == NULL)
+        bench_fatal ("cannot create directory", tmpl);
+
+    bench_dir = tmpl;
+    bench_dir_vpath = vfs_path_from_str (bench_dir);
+    mc_chdir (bench_dir_vpath);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+bench_done (void)
+{
+    int i;
+
+    for (i = 0; i < BENCH_FIXTURE_COUNT; i++)
+        g_free (bench_fixture_paths[i]);
+
+    if (bench_keep)
+        fprintf (stderr, "mcbench: fixtures are kept in %s\n", bench_dir);
+    else
+        fixture_remove_tree (bench_dir);
+
+    vfs_path_free (bench_dir_vpath);
+    g_free (bench_dir);
+
+    vfs_shut ();
+    str_uninit_strings ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (int argc, char **argv)
+{
+    GOptionContext *context;
+    GError *error = NULL;
+    FILE *out = stdout;
+    size_t i;
+
+    context = g_option_context_new ("[BENCHMARK-PREFIX...]");
+    g_option_context_add_main_entries (context, bench_options, NULL);
+    if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+        fprintf (stderr, "mcbench: %s\n", error->message);
+        g_error_free (error);
+        g_option_context_free (context);
+        return EXIT_FAILURE;
+    }
+    g_option_context_free (context);
+
+    if (bench_list)
+    {
+        for (i = 0; i < G_N_ELEMENTS (benchmarks); i++)
+            printf ("%s\n", benchmarks[i].name);
+        return EXIT_SUCCESS;
+    }
+
+    if (bench_scale < 1)
+        bench_scale = 1;
+
+    if (bench_output != NULL)
+    {
+        out = fopen (bench_output, "w");
+        if (out == NULL)
+            bench_fatal ("cannot open", bench_output);
+    }
+
+    bench_init ();
+
+    fprintf (out, "# mcbench %s scale=%d\n", VERSION, bench_scale);
+    fprintf (out, "benchmark\titerations\titems\ttotal_s\tbest_s\titems_per_s\n");
+    fflush (out);
+
+    for (i = 0; i < G_N_ELEMENTS (benchmarks); i++)
+    {
+        const bench_t *b = &benchmarks[i];
+        bench_run_t run;
+
+        if (!bench_selected (b, argc, argv))
+            continue;
+
+        memset (&run, 0, sizeof (run));
+        run.iterations = b->iterations;
+        run.timer = g_timer_new ();
+
+        b->run (&run);
+
+        fprintf (out, "%s\t%d\t%" G_GSIZE_FORMAT "\t%.6f\t%.6f\t%.0f\n", b->name, run.done,
+                 run.items, run.total, run.best, run.best > 0 ? (double) run.items / run.best : 0);
+        if (run.note != NULL)
+            fprintf (out, "# %s: %s\n", b->name, run.note);
+        fflush (out);
+
+        g_free (run.note);
+
+        g_timer_destroy (run.timer);
+    }
+
+    bench_done ();
+
+    if (out != stdout)
+        fclose (out);
+    g_free (bench_output);
+
+    return EXIT_SUCCESS;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,282 @@
+/*
+   lib - precomputed 8-bit <-> Unicode recode tables
+
+   Copyright (C) 2014
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/lib"
+
+#include "tests/mctest.h"
+
+/* number of g_iconv() calls made by lib/charsets.c */
+static int g_iconv__calls;
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Mock */
+static gsize
+g_iconv__counted (GIConv converter, gchar ** inbuf, gsize * inbytes_left, gchar ** outbuf,
+                  gsize * outbytes_left)
+{
+    g_iconv__calls++;
+    return g_iconv (converter, inbuf, inbytes_left, outbuf, outbytes_left);
+}
+
+#define g_iconv g_iconv__counted
+#include "lib/charsets.c"
+#undef g_iconv
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    str_init_strings ("UTF-8");
+    mc_global.share_data_dir = (char *) TEST_SHARE_DIR;
+    mc_global.sysconfig_dir = (char *) TEST_SHARE_DIR;
+    load_codepages_list ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    free_codepages_list ();
+    str_uninit_strings ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_codepage_table_ds") */
+/* *INDENT-OFF* */
+static const struct test_codepage_table_ds
+{
+    const char *codepage;
+} test_codepage_table_ds[] =
+{
+    { /* 0. */
+        "CP1251"
+    },
+    { /* 1. */
+        "IBM866"
+    },
+    { /* 2. */
+        "KOI8-R"
+    },
+    { /* 3. */
+        "KOI8-U"
+    },
+};
+/* *INDENT-ON* */
+
+/* @Test(dataSource = "test_codepage_table_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_codepage_table, test_codepage_table_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    const codepage_table_t *table;
+    GIConv conv;
+    int i;
+
+    conv = str_crt_conv_from (data->codepage);
+    mctest_assert_ptr_ne (conv, INVALID_CONV);
+
+    /* when */
+    table = get_codepage_table (get_codepage_index (data->codepage));
+
+    /* then */
+    mctest_assert_not_null (table);
+    for (i = 0; i < 256; i++)
+    {
+        int expected;
+
+        /* table lookup must be equal to iconv round-trip */
+        expected = convert_from_8bit_to_utf_c ((char) i, conv);
+        mctest_assert_int_eq (convert_from_8bit_to_utf_t (table, (unsigned char) i, conv),
+                              expected);
+
+        /* reverse map must give back a byte with the same codepoint */
+        if (table->to_utf[i] >= 0)
+        {
+            int byte;
+
+            byte = convert_unichar_to_8bit (table, (gunichar) table->to_utf[i]);
+            mctest_assert_int_ne (byte, -1);
+            mctest_assert_int_eq (table->to_utf[byte], table->to_utf[i]);
+        }
+    }
+
+    /* reverse map is strictly sorted for binary search and agrees with forward map */
+    for (i = 0; i < (int) table->from_utf_len; i++)
+    {
+        if (i > 0)
+            mctest_assert_int_eq (table->from_utf_ch[i - 1] < table->from_utf_ch[i], TRUE);
+        mctest_assert_int_eq (table->to_utf[table->from_utf_byte[i]], (int) table->from_utf_ch[i]);
+    }
+
+    str_close_conv (conv);
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_codepage_table_multibyte)
+/* *INDENT-ON* */
+{
+    /* given */
+    int cp;
+
+    /* when */
+    cp = get_codepage_index ("UTF-8");
+
+    /* then */
+    mctest_assert_int_ne (cp, -1);
+    mctest_assert_null (get_codepage_table (cp));
+    mctest_assert_null (get_codepage_table (-1));
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_codepage_table_no_iconv)
+/* *INDENT-ON* */
+{
+    /* given */
+    const codepage_table_t *table;
+    int cp;
+    GString *koi8, *utf8;
+
+    cp = get_codepage_index ("KOI8-R");
+    g_iconv__calls = 0;
+
+    /* when */
+    table = get_codepage_table (cp);
+
+    /* then */
+    /* each byte is converted once: reset of state and conversion */
+    mctest_assert_not_null (table);
+    mctest_assert_int_eq (g_iconv__calls, 2 * 256);
+
+    /* when */
+    g_iconv__calls = 0;
+    koi8 = g_string_new ("");
+    utf8 = g_string_new ("");
+    convert_buf_from_utf_to_8bit (table, "путь", strlen ("путь"), koi8);
+    convert_buf_from_8bit_to_utf (table, koi8->str, koi8->len, utf8);
+
+    /* then */
+    /* table is built once and lookups don't touch iconv */
+    mctest_assert_ptr_eq (get_codepage_table (cp), table);
+    mctest_assert_str_eq (utf8->str, "путь");
+    mctest_assert_int_eq (g_iconv__calls, 0);
+
+    /* without iconv converter the result can be correct only if table is used */
+    mctest_assert_int_eq (convert_from_8bit_to_utf_t (table, 0xD4, INVALID_CONV), 0x0442);
+    mctest_assert_int_eq (convert_from_utf_to_current_t (table, 0x0442, INVALID_CONV), 0xD4);
+
+    g_string_free (utf8, TRUE);
+    g_string_free (koi8, TRUE);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_convert_buf)
+/* *INDENT-ON* */
+{
+    /* given */
+    const codepage_table_t *table;
+    GString *koi8, *utf8;
+    gboolean ok;
+
+    table = get_codepage_table (get_codepage_index ("KOI8-R"));
+    mctest_assert_not_null (table);
+    koi8 = g_string_new ("");
+    utf8 = g_string_new ("");
+
+    /* when */
+    ok = convert_buf_from_utf_to_8bit (table, "/тестовый/путь", strlen ("/тестовый/путь"), koi8);
+    ok = ok && convert_buf_from_8bit_to_utf (table, koi8->str, koi8->len, utf8);
+
+    /* then */
+    mctest_assert_int_eq (ok, TRUE);
+    mctest_assert_int_eq (koi8->len, 14);
+    mctest_assert_str_eq (koi8->str, "/\324\305\323\324\317\327\331\312/\320\325\324\330");
+    mctest_assert_str_eq (utf8->str, "/тестовый/путь");
+
+    /* character that is absent in KOI8-R is replaced */
+    g_string_truncate (koi8, 0);
+    ok = convert_buf_from_utf_to_8bit (table, "a€b", strlen ("a€b"), koi8);
+    mctest_assert_int_eq (ok, FALSE);
+    mctest_assert_str_eq (koi8->str, "a.b");
+
+    g_string_free (utf8, TRUE);
+    g_string_free (koi8, TRUE);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    mctest_add_parameterized_test (tc_core, test_codepage_table, test_codepage_table_ds);
+    tcase_add_test (tc_core, test_codepage_table_multibyte);
+    tcase_add_test (tc_core, test_codepage_table_no_iconv);
+    tcase_add_test (tc_core, test_convert_buf);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_print (sr, CK_VERBOSE);
+    srunner_set_log (sr, "codepage_table.log");
+    srunner_run_all (sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? 0 : 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
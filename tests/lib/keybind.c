@@ -0,0 +1,261 @@
+/*
+   lib - lookups in compiled keymaps
+
+   Copyright (C) 2014
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/lib"
+
+#include "tests/mctest.h"
+
+#include "lib/keybind.h"
+#include "lib/mcconfig.h"
+#include "lib/strutil.h"
+#include "lib/tty/key.h"        /* KEY_M_MASK */
+
+#include "src/keybind-defaults.c"
+
+/* all key codes with all modifiers */
+#define KEYS_NUM (KEY_M_MASK + 0x1000)
+
+/* all commands */
+#define COMMANDS_NUM 1000
+
+static mc_config_t *default_keymap = NULL;
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    str_init_strings (NULL);
+    default_keymap = create_default_keymap ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    keybind_free_compiled_keymaps ();
+    mc_config_deinit (default_keymap);
+    str_uninit_strings ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* same as load_keymap_from_section() in src/setup.c */
+static GArray *
+load_keymap (const char *section_name)
+{
+    GArray *keymap;
+    gchar **profile_keys, **keys;
+
+    keymap = g_array_new (TRUE, FALSE, sizeof (global_keymap_t));
+    keys = mc_config_get_keys (default_keymap, section_name, NULL);
+
+    for (profile_keys = keys; *profile_keys != NULL; profile_keys++)
+    {
+        gchar **values;
+
+        values = mc_config_get_string_list (default_keymap, section_name, *profile_keys, NULL);
+        if (values != NULL)
+        {
+            unsigned long action;
+
+            action = keybind_lookup_action (*profile_keys);
+            if (action > 0)
+            {
+                gchar **curr_values;
+
+                for (curr_values = values; *curr_values != NULL; curr_values++)
+                    keybind_cmd_bind (keymap, *curr_values, action);
+            }
+
+            g_strfreev (values);
+        }
+    }
+
+    g_strfreev (keys);
+
+    return keymap;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_keymap_ds") */
+/* *INDENT-OFF* */
+static const struct test_keymap_ds
+{
+    const char *section;
+} test_keymap_ds[] =
+{
+    { KEYMAP_SECTION_MAIN },
+    { KEYMAP_SECTION_MAIN_EXT },
+    { KEYMAP_SECTION_PANEL },
+    { KEYMAP_SECTION_DIALOG },
+    { KEYMAP_SECTION_INPUT },
+    { KEYMAP_SECTION_LISTBOX },
+    { KEYMAP_SECTION_TREE },
+    { KEYMAP_SECTION_HELP },
+#ifdef USE_INTERNAL_EDIT
+    { KEYMAP_SECTION_EDITOR },
+    { KEYMAP_SECTION_EDITOR_EXT },
+#endif
+    { KEYMAP_SECTION_VIEWER },
+    { KEYMAP_SECTION_VIEWER_HEX },
+#ifdef USE_DIFF_VIEW
+    { KEYMAP_SECTION_DIFFVIEWER },
+#endif
+};
+/* *INDENT-ON* */
+
+/* @Test(dataSource = "test_keymap_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_compiled_keymap, test_keymap_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    GArray *keymap_array;
+    const global_keymap_t *keymap;
+    unsigned long *commands;
+    const char **shortcuts;
+    long key;
+    unsigned long command;
+    guint i;
+
+    keymap_array = load_keymap (data->section);
+    keymap = (const global_keymap_t *) keymap_array->data;
+    mctest_assert_int_ne (keymap_array->len, 0);
+
+    /* results of linear search */
+    commands = g_new (unsigned long, KEYS_NUM);
+    for (key = 0; key < KEYS_NUM; key++)
+        commands[key] = keybind_lookup_keymap_command (keymap, key);
+
+    shortcuts = g_new (const char *, COMMANDS_NUM);
+    for (command = 0; command < COMMANDS_NUM; command++)
+        shortcuts[command] = keybind_lookup_keymap_shortcut (keymap, command);
+
+    /* when */
+    keybind_compile_keymap (keymap);
+
+    /* then */
+    for (key = 0; key < KEYS_NUM; key++)
+        if (keybind_lookup_keymap_command (keymap, key) != commands[key])
+            ck_abort_msg ("[%s] key %ld: command %lu, expected %lu", data->section, key,
+                          keybind_lookup_keymap_command (keymap, key), commands[key]);
+
+    for (command = 0; command < COMMANDS_NUM; command++)
+        mctest_assert_ptr_eq (keybind_lookup_keymap_shortcut (keymap, command),
+                              shortcuts[command]);
+
+    /* every key and command of keymap, including ones out of tested ranges */
+    for (i = 0; i < keymap_array->len; i++)
+    {
+        const char *shortcut;
+        guint j;
+
+        for (j = 0; keymap[j].key != keymap[i].key; j++)
+            ;
+        mctest_assert_int_eq (keybind_lookup_keymap_command (keymap, keymap[i].key),
+                              keymap[j].command);
+
+        for (j = 0; keymap[j].command != keymap[i].command; j++)
+            ;
+        shortcut = (keymap[j].caption[0] != '\0') ? keymap[j].caption : NULL;
+        mctest_assert_ptr_eq (keybind_lookup_keymap_shortcut (keymap, keymap[i].command), shortcut);
+    }
+
+    mctest_assert_int_eq (keybind_lookup_keymap_command (keymap, -1), CK_IgnoreKey);
+    mctest_assert_null (keybind_lookup_keymap_shortcut (keymap, CK_IgnoreKey));
+
+    keybind_free_compiled_keymaps ();
+    g_free (shortcuts);
+    g_free (commands);
+    g_array_free (keymap_array, TRUE);
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_compiled_keymap_duplicates)
+/* *INDENT-ON* */
+{
+    /* given */
+    GArray *keymap_array;
+    const global_keymap_t *keymap;
+
+    keymap_array = g_array_new (TRUE, FALSE, sizeof (global_keymap_t));
+    keybind_cmd_bind (keymap_array, "f5", CK_Copy);
+    keybind_cmd_bind (keymap_array, "f5", CK_Move);
+    keybind_cmd_bind (keymap_array, "ctrl-x", CK_Move);
+    keybind_cmd_bind (keymap_array, "f6", CK_Move);
+    keymap = (const global_keymap_t *) keymap_array->data;
+
+    /* when */
+    keybind_compile_keymap (keymap);
+
+    /* then: first binding wins, as in linear search */
+    mctest_assert_int_eq (keybind_lookup_keymap_command (keymap, KEY_F (5)), CK_Copy);
+    mctest_assert_int_eq (keybind_lookup_keymap_command (keymap, KEY_F (6)), CK_Move);
+    mctest_assert_int_eq (keybind_lookup_keymap_command (keymap, KEY_F (7)), CK_IgnoreKey);
+    mctest_assert_str_eq (keybind_lookup_keymap_shortcut (keymap, CK_Copy), "F5");
+    mctest_assert_str_eq (keybind_lookup_keymap_shortcut (keymap, CK_Move), "F5");
+    mctest_assert_null (keybind_lookup_keymap_shortcut (keymap, CK_Delete));
+
+    g_array_free (keymap_array, TRUE);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    mctest_add_parameterized_test (tc_core, test_compiled_keymap, test_keymap_ds);
+    tcase_add_test (tc_core, test_compiled_keymap_duplicates);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "keybind.log");
+    srunner_run_all (sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? 0 : 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,245 @@
+/*
+   libmc - check mcconfig submodule. cache of parsed config files
+
+   Copyright (C) 2014
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "lib/mcconfig"
+
+#include "tests/mctest.h"
+
+#include "lib/mcconfig.h"
+#include "lib/strutil.h"
+#include "lib/vfs/vfs.h"
+#include "src/vfs/local/local.c"
+
+static char *ini_filename;
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+write_ini_file (const char *value)
+{
+    char *data;
+
+    data = g_strdup_printf ("[group]\nparam=%s\n", value);
+    ck_assert (g_file_set_contents (ini_filename, data, -1, NULL));
+    g_free (data);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+check_value (mc_config_t * config, const char *expected)
+{
+    char *actual;
+
+    actual = mc_config_get_string_raw (config, "group", "param", NULL);
+    mctest_assert_str_eq (actual, expected);
+    g_free (actual);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    str_init_strings (NULL);
+    vfs_init ();
+    init_localfs ();
+
+    ini_filename = g_build_filename (WORKDIR, "config_cache.ini", NULL);
+    write_ini_file ("first");
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    mc_config_cache_free ();
+    unlink (ini_filename);
+    g_free (ini_filename);
+
+    vfs_shut ();
+    str_uninit_strings ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_shared_and_copy_on_write)
+/* *INDENT-ON* */
+{
+    /* given */
+    mc_config_t *config1, *config2, *config3;
+
+    /* when */
+    config1 = mc_config_init (ini_filename, TRUE);
+    config2 = mc_config_init (ini_filename, TRUE);
+
+    /* then: file is parsed once */
+    ck_assert (config1->handle == config2->handle);
+    check_value (config1, "first");
+    check_value (config2, "first");
+
+    /* when: one of configs is changed */
+    mc_config_set_string_raw (config1, "group", "param", "changed");
+    mc_config_set_string_raw (config1, "group", "other", "new");
+
+    /* then: others don't see changes */
+    ck_assert (config1->handle != config2->handle);
+    check_value (config1, "changed");
+    check_value (config2, "first");
+    mctest_assert_int_eq (mc_config_has_param (config2, "group", "other"), FALSE);
+
+    mc_config_deinit (config1);
+    config3 = mc_config_init (ini_filename, TRUE);
+    ck_assert (config3->handle == config2->handle);
+    check_value (config3, "first");
+
+    /* default value is set in a copy too */
+    mctest_assert_int_eq (mc_config_get_int (config3, "group", "int", 10), 10);
+    ck_assert (config3->handle != config2->handle);
+    mctest_assert_int_eq (mc_config_has_param (config2, "group", "int"), FALSE);
+
+    mc_config_deinit (config2);
+    mc_config_deinit (config3);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_read_only_and_writable)
+/* *INDENT-ON* */
+{
+    /* given */
+    mc_config_t *config1, *config2;
+
+    /* when */
+    config1 = mc_config_init (ini_filename, TRUE);
+    config2 = mc_config_init (ini_filename, FALSE);
+
+    /* then: comments are kept in writable config only, so files aren't shared */
+    ck_assert (config1->handle != config2->handle);
+    check_value (config1, "first");
+    check_value (config2, "first");
+
+    mc_config_deinit (config1);
+    mc_config_deinit (config2);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_changed_file)
+/* *INDENT-ON* */
+{
+    /* given */
+    mc_config_t *config1, *config2;
+
+    config1 = mc_config_init (ini_filename, TRUE);
+
+    /* when: file is changed by somebody else */
+    write_ini_file ("second value");
+    config2 = mc_config_init (ini_filename, TRUE);
+
+    /* then */
+    ck_assert (config1->handle != config2->handle);
+    check_value (config1, "first");
+    check_value (config2, "second value");
+
+    mc_config_deinit (config1);
+    mc_config_deinit (config2);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_saved_file)
+/* *INDENT-ON* */
+{
+    /* given */
+    mc_config_t *config1, *config2;
+
+    config1 = mc_config_init (ini_filename, FALSE);
+    config2 = mc_config_init (ini_filename, FALSE);
+
+    /* when: file is saved with the same size in the same second */
+    mc_config_set_string_raw (config1, "group", "param", "FIRST");
+    ck_assert (mc_config_save_file (config1, NULL));
+    mc_config_deinit (config1);
+    config1 = mc_config_init (ini_filename, FALSE);
+
+    /* then */
+    check_value (config1, "FIRST");
+    check_value (config2, "first");
+
+    mc_config_deinit (config1);
+    mc_config_deinit (config2);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    tcase_add_test (tc_core, test_shared_and_copy_on_write);
+    tcase_add_test (tc_core, test_read_only_and_writable);
+    tcase_add_test (tc_core, test_changed_file);
+    tcase_add_test (tc_core, test_saved_file);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "config_cache.log");
+    srunner_run_all (sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? 0 : 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,290 @@
+/*
+   lib/search - batch matching and cache of compiled patterns
+
+   Copyright (C) 2014
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "lib/search"
+
+#include "tests/mctest.h"
+
+
+#include "lib/strutil.h"
+#include "lib/search.h"
+
+#define CHARSET "UTF-8"
+
+/* number of names in large list */
+#define NAMES_NUM 5000
+
+static const char *names[] = {
+    "..",
+    "file.c",
+    "file.C",
+    "File.h",
+    "file1.txt",
+    "file22.txt",
+    "Makefile",
+    "multi\nline.c",
+    "x",
+    "",
+    NULL
+};
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    str_init_strings (NULL);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    mc_search_cache_free ();
+    str_uninit_strings ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static const char *
+get_name (gsize index, gsize * len, gpointer user_data)
+{
+    const char **list = (const char **) user_data;
+
+    /* skip ".." like dir_list_match() does */
+    if (strcmp (list[index], "..") == 0)
+        return NULL;
+
+    *len = strlen (list[index]);
+    return list[index];
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_run_batch_ds") */
+/* *INDENT-OFF* */
+static const struct test_run_batch_ds
+{
+    const char *pattern;
+    mc_search_type_t type;
+    mc_search_flags_t flags;
+    gsize expected_found;
+} test_run_batch_ds[] =
+{
+    { /* 0. */
+        "*.c",
+        MC_SEARCH_T_GLOB,
+        MC_SEARCH_F_ENTIRE_LINE | MC_SEARCH_F_CASE_SENSITIVE,
+        1
+    },
+    { /* 1. */
+        "*.c",
+        MC_SEARCH_T_GLOB,
+        MC_SEARCH_F_ENTIRE_LINE,
+        2
+    },
+    { /* 2. */
+        "file?.txt",
+        MC_SEARCH_T_GLOB,
+        MC_SEARCH_F_ENTIRE_LINE | MC_SEARCH_F_CASE_SENSITIVE,
+        1
+    },
+    { /* 3. */
+        "^f.*[0-9]",
+        MC_SEARCH_T_REGEX,
+        MC_SEARCH_F_ENTIRE_LINE | MC_SEARCH_F_CASE_SENSITIVE,
+        2
+    },
+    { /* 4. */
+        "file",
+        MC_SEARCH_T_REGEX,
+        MC_SEARCH_F_NONE,
+        6
+    },
+    { /* 5. */
+        "ile",
+        MC_SEARCH_T_NORMAL,
+        MC_SEARCH_F_CASE_SENSITIVE,
+        6
+    },
+};
+/* *INDENT-ON* */
+
+/* @Test(dataSource = "test_run_batch_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_run_batch, test_run_batch_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    mc_search_t *search, *single;
+    guint8 *bitmap;
+    gsize count, found, i;
+
+    count = g_strv_length ((gchar **) names);
+
+    single = mc_search_new (data->pattern, -1, CHARSET);
+    single->search_type = data->type;
+    single->is_case_sensitive = (data->flags & MC_SEARCH_F_CASE_SENSITIVE) != 0;
+    single->is_entire_line = (data->flags & MC_SEARCH_F_ENTIRE_LINE) != 0;
+
+    /* when */
+    search = mc_search_cache_get (data->pattern, CHARSET, data->type, data->flags);
+    bitmap = mc_search_run_batch (search, count, get_name, names, &found);
+
+    /* then: same results as for one-by-one search */
+    mctest_assert_not_null (bitmap);
+    mctest_assert_int_eq (found, data->expected_found);
+
+    for (i = 0; i < count; i++)
+    {
+        gboolean expected;
+
+        expected = strcmp (names[i], "..") != 0
+            && mc_search_run (single, names[i], 0, strlen (names[i]), NULL);
+        mctest_assert_int_eq (MC_SEARCH_BITMAP_TEST (bitmap, i) ? 1 : 0, expected ? 1 : 0);
+    }
+
+    g_free (bitmap);
+    mc_search_free (single);
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_search_cache)
+/* *INDENT-ON* */
+{
+    mc_search_t *search;
+    int i;
+
+    /* given */
+    search = mc_search_cache_get ("*.c", CHARSET, MC_SEARCH_T_GLOB, MC_SEARCH_F_ENTIRE_LINE);
+    mctest_assert_not_null (search);
+
+    /* then: same key, same object */
+    mctest_assert_ptr_eq (mc_search_cache_get ("*.c", CHARSET, MC_SEARCH_T_GLOB,
+                                               MC_SEARCH_F_ENTIRE_LINE), search);
+
+    /* other flags, type or pattern: other object */
+    mctest_assert_ptr_ne (mc_search_cache_get ("*.c", CHARSET, MC_SEARCH_T_GLOB,
+                                               MC_SEARCH_F_ENTIRE_LINE |
+                                               MC_SEARCH_F_CASE_SENSITIVE), search);
+    mctest_assert_ptr_ne (mc_search_cache_get ("*.c", CHARSET, MC_SEARCH_T_REGEX,
+                                               MC_SEARCH_F_ENTIRE_LINE), search);
+    mctest_assert_ptr_ne (mc_search_cache_get ("*.h", CHARSET, MC_SEARCH_T_GLOB,
+                                               MC_SEARCH_F_ENTIRE_LINE), search);
+
+    /* recently used pattern is kept */
+    for (i = 0; i < 100; i++)
+    {
+        char pattern[16];
+
+        g_snprintf (pattern, sizeof (pattern), "*.%d", i);
+        mctest_assert_not_null (mc_search_cache_get (pattern, CHARSET, MC_SEARCH_T_GLOB,
+                                                     MC_SEARCH_F_ENTIRE_LINE));
+        mctest_assert_ptr_eq (mc_search_cache_get ("*.c", CHARSET, MC_SEARCH_T_GLOB,
+                                                   MC_SEARCH_F_ENTIRE_LINE), search);
+    }
+
+    /* invalid and empty patterns aren't cached */
+    mctest_assert_null (mc_search_cache_get ("(", CHARSET, MC_SEARCH_T_REGEX,
+                                             MC_SEARCH_F_NONE));
+    mctest_assert_null (mc_search_cache_get ("", CHARSET, MC_SEARCH_T_GLOB, MC_SEARCH_F_NONE));
+
+    /* mc_search() uses cache */
+    mctest_assert_int_eq (mc_search ("*.c", CHARSET, "file.c", MC_SEARCH_T_GLOB), TRUE);
+    mctest_assert_int_eq (mc_search ("*.c", CHARSET, "file.C", MC_SEARCH_T_GLOB), FALSE);
+    mctest_assert_int_eq (mc_search ("(", CHARSET, "(", MC_SEARCH_T_REGEX), FALSE);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_run_batch_large)
+/* *INDENT-ON* */
+{
+    char **list;
+    mc_search_t *search;
+    guint8 *bitmap;
+    gsize found = 0, i;
+
+    /* given */
+    list = g_new (char *, NAMES_NUM + 1);
+    for (i = 0; i < NAMES_NUM; i++)
+        list[i] = g_strdup_printf ("file%06u.txt", (unsigned int) i);
+    list[NAMES_NUM] = NULL;
+
+    /* when */
+    search = mc_search_cache_get ("*7.txt", CHARSET, MC_SEARCH_T_GLOB, MC_SEARCH_F_ENTIRE_LINE);
+    bitmap = mc_search_run_batch (search, NAMES_NUM, get_name, list, &found);
+
+    /* then */
+    mctest_assert_int_eq (found, NAMES_NUM / 10);
+    for (i = 0; i < NAMES_NUM; i++)
+        if (MC_SEARCH_BITMAP_TEST (bitmap, i) != (i % 10 == 7))
+            ck_abort_msg ("name %s: wrong result", list[i]);
+
+    g_free (bitmap);
+    g_strfreev (list);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    mctest_add_parameterized_test (tc_core, test_run_batch, test_run_batch_ds);
+    tcase_add_test (tc_core, test_search_cache);
+    tcase_add_test (tc_core, test_run_batch_large);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "run_batch.log");
+    srunner_run_all (sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? 0 : 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
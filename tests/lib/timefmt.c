@@ -0,0 +1,285 @@
+/*
+   lib - cache of file time formatting
+
+   Copyright (C) 2014
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/lib"
+
+#include "tests/mctest.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "lib/timefmt.c"
+
+/* central European time with DST: switch at 01:00 UTC of the last Sundays of March and October */
+#define TZ_CET "CET-1CEST,M3.5.0,M10.5.0/3"
+/* Lord Howe Island: DST shift is half an hour */
+#define TZ_HALF "<+1030>-10:30<+11>-11,M10.1.0,M4.1.0"
+
+/* 2014-03-30 01:00:00 UTC: spring forward in CET */
+#define CET_SPRING ((time_t) 1396141200)
+/* 2014-10-26 01:00:00 UTC: fall back in CET */
+#define CET_AUTUMN ((time_t) 1414285200)
+/* 2014-04-05 15:00:00 UTC: fall back in TZ_HALF */
+#define HALF_AUTUMN ((time_t) 1396710000)
+
+#define HOUR (60 * 60)
+#define DAY (24 * HOUR)
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+set_zone (const char *zone)
+{
+    setenv ("TZ", zone, 1);
+    tzset ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Format time by the way without cache */
+
+static const char *
+reference_date (time_t when, time_t current_time)
+{
+    static char buf[TIMEFMT_BUF_LEN];
+    const char *fmt;
+
+    if (current_time > when + TIMEFMT_OLD_AGE || current_time < when - TIMEFMT_FUTURE_SLOP)
+        fmt = user_old_timeformat;
+    else
+        fmt = user_recent_timeformat;
+
+    FMT_LOCALTIME (buf, sizeof (buf), fmt, when);
+    return buf;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+check_range (time_t from, time_t to, time_t step, time_t current_time)
+{
+    time_t t;
+
+    for (t = from; t < to; t += step)
+    {
+        char *expected;
+
+        expected = g_strdup (reference_date (t, current_time));
+        mctest_assert_str_eq (file_date_at (t, current_time), expected);
+        g_free (expected);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    set_zone ("UTC");
+    user_recent_timeformat = g_strdup ("%b %e %H:%M");
+    user_old_timeformat = g_strdup ("%b %e  %Y");
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    g_free (user_recent_timeformat);
+    g_free (user_old_timeformat);
+    user_recent_timeformat = NULL;
+    user_old_timeformat = NULL;
+    timefmt_zone_isdst = -1;
+    timefmt_cache_flush ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_dst_ds") */
+/* *INDENT-OFF* */
+static const struct test_dst_ds
+{
+    const char *zone;
+    time_t transition;
+    const char *recent_format;
+} test_dst_ds[] =
+{
+    { TZ_CET, CET_SPRING, "%b %e %H:%M" },
+    { TZ_CET, CET_AUTUMN, "%b %e %H:%M" },
+    { TZ_CET, CET_AUTUMN, "%F %T %Z" },
+    { TZ_CET, CET_AUTUMN, "%a %k:%M %I%p" },
+    { TZ_HALF, HALF_AUTUMN, "%b %e %R" },
+    { TZ_HALF, HALF_AUTUMN, "%j %T%z" }
+};
+/* *INDENT-ON* */
+
+/* @Test(dataSource = "test_dst_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_dst, test_dst_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    time_t current_time = data->transition + DAY;
+
+    set_zone (data->zone);
+    g_free (user_recent_timeformat);
+    user_recent_timeformat = g_strdup (data->recent_format);
+
+    /* when, then: every minute around transition */
+    check_range (data->transition - 2 * DAY, data->transition + 2 * DAY, 60, current_time);
+    /* every second close to transition, cache is filled already */
+    check_range (data->transition - 2 * HOUR, data->transition + 2 * HOUR, 1, current_time);
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_cutoff_ds") */
+/* *INDENT-OFF* */
+static const struct test_cutoff_ds
+{
+    time_t age;
+    gboolean old;
+} test_cutoff_ds[] =
+{
+    { 0, FALSE },
+    { TIMEFMT_OLD_AGE, FALSE },
+    { TIMEFMT_OLD_AGE + 1, TRUE },
+    { -TIMEFMT_FUTURE_SLOP, FALSE },
+    { -TIMEFMT_FUTURE_SLOP - 1, TRUE },
+    { -DAY, TRUE }
+};
+/* *INDENT-ON* */
+
+/* @Test(dataSource = "test_cutoff_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_cutoff, test_cutoff_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    time_t current_time = CET_SPRING + 12 * HOUR + 34 * 60;
+    time_t when = current_time - data->age;
+    const char *actual;
+
+    set_zone (TZ_CET);
+    g_free (user_recent_timeformat);
+    g_free (user_old_timeformat);
+    user_recent_timeformat = g_strdup ("recent %H:%M");
+    user_old_timeformat = g_strdup ("old %Y");
+
+    /* when: the same day is formatted twice with different current time */
+    file_date_at (when, when);
+    actual = file_date_at (when, current_time);
+
+    /* then */
+    mctest_assert_str_eq (actual, reference_date (when, current_time));
+    mctest_assert_int_eq (strncmp (actual, "old ", 4) == 0, data->old);
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_zone_change)
+/* *INDENT-ON* */
+{
+    /* given */
+    time_t current_time = CET_AUTUMN + 10 * DAY;
+    const time_t when = current_time - 3 * HOUR;
+
+    set_zone ("UTC");
+    mctest_assert_str_eq (file_date_at (when, current_time), "Nov  4 22:00");
+
+    /* when: time zone is changed */
+    set_zone ("JST-9");
+
+    /* then: old intervals are used until the next check of time zone */
+    mctest_assert_str_eq (file_date_at (when, current_time + TIMEFMT_ZONE_CHECK - 1),
+                          "Nov  4 22:00");
+    mctest_assert_str_eq (file_date_at (when, current_time + TIMEFMT_ZONE_CHECK),
+                          "Nov  5 07:00");
+    check_range (when - 2 * DAY, when + DAY, 60, current_time + TIMEFMT_ZONE_CHECK);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_format_change)
+/* *INDENT-ON* */
+{
+    /* given */
+    time_t current_time = CET_SPRING;
+
+    check_range (current_time - DAY, current_time, 60, current_time);
+
+    /* when */
+    g_free (user_recent_timeformat);
+    user_recent_timeformat = g_strdup ("%H%M%S%k%R%T%H%M%S%%H");
+
+    /* then: format with too many time conversions isn't split */
+    check_range (current_time - DAY, current_time, 61, current_time);
+    mctest_assert_int_eq (timefmt_formats[0].split, FALSE);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    mctest_add_parameterized_test (tc_core, test_dst, test_dst_ds);
+    mctest_add_parameterized_test (tc_core, test_cutoff, test_cutoff_ds);
+    tcase_add_test (tc_core, test_zone_change);
+    tcase_add_test (tc_core, test_format_change);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "timefmt.log");
+    srunner_run_all (sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? 0 : 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,336 @@
+/*
+   lib/tty - waiting for descriptors, idle timers and completions
+
+   Copyright (C) 2014
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/lib/tty"
+
+#include <config.h>
+
+#include <fcntl.h>              /* O_NONBLOCK must be defined before lib/global.h */
+
+#include "tests/mctest.h"
+
+#include <unistd.h>
+
+#include "lib/tty/event.c"
+
+/* wait time in microseconds */
+#define WAIT_TIME (G_USEC_PER_SEC / 10)
+
+static int test_pipe[2];
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    tty_event_init ();
+    ck_assert (pipe (test_pipe) == 0);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    close (test_pipe[0]);
+    close (test_pipe[1]);
+    tty_event_done ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+use_backend (gboolean use_epoll)
+{
+#ifdef EVENT_USE_EPOLL
+    if (!use_epoll)
+        event_epoll_close ();
+#endif
+
+    if (!use_epoll)
+        mctest_assert_int_eq (tty_event_is_epoll (), FALSE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+count_call (void *data)
+{
+    (*(int *) data)++;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef HAVE_GLIB_THREADS
+static gpointer
+post_thread (gpointer data)
+{
+    g_usleep (WAIT_TIME / 2);
+    tty_post_completion (count_call, data);
+    return NULL;
+}
+#endif
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_backend_ds") */
+/* *INDENT-OFF* */
+static const struct test_backend_ds
+{
+    gboolean use_epoll;
+} test_backend_ds[] =
+{
+    { TRUE },
+    { FALSE }
+};
+/* *INDENT-ON* */
+
+/* @Test(dataSource = "test_backend_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_wait_fd, test_backend_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    struct timeval time_out;
+    gint64 start;
+    int ret;
+
+    use_backend (data->use_epoll);
+
+    /* when: nothing to read */
+    tty_event_reset ();
+    tty_event_add_fd (test_pipe[0]);
+    time_out.tv_sec = 0;
+    time_out.tv_usec = WAIT_TIME;
+    start = g_get_monotonic_time ();
+    ret = tty_event_wait (&time_out, NULL);
+
+    /* then: timeout is kept */
+    mctest_assert_int_eq (ret, 0);
+    ck_assert (g_get_monotonic_time () - start >= WAIT_TIME);
+    mctest_assert_int_eq (tty_event_is_ready (test_pipe[0]), FALSE);
+
+    /* when: there is something to read */
+    ck_assert (write (test_pipe[1], "x", 1) == 1);
+    tty_event_reset ();
+    tty_event_add_fd (test_pipe[0]);
+    ret = tty_event_wait (NULL, NULL);
+
+    /* then */
+    mctest_assert_int_eq (ret, 1);
+    mctest_assert_int_eq (tty_event_is_ready (test_pipe[0]), TRUE);
+    tty_event_clear_ready (test_pipe[0]);
+    mctest_assert_int_eq (tty_event_is_ready (test_pipe[0]), FALSE);
+
+    /* when: descriptor isn't waited for any more */
+    tty_event_reset ();
+    time_out.tv_sec = 0;
+    time_out.tv_usec = 0;
+    ret = tty_event_wait (&time_out, NULL);
+
+    /* then */
+    mctest_assert_int_eq (ret, 0);
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test(dataSource = "test_backend_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_reused_fd, test_backend_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    int fd, new_pipe[2];
+    struct timeval time_out;
+
+    use_backend (data->use_epoll);
+
+    fd = test_pipe[0];
+    tty_event_reset ();
+    tty_event_add_fd (fd);
+    time_out.tv_sec = 0;
+    time_out.tv_usec = 0;
+    mctest_assert_int_eq (tty_event_wait (&time_out, NULL), 0);
+
+    /* when: descriptor is closed and its number is got by other pipe */
+    close (test_pipe[0]);
+    close (test_pipe[1]);
+    tty_event_forget_fd (fd);
+    ck_assert (pipe (new_pipe) == 0);
+    if (new_pipe[0] != fd)
+    {
+        ck_assert (dup2 (new_pipe[0], fd) == fd);
+        close (new_pipe[0]);
+    }
+    test_pipe[0] = fd;
+    test_pipe[1] = new_pipe[1];
+    ck_assert (write (test_pipe[1], "x", 1) == 1);
+
+    /* then */
+    tty_event_reset ();
+    tty_event_add_fd (fd);
+    mctest_assert_int_eq (tty_event_wait (NULL, NULL), 1);
+    mctest_assert_int_eq (tty_event_is_ready (fd), TRUE);
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test(dataSource = "test_backend_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_idle_timer, test_backend_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    struct timeval time_out;
+    gboolean completed;
+    int count = 0, other = 0;
+    guint id, other_id;
+    int ret;
+
+    use_backend (data->use_epoll);
+
+    id = tty_add_idle_timer (WAIT_TIME / 10, count_call, &count);
+    other_id = tty_add_idle_timer (WAIT_TIME * 10, count_call, &other);
+    mctest_assert_int_ne (id, 0);
+    mctest_assert_int_ne (id, other_id);
+
+    /* when */
+    tty_event_reset ();
+    tty_event_add_fd (test_pipe[0]);
+    time_out.tv_sec = 0;
+    time_out.tv_usec = WAIT_TIME + WAIT_TIME / 20;
+    ret = tty_event_wait (&time_out, &completed);
+
+    /* then: timers don't break the timeout. Number of calls depends on load of machine,
+       but the short timer is due before the wait ends and is called more often */
+    mctest_assert_int_eq (ret, 0);
+    mctest_assert_int_eq (completed, FALSE);
+    ck_assert (count >= 1);
+    ck_assert (count > other);
+
+    /* when: timer is deleted */
+    tty_delete_idle_timer (id);
+    count = 0;
+    time_out.tv_sec = 0;
+    time_out.tv_usec = WAIT_TIME / 2;
+    ret = tty_event_wait (&time_out, &completed);
+
+    /* then */
+    mctest_assert_int_eq (ret, 0);
+    mctest_assert_int_eq (count, 0);
+
+    /* timers aren't run if caller doesn't serve callbacks */
+    id = tty_add_idle_timer (WAIT_TIME / 10, count_call, &count);
+    ret = tty_event_wait (&time_out, NULL);
+    mctest_assert_int_eq (ret, 0);
+    mctest_assert_int_eq (count, 0);
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test(dataSource = "test_backend_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_completion, test_backend_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    gboolean completed;
+    int count = 0;
+    int ret;
+
+    use_backend (data->use_epoll);
+
+    /* when: completion is posted before wait */
+    tty_post_completion (count_call, &count);
+    tty_post_completion (count_call, &count);
+    tty_event_reset ();
+    tty_event_add_fd (test_pipe[0]);
+    ret = tty_event_wait (NULL, &completed);
+
+    /* then */
+    mctest_assert_int_eq (ret, 0);
+    mctest_assert_int_eq (completed, TRUE);
+    mctest_assert_int_eq (count, 2);
+
+#ifdef HAVE_GLIB_THREADS
+    {
+        GThread *thread;
+
+        /* when: completion is posted by other thread while main one is blocked */
+        thread = g_thread_new ("post", post_thread, &count);
+        tty_event_reset ();
+        tty_event_add_fd (test_pipe[0]);
+        ret = tty_event_wait (NULL, &completed);
+        g_thread_join (thread);
+
+        /* then */
+        mctest_assert_int_eq (ret, 0);
+        mctest_assert_int_eq (completed, TRUE);
+        mctest_assert_int_eq (count, 3);
+    }
+#endif
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    mctest_add_parameterized_test (tc_core, test_wait_fd, test_backend_ds);
+    mctest_add_parameterized_test (tc_core, test_reused_fd, test_backend_ds);
+    mctest_add_parameterized_test (tc_core, test_idle_timer, test_backend_ds);
+    mctest_add_parameterized_test (tc_core, test_completion, test_backend_ds);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "tty_event.log");
+    srunner_run_all (sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? 0 : 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
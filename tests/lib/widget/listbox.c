@@ -0,0 +1,306 @@
+/*
+   lib/widget - WListbox with indexed entry store
+
+   Copyright (C) 2014
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/lib/widget"
+
+#include "tests/mctest.h"
+
+#include "lib/strutil.h"
+#include "lib/widget.h"
+
+/* number of entries read by listbox code */
+static int entries_read = 0;
+
+/* @Mock */
+#undef g_ptr_array_index
+#define g_ptr_array_index(array, index) (entries_read++, (array)->pdata[index])
+
+#include "lib/widget/listbox.c"
+
+/* number of entries in listbox */
+#define ENTRIES 5000
+
+/* number of listbox lines */
+#define LINES_NUM 20
+
+/* number of repeated navigation and draw operations */
+#define ROUNDS 10
+
+static WDialog owner;
+static WListbox *l = NULL;
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    int i;
+
+    str_init_strings (NULL);
+
+    memset (&owner, 0, sizeof (owner));
+    owner.color = dialog_colors;
+
+    l = listbox_new (0, 0, LINES_NUM, 40, FALSE, NULL);
+    WIDGET (l)->owner = &owner;
+
+    for (i = 0; i < ENTRIES; i++)
+    {
+        char text[32];
+
+        g_snprintf (text, sizeof (text), "entry %07d", i);
+        listbox_add_item (l, LISTBOX_APPEND_AT_END, 0, text, NULL);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    send_message (l, NULL, MSG_DESTROY, 0, NULL);
+    g_free (l);
+    l = NULL;
+
+    str_uninit_strings ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_listbox_navigation)
+/* *INDENT-ON* */
+{
+    int i;
+    char *text;
+
+    mctest_assert_int_eq (listbox_get_length (l), ENTRIES);
+
+    for (i = 0; i < ROUNDS; i++)
+    {
+        /* jump near the end and draw */
+        listbox_select_entry (l, ENTRIES - 1 - i);
+        send_message (l, NULL, MSG_DRAW, 0, NULL);
+
+        /* keyboard navigation */
+        send_message (l, NULL, MSG_ACTION, CK_Bottom, NULL);
+        send_message (l, NULL, MSG_ACTION, CK_PageUp, NULL);
+        send_message (l, NULL, MSG_ACTION, CK_Up, NULL);
+        send_message (l, NULL, MSG_DRAW, 0, NULL);
+    }
+
+    mctest_assert_int_eq (l->pos, ENTRIES - 1 - LINES_NUM);
+    mctest_assert_int_eq (l->top, ENTRIES - 1 - LINES_NUM);
+
+    listbox_get_current (l, &text, NULL);
+    mctest_assert_str_eq (text, "entry 0004979");
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_listbox_select_entry)
+/* *INDENT-ON* */
+{
+    /* scroll down */
+    listbox_select_entry (l, 2500);
+    mctest_assert_int_eq (l->pos, 2500);
+    mctest_assert_int_eq (l->top, 2500 - LINES_NUM + 1);
+
+    /* inside visible window: no scroll */
+    listbox_select_entry (l, 2490);
+    mctest_assert_int_eq (l->pos, 2490);
+    mctest_assert_int_eq (l->top, 2500 - LINES_NUM + 1);
+
+    /* scroll up */
+    listbox_select_entry (l, 100);
+    mctest_assert_int_eq (l->pos, 100);
+    mctest_assert_int_eq (l->top, 100);
+
+    /* out of range */
+    listbox_select_entry (l, ENTRIES);
+    mctest_assert_int_eq (l->pos, 0);
+    mctest_assert_int_eq (l->top, 0);
+
+    /* wrap */
+    send_message (l, NULL, MSG_ACTION, CK_Up, NULL);
+    mctest_assert_int_eq (l->pos, ENTRIES - 1);
+    send_message (l, NULL, MSG_ACTION, CK_Down, NULL);
+    mctest_assert_int_eq (l->pos, 0);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_listbox_search_prefix)
+/* *INDENT-ON* */
+{
+    int i;
+
+    i = listbox_search_prefix (l, "entry 00049", 11, 0);
+    mctest_assert_int_eq (i, 4900);
+
+    /* type-ahead: continue from previous match */
+    i = listbox_search_prefix (l, "entry 000499", 12, i);
+    mctest_assert_int_eq (i, 4990);
+
+    i = listbox_search_prefix (l, "entry 0004999", 13, i);
+    mctest_assert_int_eq (i, 4999);
+
+    i = listbox_search_prefix (l, "entry 000499", 12, i + 1);
+    mctest_assert_int_eq (i, -1);
+
+    i = listbox_search_prefix (l, "none", 4, 0);
+    mctest_assert_int_eq (i, -1);
+
+    mctest_assert_int_eq (listbox_search_text (l, "entry 0000042"), 42);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_listbox_entries_read)
+/* *INDENT-ON* */
+{
+    char *text;
+
+    /* selection doesn't walk the list */
+    entries_read = 0;
+    listbox_select_entry (l, ENTRIES - 1);
+    listbox_get_current (l, &text, NULL);
+    mctest_assert_str_eq (text, "entry 0004999");
+    mctest_assert_int_eq (entries_read, 1);
+
+    /* only visible entries are drawn */
+    entries_read = 0;
+    send_message (l, NULL, MSG_DRAW, 0, NULL);
+    mctest_assert_int_eq (entries_read, LINES_NUM);
+
+    /* no hotkeys in list: no scan */
+    entries_read = 0;
+    mctest_assert_int_eq (send_message (l, NULL, MSG_HOTKEY, 'y', NULL), MSG_NOT_HANDLED);
+    mctest_assert_int_eq (entries_read, 0);
+
+    /* sorted insertion uses binary search: ceil (log2 (ENTRIES + 1)) probes at most */
+    entries_read = 0;
+    listbox_add_item (l, LISTBOX_APPEND_SORTED, 0, "entry 0002500a", NULL);
+    ck_assert (entries_read <= 13);
+    mctest_assert_str_eq (listbox_get_nth_item (l, 2501)->text, "entry 0002500a");
+
+    /* type-ahead search reads entries from given position only */
+    entries_read = 0;
+    mctest_assert_int_eq (listbox_search_prefix (l, "entry 0004999", 13, 4991), 5000);
+    mctest_assert_int_eq (entries_read, 10);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_listbox_insert)
+/* *INDENT-ON* */
+{
+    WListbox *s;
+    char *text;
+
+    s = listbox_new (0, 0, LINES_NUM, 40, FALSE, NULL);
+
+    listbox_add_item (s, LISTBOX_APPEND_SORTED, 0, "b", NULL);
+    listbox_add_item (s, LISTBOX_APPEND_SORTED, 0, "d", NULL);
+    listbox_add_item (s, LISTBOX_APPEND_SORTED, 0, "a", NULL);
+    listbox_add_item (s, LISTBOX_APPEND_SORTED, 0, "c", NULL);
+
+    listbox_select_entry (s, 1);
+    listbox_add_item (s, LISTBOX_APPEND_BEFORE, 0, "before", NULL);
+    listbox_add_item (s, LISTBOX_APPEND_AFTER, 0, "after", NULL);
+    listbox_add_item (s, LISTBOX_APPEND_AT_END, 'z', "end", NULL);
+
+    mctest_assert_int_eq (listbox_get_length (s), 7);
+    mctest_assert_str_eq (listbox_get_nth_item (s, 0)->text, "a");
+    mctest_assert_str_eq (listbox_get_nth_item (s, 1)->text, "before");
+    mctest_assert_str_eq (listbox_get_nth_item (s, 2)->text, "after");
+    mctest_assert_str_eq (listbox_get_nth_item (s, 3)->text, "b");
+    mctest_assert_str_eq (listbox_get_nth_item (s, 4)->text, "c");
+    mctest_assert_str_eq (listbox_get_nth_item (s, 5)->text, "d");
+    mctest_assert_str_eq (listbox_get_nth_item (s, 6)->text, "end");
+    mctest_assert_null (listbox_get_nth_item (s, 7));
+
+    /* hotkey */
+    mctest_assert_int_eq (send_message (s, NULL, MSG_HOTKEY, 'y', NULL), MSG_NOT_HANDLED);
+
+    listbox_select_entry (s, 1);
+    listbox_remove_current (s);
+    listbox_get_current (s, &text, NULL);
+    mctest_assert_str_eq (text, "after");
+    mctest_assert_int_eq (listbox_get_length (s), 6);
+
+    send_message (s, NULL, MSG_DESTROY, 0, NULL);
+    g_free (s);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    tcase_add_test (tc_core, test_listbox_navigation);
+    tcase_add_test (tc_core, test_listbox_select_entry);
+    tcase_add_test (tc_core, test_listbox_search_prefix);
+    tcase_add_test (tc_core, test_listbox_entries_read);
+    tcase_add_test (tc_core, test_listbox_insert);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "listbox.log");
+    srunner_run_all (sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? 0 : 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
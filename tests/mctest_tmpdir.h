@@ -0,0 +1,95 @@
+/** \file  mctest_tmpdir.h
+ *  \brief Header: temporary directory for tests working with real files
+ */
+
+#ifndef MC__TEST_TMPDIR
+#define MC__TEST_TMPDIR
+
+#include <dirent.h>
+#include <stdlib.h>             /* mkdtemp() */
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "lib/global.h"         /* DIR_IS_DOT(), DIR_IS_DOTDOT() */
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+/*** enums ***************************************************************************************/
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+/*** global variables defined in .c file *********************************************************/
+
+/*** declarations of public functions ************************************************************/
+
+/*** inline functions ****************************************************************************/
+
+/**
+ * Remove file or directory with all its contents.
+ * Directories are made writable first: tests can take permissions away.
+ */
+
+static inline void
+mctest_tmpdir_remove_tree (const char *path)
+{
+    DIR *dir;
+    struct dirent *d;
+
+    chmod (path, 0700);
+    dir = opendir (path);
+    if (dir == NULL)
+    {
+        unlink (path);
+        return;
+    }
+
+    while ((d = readdir (dir)) != NULL)
+        if (!DIR_IS_DOT (d->d_name) && !DIR_IS_DOTDOT (d->d_name))
+        {
+            char *p;
+
+            p = g_build_filename (path, d->d_name, (char *) NULL);
+            mctest_tmpdir_remove_tree (p);
+            g_free (p);
+        }
+
+    closedir (dir);
+    rmdir (path);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Create unique empty directory for test, usually in @Before.
+ *
+ * @param name part of directory name to tell tests apart
+ * @return full path, use mctest_tmpdir_free() to remove directory and free path
+ */
+
+static inline char *
+mctest_tmpdir_new (const char *name)
+{
+    char *tmpl, *path;
+
+    tmpl = g_strdup_printf ("%s" PATH_SEP_STR "mc-test-%s-XXXXXX", g_get_tmp_dir (), name);
+    path = g_strdup (mkdtemp (tmpl));
+    g_free (tmpl);
+
+    return path;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Remove directory created by mctest_tmpdir_new(), usually in @After */
+
+static inline void
+mctest_tmpdir_free (char *path)
+{
+    if (path != NULL)
+    {
+        mctest_tmpdir_remove_tree (path);
+        g_free (path);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+#endif /* MC__TEST_TMPDIR */
@@ -0,0 +1,428 @@
+/*
+   src/editor - tests for book mark operations
+
+   Copyright (C) 2014
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/src/editor"
+
+#include "tests/mctest.h"
+
+#include "src/editor/edit-impl.h"
+#include "src/editor/editwidget.h"
+
+/* colors of book marks, real ones are taken from skin */
+#define MARK_COLOR 1
+#define FOUND_COLOR 2
+
+/* number of book marks in large test: speed is measured by tests/bench/mcbench */
+#define MARKS_NUM 1000
+
+/* number of random operations */
+#define OPERATIONS_NUM 20000
+
+/* book mark in the model: plain list ordered by line and time of insertion */
+typedef struct
+{
+    long line;
+    int c;
+} mark_t;
+
+static WEdit *test_edit;
+static GArray *model;
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    test_edit = g_new0 (WEdit, 1);
+    model = g_array_new (FALSE, FALSE, sizeof (mark_t));
+    g_random_set_seed (12345);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    book_mark_flush (test_edit, -1);
+    if (test_edit->serialized_bookmarks != NULL)
+        g_array_free (test_edit->serialized_bookmarks, TRUE);
+    g_free (test_edit);
+    g_array_free (model, TRUE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+model_insert (long line, int c)
+{
+    mark_t m = { line, c };
+    guint i;
+
+    for (i = 0; i < model->len && g_array_index (model, mark_t, i).line <= line; i++)
+        ;
+    g_array_insert_val (model, i, m);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+model_clear (long line, int c)
+{
+    guint i;
+
+    for (i = model->len; i != 0; i--)
+    {
+        const mark_t *m = &g_array_index (model, mark_t, i - 1);
+
+        if (m->line == line && (m->c == c || c == -1))
+        {
+            g_array_remove_index (model, i - 1);
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+model_shift (long line, long delta)
+{
+    guint i;
+
+    for (i = 0; i < model->len; i++)
+        if (g_array_index (model, mark_t, i).line > line)
+            g_array_index (model, mark_t, i).line += delta;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Check treap invariants: parent priority isn't less than priorities of children and
+ * in-order line numbers (own line plus shifts of ancestors) are not decreasing.
+ *
+ * @return height of tree
+ */
+
+static int
+check_tree (const edit_book_mark_t * p, long shift, long *last_line)
+{
+    int left, right;
+
+    if (p == NULL)
+        return 0;
+
+    if (p->left != NULL)
+        ck_assert (p->left->priority <= p->priority);
+    if (p->right != NULL)
+        ck_assert (p->right->priority <= p->priority);
+
+    left = check_tree (p->left, shift + p->shift, last_line);
+    ck_assert (*last_line <= p->line + shift);
+    *last_line = p->line + shift;
+    right = check_tree (p->right, shift + p->shift, last_line);
+
+    return MAX (left, right) + 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** collect nodes and their own line numbers without applying pending shifts */
+
+static void
+collect_nodes (const edit_book_mark_t * p, GPtrArray * nodes, GArray * lines)
+{
+    if (p != NULL)
+    {
+        collect_nodes (p->left, nodes, lines);
+        g_ptr_array_add (nodes, (gpointer) p);
+        g_array_append_val (lines, p->line);
+        collect_nodes (p->right, nodes, lines);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+check_model (long max_line)
+{
+    long line = G_MINLONG;
+    guint i;
+
+    check_tree (test_edit->book_mark, 0, &line);
+
+    for (line = -2; line <= max_line; line++)
+    {
+        gboolean color = FALSE, found = FALSE;
+        long next = -1, prev = -1;
+
+        for (i = 0; i < model->len; i++)
+        {
+            const mark_t *m = &g_array_index (model, mark_t, i);
+
+            if (m->line == line)
+            {
+                color = color || m->c == MARK_COLOR;
+                found = found || m->c == FOUND_COLOR;
+            }
+            if (m->line < line)
+                prev = m->line;
+            if (m->line > line && next == -1)
+                next = m->line;
+        }
+
+        if (book_mark_query_color (test_edit, line, MARK_COLOR) != color
+            || book_mark_query_color (test_edit, line, FOUND_COLOR) != found)
+            ck_abort_msg ("line %ld: wrong color", line);
+        mctest_assert_int_eq (book_mark_next (test_edit, line), next);
+        mctest_assert_int_eq (book_mark_prev (test_edit, line), prev);
+    }
+
+    /* order of insertion is kept on the same line */
+    book_mark_serialize (test_edit, MARK_COLOR);
+    for (i = 0, line = 0; i < model->len; i++)
+    {
+        const mark_t *m = &g_array_index (model, mark_t, i);
+
+        if (m->c == MARK_COLOR && m->line >= 0)
+        {
+            mctest_assert_int_eq (g_array_index (test_edit->serialized_bookmarks, size_t, line),
+                                  m->line);
+            line++;
+        }
+    }
+    mctest_assert_int_eq (test_edit->serialized_bookmarks != NULL ?
+                          test_edit->serialized_bookmarks->len : 0, line);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_book_mark_basic)
+/* *INDENT-ON* */
+{
+    /* given */
+    book_mark_insert (test_edit, 10, MARK_COLOR);
+    book_mark_insert (test_edit, 20, MARK_COLOR);
+    book_mark_insert (test_edit, 20, FOUND_COLOR);
+
+    /* then */
+    mctest_assert_int_eq (book_mark_query_color (test_edit, 10, MARK_COLOR), TRUE);
+    mctest_assert_int_eq (book_mark_query_color (test_edit, 10, FOUND_COLOR), FALSE);
+    mctest_assert_int_eq (book_mark_query_color (test_edit, 20, FOUND_COLOR), TRUE);
+    mctest_assert_int_eq (book_mark_next (test_edit, 0), 10);
+    mctest_assert_int_eq (book_mark_next (test_edit, 10), 20);
+    mctest_assert_int_eq (book_mark_next (test_edit, 20), -1);
+    mctest_assert_int_eq (book_mark_prev (test_edit, 20), 10);
+    mctest_assert_int_eq (book_mark_prev (test_edit, 10), -1);
+
+    /* when: line is inserted before first book mark and deleted after it */
+    book_mark_inc (test_edit, 5);
+    book_mark_dec (test_edit, 15);
+
+    /* then */
+    mctest_assert_int_eq (book_mark_query_color (test_edit, 11, MARK_COLOR), TRUE);
+    mctest_assert_int_eq (book_mark_query_color (test_edit, 20, MARK_COLOR), TRUE);
+    mctest_assert_int_eq (book_mark_query_color (test_edit, 20, FOUND_COLOR), TRUE);
+
+    /* when */
+    book_mark_flush (test_edit, FOUND_COLOR);
+
+    /* then */
+    mctest_assert_int_eq (book_mark_query_color (test_edit, 20, FOUND_COLOR), FALSE);
+    mctest_assert_int_eq (book_mark_clear (test_edit, 20, -1), TRUE);
+    mctest_assert_int_eq (book_mark_clear (test_edit, 20, -1), FALSE);
+    mctest_assert_int_eq (book_mark_next (test_edit, 11), -1);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_book_mark_random)
+/* *INDENT-ON* */
+{
+    int i;
+
+    for (i = 0; i < OPERATIONS_NUM; i++)
+    {
+        long line;
+        int c;
+
+        line = g_random_int_range (0, 100);
+        c = g_random_boolean ()? MARK_COLOR : FOUND_COLOR;
+
+        switch (g_random_int_range (0, 8))
+        {
+        case 0:
+        case 1:
+        case 2:
+            book_mark_insert (test_edit, line, c);
+            model_insert (line, c);
+            break;
+        case 3:
+            mctest_assert_int_eq (book_mark_clear (test_edit, line, c), model_clear (line, c));
+            break;
+        case 4:
+            mctest_assert_int_eq (book_mark_clear (test_edit, line, -1), model_clear (line, -1));
+            break;
+        case 5:
+            book_mark_inc (test_edit, line);
+            model_shift (line, 1);
+            break;
+        case 6:
+            book_mark_dec (test_edit, line);
+            model_shift (line, -1);
+            break;
+        default:
+            if (g_random_int_range (0, 50) == 0)
+            {
+                guint j, k;
+
+                book_mark_flush (test_edit, c);
+                for (j = 0, k = 0; j < model->len; j++)
+                    if (g_array_index (model, mark_t, j).c != c)
+                        g_array_index (model, mark_t, k++) = g_array_index (model, mark_t, j);
+                g_array_set_size (model, k);
+            }
+            break;
+        }
+
+        if (i % 100 == 0)
+            check_model (200);
+    }
+
+    check_model (200);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_book_mark_lazy_shift)
+/* *INDENT-ON* */
+{
+    GPtrArray *nodes;
+    GArray *lines;
+    long last_line = G_MINLONG;
+    int height, changed = 0;
+    guint i;
+
+    /* given */
+    for (i = 0; i < MARKS_NUM; i++)
+        book_mark_insert (test_edit, (long) i * 2 + 1, MARK_COLOR);
+
+    height = check_tree (test_edit->book_mark, 0, &last_line);
+    /* tree is balanced: random priorities are reproducible with fixed seed */
+    ck_assert (height <= 4 * (int) g_bit_storage (MARKS_NUM));
+
+    nodes = g_ptr_array_new ();
+    lines = g_array_new (FALSE, FALSE, sizeof (long));
+    collect_nodes (test_edit->book_mark, nodes, lines);
+    mctest_assert_int_eq (nodes->len, MARKS_NUM);
+
+    /* when: line is inserted before all book marks */
+    book_mark_inc (test_edit, 0);
+
+    /* then: only nodes on split and merge paths are touched */
+    for (i = 0; i < nodes->len; i++)
+        if (((edit_book_mark_t *) g_ptr_array_index (nodes, i))->line
+            != g_array_index (lines, long, i))
+            changed++;
+    ck_assert (changed <= 4 * height);
+
+    last_line = G_MINLONG;
+    check_tree (test_edit->book_mark, 0, &last_line);
+    mctest_assert_int_eq (book_mark_next (test_edit, 0), 2);
+    mctest_assert_int_eq (book_mark_prev (test_edit, MARKS_NUM * 3), MARKS_NUM * 2);
+
+    g_array_free (lines, TRUE);
+    g_ptr_array_free (nodes, TRUE);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_book_mark_large)
+/* *INDENT-ON* */
+{
+    long i;
+
+    /* given */
+    for (i = 0; i < MARKS_NUM; i++)
+        book_mark_insert (test_edit, i * 2 + 1, MARK_COLOR);
+
+    /* when: insert a line at the top of file for every book mark */
+    for (i = 0; i < MARKS_NUM; i++)
+        book_mark_inc (test_edit, 0);
+    for (i = 0; i < MARKS_NUM; i++)
+        if (!book_mark_query_color (test_edit, MARKS_NUM + i * 2 + 1, MARK_COLOR)
+            || book_mark_query_color (test_edit, MARKS_NUM + i * 2, MARK_COLOR))
+            ck_abort_msg ("book mark %ld: wrong line", i);
+
+    /* then */
+    mctest_assert_int_eq (book_mark_query_color (test_edit, 1, MARK_COLOR), FALSE);
+    mctest_assert_int_eq (book_mark_next (test_edit, 0), MARKS_NUM + 1);
+    mctest_assert_int_eq (book_mark_prev (test_edit, MARKS_NUM * 3), MARKS_NUM * 3 - 1);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    tcase_add_test (tc_core, test_book_mark_basic);
+    tcase_add_test (tc_core, test_book_mark_random);
+    tcase_add_test (tc_core, test_book_mark_lazy_shift);
+    tcase_add_test (tc_core, test_book_mark_large);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "bookmark__operations.log");
+    srunner_run_all (sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? 0 : 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,277 @@
+/*
+   src/editor - tests for edit_buffer_writev_file() function
+
+   Copyright (C) 2014
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/src/editor"
+
+#include "tests/mctest.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "lib/widget.h"         /* B_CANCEL */
+
+#include "src/editor/editbuffer.h"
+
+/* size of one block of editor buffer */
+#define BLOCK_SIZE (64 * 1024)
+
+static edit_buffer_t test_buf;
+static char *test_file = NULL;
+static int test_fd = -1;
+
+/* @CapturedValue */
+static int status_update__calls;
+
+/* --------------------------------------------------------------------------------------------- */
+
+static unsigned char
+test_byte (off_t i)
+{
+    /* differs in neighbour blocks to catch misplaced ones */
+    return (unsigned char) (i * 7 + i / BLOCK_SIZE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* fill buffer with 'size' bytes and place cursor at 'curs' */
+static void
+test_buf_fill (off_t size, off_t curs)
+{
+    off_t i;
+
+    for (i = 0; i < size; i++)
+        edit_buffer_insert (&test_buf, test_byte (i));
+    for (; i > curs; i--)
+        edit_buffer_insert_ahead (&test_buf, edit_buffer_backspace (&test_buf));
+
+    test_buf.size = size;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+test_file_check (off_t size)
+{
+    char *contents = NULL;
+    gsize length = 0;
+    off_t i;
+
+    fail_unless (g_file_get_contents (test_file, &contents, &length, NULL));
+    mctest_assert_int_eq (length, size);
+
+    for (i = 0; i < size; i++)
+        if ((unsigned char) contents[i] != test_byte (i))
+            break;
+    mctest_assert_int_eq (i, size);
+
+    g_free (contents);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Mock */
+static int
+status_update__cancel (status_msg_t * sm)
+{
+    (void) sm;
+
+    status_update__calls++;
+    return B_CANCEL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    char tmpl[] = "/tmp/mc-test-writev-XXXXXX";
+
+    edit_buffer_init (&test_buf, 0);
+
+    test_fd = mkstemp (tmpl);
+    test_file = g_strdup (tmpl);
+    status_update__calls = 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    if (test_fd != -1)
+        close (test_fd);
+    unlink (test_file);
+    g_free (test_file);
+    test_file = NULL;
+
+    edit_buffer_clean (&test_buf);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_writev_file_ds") */
+/* *INDENT-OFF* */
+static const struct test_writev_file_ds
+{
+    off_t size;
+    off_t curs;
+} test_writev_file_ds[] =
+{
+    { /* 0. empty file */
+        0,
+        0
+    },
+    { /* 1. */
+        10,
+        0
+    },
+    { /* 2. */
+        10,
+        10
+    },
+    { /* 3. cursor inside block */
+        3 * BLOCK_SIZE + 7,
+        BLOCK_SIZE + 3
+    },
+    { /* 4. cursor at the block boundary */
+        3 * BLOCK_SIZE + 7,
+        2 * BLOCK_SIZE
+    },
+    { /* 5. more blocks than one writev() call takes */
+        70 * BLOCK_SIZE + 5,
+        33 * BLOCK_SIZE + 5
+    }
+};
+/* *INDENT-ON* */
+
+/* @Test(dataSource = "test_writev_file_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_writev_file, test_writev_file_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    off_t actual;
+    gboolean aborted = TRUE;
+
+    test_buf_fill (data->size, data->curs);
+
+    /* when */
+    actual = edit_buffer_writev_file (&test_buf, test_fd, NULL, &aborted);
+
+    /* then */
+    mctest_assert_int_eq (actual, data->size);
+    fail_if (aborted);
+    test_file_check (data->size);
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_writev_file_abort)
+/* *INDENT-ON* */
+{
+    /* given */
+    edit_buffer_read_file_status_msg_t rsm;
+    off_t actual;
+    gboolean aborted = FALSE;
+
+    memset (&rsm, 0, sizeof (rsm));
+    STATUS_MSG (&rsm)->update = status_update__cancel;
+    rsm.buf = &test_buf;
+    test_buf_fill (70 * BLOCK_SIZE + 5, 10);
+
+    /* when */
+    actual = edit_buffer_writev_file (&test_buf, test_fd, &rsm, &aborted);
+
+    /* then: writing is stopped after the first batch */
+    fail_unless (aborted);
+    mctest_assert_int_eq (status_update__calls, 1);
+    fail_unless (actual > 0 && actual < test_buf.size);
+    mctest_assert_int_eq (rsm.loaded, actual);
+    test_file_check (actual);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_writev_file_error)
+/* *INDENT-ON* */
+{
+    /* given */
+    off_t actual;
+    gboolean aborted = TRUE;
+    int fd;
+
+    test_buf_fill (BLOCK_SIZE + 5, 10);
+    fd = open (test_file, O_RDONLY);
+
+    /* when */
+    actual = edit_buffer_writev_file (&test_buf, fd, NULL, &aborted);
+
+    /* then: error is reported by short length */
+    mctest_assert_int_eq (actual, 0);
+    fail_if (aborted);
+    close (fd);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    mctest_add_parameterized_test (tc_core, test_writev_file, test_writev_file_ds);
+    tcase_add_test (tc_core, test_writev_file_abort);
+    tcase_add_test (tc_core, test_writev_file_error);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "editbuffer__writev_file.log");
+    srunner_run_all (sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? 0 : 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
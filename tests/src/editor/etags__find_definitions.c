@@ -0,0 +1,458 @@
+/*
+   src/editor - lookups in indexed tags files
+
+   Copyright (C) 2014
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/src/editor"
+
+#include "tests/mctest.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+/* number of lines read from tags file */
+static int fgets__calls = 0;
+
+/* @Mock */
+static char *
+fgets__counted (char *s, int size, FILE * stream)
+{
+    fgets__calls++;
+    return fgets (s, size, stream);
+}
+
+#define fgets fgets__counted
+#include "src/editor/etags.c"
+#undef fgets
+
+/* number of tags in large file: speed is measured by tests/bench/mcbench */
+#define TAGS_NUM 5000
+/* number of tags looked up in large file */
+#define TAGS_LOOKUPS 100
+
+static char *work_dir = NULL;
+static char *tagfile = NULL;
+
+static etags_hash_t def_hash[MAX_DEFINITIONS];
+
+/* *INDENT-OFF* */
+static const char etags_data[] =
+    "\x0c\n"
+    "src/main.c,120\n"
+    "int main (\x7f" "12,300\n"
+    "static void do_nothing \x7f" "do_nothing\x01" "20,400\n"
+    "#define FOO \x7f" "FOO\x01" "3,40\n"
+    "\x0c\n"
+    "src/util.c,80\n"
+    "#define FOO \x7f" "FOO\x01" "7,90\n"
+    "void edit_load (\x7f" "edit_load\x01" "30,500\n"
+    "void edit_save (\x7f" "edit_save\x01" "40,600\n"
+    "void edit_saveas (\x7f" "edit_saveas\x01" "50,700\n";
+
+static const char ctags_data[] =
+    "!_TAG_FILE_FORMAT\t2\t/extended format/\n"
+    "!_TAG_FILE_SORTED\t1\t/0=unsorted, 1=sorted/\n"
+    "by_number\tsrc/a.c\t15;\"\tf\n"
+    "by_field\tsrc/a.c\t/^void by_field (void)$/;\"\tf\tline:25\n"
+    "by_pattern\tsrc/b.c\t/^int by_pattern;\t\\/* \"x;\" *\\/$/;\"\tv\n"
+    "by_pattern\tsrc/a.c\t7;\"\tf\n";
+
+static const char ctags_source[] =
+    "/* b.c */\n"
+    "\n"
+    "int by_pattern;\t/* \"x;\" */\n";
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+write_file (const char *name, const char *data, size_t len)
+{
+    char *path;
+
+    path = g_build_filename (work_dir, name, (char *) NULL);
+    ck_assert (g_file_set_contents (path, data, (gssize) len, NULL));
+    g_free (path);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+free_definitions (int num)
+{
+    int i;
+
+    for (i = 0; i < num; i++)
+    {
+        g_free (def_hash[i].filename);
+        g_free (def_hash[i].fullpath);
+        g_free (def_hash[i].short_define);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+check_definition (int i, const char *filename, const char *short_define, long line)
+{
+    char *fullpath;
+
+    fullpath = g_build_filename (work_dir, filename, (char *) NULL);
+    mctest_assert_str_eq (def_hash[i].filename, filename);
+    mctest_assert_int_eq (def_hash[i].filename_len, strlen (filename));
+    mctest_assert_str_eq (def_hash[i].fullpath, fullpath);
+    mctest_assert_str_eq (def_hash[i].short_define, short_define);
+    mctest_assert_int_eq (def_hash[i].line, line);
+    g_free (fullpath);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    work_dir = g_build_filename (g_get_tmp_dir (), "etags-XXXXXX", (char *) NULL);
+    ck_assert (mkdtemp (work_dir) != NULL);
+    tagfile = g_build_filename (work_dir, "TAGS", (char *) NULL);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    char *path;
+
+    etags_free_index ();
+
+    unlink (tagfile);
+    path = g_build_filename (work_dir, "src", "b.c", (char *) NULL);
+    unlink (path);
+    g_free (path);
+    path = g_build_filename (work_dir, "src", (char *) NULL);
+    rmdir (path);
+    g_free (path);
+    rmdir (work_dir);
+
+    g_free (tagfile);
+    g_free (work_dir);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_etags_exact)
+/* *INDENT-ON* */
+{
+    int num;
+
+    /* given */
+    write_file ("TAGS", etags_data, sizeof (etags_data) - 1);
+
+    /* when: implicit name */
+    num = etags_find_definitions (tagfile, work_dir, "main", FALSE, def_hash, MAX_DEFINITIONS);
+
+    /* then */
+    mctest_assert_int_eq (num, 1);
+    check_definition (0, "src/main.c", "int main (", 12);
+    free_definitions (num);
+
+    /* when: explicit name */
+    num = etags_find_definitions (tagfile, work_dir, "do_nothing", FALSE, def_hash,
+                                  MAX_DEFINITIONS);
+
+    /* then */
+    mctest_assert_int_eq (num, 1);
+    check_definition (0, "src/main.c", "do_nothing", 20);
+    free_definitions (num);
+
+    /* when: name defined twice */
+    num = etags_find_definitions (tagfile, work_dir, "FOO", FALSE, def_hash, MAX_DEFINITIONS);
+
+    /* then: in order of tags file */
+    mctest_assert_int_eq (num, 2);
+    check_definition (0, "src/main.c", "FOO", 3);
+    check_definition (1, "src/util.c", "FOO", 7);
+    free_definitions (num);
+
+    /* no substring matches */
+    mctest_assert_int_eq (etags_find_definitions (tagfile, work_dir, "edit", FALSE, def_hash,
+                                                  MAX_DEFINITIONS), 0);
+    mctest_assert_int_eq (etags_find_definitions (tagfile, work_dir, "ain", FALSE, def_hash,
+                                                  MAX_DEFINITIONS), 0);
+    mctest_assert_int_eq (etags_find_definitions (tagfile, work_dir, "zzz", FALSE, def_hash,
+                                                  MAX_DEFINITIONS), 0);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_etags_prefix)
+/* *INDENT-ON* */
+{
+    int num;
+
+    /* given */
+    write_file ("TAGS", etags_data, sizeof (etags_data) - 1);
+
+    /* when */
+    num = etags_find_definitions (tagfile, work_dir, "edit_s", TRUE, def_hash, MAX_DEFINITIONS);
+
+    /* then */
+    mctest_assert_int_eq (num, 2);
+    check_definition (0, "src/util.c", "edit_save", 40);
+    check_definition (1, "src/util.c", "edit_saveas", 50);
+    free_definitions (num);
+
+    /* when: limited number of results */
+    num = etags_find_definitions (tagfile, work_dir, "edit_", TRUE, def_hash, 2);
+
+    /* then */
+    mctest_assert_int_eq (num, 2);
+    check_definition (0, "src/util.c", "edit_load", 30);
+    check_definition (1, "src/util.c", "edit_save", 40);
+    free_definitions (num);
+
+    /* when: exact match is preferred */
+    num = etags_set_definition_hash (tagfile, work_dir, "edit_save", def_hash);
+
+    /* then */
+    mctest_assert_int_eq (num, 1);
+    check_definition (0, "src/util.c", "edit_save", 40);
+    free_definitions (num);
+
+    /* when: no exact match */
+    num = etags_set_definition_hash (tagfile, work_dir, "edit", def_hash);
+
+    /* then */
+    mctest_assert_int_eq (num, 3);
+    free_definitions (num);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_ctags)
+/* *INDENT-ON* */
+{
+    char *src_dir;
+    int num;
+
+    /* given */
+    write_file ("TAGS", ctags_data, sizeof (ctags_data) - 1);
+    src_dir = g_build_filename (work_dir, "src", (char *) NULL);
+    mkdir (src_dir, 0700);
+    g_free (src_dir);
+    write_file ("src/b.c", ctags_source, sizeof (ctags_source) - 1);
+
+    /* when: line number as address */
+    num = etags_find_definitions (tagfile, work_dir, "by_number", FALSE, def_hash,
+                                  MAX_DEFINITIONS);
+
+    /* then */
+    mctest_assert_int_eq (num, 1);
+    check_definition (0, "src/a.c", "by_number", 15);
+    free_definitions (num);
+
+    /* when: line number in extension fields */
+    num = etags_find_definitions (tagfile, work_dir, "by_field", FALSE, def_hash,
+                                  MAX_DEFINITIONS);
+
+    /* then */
+    mctest_assert_int_eq (num, 1);
+    check_definition (0, "src/a.c", "by_field", 25);
+    free_definitions (num);
+
+    /* when: line is found by search pattern */
+    num = etags_find_definitions (tagfile, work_dir, "by_pattern", FALSE, def_hash,
+                                  MAX_DEFINITIONS);
+
+    /* then */
+    mctest_assert_int_eq (num, 2);
+    check_definition (0, "src/b.c", "by_pattern", 3);
+    check_definition (1, "src/a.c", "by_pattern", 7);
+    free_definitions (num);
+
+    /* pseudo tags are ignored */
+    mctest_assert_int_eq (etags_find_definitions (tagfile, work_dir, "!_TAG", TRUE, def_hash,
+                                                  MAX_DEFINITIONS), 0);
+
+    /* prefix */
+    num = etags_find_definitions (tagfile, work_dir, "by_", TRUE, def_hash, MAX_DEFINITIONS);
+    mctest_assert_int_eq (num, 4);
+    free_definitions (num);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_reindex)
+/* *INDENT-ON* */
+{
+    struct stat st;
+    struct utimbuf times;
+    int num;
+
+    /* given */
+    write_file ("TAGS", etags_data, sizeof (etags_data) - 1);
+    num = etags_find_definitions (tagfile, work_dir, "main", FALSE, def_hash, MAX_DEFINITIONS);
+    mctest_assert_int_eq (num, 1);
+    free_definitions (num);
+
+    /* when: file is replaced */
+    write_file ("TAGS", ctags_data, sizeof (ctags_data) - 1);
+    mctest_assert_int_eq (stat (tagfile, &st), 0);
+    times.actime = st.st_atime;
+    times.modtime = st.st_mtime + 10;
+    utime (tagfile, &times);
+
+    /* then */
+    mctest_assert_int_eq (etags_find_definitions (tagfile, work_dir, "main", FALSE, def_hash,
+                                                  MAX_DEFINITIONS), 0);
+    num = etags_find_definitions (tagfile, work_dir, "by_number", FALSE, def_hash,
+                                  MAX_DEFINITIONS);
+    mctest_assert_int_eq (num, 1);
+    free_definitions (num);
+
+    /* missing file */
+    unlink (tagfile);
+    mctest_assert_int_eq (etags_find_definitions (tagfile, work_dir, "by_number", FALSE,
+                                                  def_hash, MAX_DEFINITIONS), 0);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_large)
+/* *INDENT-ON* */
+{
+    GString *data;
+    const etags_index_t *idx;
+    int i, num;
+
+    /* given */
+    data = g_string_sized_new (TAGS_NUM * 40);
+    for (i = 0; i < TAGS_NUM; i++)
+    {
+        if (i % 1000 == 0)
+            g_string_append_printf (data, "\x0c\nsrc/file%d.c,1000\n", i / 1000);
+        g_string_append_printf (data, "int func%06d (\x7f%d,%d\n", (i * 7919) % TAGS_NUM,
+                                i % 1000 + 1, i);
+    }
+    write_file ("TAGS", data->str, data->len);
+    g_string_free (data, TRUE);
+
+    /* when */
+    num = etags_find_definitions (tagfile, work_dir, "func000001", FALSE, def_hash,
+                                  MAX_DEFINITIONS);
+
+    /* then */
+    mctest_assert_int_eq (num, 1);
+    free_definitions (num);
+
+    /* index holds every tag sorted by name */
+    idx = etags_index;
+    mctest_assert_not_null (idx);
+    mctest_assert_int_eq (idx->tags->len, TAGS_NUM);
+    for (i = 1; i < TAGS_NUM; i++)
+        ck_assert (etags_tag_cmp (&g_array_index (idx->tags, etags_tag_t, i - 1),
+                                  &g_array_index (idx->tags, etags_tag_t, i)) < 0);
+
+    /* lookups reuse index and read only the line of found tag */
+    fgets__calls = 0;
+    for (i = 0; i < TAGS_LOOKUPS; i++)
+    {
+        char name[16];
+
+        g_snprintf (name, sizeof (name), "func%06d", (i * 199) % TAGS_NUM);
+        num = etags_find_definitions (tagfile, work_dir, name, FALSE, def_hash,
+                                      MAX_DEFINITIONS);
+        mctest_assert_int_eq (num, 1);
+        free_definitions (num);
+    }
+    mctest_assert_ptr_eq (etags_index, idx);
+    mctest_assert_int_eq (fgets__calls, TAGS_LOOKUPS);
+
+    fgets__calls = 0;
+    num = etags_find_definitions (tagfile, work_dir, "func00001", TRUE, def_hash,
+                                  MAX_DEFINITIONS);
+    mctest_assert_int_eq (num, 10);
+    mctest_assert_int_eq (fgets__calls, 10);
+    for (i = 0; i < num; i++)
+    {
+        char name[32];
+
+        g_snprintf (name, sizeof (name), "int func%06d (", 10 + i);
+        mctest_assert_str_eq (def_hash[i].short_define, name);
+    }
+    free_definitions (num);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    tcase_add_test (tc_core, test_etags_exact);
+    tcase_add_test (tc_core, test_etags_prefix);
+    tcase_add_test (tc_core, test_ctags);
+    tcase_add_test (tc_core, test_reindex);
+    tcase_add_test (tc_core, test_large);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "etags__find_definitions.log");
+    srunner_run_all (sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? 0 : 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,451 @@
+/*
+   src/filemanager - recursive change of permissions
+
+   Copyright (C) 2014
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/src/filemanager"
+
+#include "tests/mctest.h"
+#include "tests/mctest_tmpdir.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "lib/strutil.h"
+#include "lib/vfs/vfs.h"
+#include "src/vfs/local/local.h"
+
+/* name of entry fstatat() fails for, and how many times */
+static const char *fstatat_fail_name = NULL;
+static int fstatat_fail_count = 0;
+
+/* file system with transient errors */
+static int
+test_fstatat (int dir_fd, const char *name, struct stat *st, int flags)
+{
+    if (fstatat_fail_count > 0 && strcmp (name, fstatat_fail_name) == 0)
+    {
+        fstatat_fail_count--;
+        errno = EIO;
+        return -1;
+    }
+
+    return fstatat (dir_fd, name, st, flags);
+}
+
+#define fstatat test_fstatat
+#include "src/filemanager/chattr.c"
+#undef fstatat
+
+static char *work_dir = NULL;
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @CapturedValue */
+static int file_error__count;
+/* @ThenReturnValue */
+static FileProgressStatus file_error__return_value;
+
+/* @Mock */
+FileProgressStatus
+file_error (const char *format, const char *file)
+{
+    (void) format;
+    (void) file;
+
+    file_error__count++;
+    return file_error__return_value;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static char *
+tree_path (const char *name)
+{
+    return g_build_filename (work_dir, "top", name, (char *) NULL);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static mode_t
+tree_mode (const char *name)
+{
+    struct stat st;
+    char *p;
+
+    p = tree_path (name);
+    if (lstat (p, &st) != 0)
+        st.st_mode = 0;
+    g_free (p);
+
+    return st.st_mode & 07777;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* top/file, top/dir/file, top/dir/sub/file, top/link -> ../outside */
+static void
+make_tree (void)
+{
+    static const char *files[] = { "file", "dir/file", "dir/sub/file", "../outside" };
+    char *p;
+    size_t i;
+
+    p = tree_path ("dir/sub");
+    g_mkdir_with_parents (p, 0755);
+    chmod (p, 0755);
+    g_free (p);
+    p = tree_path ("dir");
+    chmod (p, 0755);
+    g_free (p);
+    p = tree_path (NULL);
+    chmod (p, 0755);
+    g_free (p);
+
+    for (i = 0; i < G_N_ELEMENTS (files); i++)
+    {
+        int fd;
+
+        p = tree_path (files[i]);
+        fd = open (p, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd != -1)
+            close (fd);
+        chmod (p, 0644);
+        g_free (p);
+    }
+
+    p = tree_path ("link");
+    symlink ("../outside", p);
+    g_free (p);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static FileProgressStatus
+apply_to_tree (mode_t and_mask, mode_t or_mask, int targets)
+{
+    chattr_op_t op;
+    vfs_path_t *vpath;
+    FileProgressStatus status;
+
+    chattr_op_init (&op);
+    op.ctx = file_op_context_new (OP_CHMOD);
+    op.change_mode = TRUE;
+    op.and_mask = and_mask;
+    op.or_mask = or_mask;
+    op.targets = targets;
+
+    vpath = vfs_path_build_filename (work_dir, "top", (char *) NULL);
+    status = chattr_apply (&op, OP_CHMOD, vpath);
+    vfs_path_free (vpath);
+    chattr_op_deinit (&op);
+
+    return status;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* group other than 'gid' which the file can be given to, (gid_t) -1 if there is none */
+static gid_t
+other_gid (gid_t gid)
+{
+    gid_t *groups;
+    gid_t ret = (gid_t) (-1);
+    int n, i;
+
+    if (getuid () == 0)
+        return (gid == 1) ? 2 : 1;
+
+    n = getgroups (0, NULL);
+    if (n <= 0)
+        return ret;
+
+    groups = g_new (gid_t, n);
+    n = getgroups (n, groups);
+    for (i = 0; i < n && ret == (gid_t) (-1); i++)
+        if (groups[i] != gid)
+            ret = groups[i];
+    g_free (groups);
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    str_init_strings (NULL);
+
+    vfs_init ();
+    init_localfs ();
+    vfs_setup_work_dir ();
+
+    work_dir = mctest_tmpdir_new ("chattr");
+    make_tree ();
+
+    fstatat_fail_name = NULL;
+    fstatat_fail_count = 0;
+    file_error__count = 0;
+    file_error__return_value = FILE_ABORT;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    mctest_tmpdir_free (work_dir);
+    work_dir = NULL;
+
+    vfs_shut ();
+    str_uninit_strings ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_chattr_targets_ds") */
+/* *INDENT-OFF* */
+static const struct test_chattr_targets_ds
+{
+    int targets;
+    mode_t file_mode;
+    mode_t dir_mode;
+} test_chattr_targets_ds[] =
+{
+    { /* 0. selected directory only */
+        0,
+        0644,
+        0755
+    },
+    { /* 1. */
+        CHATTR_FILES,
+        0664,
+        0755
+    },
+    { /* 2. */
+        CHATTR_DIRS,
+        0644,
+        0775
+    },
+    { /* 3. */
+        CHATTR_FILES | CHATTR_DIRS,
+        0664,
+        0775
+    }
+};
+/* *INDENT-ON* */
+
+/* @Test(dataSource = "test_chattr_targets_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_chattr_targets, test_chattr_targets_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    FileProgressStatus status;
+    char *p;
+    struct stat st;
+
+    /* when */
+    status = apply_to_tree (~(mode_t) 0, S_IWGRP, data->targets);
+
+    /* then */
+    mctest_assert_int_eq (status, FILE_CONT);
+    mctest_assert_int_eq (tree_mode (NULL), 0775);
+    mctest_assert_int_eq (tree_mode ("file"), data->file_mode);
+    mctest_assert_int_eq (tree_mode ("dir/file"), data->file_mode);
+    mctest_assert_int_eq (tree_mode ("dir/sub/file"), data->file_mode);
+    mctest_assert_int_eq (tree_mode ("dir"), data->dir_mode);
+    mctest_assert_int_eq (tree_mode ("dir/sub"), data->dir_mode);
+
+    /* symlink is not followed */
+    p = g_build_filename (work_dir, "outside", (char *) NULL);
+    mctest_assert_int_eq (stat (p, &st), 0);
+    mctest_assert_int_eq (st.st_mode & 07777, 0644);
+    g_free (p);
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_chattr_remove_search)
+/* *INDENT-ON* */
+{
+    /* given */
+    FileProgressStatus status;
+
+    /* when: directories are changed after their contents */
+    status = apply_to_tree (~(mode_t) (S_IXUSR | S_IXGRP | S_IXOTH), 0,
+                            CHATTR_FILES | CHATTR_DIRS);
+
+    /* then */
+    mctest_assert_int_eq (status, FILE_CONT);
+    mctest_assert_int_eq (tree_mode (NULL), 0644);
+
+    /* directories are changed before their contents */
+    status = apply_to_tree (~(mode_t) 0, S_IXUSR, CHATTR_DIRS);
+    mctest_assert_int_eq (status, FILE_CONT);
+    mctest_assert_int_eq (tree_mode (NULL), 0744);
+    mctest_assert_int_eq (tree_mode ("dir"), 0744);
+    mctest_assert_int_eq (tree_mode ("dir/sub"), 0744);
+    mctest_assert_int_eq (tree_mode ("dir/sub/file"), 0644);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_chattr_chown_setid)
+/* *INDENT-ON* */
+{
+    /* given */
+    chattr_op_t op;
+    vfs_path_t *vpath;
+    FileProgressStatus status;
+    struct stat st;
+    char *p;
+    gid_t gid;
+
+    p = tree_path ("file");
+    chmod (p, 06755);
+    lstat (p, &st);
+    gid = other_gid (st.st_gid);
+
+    chattr_op_init (&op);
+    op.ctx = file_op_context_new (OP_CHOWN);
+    op.change_mode = TRUE;
+    op.gid = gid;
+    op.targets = CHATTR_FILES;
+
+    vpath = vfs_path_build_filename (work_dir, "top", (char *) NULL);
+
+    /* when: mode is kept, but change of group resets set-ID bits */
+    status = gid == (gid_t) (-1) ? FILE_CONT : chattr_apply (&op, OP_CHOWN, vpath);
+
+    /* then: they are set again */
+    mctest_assert_int_eq (status, FILE_CONT);
+    mctest_assert_int_eq (lstat (p, &st), 0);
+    if (gid != (gid_t) (-1))
+        mctest_assert_int_eq (st.st_gid, gid);
+    mctest_assert_int_eq (st.st_mode & 07777, 06755);
+
+    vfs_path_free (vpath);
+    chattr_op_deinit (&op);
+    g_free (p);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef CHATTR_LOCAL
+/* @DataSource("test_chattr_stat_error_ds") */
+/* *INDENT-OFF* */
+static const struct test_chattr_stat_error_ds
+{
+    FileProgressStatus answer;
+    mode_t file_mode;
+} test_chattr_stat_error_ds[] =
+{
+    { /* 0. stat succeeds after retry */
+        FILE_RETRY,
+        0664
+    },
+    { /* 1. */
+        FILE_SKIP,
+        0644
+    }
+};
+/* *INDENT-ON* */
+
+/* @Test(dataSource = "test_chattr_stat_error_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_chattr_stat_error, test_chattr_stat_error_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    FileProgressStatus status;
+
+    fstatat_fail_name = "file";
+    fstatat_fail_count = 1;
+    file_error__return_value = data->answer;
+
+    /* when: stat of top/file fails once */
+    status = apply_to_tree (~(mode_t) 0, S_IWGRP, CHATTR_FILES);
+
+    /* then */
+    mctest_assert_int_eq (status, FILE_CONT);
+    mctest_assert_int_eq (file_error__count, 1);
+    mctest_assert_int_eq (tree_mode ("file"), data->file_mode);
+    /* other entries aren't affected */
+    mctest_assert_int_eq (tree_mode ("dir/file"), 0644 | S_IWGRP);
+    mctest_assert_int_eq (tree_mode ("dir/sub/file"), 0644 | S_IWGRP);
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+#endif /* CHATTR_LOCAL */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    mctest_add_parameterized_test (tc_core, test_chattr_targets, test_chattr_targets_ds);
+    tcase_add_test (tc_core, test_chattr_remove_search);
+    tcase_add_test (tc_core, test_chattr_chown_setid);
+#ifdef CHATTR_LOCAL
+    mctest_add_parameterized_test (tc_core, test_chattr_stat_error, test_chattr_stat_error_ds);
+#endif
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "chattr.log");
+    srunner_run_all (sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? 0 : 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,301 @@
+/*
+   src/filemanager - copying of trees with hardlinked files
+
+   Copyright (C) 2014
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/src/filemanager"
+
+#include "tests/mctest.h"
+#include "tests/mctest_tmpdir.h"
+
+#include <dirent.h>
+#include <stdlib.h>
+
+#include "lib/vfs/vfs.h"
+#include "src/vfs/local/local.h"
+
+#include "src/filemanager/file.c"
+
+/* source tree: a/NNN/MMM and b/NNN/MMM are hardlinks to the same inode */
+#define TREE_DIRS 3
+#define TREE_FILES 4
+
+static char *work_dir = NULL;
+
+/* --------------------------------------------------------------------------------------------- */
+
+static char *
+tree_path (const char *top, const char *half, int dir, int file)
+{
+    char name_dir[16], name_file[16];
+
+    g_snprintf (name_dir, sizeof (name_dir), "%03d", dir);
+    if (file < 0)
+        return g_build_filename (work_dir, top, half, name_dir, (char *) NULL);
+
+    g_snprintf (name_file, sizeof (name_file), "%03d", file);
+    return g_build_filename (work_dir, top, half, name_dir, name_file, (char *) NULL);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+make_source_tree (void)
+{
+    char *p;
+    int i, j;
+
+    p = g_build_filename (work_dir, "src", "a", (char *) NULL);
+    g_mkdir_with_parents (p, 0755);
+    g_free (p);
+    p = g_build_filename (work_dir, "src", "b", (char *) NULL);
+    g_mkdir_with_parents (p, 0755);
+    g_free (p);
+
+    for (i = 0; i < TREE_DIRS; i++)
+    {
+        char *a, *b;
+
+        a = tree_path ("src", "a", i, -1);
+        b = tree_path ("src", "b", i, -1);
+        mkdir (a, 0755);
+        mkdir (b, 0755);
+        g_free (a);
+        g_free (b);
+
+        for (j = 0; j < TREE_FILES; j++)
+        {
+            int fd;
+
+            a = tree_path ("src", "a", i, j);
+            b = tree_path ("src", "b", i, j);
+            fd = open (a, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd != -1)
+                close (fd);
+            link (a, b);
+            g_free (a);
+            g_free (b);
+        }
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    str_init_strings (NULL);
+
+    vfs_init ();
+    init_localfs ();
+    vfs_setup_work_dir ();
+
+    work_dir = mctest_tmpdir_new ("copy-hardlinks");
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    linklist = free_linklist (linklist);
+    dest_dirs = free_linklist (dest_dirs);
+    parent_dirs = free_linklist (parent_dirs);
+
+    mctest_tmpdir_free (work_dir);
+    work_dir = NULL;
+
+    vfs_shut ();
+    str_uninit_strings ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_copy_hardlinks)
+/* *INDENT-ON* */
+{
+    file_op_context_t *ctx;
+    file_op_total_context_t *tctx;
+    FileProgressStatus status;
+    char *src, *dst;
+    int i, j, not_linked = 0;
+
+    /* given */
+    mctest_assert_not_null (work_dir);
+    make_source_tree ();
+
+    src = g_build_filename (work_dir, "src", (char *) NULL);
+    dst = g_build_filename (work_dir, "dst", (char *) NULL);
+
+    ctx = file_op_context_new (OP_COPY);
+    tctx = file_op_total_context_new ();
+
+    /* when */
+    status = copy_dir_dir (tctx, ctx, src, dst, TRUE, FALSE, FALSE);
+
+    /* then */
+    mctest_assert_int_eq (status, FILE_CONT);
+    mctest_assert_int_eq (parent_dirs == NULL ? 0 : g_hash_table_size (parent_dirs), 0);
+    /* the cache holds one entry per inode, found by key */
+    mctest_assert_not_null (linklist);
+    mctest_assert_int_eq (g_hash_table_size (linklist), TREE_DIRS * TREE_FILES);
+
+    for (i = 0; i < TREE_DIRS; i++)
+        for (j = 0; j < TREE_FILES; j++)
+        {
+            struct stat sa, sb;
+            char *a, *b;
+            vfs_path_t *vpath;
+
+            a = tree_path ("dst", "a", i, j);
+            b = tree_path ("dst", "b", i, j);
+            if (lstat (a, &sa) != 0 || lstat (b, &sb) != 0 || sa.st_ino != sb.st_ino
+                || sa.st_dev != sb.st_dev || sa.st_nlink != 2)
+                not_linked++;
+            g_free (a);
+            g_free (b);
+
+            a = tree_path ("src", "a", i, j);
+            vpath = vfs_path_from_str (a);
+            mctest_assert_int_eq (lstat (a, &sa), 0);
+            mctest_assert_int_eq (is_in_linklist (linklist, vpath, &sa), TRUE);
+            vfs_path_free (vpath);
+            g_free (a);
+        }
+
+    mctest_assert_int_eq (not_linked, 0);
+
+    file_op_total_context_destroy (tctx);
+    file_op_context_destroy (ctx);
+    g_free (src);
+    g_free (dst);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_link_hash)
+/* *INDENT-ON* */
+{
+    GHashTable *hashes;
+    struct link lnk;
+    ino_t ino;
+
+    /* given */
+    hashes = g_hash_table_new (g_direct_hash, g_direct_equal);
+    memset (&lnk, 0, sizeof (lnk));
+    lnk.dev = 0x803;
+
+    /* when */
+    for (ino = 1; ino <= 10000; ino++)
+    {
+        lnk.ino = ino;
+        g_hash_table_insert (hashes, GUINT_TO_POINTER (link_hash (&lnk)), NULL);
+    }
+
+    /* then: inodes of one device never collide, lookup doesn't degrade to list scan */
+    mctest_assert_int_eq (g_hash_table_size (hashes), 10000);
+
+    g_hash_table_destroy (hashes);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_copy_dir_into_itself)
+/* *INDENT-ON* */
+{
+    file_op_context_t *ctx;
+    file_op_total_context_t *tctx;
+    FileProgressStatus status;
+    char *src, *dst, *p;
+    struct stat st;
+
+    /* given */
+    mctest_assert_not_null (work_dir);
+    src = g_build_filename (work_dir, "src", (char *) NULL);
+    dst = g_build_filename (work_dir, "src", "copy", (char *) NULL);
+    p = g_build_filename (work_dir, "src", "sub", (char *) NULL);
+    g_mkdir_with_parents (p, 0755);
+    g_free (p);
+
+    ctx = file_op_context_new (OP_COPY);
+    tctx = file_op_total_context_new ();
+
+    /* when */
+    status = copy_dir_dir (tctx, ctx, src, dst, TRUE, FALSE, FALSE);
+
+    /* then: created directory isn't copied again */
+    mctest_assert_int_eq (status, FILE_CONT);
+    p = g_build_filename (dst, "sub", (char *) NULL);
+    mctest_assert_int_eq (lstat (p, &st), 0);
+    g_free (p);
+    p = g_build_filename (dst, "copy", (char *) NULL);
+    mctest_assert_int_ne (lstat (p, &st), 0);
+    g_free (p);
+    mctest_assert_int_eq (g_hash_table_size (dest_dirs), 2);
+
+    file_op_total_context_destroy (tctx);
+    file_op_context_destroy (ctx);
+    g_free (src);
+    g_free (dst);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    tcase_add_test (tc_core, test_copy_hardlinks);
+    tcase_add_test (tc_core, test_link_hash);
+    tcase_add_test (tc_core, test_copy_dir_into_itself);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "copy_hardlinks.log");
+    srunner_run_all (sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? 0 : 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,626 @@
+/*
+   src/filemanager - reading of directory in background
+
+   Copyright (C) 2014
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/src/filemanager"
+
+#include "tests/mctest.h"
+#include "tests/mctest_tmpdir.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "lib/vfs/vfs.h"
+#include "src/vfs/local/local.h"
+
+#include "src/filemanager/dir.c"
+
+/* number of files in the slow directory */
+#define SLOW_FILES 50
+
+/* number of sorted entries and entries merged into them */
+#define MERGE_SORTED 1000
+#define MERGE_ADDED 10
+
+/* limit of waiting for the loader thread: it is never reached if test passes */
+#define WAIT_TIMEOUT (10 * G_USEC_PER_SEC)
+
+static char *work_dir = NULL;
+static vfs_path_t *work_vpath = NULL;
+
+/* state shared with the loader thread */
+static GMutex test_lock;
+static GCond test_cond;
+static int notify_count = 0;
+/* number of readdir() calls allowed to pass, -1 for any number */
+static int gate_count = -1;
+static gboolean gate_blocked = FALSE;
+
+/* number of calls of sort function */
+static int compare_count = 0;
+
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef DIR_LIST_LOADER_THREADED
+/* file system with slow network connection: readdir() waits until test lets it go */
+static struct dirent *
+slow_readdir (DIR * dirp)
+{
+    g_mutex_lock (&test_lock);
+    while (gate_count == 0)
+    {
+        gate_blocked = TRUE;
+        g_cond_broadcast (&test_cond);
+        g_cond_wait (&test_cond, &test_lock);
+    }
+    gate_blocked = FALSE;
+    if (gate_count > 0)
+        gate_count--;
+    g_mutex_unlock (&test_lock);
+
+    return readdir (dirp);
+}
+
+static const dir_local_ops_t slow_ops = {
+    opendir, slow_readdir, closedir, lstat, stat
+};
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+gate_open (int count)
+{
+    g_mutex_lock (&test_lock);
+    gate_count = count;
+    g_cond_broadcast (&test_cond);
+    g_mutex_unlock (&test_lock);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* wait until thread has passed all allowed readdir() calls and waits for the next one */
+static gboolean
+gate_wait_blocked (void)
+{
+    gint64 end_time;
+    gboolean ret;
+
+    end_time = g_get_monotonic_time () + WAIT_TIMEOUT;
+
+    g_mutex_lock (&test_lock);
+    while (!(gate_blocked && gate_count == 0)
+           && g_cond_wait_until (&test_cond, &test_lock, end_time))
+        ;
+    ret = gate_blocked && gate_count == 0;
+    g_mutex_unlock (&test_lock);
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+wait_notify (int count)
+{
+    gint64 end_time;
+    gboolean ret;
+
+    end_time = g_get_monotonic_time () + WAIT_TIMEOUT;
+
+    g_mutex_lock (&test_lock);
+    while (notify_count < count && g_cond_wait_until (&test_cond, &test_lock, end_time))
+        ;
+    ret = notify_count >= count;
+    g_mutex_unlock (&test_lock);
+
+    return ret;
+}
+#endif
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+make_file (const char *name)
+{
+    char *p;
+    int fd;
+
+    p = g_build_filename (work_dir, name, (char *) NULL);
+    fd = open (p, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd != -1)
+        close (fd);
+    g_free (p);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+make_files (int count)
+{
+    int i;
+
+    for (i = 0; i < count; i++)
+    {
+        char name[16];
+
+        g_snprintf (name, sizeof (name), "%03d", i);
+        make_file (name);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+count_notify (dir_list_loader_t * loader, void *data)
+{
+    (void) loader;
+    (void) data;
+
+    g_mutex_lock (&test_lock);
+    notify_count++;
+    g_cond_broadcast (&test_cond);
+    g_mutex_unlock (&test_lock);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+get_notify_count (void)
+{
+    int count;
+
+    g_mutex_lock (&test_lock);
+    count = notify_count;
+    g_mutex_unlock (&test_lock);
+
+    return count;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+find_entry (const dir_list * list, const char *name)
+{
+    int i;
+
+    for (i = 0; i < list->len; i++)
+        if (strcmp (list->list[i].fname, name) == 0)
+            return i;
+
+    return -1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+counting_sort_name (file_entry_t * a, file_entry_t * b)
+{
+    compare_count++;
+    return sort_name (a, b);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+append_file (dir_list * list, int number)
+{
+    struct stat st;
+    char name[16];
+
+    memset (&st, 0, sizeof (st));
+    st.st_mode = S_IFREG | 0644;
+    g_snprintf (name, sizeof (name), "f%05d", number);
+    ck_assert (dir_list_append (list, name, &st, FALSE, FALSE));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    str_init_strings (NULL);
+
+    vfs_init ();
+    init_localfs ();
+    vfs_setup_work_dir ();
+
+    work_dir = mctest_tmpdir_new ("dir-list-loader");
+    work_vpath = vfs_path_from_str (work_dir);
+    notify_count = 0;
+    gate_count = -1;
+    gate_blocked = FALSE;
+
+    panels_options.show_dot_files = TRUE;
+    panels_options.show_backups = TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+#ifdef DIR_LIST_LOADER_THREADED
+    dir_local_ops = &dir_local_default_ops;
+    dir_list_loader_threads = TRUE;
+#endif
+
+    vfs_path_free (work_vpath);
+    work_vpath = NULL;
+    mctest_tmpdir_free (work_dir);
+    work_dir = NULL;
+
+    vfs_shut ();
+    str_uninit_strings ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef DIR_LIST_LOADER_THREADED
+
+/* *INDENT-OFF* */
+START_TEST (test_same_as_sync_load)
+/* *INDENT-ON* */
+{
+    dir_sort_options_t sort_op = { FALSE, TRUE, FALSE };
+    dir_list sync_list = { NULL, 0, 0, NULL };
+    dir_list async_list = { NULL, 0, 0, NULL };
+    dir_list_loader_t *loader;
+    char *p, *target;
+    int i, error;
+
+    /* given: files, directory, hidden and backup files, links */
+    make_files (10);
+    make_file (".hidden");
+    make_file ("backup~");
+    p = g_build_filename (work_dir, "subdir", (char *) NULL);
+    mkdir (p, 0755);
+    target = p;
+    p = g_build_filename (work_dir, "link_to_dir", (char *) NULL);
+    ck_assert (symlink (target, p) == 0);
+    g_free (p);
+    g_free (target);
+    p = g_build_filename (work_dir, "stale_link", (char *) NULL);
+    ck_assert (symlink ("nowhere", p) == 0);
+    g_free (p);
+
+    panels_options.show_backups = FALSE;
+    /* dir_list_load() reads the current directory */
+    mc_chdir (work_vpath);
+    dir_list_load (&sync_list, work_vpath, (GCompareFunc) sort_name, &sort_op, NULL);
+
+    /* when */
+    loader = dir_list_loader_new (work_vpath, count_notify, NULL);
+    mctest_assert_not_null (loader);
+    mctest_assert_int_eq (dir_list_loader_init_list (loader, &async_list), TRUE);
+    mctest_assert_int_eq (dir_list_loader_wait (loader, WAIT_TIMEOUT), TRUE);
+    mctest_assert_int_eq (dir_list_loader_take (loader, &async_list, NULL, &error), TRUE);
+    dir_list_sort (&async_list, (GCompareFunc) sort_name, &sort_op);
+    dir_list_loader_unref (loader);
+
+    /* then */
+    mctest_assert_int_eq (error, 0);
+    mctest_assert_int_eq (async_list.len, sync_list.len);
+    mctest_assert_int_eq (find_entry (&async_list, "backup~"), -1);
+    ck_assert (find_entry (&async_list, ".hidden") > 0);
+
+    for (i = 0; i < sync_list.len; i++)
+    {
+        file_entry_t *a = &async_list.list[i];
+        file_entry_t *s = &sync_list.list[i];
+
+        mctest_assert_str_eq (a->fname, s->fname);
+        mctest_assert_int_eq (a->st.mode, s->st.mode);
+        mctest_assert_int_eq (a->f.link_to_dir, s->f.link_to_dir);
+        mctest_assert_int_eq (a->f.stale_link, s->f.stale_link);
+    }
+
+    i = find_entry (&async_list, "link_to_dir");
+    mctest_assert_int_eq (async_list.list[i].f.link_to_dir, 1);
+    i = find_entry (&async_list, "stale_link");
+    mctest_assert_int_eq (async_list.list[i].f.stale_link, 1);
+
+    dir_list_clean (&sync_list);
+    g_free (sync_list.list);
+    dir_list_clean (&async_list);
+    g_free (async_list.list);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_filter)
+/* *INDENT-ON* */
+{
+    dir_list list = { NULL, 0, 0, NULL };
+    dir_list_loader_t *loader;
+    char *p;
+    int error;
+
+    /* given */
+    make_file ("one.c");
+    make_file ("two.h");
+    p = g_build_filename (work_dir, "dir.h", (char *) NULL);
+    mkdir (p, 0755);
+    g_free (p);
+
+    /* when */
+    loader = dir_list_loader_new (work_vpath, NULL, NULL);
+    mctest_assert_not_null (loader);
+    dir_list_loader_init_list (loader, &list);
+    dir_list_loader_wait (loader, WAIT_TIMEOUT);
+    mctest_assert_int_eq (dir_list_loader_take (loader, &list, "*.c", &error), TRUE);
+    dir_list_loader_unref (loader);
+
+    /* then: directories aren't filtered */
+    mctest_assert_int_eq (list.len, 3);
+    ck_assert (find_entry (&list, "one.c") > 0);
+    ck_assert (find_entry (&list, "dir.h") > 0);
+    mctest_assert_int_eq (find_entry (&list, "two.h"), -1);
+
+    dir_list_clean (&list);
+    g_free (list.list);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_partial_results)
+/* *INDENT-ON* */
+{
+    dir_list list = { NULL, 0, 0, NULL };
+    dir_list_loader_t *loader;
+    int error;
+
+    /* given: a few entries are read, then file system hangs */
+    make_files (SLOW_FILES);
+    dir_local_ops = &slow_ops;
+    gate_open (5);
+
+    loader = dir_list_loader_new (work_vpath, count_notify, NULL);
+    mctest_assert_not_null (loader);
+    dir_list_loader_init_list (loader, &list);
+    fail_unless (gate_wait_blocked ());
+
+    /* when: the next entries are read after flush interval */
+    g_usleep (DIR_LIST_LOADER_FLUSH_INTERVAL);
+    gate_open (3);
+    fail_unless (wait_notify (1));
+    fail_unless (gate_wait_blocked ());
+
+    /* then: main thread gets entries read so far */
+    mctest_assert_int_eq (dir_list_loader_wait (loader, 0), FALSE);
+    mctest_assert_int_eq (dir_list_loader_take (loader, &list, NULL, &error), FALSE);
+    fail_unless (list.len > 1 && list.len <= 8 + 1);
+    mctest_assert_str_eq (list.list[0].fname, "..");
+
+    /* when: the rest of them */
+    gate_open (-1);
+    mctest_assert_int_eq (dir_list_loader_wait (loader, WAIT_TIMEOUT), TRUE);
+    mctest_assert_int_eq (dir_list_loader_take (loader, &list, NULL, &error), TRUE);
+    dir_list_loader_unref (loader);
+
+    /* then */
+    mctest_assert_int_eq (error, 0);
+    mctest_assert_int_eq (list.len, SLOW_FILES + 1);
+    /* notify is called after loader lock is released and can come later than wait returns */
+    fail_unless (wait_notify (2));
+    mctest_assert_int_eq (get_notify_count (), 2);
+
+    dir_list_clean (&list);
+    g_free (list.list);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_cancel)
+/* *INDENT-ON* */
+{
+    dir_list list = { NULL, 0, 0, NULL };
+    dir_list_loader_t *loader;
+    int error, count;
+
+    /* given: file system hangs after a few entries */
+    make_files (SLOW_FILES);
+    dir_local_ops = &slow_ops;
+    gate_open (5);
+
+    loader = dir_list_loader_new (work_vpath, count_notify, NULL);
+    mctest_assert_not_null (loader);
+    dir_list_loader_init_list (loader, &list);
+    fail_unless (gate_wait_blocked ());
+
+    /* when */
+    dir_list_loader_cancel (loader);
+    count = get_notify_count ();
+    gate_open (-1);
+
+    /* then: thread stops after the pending readdir() and doesn't notify any more */
+    mctest_assert_int_eq (dir_list_loader_is_cancelled (loader), TRUE);
+    mctest_assert_int_eq (dir_list_loader_wait (loader, WAIT_TIMEOUT), TRUE);
+    mctest_assert_int_eq (dir_list_loader_take (loader, &list, NULL, &error), TRUE);
+    fail_unless (list.len <= 6 + 1);
+    mctest_assert_int_eq (get_notify_count (), count);
+
+    dir_list_loader_unref (loader);
+    dir_list_clean (&list);
+    g_free (list.list);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+#endif /* DIR_LIST_LOADER_THREADED */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_not_loaded_partially)
+/* *INDENT-ON* */
+{
+    vfs_path_t *vpath;
+
+    /* root directory is read synchronously */
+    vpath = vfs_path_from_str (PATH_SEP_STR);
+    mctest_assert_null (dir_list_loader_new (vpath, NULL, NULL));
+    vfs_path_free (vpath);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_step)
+/* *INDENT-ON* */
+{
+    dir_list list = { NULL, 0, 0, NULL };
+    dir_list_loader_t *loader;
+    int error, steps;
+
+    /* given: directory isn't read in background as VFS one */
+    make_files (SLOW_FILES);
+#ifdef DIR_LIST_LOADER_THREADED
+    dir_list_loader_threads = FALSE;
+#endif
+
+    loader = dir_list_loader_new (work_vpath, count_notify, NULL);
+    mctest_assert_not_null (loader);
+    mctest_assert_int_eq (dir_list_loader_in_background (loader), FALSE);
+    dir_list_loader_init_list (loader, &list);
+
+    /* when: nothing is read until step is done */
+    mctest_assert_int_eq (dir_list_loader_take (loader, &list, NULL, &error), FALSE);
+    mctest_assert_int_eq (list.len, 1);
+
+    /* then: one entry is read by step which has no time */
+    mctest_assert_int_eq (dir_list_loader_step (loader, 0), FALSE);
+    mctest_assert_int_eq (dir_list_loader_take (loader, &list, NULL, &error), FALSE);
+    mctest_assert_int_eq (list.len, 2);
+
+    /* when: the rest of them */
+    for (steps = 1; !dir_list_loader_step (loader, 0); steps++)
+        ;
+    mctest_assert_int_eq (dir_list_loader_take (loader, &list, NULL, &error), TRUE);
+    dir_list_loader_unref (loader);
+
+    /* then: every entry is read in its own step, notify isn't called in the main thread */
+    mctest_assert_int_eq (error, 0);
+    mctest_assert_int_eq (list.len, SLOW_FILES + 1);
+    fail_unless (steps >= SLOW_FILES);
+    mctest_assert_int_eq (get_notify_count (), 0);
+
+    dir_list_clean (&list);
+    g_free (list.list);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_sort_merge)
+/* *INDENT-ON* */
+{
+    dir_sort_options_t sort_op = { FALSE, TRUE, FALSE };
+    dir_list list = { NULL, 0, 0, NULL };
+    int i;
+
+    /* given: sorted list with even numbers, odd ones are appended in reverse order */
+    dir_list_init (&list);
+    for (i = 0; i < MERGE_SORTED; i++)
+        append_file (&list, 2 * i);
+    for (i = 0; i < MERGE_ADDED; i++)
+        append_file (&list, 2 * (MERGE_SORTED - i * (MERGE_SORTED / MERGE_ADDED)) - 1);
+
+    /* when */
+    compare_count = 0;
+    dir_list_sort_merge (&list, MERGE_SORTED + 1, (GCompareFunc) counting_sort_name, &sort_op);
+
+    /* then: list is sorted */
+    mctest_assert_int_eq (list.len, MERGE_SORTED + MERGE_ADDED + 1);
+    mctest_assert_str_eq (list.list[0].fname, "..");
+    for (i = 2; i < list.len; i++)
+        ck_assert_msg (strcmp (list.list[i - 1].fname, list.list[i].fname) < 0,
+                       "%s isn't before %s", list.list[i - 1].fname, list.list[i].fname);
+
+    /* the sorted part isn't sorted again: new entries are only placed by binary search */
+    ck_assert_msg (compare_count < MERGE_ADDED * 20 + MERGE_ADDED * MERGE_ADDED,
+                   "%d comparisons", compare_count);
+
+    dir_list_clean (&list);
+    g_free (list.list);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+#ifdef DIR_LIST_LOADER_THREADED
+    tcase_add_test (tc_core, test_same_as_sync_load);
+    tcase_add_test (tc_core, test_filter);
+    tcase_add_test (tc_core, test_partial_results);
+    tcase_add_test (tc_core, test_cancel);
+#endif
+    tcase_add_test (tc_core, test_not_loaded_partially);
+    tcase_add_test (tc_core, test_step);
+    tcase_add_test (tc_core, test_sort_merge);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "dir_list_loader.log");
+    srunner_run_all (sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? 0 : 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
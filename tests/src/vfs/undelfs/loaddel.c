@@ -0,0 +1,279 @@
+/*
+   src/vfs/undelfs - scanning of deleted inodes
+
+   Copyright (C) 2014
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/src/vfs/undelfs"
+
+#include "tests/mctest.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "src/vfs/undelfs/undelfs.c"
+
+/* small file system with many block groups: several chunks are scanned in parallel */
+#define IMAGE_BLOCKS 32768
+#define IMAGE_BLOCKS_PER_GROUP 256
+#define IMAGE_INODES_PER_GROUP 32
+
+/* first non-reserved inode of GOOD_OLD_REV file system */
+#define IMAGE_FIRST_INO 11
+
+#define IMAGE_DTIME 1400000000
+
+static char *image = NULL;
+
+/* inode numbers of files that should be found */
+static GArray *expected = NULL;
+
+/* inode numbers of files that shouldn't be found */
+static GArray *unexpected = NULL;
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* create file system image with deleted and alive files in every block group */
+static void
+make_image (void)
+{
+    struct ext2_super_block param;
+    ext2_filsys efs;
+    ext2_ino_t ipg;
+    dgrp_t group;
+    blk_t blk = 0;
+    int fd;
+
+    fd = g_file_open_tmp ("undelfs-XXXXXX", &image, NULL);
+    ck_assert_int_ne (fd, -1);
+    ck_assert_int_eq (ftruncate (fd, (off_t) IMAGE_BLOCKS * 1024), 0);
+    close (fd);
+
+    memset (&param, 0, sizeof (param));
+    param.s_blocks_count = IMAGE_BLOCKS;
+    param.s_blocks_per_group = IMAGE_BLOCKS_PER_GROUP;
+    param.s_inodes_count = (IMAGE_BLOCKS / IMAGE_BLOCKS_PER_GROUP) * IMAGE_INODES_PER_GROUP;
+    param.s_log_block_size = 0;
+
+    ck_assert_int_eq (ext2fs_initialize (image, 0, &param, unix_io_manager, &efs), 0);
+    ck_assert_int_eq (ext2fs_allocate_tables (efs), 0);
+
+    ipg = efs->super->s_inodes_per_group;
+
+    for (group = 0; group < efs->group_desc_count; group++)
+    {
+        int k;
+
+        for (k = 0; k < 5; k++)
+        {
+            struct ext2_inode inode;
+            ext2_ino_t ino;
+
+            ino = group * ipg + IMAGE_FIRST_INO + k;
+
+            ck_assert_int_eq (ext2fs_new_block (efs, blk + 1, efs->block_map, &blk), 0);
+
+            memset (&inode, 0, sizeof (inode));
+            inode.i_mode = S_IFREG | 0644;
+            inode.i_uid = 500;
+            inode.i_gid = 100;
+            inode.i_size = 100 + ino;
+            inode.i_blocks = 2;
+            inode.i_block[0] = blk;
+            inode.i_dtime = IMAGE_DTIME + ino;
+
+            switch ((group + k) % 5)
+            {
+            case 0:
+                /* deleted file, its block is free */
+                g_array_append_val (expected, ino);
+                break;
+            case 1:
+                /* deleted file, its block is reused */
+                ext2fs_mark_block_bitmap (efs->block_map, blk);
+                g_array_append_val (unexpected, ino);
+                break;
+            case 2:
+                /* alive file */
+                inode.i_dtime = 0;
+                inode.i_links_count = 1;
+                ext2fs_mark_block_bitmap (efs->block_map, blk);
+                g_array_append_val (unexpected, ino);
+                break;
+            case 3:
+                /* deleted directory */
+                inode.i_mode = S_IFDIR | 0755;
+                g_array_append_val (unexpected, ino);
+                break;
+            default:
+                /* deleted file with corrupted block list */
+                inode.i_block[0] = IMAGE_BLOCKS + 10;
+                g_array_append_val (unexpected, ino);
+                break;
+            }
+
+            ck_assert_int_eq (ext2fs_write_inode (efs, ino, &inode), 0);
+        }
+    }
+
+    ext2fs_mark_bb_dirty (efs);
+    ext2fs_mark_super_dirty (efs);
+    ck_assert_int_eq (ext2fs_close (efs), 0);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    expected = g_array_new (FALSE, FALSE, sizeof (ext2_ino_t));
+    unexpected = g_array_new (FALSE, FALSE, sizeof (ext2_ino_t));
+    make_image ();
+
+    /* as in undelfs_opendir() */
+    ext2_fname = g_strdup (image);
+    ck_assert_int_eq (ext2fs_open (ext2_fname, 0, 0, 0, unix_io_manager, &fs), 0);
+    ck_assert_int_eq (ext2fs_read_inode_bitmap (fs), 0);
+    ck_assert_int_eq (ext2fs_read_block_bitmap (fs), 0);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    undelfs_shutdown ();
+    unlink (image);
+    g_free (image);
+    g_array_free (unexpected, TRUE);
+    g_array_free (expected, TRUE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static long
+getindex (ext2_ino_t ino)
+{
+    char name[32];
+
+    g_snprintf (name, sizeof (name), "%lu:1", (unsigned long) ino);
+    return undelfs_getindex (name);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_loaddel)
+/* *INDENT-ON* */
+{
+    guint i;
+
+    /* given: file system is opened in setup() */
+
+    /* when */
+    mctest_assert_int_eq (undelfs_loaddel (), 1);
+
+    /* then: all deleted files are found in order of inode numbers */
+    mctest_assert_int_eq (num_delarray, expected->len);
+
+    for (i = 0; i < expected->len; i++)
+    {
+        ext2_ino_t ino = g_array_index (expected, ext2_ino_t, i);
+
+        mctest_assert_int_eq (delarray[i].ino, ino);
+        mctest_assert_int_eq (delarray[i].mode, S_IFREG | 0644);
+        mctest_assert_int_eq (delarray[i].uid, 500);
+        mctest_assert_int_eq (delarray[i].gid, 100);
+        mctest_assert_int_eq (delarray[i].size, 100 + ino);
+        mctest_assert_int_eq (delarray[i].dtime, IMAGE_DTIME + ino);
+        mctest_assert_int_eq (delarray[i].num_blocks, 1);
+        mctest_assert_int_eq (delarray[i].free_blocks, 1);
+
+        mctest_assert_int_eq (getindex (ino), i);
+    }
+
+    for (i = 0; i < unexpected->len; i++)
+        mctest_assert_int_eq (getindex (g_array_index (unexpected, ext2_ino_t, i)), -1);
+
+    mctest_assert_int_eq (getindex (0), -1);
+    mctest_assert_int_eq (getindex (fs->super->s_inodes_count + 1), -1);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_loaddel_rescan)
+/* *INDENT-ON* */
+{
+    int i;
+
+    /* given */
+    mctest_assert_int_eq (undelfs_loaddel (), 1);
+    undelfs_shutdown ();
+
+    ext2_fname = g_strdup (image);
+    ck_assert_int_eq (ext2fs_open (ext2_fname, 0, 0, 0, unix_io_manager, &fs), 0);
+    ck_assert_int_eq (ext2fs_read_inode_bitmap (fs), 0);
+    ck_assert_int_eq (ext2fs_read_block_bitmap (fs), 0);
+
+    /* when */
+    mctest_assert_int_eq (undelfs_loaddel (), 1);
+
+    /* then: same result */
+    mctest_assert_int_eq (num_delarray, expected->len);
+    for (i = 0; i < num_delarray; i++)
+        mctest_assert_int_eq (delarray[i].ino, g_array_index (expected, ext2_ino_t, i));
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    tcase_add_test (tc_core, test_loaddel);
+    tcase_add_test (tc_core, test_loaddel_rescan);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "loaddel.log");
+    srunner_run_all (sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? 0 : 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
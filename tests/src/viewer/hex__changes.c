@@ -0,0 +1,372 @@
+/*
+   src/viewer - tests for ranges of changes in hexedit mode
+
+   Copyright (C) 2014
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/src/viewer"
+
+#include "tests/mctest.h"
+
+#include "src/viewer/internal.h"
+
+/* contents of viewed "file" */
+#define TEST_DATA "0123456789"
+
+/* size of file in random test */
+#define RANDOM_SIZE 200
+
+/* number of random operations */
+#define OPERATIONS_NUM 5000
+
+/* max number of changes before the tested one */
+#define MAX_SETS 3
+
+static mcview_t *test_view;
+
+/* model of changes: value of every byte, -1 if byte isn't changed */
+static int model[RANDOM_SIZE];
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    test_view = g_new0 (mcview_t, 1);
+    mcview_set_datasource_string (test_view, TEST_DATA);
+    g_random_set_seed (12345);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    mcview_hexedit_free_change_list (test_view);
+    mcview_close_datasource (test_view);
+    g_free (test_view);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+changes_to_string_cb (gpointer key, gpointer value, gpointer user_data)
+{
+    const struct hexedit_change_node *node = (const struct hexedit_change_node *) key;
+    GString *s = (GString *) user_data;
+
+    (void) value;
+
+    if (s->len != 0)
+        g_string_append_c (s, ' ');
+    g_string_append_printf (s, "%ld:", (long) node->offset);
+    g_string_append_len (s, (const char *) node->data->data, node->data->len);
+
+    return FALSE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Ranges of changes as "offset:bytes" separated by spaces */
+
+static char *
+changes_to_string (void)
+{
+    GString *s;
+
+    s = g_string_new ("");
+    if (test_view->changes != NULL)
+        g_tree_foreach (test_view->changes, changes_to_string_cb, s);
+
+    return g_string_free (s, FALSE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+set_bytes (off_t offset, size_t len, char c)
+{
+    byte *data;
+
+    data = g_malloc (len);
+    memset (data, c, len);
+    mcview_hexedit_set_bytes (test_view, offset, data, len);
+    g_free (data);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+check_model_cb (gpointer key, gpointer value, gpointer user_data)
+{
+    const struct hexedit_change_node *node = (const struct hexedit_change_node *) key;
+    off_t *end = (off_t *) user_data;
+    guint i;
+
+    (void) value;
+
+    /* ranges are sorted, neither overlapping nor adjacent */
+    if (node->data->len == 0 || node->offset <= *end)
+        ck_abort_msg ("range at %ld: wrong place", (long) node->offset);
+
+    for (i = 0; i < node->data->len; i++)
+        if (model[node->offset + i] != node->data->data[i])
+            ck_abort_msg ("byte %ld: wrong value", (long) (node->offset + i));
+
+    *end = node->offset + (off_t) node->data->len;
+
+    return FALSE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+check_model (void)
+{
+    off_t offset, end = -2;
+
+    g_tree_foreach (test_view->changes, check_model_cb, &end);
+
+    for (offset = 0; offset < RANDOM_SIZE; offset++)
+    {
+        struct hexedit_change_node *node;
+
+        node = mcview_hexedit_find_change (test_view, offset);
+        if ((node != NULL) != (model[offset] != -1))
+            ck_abort_msg ("byte %ld: wrong range", (long) offset);
+        if (node != NULL && (offset < node->offset
+                             || offset >= node->offset + (off_t) node->data->len))
+            ck_abort_msg ("byte %ld: range doesn't contain it", (long) offset);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_set_bytes_ds") */
+/* *INDENT-OFF* */
+static const struct test_set_bytes_ds
+{
+    /* changes made before, with bytes 'a', 'b'...; the tested one is the last */
+    struct
+    {
+        off_t offset;
+        size_t len;
+    } sets[MAX_SETS + 1];
+    const char *expected;
+} test_set_bytes_ds[] =
+{
+    { /* 0. the first change */
+        { { 5, 3 } },
+        "5:aaa"
+    },
+    { /* 1. overlapping the end of range */
+        { { 2, 4 }, { 4, 4 } },
+        "2:aabbbb"
+    },
+    { /* 2. overlapping the start of range */
+        { { 4, 4 }, { 2, 4 } },
+        "2:bbbbaa"
+    },
+    { /* 3. adjacent after range */
+        { { 2, 2 }, { 4, 2 } },
+        "2:aabb"
+    },
+    { /* 4. adjacent before range */
+        { { 4, 2 }, { 2, 2 } },
+        "2:bbaa"
+    },
+    { /* 5. contained in range */
+        { { 2, 8 }, { 4, 2 } },
+        "2:aabbaaaa"
+    },
+    { /* 6. containing ranges */
+        { { 4, 2 }, { 8, 1 }, { 2, 10 } },
+        "2:cccccccccc"
+    },
+    { /* 7. joining ranges */
+        { { 2, 2 }, { 6, 2 }, { 4, 2 } },
+        "2:aaccbb"
+    },
+    { /* 8. same range */
+        { { 3, 3 }, { 3, 3 } },
+        "3:bbb"
+    },
+    { /* 9. separate ranges */
+        { { 2, 2 }, { 5, 2 }, { 0, 1 } },
+        "0:c 2:aa 5:bb"
+    },
+    { /* 10. overlapping one range and adjacent to other one */
+        { { 0, 3 }, { 7, 2 }, { 2, 5 } },
+        "0:aacccccbb"
+    }
+};
+/* *INDENT-ON* */
+
+/* @Test(dataSource = "test_set_bytes_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_set_bytes, test_set_bytes_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    char *actual;
+    int i;
+
+    /* when */
+    for (i = 0; data->sets[i].len != 0; i++)
+        set_bytes (data->sets[i].offset, data->sets[i].len, 'a' + i);
+
+    /* then */
+    actual = changes_to_string ();
+    mctest_assert_str_eq (actual, data->expected);
+    g_free (actual);
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_fill_bytes_ds") */
+/* *INDENT-OFF* */
+static const struct test_fill_bytes_ds
+{
+    off_t cursor;
+    const char *pattern;
+    off_t count;
+    const char *expected;
+} test_fill_bytes_ds[] =
+{
+    { /* 0. */
+        2,
+        "ab",
+        5,
+        "2:ababa"
+    },
+    { /* 1. file size isn't changed */
+        6,
+        "ab",
+        100,
+        "6:abab"
+    },
+    { /* 2. */
+        9,
+        "xyz",
+        3,
+        "9:x"
+    },
+    { /* 3. cursor at the end of file */
+        10,
+        "ab",
+        3,
+        ""
+    }
+};
+/* *INDENT-ON* */
+
+/* @Test(dataSource = "test_fill_bytes_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_fill_bytes, test_fill_bytes_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    GByteArray *pattern;
+    char *actual;
+
+    pattern = g_byte_array_new ();
+    g_byte_array_append (pattern, (const guint8 *) data->pattern, strlen (data->pattern));
+    test_view->hex_cursor = data->cursor;
+
+    /* when */
+    mcview_hexedit_fill_bytes (test_view, pattern, data->count);
+
+    /* then */
+    actual = changes_to_string ();
+    mctest_assert_str_eq (actual, data->expected);
+    g_free (actual);
+    g_byte_array_free (pattern, TRUE);
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_set_bytes_random)
+/* *INDENT-ON* */
+{
+    int i;
+
+    for (i = 0; i < RANDOM_SIZE; i++)
+        model[i] = -1;
+
+    for (i = 0; i < OPERATIONS_NUM; i++)
+    {
+        off_t offset;
+        size_t len, j;
+        char c;
+
+        offset = g_random_int_range (0, RANDOM_SIZE - 1);
+        len = (size_t) g_random_int_range (1, MIN (RANDOM_SIZE - offset, 10) + 1);
+        c = (char) g_random_int_range ('a', 'z' + 1);
+
+        set_bytes (offset, len, c);
+        for (j = 0; j < len; j++)
+            model[offset + j] = c;
+
+        if (i % 100 == 0)
+            check_model ();
+    }
+
+    check_model ();
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    mctest_add_parameterized_test (tc_core, test_set_bytes, test_set_bytes_ds);
+    mctest_add_parameterized_test (tc_core, test_fill_bytes, test_fill_bytes_ds);
+    tcase_add_test (tc_core, test_set_bytes_random);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "hex__changes.log");
+    srunner_run_all (sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? 0 : 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */